@@ -8,20 +8,20 @@
 #define MAX_FADC125_CH     72
 #endif
 
-const int FA125_NPEAK_MAX   = 63;
+static const int FA125_NPEAK_MAX   = 63;
 
-const int FA125_IE_MAX   = 1023;
+static const int FA125_IE_MAX   = 1023;
 
-const int FA125_IBIT_MAX = 7;
-const int FA125_ABIT_MAX = 3;
-const int FA125_PBIT_MAX = 3;
+static const int FA125_IBIT_MAX = 7;
+static const int FA125_ABIT_MAX = 3;
+static const int FA125_PBIT_MAX = 3;
 
-const int FA125_PG_MAX   = 7;
-const int FA125_P1_MAX   = 7;
-const int FA125_P2_MAX   = 7;
+static const int FA125_PG_MAX   = 7;
+static const int FA125_P1_MAX   = 7;
+static const int FA125_P2_MAX   = 7;
 
-const int FA125_TH_MAX   = 511;
-const int FA125_TL_MAX   = 255;
+static const int FA125_TH_MAX   = 511;
+static const int FA125_TL_MAX   = 255;
 
 /*
  *
@@ -93,3 +93,5 @@ typedef struct {
   unsigned int data_format;
 
 } FADC125_CONF;
+
+int fa125ConfigApply(int id, FADC125_CONF *conf);
@@ -43,7 +43,12 @@
 #include "jvme.h"
 #endif
 #include <pthread.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(VXWORKS)
+#define FA125_UNPACK_X86
+#include <immintrin.h>
+#endif
 #include "fa125Lib.h"
+#include "fa125Config.h"
 
 #ifndef LSWAP
 #define LSWAP(x)        ((((x) & 0x000000ff) << 24) | \
@@ -52,11 +57,43 @@
                          (((x) & 0xff000000) >> 24))
 #endif
 
-/* Mutex to guard TD read/writes */
-pthread_mutex_t    fa125Mutex = PTHREAD_MUTEX_INITIALIZER;
-#define FA125LOCK     if(pthread_mutex_lock(&fa125Mutex)<0) perror("pthread_mutex_lock");
+/* Crate mutex.  Guards the DMA engine, the Multiblock token and the
+   fa125Dma and fa125BlockError state.  Taken before any module mutex.
+   Recursive, as are the module mutexes.  Both are initialized by the
+   first lock, since a mutex may not be initialized twice. */
+pthread_mutex_t    fa125Mutex;
+static pthread_once_t fa125MutexOnce = PTHREAD_ONCE_INIT;
+static void fa125MutexInit();
+#define FA125LOCK     if((pthread_once(&fa125MutexOnce, fa125MutexInit)!=0) || \
+			 (pthread_mutex_lock(&fa125Mutex)<0)) perror("pthread_mutex_lock");
 #define FA125UNLOCK   if(pthread_mutex_unlock(&fa125Mutex)<0) perror("pthread_mutex_unlock");
 
+/* Mutex of each module.  Guards its registers and shadow, so that slow
+   operations on one module (configuration, DAC programming, firmware) do
+   not hold up the readout of the others.  Recursive, so that routines
+   holding it may call the library.  With
+   fa125SetGlobalLock(1), every module uses the crate mutex instead. */
+static pthread_mutex_t fa125SlotMutex[FA125_MAX_BOARDS+1];
+static int fa125GlobalLock=0;
+#define FA125SLOTMUTEX(_id)  (fa125GlobalLock ? &fa125Mutex : &fa125SlotMutex[_id])
+#define FA125SLOTLOCK(_id)   if((pthread_once(&fa125MutexOnce, fa125MutexInit)!=0) || \
+				(pthread_mutex_lock(FA125SLOTMUTEX(_id))<0)) perror("pthread_mutex_lock");
+#define FA125SLOTUNLOCK(_id) if(pthread_mutex_unlock(FA125SLOTMUTEX(_id))<0) perror("pthread_mutex_unlock");
+
+static void
+fa125MutexInit()
+{
+  pthread_mutexattr_t attr;
+  int ii;
+
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&fa125Mutex, &attr);
+  for(ii=0; ii<=FA125_MAX_BOARDS; ii++)
+    pthread_mutex_init(&fa125SlotMutex[ii], &attr);
+  pthread_mutexattr_destroy(&attr);
+}
+
 /* Define global variables */
 int nfa125=0; /* Number of initialized modules */
 volatile struct fa125_a24 *fa125p[(FA125_MAX_BOARDS+1)]; /* pointers to FA125 memory map */
@@ -74,6 +111,319 @@ int berr_count=0; /* A count of the number of BERR that have occurred when runni
 /* store the dacOffsets in the library, until the firmware is able to read them back */
 static unsigned short fa125dacOffset[FA125_MAX_BOARDS+1][72];
 int fa125BlockError=FA125_BLOCKERROR_NO_ERROR;       /* Whether (1) or not (0) Block Transfer had an error */
+/* DMA started by fa125ReadBlock, completed by fa125ReadBlockComplete */
+static int fa125DmaPending=0;  /* Whether (1) or not (0) a DMA is in progress */
+static int fa125DmaID=0;       /* Slot number addressed by the DMA */
+static int fa125DmaMode=0;     /* Readout mode (rflag&0xf) of the DMA */
+static int fa125DmaNwrds=0;    /* Max number of words of the DMA */
+static int fa125DmaDummy=0;    /* Whether (1) or not (0) a dummy word was inserted for alignment */
+static volatile UINT32 *fa125DmaData=NULL; /* Destination of the DMA */
+static int fa125DmaIndex=0;    /* Whether (1) or not (0) to index the blocks of the DMA */
+static FA125_BLOCK_INDEX fa125BlockIndex[FA125_MAX_BOARDS+1]; /* Blocks of the last DMA */
+static int fa125BlockIndexN=0; /* Number of blocks in the last DMA */
+static int fa125DmaAbandon();
+
+/* Readout policy of fa125ReadCrate.  Guarded by FA125LOCK. */
+static int fa125ReadoutDeadline=1000;                       /* usec to wait for modules not ready */
+static unsigned int fa125ReadoutOwed[FA125_MAX_BOARDS+1];    /* late blocks still in the module */
+static unsigned int fa125ReadoutLate[FA125_MAX_BOARDS+1];    /* blocks ready only after a wait */
+static unsigned int fa125ReadoutMissed[FA125_MAX_BOARDS+1];  /* blocks not ready by the deadline */
+static unsigned int fa125ReadoutDropped[FA125_MAX_BOARDS+1]; /* late blocks read and dropped */
+
+/* Transfer mode and crossover of fa125DmaCalibrate, and the running mean
+   block length of each module, for fa125ReadBlock rflag 0x20 */
+static FA125_DMA_CALIBRATION fa125DmaCal;
+static int fa125ReadAutoWords[FA125_MAX_BOARDS+1];
+
+/* Block ready waiter (fa125WaitBlockReady).  Guarded by FA125LOCK. */
+#define FA125_WAIT_SPIN_MIN    1000     /* ns */
+#define FA125_WAIT_SPIN_MAX    100000   /* ns */
+#define FA125_WAIT_PAUSE_MIN   1000     /* ns */
+#define FA125_WAIT_PAUSE_MAX   1000000  /* ns */
+#define FA125_WAIT_CALIBRATE   1024     /* waits between spin calibrations */
+static int fa125WaitSpin=10000;         /* ns polled without pause */
+static int fa125WaitSpinFixed=0;        /* Whether (1) or not (0) set by fa125SetWaitSpin */
+static unsigned long long fa125WaitCount=0, fa125WaitPolls=0;
+static unsigned int fa125ReadyHist[FA125_MAX_BOARDS+1][FA125_READY_NBINS]; /* time to ready */
+static unsigned int fa125ReadyTimeout[FA125_MAX_BOARDS+1];
+
+/* Readout counters (fa125GetReadoutStats), updated without a lock */
+static FA125_READOUT_STATS fa125Stats[32]; /* by slot number, as in the block header */
+static long long fa125DmaStart=0; /* Time the DMA in progress was started */
+#ifdef VXWORKS
+/* No atomics in the VxWorks compiler.  A count may be lost when the
+   counters are cleared during an update. */
+#define FA125STAT(_id, _field, _n)					\
+  (fa125Stats[_id]._field += (unsigned long long)(_n))
+#else
+#define FA125STAT(_id, _field, _n)					\
+  __atomic_fetch_add(&fa125Stats[_id]._field, (unsigned long long)(_n), __ATOMIC_RELAXED)
+#endif
+
+static long long
+fa125ReadoutNsec()
+{
+  struct timespec ts;
+#ifdef VXWORKS
+  clock_gettime(CLOCK_REALTIME, &ts);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+#ifndef VXWORKS
+/* VME transaction accounting (fa125GetVmeCounts*), built with -DFA125_ACCT.
+   Every VME access of the library then goes through the wrappers below,
+   and is counted for the outermost library routine of the calling thread
+   (FA125ACCT_ENTRY), for the module addressed and for the thread.  Counts
+   are relaxed atomic adds.  Without FA125_ACCT, the counts stay zero. */
+#define FA125_ACCT_NAPI      256     /* routines counted; entry 0 is for the rest */
+#define FA125_ACCT_NTHREADS  16      /* threads counted */
+enum { FA125_ACCT_CALLS, FA125_ACCT_READS, FA125_ACCT_WRITES, FA125_ACCT_PROBES,
+       FA125_ACCT_DMAS, FA125_ACCT_DMA_BYTES };
+
+struct fa125_acct_api
+{
+  const char       *name;
+  FA125_VME_COUNTS  c;
+};
+
+static struct fa125_acct_api fa125AcctApi[FA125_ACCT_NAPI] = { {"(other)"} };
+static FA125_VME_COUNTS fa125AcctSlot[FA125_MAX_BOARDS+2]; /* by slot, 0 for the crate */
+static FA125_VME_COUNTS *fa125AcctThreads[FA125_ACCT_NTHREADS];
+static int fa125AcctNthreads=0;
+static __thread FA125_VME_COUNTS *fa125AcctThread=NULL;
+static __thread int fa125AcctNoThread=0;
+
+static FA125_VME_COUNTS *
+fa125AcctThreadCounts()
+{
+  FA125_VME_COUNTS *c;
+  int ithread;
+
+  if(fa125AcctThread || fa125AcctNoThread)
+    return fa125AcctThread;
+
+  ithread = __atomic_fetch_add(&fa125AcctNthreads, 1, __ATOMIC_ACQ_REL);
+  c = (ithread < FA125_ACCT_NTHREADS) ?
+    (FA125_VME_COUNTS *)calloc(1, sizeof(FA125_VME_COUNTS)) : NULL;
+  if(c == NULL)
+    {
+      fa125AcctNoThread = 1;
+      return NULL;
+    }
+  __atomic_store_n(&fa125AcctThreads[ithread], c, __ATOMIC_RELEASE);
+  fa125AcctThread = c;
+
+  return c;
+}
+
+#ifdef FA125_ACCT
+static __thread struct fa125_acct_api *fa125AcctCurrent=NULL; /* outermost routine */
+static int fa125AcctDmaSlot=0;          /* module and size of the last DMA started */
+static int fa125AcctDmaSize=0;
+
+#define FA125ACCT_ADD(_c, _field, _n)					\
+  __atomic_fetch_add(&((unsigned long long *)(_c))[_field],		\
+		     (unsigned long long)(_n), __ATOMIC_RELAXED)
+
+/* Entry of a routine, claimed once by the address of its name */
+static struct fa125_acct_api *
+fa125AcctFind(const char *name)
+{
+  unsigned long hash = ((unsigned long)name >> 3) * 2654435761UL;
+  const char *expected;
+  int ii, iapi;
+
+  for(ii = 0; ii < FA125_ACCT_NAPI - 1; ii++)
+    {
+      iapi = 1 + (hash + ii) % (FA125_ACCT_NAPI - 1);
+      expected = __atomic_load_n(&fa125AcctApi[iapi].name, __ATOMIC_ACQUIRE);
+      if(expected == name)
+	return &fa125AcctApi[iapi];
+      if((expected == NULL) &&
+	 (__atomic_compare_exchange_n(&fa125AcctApi[iapi].name, &expected, name, 0,
+				      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ||
+	  (expected == name)))
+	return &fa125AcctApi[iapi];
+    }
+
+  return &fa125AcctApi[0];
+}
+
+static struct fa125_acct_api *
+fa125AcctEnter(const char *name)
+{
+  if(fa125AcctCurrent)
+    return NULL;	/* Called by another routine: counted for that one */
+
+  fa125AcctCurrent = fa125AcctFind(name);
+  FA125ACCT_ADD(&fa125AcctCurrent->c, FA125_ACCT_CALLS, 1);
+
+  return fa125AcctCurrent;
+}
+
+static void
+fa125AcctLeave(struct fa125_acct_api **entered)
+{
+  if(*entered)
+    fa125AcctCurrent = NULL;
+}
+
+/* First statement of a library routine that reaches the VME bus */
+#define FA125ACCT_ENTRY							\
+  struct fa125_acct_api *fa125AcctEntered				\
+  __attribute__((cleanup(fa125AcctLeave), unused)) = fa125AcctEnter(__FUNCTION__)
+
+static void
+fa125AcctAdd(int slot, int field, unsigned long long n)
+{
+  FA125_VME_COUNTS *t = fa125AcctThreadCounts();
+
+  FA125ACCT_ADD(fa125AcctCurrent ? &fa125AcctCurrent->c : &fa125AcctApi[0].c, field, n);
+  FA125ACCT_ADD(&fa125AcctSlot[slot], field, n);
+  if(t)
+    FA125ACCT_ADD(t, field, n);
+}
+
+/* Slot of the module at a CPU address, 0 if none */
+static int
+fa125AcctSlotOf(unsigned long addr)
+{
+  int ifa, id;
+
+  for(ifa = 0; ifa < nfa125; ifa++)
+    {
+      id = fa125ID[ifa];
+      if((fa125p[id] != NULL) &&
+	 (addr - (unsigned long)fa125p[id] < sizeof(struct fa125_a24)))
+	return id;
+      if((fa125pd[id] != NULL) &&
+	 (addr - (unsigned long)fa125pd[id] < sizeof(struct fa125_a32)))
+	return id;
+    }
+
+  return 0;
+}
+
+static unsigned int
+fa125AcctRead32(volatile unsigned int *addr)
+{
+  fa125AcctAdd(fa125AcctSlotOf((unsigned long)addr), FA125_ACCT_READS, 1);
+  return vmeRead32(addr);
+}
+
+static void
+fa125AcctWrite32(volatile unsigned int *addr, unsigned int val)
+{
+  fa125AcctAdd(fa125AcctSlotOf((unsigned long)addr), FA125_ACCT_WRITES, 1);
+  vmeWrite32(addr, val);
+}
+
+static int
+fa125AcctMemProbe(char *addr, int size, char *rval)
+{
+  fa125AcctAdd(fa125AcctSlotOf((unsigned long)addr), FA125_ACCT_PROBES, 1);
+  return vmeMemProbe(addr, size, rval);
+}
+
+static int
+fa125AcctDmaSend(unsigned long locAdrs, unsigned int vmeAdrs, int size)
+{
+  fa125AcctDmaSlot = fa125AcctSlotOf(vmeAdrs + fa125A32Offset);
+  fa125AcctDmaSize = size;
+  fa125AcctAdd(fa125AcctDmaSlot, FA125_ACCT_DMAS, 1);
+  return vmeDmaSend(locAdrs, vmeAdrs, size);
+}
+
+static int
+fa125AcctDmaDone()
+{
+  int retVal = vmeDmaDone();
+
+  /* Bytes transferred, or all of them if terminated on the word count */
+  fa125AcctAdd(fa125AcctDmaSlot, FA125_ACCT_DMA_BYTES,
+	       (retVal > 0) ? retVal : ((retVal == 0) ? fa125AcctDmaSize : 0));
+  return retVal;
+}
+
+#define vmeRead32(_addr)                  fa125AcctRead32(_addr)
+#define vmeWrite32(_addr, _val)           fa125AcctWrite32(_addr, _val)
+#define vmeMemProbe(_addr, _size, _rval)  fa125AcctMemProbe(_addr, _size, _rval)
+#define vmeDmaSend(_loc, _vme, _size)     fa125AcctDmaSend(_loc, _vme, _size)
+#define vmeDmaDone()                      fa125AcctDmaDone()
+#else
+/* A declaration, not an empty statement, so that the routine's own
+   declarations may follow it */
+#define FA125ACCT_ENTRY  struct fa125_acct_none
+#endif /* FA125_ACCT */
+#else
+#define FA125ACCT_ENTRY  struct fa125_acct_none
+#endif /* VXWORKS */
+
+/* Shadow image of the writable configuration registers of each module.
+   Setters modify the shadow and write only the words that change.
+   fe[].config1 is last in each front end, so that a flush enables
+   processing after the window registers are written. */
+struct fa125_shadow
+{
+  struct
+  {
+    UINT32 ctrl1;
+  } main;
+  struct
+  {
+    UINT32 nw;
+    UINT32 pl;
+    UINT32 threshold[6];
+    UINT32 config2;
+    UINT32 test;
+    UINT32 ped_sf;
+    UINT32 timing_thres_lo[3];
+    UINT32 ie;
+    UINT32 timing_thres_hi[2];
+    UINT32 selftrig_thres[6];
+    UINT32 config1;
+  } fe[12];
+  struct
+  {
+    UINT32 trigsrc;
+    UINT32 ctrl2;
+    UINT32 blocklevel;
+    UINT32 pulser_trig_delay;
+    UINT32 ntrig_busy;
+  } proc;
+};
+#define FA125_SHADOW_NWORDS  (sizeof(struct fa125_shadow)/sizeof(UINT32))
+static struct fa125_shadow fa125Shadow[FA125_MAX_BOARDS+1];
+static volatile UINT32 *fa125ShadowReg[FA125_MAX_BOARDS+1][FA125_SHADOW_NWORDS]; /* register of each word */
+static UINT32 fa125ShadowDirty[FA125_MAX_BOARDS+1][(FA125_SHADOW_NWORDS+31)/32]; /* words not yet written */
+static int fa125ShadowDeferred[FA125_MAX_BOARDS+1]; /* Whether (1) or not (0) writes wait for a flush */
+
+/* Write a shadowed register, e.g. FA125SWRITE(id, fe[0].nw, NW) */
+#define FA125SWRITE(_id, _reg, _val) fa125ShadowWrite(_id, &fa125Shadow[_id]._reg, _val)
+#define FA125SREAD(_id, _reg)        (fa125Shadow[_id]._reg)
+#define FA125SDIRTY(_id, _reg)       fa125ShadowIsDirty(_id, &fa125Shadow[_id]._reg)
+
+/* Configuration steps of each module, run by fa125ConfigRun */
+static struct
+{
+  int               nstep;
+  FA125_CONFIG_FUNC func[FA125_CONFIG_MAX_STEPS];
+  void             *arg[FA125_CONFIG_MAX_STEPS];
+  int               status;   /* OK, or ERROR if a step failed */
+  int               failed;   /* Step that failed */
+  double            seconds;  /* Time to run the steps */
+} fa125ConfigSlot[FA125_MAX_BOARDS+1];
+static pthread_mutex_t fa125ConfigMutex = PTHREAD_MUTEX_INITIALIZER;
+static int fa125ConfigNext=0;  /* Next entry of fa125ID for a worker to take */
+
+static void fa125ShadowReadback(int id);
+static void fa125ShadowWrite(int id, UINT32 *sreg, UINT32 val);
+static int  fa125ShadowIsDirty(int id, UINT32 *sreg);
+static int  fa125ShadowFlushLocked(int id);
+static int  fa125CheckPedCalc(const char *func, int id);
 
 /**
  * @defgroup Config Initialization/Configuration
@@ -129,6 +479,7 @@ int fa125BlockError=FA125_BLOCKERROR_NO_ERROR;       /* Whether (1) or not (0) B
 int
 fa125Init (UINT32 addr, UINT32 addr_inc, int nadc, int iFlag)
 {
+  FA125ACCT_ENTRY;
   int res=0;
   volatile unsigned int rdata=0;
   unsigned long laddr=0;
@@ -143,6 +494,10 @@ fa125Init (UINT32 addr, UINT32 addr_inc, int nadc, int iFlag)
 
   /* Initialize some global variables */
   nfa125=0;
+  /* No DMA of an earlier initialization is still in progress */
+  FA125LOCK;
+  fa125DmaAbandon();
+  FA125UNLOCK;
   memset((char *)fa125ID,0,sizeof(fa125ID));
   memset((char *)fa125dacOffset,0,sizeof(fa125dacOffset));
 
@@ -354,6 +709,13 @@ fa125Init (UINT32 addr, UINT32 addr_inc, int nadc, int iFlag)
 	}
     }
 
+  for(islot=0; islot<nfa125; islot++)
+    {
+      FA125SLOTLOCK(fa125ID[islot]);
+      fa125ShadowReadback(fa125ID[islot]);
+      FA125SLOTUNLOCK(fa125ID[islot]);
+    }
+
   if(noBoardInit)
     {
       if(nfa125>0)
@@ -426,8 +788,10 @@ fa125Init (UINT32 addr, UINT32 addr_inc, int nadc, int iFlag)
       if(!noBoardInit)
 	{
 	  vmeWrite32(&fa125p[fa125ID[ii]]->main.adr32, (a32addr>>16) | FA125_ADR32_ENABLE);  /* Write the register and enable */
-	  vmeWrite32(&fa125p[fa125ID[ii]]->main.ctrl1,
-			     vmeRead32(&fa125p[fa125ID[ii]]->main.ctrl1) | FA125_CTRL1_ENABLE_BERR);/* Enable Bus Error termination */
+	  FA125SLOTLOCK(fa125ID[ii]);
+	  FA125SWRITE(fa125ID[ii], main.ctrl1,
+		      FA125SREAD(fa125ID[ii], main.ctrl1) | FA125_CTRL1_ENABLE_BERR);/* Enable Bus Error termination */
+	  FA125SLOTUNLOCK(fa125ID[ii]);
 	}
 
     }
@@ -456,26 +820,36 @@ fa125Init (UINT32 addr, UINT32 addr_inc, int nadc, int iFlag)
       if(!noBoardInit)
 	{
 	  unsigned int ctrl1=0;
+	  FA125LOCK;
 	  for (ii=0;ii<nfa125;ii++)
 	    {
+	      FA125SLOTLOCK(fa125ID[ii]);
 	      /* Write to the register and enable */
 	      vmeWrite32(&fa125p[fa125ID[ii]]->main.adr_mb,
 			 (a32addr+FA125_MAX_A32MB_SIZE) | (a32addr>>16) | FA125_ADRMB_ENABLE);
-	      ctrl1 = vmeRead32(&fa125p[fa125ID[ii]]->main.ctrl1) &
+	      ctrl1 = FA125SREAD(fa125ID[ii], main.ctrl1) &
 		~(FA125_CTRL1_FIRST_BOARD | FA125_CTRL1_LAST_BOARD);
-	      vmeWrite32(&fa125p[fa125ID[ii]]->main.ctrl1,
-			 ctrl1 | FA125_CTRL1_ENABLE_MULTIBLOCK);
+	      FA125SWRITE(fa125ID[ii], main.ctrl1,
+			  ctrl1 | FA125_CTRL1_ENABLE_MULTIBLOCK);
+	      FA125SLOTUNLOCK(fa125ID[ii]);
 	    }
+	  FA125UNLOCK;
 	}
       /* Set First Board and Last Board */
       fa125MaxSlot = maxSlot;
       fa125MinSlot = minSlot;
       if(!noBoardInit)
 	{
-	  vmeWrite32(&fa125p[minSlot]->main.ctrl1,
-		     vmeRead32(&fa125p[minSlot]->main.ctrl1) | FA125_CTRL1_FIRST_BOARD);
-	  vmeWrite32(&fa125p[maxSlot]->main.ctrl1,
-		     vmeRead32(&fa125p[maxSlot]->main.ctrl1) | FA125_CTRL1_LAST_BOARD);
+	  FA125LOCK;
+	  FA125SLOTLOCK(minSlot);
+	  FA125SWRITE(minSlot, main.ctrl1,
+		      FA125SREAD(minSlot, main.ctrl1) | FA125_CTRL1_FIRST_BOARD);
+	  FA125SLOTUNLOCK(minSlot);
+	  FA125SLOTLOCK(maxSlot);
+	  FA125SWRITE(maxSlot, main.ctrl1,
+		      FA125SREAD(maxSlot, main.ctrl1) | FA125_CTRL1_LAST_BOARD);
+	  FA125SLOTUNLOCK(maxSlot);
+	  FA125UNLOCK;
 	}
     }
 
@@ -562,6 +936,7 @@ fa125Slot(unsigned int i)
 int
 fa125Status(int id, int pflag)
 {
+  FA125ACCT_ENTRY;
   struct fa125_a24_main m;
   struct fa125_a24_proc p;
   struct fa125_a24_fe   f[12];
@@ -581,7 +956,7 @@ fa125Status(int id, int pflag)
   if(pflag & FA125_STATUS_SHOWREGS)
     showregs=1;
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   m.id = vmeRead32(&fa125p[id]->main.id);
   m.swapctl = vmeRead32(&fa125p[id]->main.swapctl);
   m.version = vmeRead32(&fa125p[id]->main.version);
@@ -626,7 +1001,7 @@ fa125Status(int id, int pflag)
     {
       f[i].test  = vmeRead32(&fa125p[id]->fe[i].test);
     }
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   faBase  = (unsigned long) &fa125p[id]->main.id;
   a32Base = (m.adr32 & FA125_ADR32_BASE_MASK)<<16;
@@ -829,6 +1204,7 @@ fa125Status(int id, int pflag)
 void
 fa125GStatus(int pflag)
 {
+  FA125ACCT_ENTRY;
   int ifa, id;
   struct fa125_a24_main m[20];
   struct fa125_a24_proc p[20];
@@ -836,10 +1212,10 @@ fa125GStatus(int pflag)
   unsigned int a24addr[20];
   int th_check[20], sign[20];
 
-  FA125LOCK;
   for (ifa=0;ifa<nfa125;ifa++)
     {
       id = fa125Slot(ifa);
+      FA125SLOTLOCK(id);
       a24addr[id]    = (unsigned int)((unsigned long)fa125p[id] - fa125A24Offset);
 
       m[id].version     = vmeRead32(&fa125p[id]->main.version);
@@ -869,8 +1245,8 @@ fa125GStatus(int pflag)
       f[id].ie      = vmeRead32(&fa125p[id]->fe[0].ie);
       f[id].ped_sf  = vmeRead32(&fa125p[id]->fe[0].ped_sf);
       sign[id]      = (f[id].ped_sf & FA125_FE_PED_SF_PBIT_SIGN)?-1:1;
+      FA125SLOTUNLOCK(id);
     }
-  FA125UNLOCK;
 
   for (ifa=0;ifa<nfa125;ifa++)
     {
@@ -1108,59 +1484,19 @@ fa125GetModeNumber(char *mode)
   return ERROR;
 }
 
-/**
- *  @ingroup Config
- *  @brief Configure the processing type/mode
- *
- *  @param id Slot number
- *  @param pmode  Processing Mode
- *     -     3 - Pulse Integral and Time (CDC)
- *     -     4 - Pulse Integral and Time (FDC)
- *     -     5 - Peak Amplitude and Time (FDC_amp)
- *     -     6 - Pulse Samples (CDC_long)
- *     -     7 - Pulse Samples (FDC_long)
- *  @param  PL  Window Latency
- *  @param  NW  Window Width
- *  @param  IE  Integration End
- *  @param  PG  Pedestal Gap
- *  @param  NPK Number of pulses processed per window
- *  @param  P1  Parameter for initial pedestal window (NP = 2^P1)
- *  @param  P2  Parameter for local pedestal window (NP2 = 2^P2)
- *
- *     (1) NW > NP + NE
- *     (2) NW > NU
- *     (3) NU > 14
- *     (4) NE >= NU-PG-PED
- *     (5) NE >= 6
- *     (6) NPK > 0
- *     (7) NP >= NP2
- *     (8) NP2 > 0
- *     (9) H > TH > TL
- *    (10) PED > 4
- *    (11) PG > 0
- *    (12) PED+PG < NU
- *
- *  @return OK if successful, otherwise ERROR.
- */
-int
-fa125SetProcMode(int id, char *mode, unsigned int PL, unsigned int NW,
-		 unsigned int IE, unsigned int PG, unsigned int NPK,
-		 unsigned int P1, unsigned int P2)
+/* Check the processing mode parameters of fa125SetProcMode and
+   fa125ConfigApply.  PL, NW, IE, PG and NPK out of range are replaced by
+   their defaults.  Returns ERROR if the mode or the windows are invalid. */
+static int
+fa125CheckProcMode(const char *func, int pmode, unsigned int *pPL, unsigned int *pNW,
+		   unsigned int *pIE, unsigned int *pPG, unsigned int *pNPK,
+		   unsigned int P1, unsigned int P2)
 {
-  int imode=0, pmode=0, supported_modes[FA125_SUPPORTED_NMODES] = FA125_SUPPORTED_MODES;
+  int imode=0, supported_modes[FA125_SUPPORTED_NMODES] = FA125_SUPPORTED_MODES;
   int cdc_modes[FA125_CDC_NMODES] = FA125_CDC_MODES;
   int mode_supported=0, cdc_mode=0;
   int NE=20;
-
-  if(id==0) id=fa125ID[0];
-
-  if((id<0) || (id>21) || (fa125p[id] == NULL))
-    {
-      printf("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",__FUNCTION__,id);
-      return ERROR;
-    }
-
-  pmode = fa125GetModeNumber(mode);
+  unsigned int PL=*pPL, NW=*pNW, IE=*pIE, PG=*pPG, NPK=*pNPK;
 
   /* Check if mode is supported */
   for(imode=0; imode<FA125_SUPPORTED_NMODES; imode++)
@@ -1174,7 +1510,7 @@ fa125SetProcMode(int id, char *mode, unsigned int PL, unsigned int NW,
   if(!mode_supported)
     {
       printf("\n%s: ERROR: Processing Mode (%d) not supported\n\n",
-	     __FUNCTION__,pmode);
+	     func,pmode);
       return ERROR;
     }
 
@@ -1192,71 +1528,141 @@ fa125SetProcMode(int id, char *mode, unsigned int PL, unsigned int NW,
   if((PL==0) || (PL>FA125_MAX_PL))
     {
       printf("%s: WARN: Invalid PL (%d). Setting default (%d)\n",
-	     __FUNCTION__,PL,FA125_DEFAULT_PL);
+	     func,PL,FA125_DEFAULT_PL);
       PL  = FA125_DEFAULT_PL;
     }
   if((NW==0) || (NW>FA125_MAX_NW))
     {
       printf("%s: WARN: Invalid NW (%d). Setting default (%d)\n",
-	     __FUNCTION__,NW,FA125_DEFAULT_NW);
+	     func,NW,FA125_DEFAULT_NW);
       NW = FA125_DEFAULT_NW;
     }
   if((IE==0) || (IE>FA125_MAX_IE))
     {
       printf("%s: WARN: Invalid IE (%d). Setting default (%d)\n",
-	     __FUNCTION__,IE,FA125_DEFAULT_IE);
+	     func,IE,FA125_DEFAULT_IE);
       IE = FA125_DEFAULT_IE;
     }
   if((PG==0) || (PG>FA125_MAX_PG))
     {
       printf("%s: WARN: Invalid PG (%d). Setting default (%d)\n",
-	     __FUNCTION__,PG,FA125_DEFAULT_PG);
+	     func,PG,FA125_DEFAULT_PG);
       PG = FA125_DEFAULT_PG;
     }
   if((NPK==0) || (NPK>FA125_MAX_NPK))
     {
       printf("%s: WARN: Invalid NPK (%d). Setting default (%d)\n",
-	     __FUNCTION__,NPK,FA125_DEFAULT_NPK);
+	     func,NPK,FA125_DEFAULT_NPK);
       NPK = FA125_DEFAULT_NPK;
     }
   if(cdc_mode && (NPK!=1))
     {
       printf("%s: WARN: Invalid NPK (%d) for CDC mode. Setting to 1\n",
-	     __FUNCTION__,NPK);
+	     func,NPK);
       NPK=1;
     }
 
+  if((P1>FA125_MAX_P1) || (P2>FA125_MAX_P2))
+    {
+      printf("\n%s: ERROR: Invalid pedestal window (P1 = %d, P2 = %d)\n\n",
+	     func,P1,P2);
+      return ERROR;
+    }
 
-  if(NW <= ((2^P1) + NE))
+  /* NP = 2^P1 samples */
+  if(NW <= ((1<<P1) + NE))
     {
-      printf("\n%s: ERROR: Window must be > Initial Pedestal Window + NE (%d)\n\n",__FUNCTION__
-	     ,NE);
+      printf("\n%s: ERROR: Window must be > Initial Pedestal Window + NE (%d)\n\n",
+	     func,NE);
       return ERROR;
     }
 
   if(P1 < P2)
     {
       printf("\n%s: ERROR: Initial Pedestal Window Must be >= Local Pedestal Window\n\n",
-	     __FUNCTION__);
+	     func);
       return ERROR;
     }
 
+  *pPL  = PL;
+  *pNW  = NW;
+  *pIE  = IE;
+  *pPG  = PG;
+  *pNPK = NPK;
 
-  FA125LOCK;
+  return OK;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Configure the processing type/mode
+ *
+ *  @param id Slot number
+ *  @param pmode  Processing Mode
+ *     -     3 - Pulse Integral and Time (CDC)
+ *     -     4 - Pulse Integral and Time (FDC)
+ *     -     5 - Peak Amplitude and Time (FDC_amp)
+ *     -     6 - Pulse Samples (CDC_long)
+ *     -     7 - Pulse Samples (FDC_long)
+ *  @param  PL  Window Latency
+ *  @param  NW  Window Width
+ *  @param  IE  Integration End
+ *  @param  PG  Pedestal Gap
+ *  @param  NPK Number of pulses processed per window
+ *  @param  P1  Parameter for initial pedestal window (NP = 2^P1)
+ *  @param  P2  Parameter for local pedestal window (NP2 = 2^P2)
+ *
+ *     (1) NW > NP + NE
+ *     (2) NW > NU
+ *     (3) NU > 14
+ *     (4) NE >= NU-PG-PED
+ *     (5) NE >= 6
+ *     (6) NPK > 0
+ *     (7) NP >= NP2
+ *     (8) NP2 > 0
+ *     (9) H > TH > TL
+ *    (10) PED > 4
+ *    (11) PG > 0
+ *    (12) PED+PG < NU
+ *
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125SetProcMode(int id, char *mode, unsigned int PL, unsigned int NW,
+		 unsigned int IE, unsigned int PG, unsigned int NPK,
+		 unsigned int P1, unsigned int P2)
+{
+  FA125ACCT_ENTRY;
+  int pmode=0;
+
+  if(id==0) id=fa125ID[0];
+
+  if((id<0) || (id>21) || (fa125p[id] == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",__FUNCTION__,id);
+      return ERROR;
+    }
+
+  pmode = fa125GetModeNumber(mode);
+
+  if(fa125CheckProcMode(__FUNCTION__, pmode, &PL, &NW, &IE, &PG, &NPK, P1, P2) != OK)
+    return ERROR;
+
+  FA125SLOTLOCK(id);
   /* Disable ADC processing while writing window info */
-  vmeWrite32(&fa125p[id]->fe[0].config1, ((pmode-1) | (NPK<<4)));
-  vmeWrite32(&fa125p[id]->fe[0].pl, PL);
-  vmeWrite32(&fa125p[id]->fe[0].nw, NW);
-  vmeWrite32(&fa125p[id]->fe[0].ie, IE | (PG<<12));
-  vmeWrite32(&fa125p[id]->fe[0].ped_sf,
-	     (vmeRead32(&fa125p[id]->fe[0].ped_sf) &
-	      ~(FA125_FE_PED_SF_NP_MASK | FA125_FE_PED_SF_NP2_MASK)) |
-	     (P1 | (P2<<8)) );
+  FA125SWRITE(id, fe[0].config1, ((pmode-1) | (NPK<<4)));
+  FA125SWRITE(id, fe[0].pl, PL);
+  FA125SWRITE(id, fe[0].nw, NW);
+  FA125SWRITE(id, fe[0].ie, IE | (PG<<12));
+  FA125SWRITE(id, fe[0].ped_sf,
+	      (FA125SREAD(id, fe[0].ped_sf) &
+	       ~(FA125_FE_PED_SF_NP_MASK | FA125_FE_PED_SF_NP2_MASK)) |
+	      (P1 | (P2<<8)) );
 
   /* Enable ADC processing */
-  vmeWrite32(&fa125p[id]->fe[0].config1, ((pmode-1) | (NPK<<4) | FA125_FE_CONFIG1_ENABLE) );
+  FA125SWRITE(id, fe[0].config1, ((pmode-1) | (NPK<<4) | FA125_FE_CONFIG1_ENABLE) );
 
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
 
   return OK;
@@ -1270,13 +1676,16 @@ fa125SetProcMode(int id, char *mode, unsigned int PL, unsigned int NW,
  *  @param ABIT Amplitude Scale Factor
  *  @param PBIT Pedestal Scale Factor
  *  @return OK if successful, otherwise ERROR.
+ *     While writes are deferred, the firmware P2 + PBIT calculation is
+ *     checked by fa125ShadowFlush instead.
  */
 
 int
 fa125SetScaleFactors(int id, unsigned int IBIT, unsigned int ABIT, int PBIT)
 {
+  FA125ACCT_ENTRY;
   int rval=OK, pbit_sign_bit=0, p2=0;
-  unsigned int ped_sf=0, check=0, uint_PBIT=0;
+  unsigned int ped_sf=0, uint_PBIT=0;
   if(id==0) id=fa125ID[0];
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
@@ -1309,8 +1718,8 @@ fa125SetScaleFactors(int id, unsigned int IBIT, unsigned int ABIT, int PBIT)
   if(PBIT<0)
     pbit_sign_bit = 1;
 
-  FA125LOCK;
-  ped_sf = vmeRead32(&fa125p[id]->fe[0].ped_sf);
+  FA125SLOTLOCK(id);
+  ped_sf = FA125SREAD(id, fe[0].ped_sf);
   p2     = ((ped_sf & FA125_FE_PED_SF_NP2_MASK)>>8);
 
   if((p2 + PBIT) < 0)
@@ -1336,20 +1745,19 @@ fa125SetScaleFactors(int id, unsigned int IBIT, unsigned int ABIT, int PBIT)
 
   uint_PBIT = pbit_sign_bit ? (unsigned int)((-1) * PBIT) : PBIT;
 
-  vmeWrite32(&fa125p[id]->fe[0].ped_sf,
-	     (ped_sf &
-	      (FA125_FE_PED_SF_NP_MASK | FA125_FE_PED_SF_NP2_MASK)) |
-	     (IBIT<<16) | (ABIT<<19) | (uint_PBIT<<22) | (pbit_sign_bit<<25));
-  check = (vmeRead32(&fa125p[id]->fe[0].ped_sf) & FA125_FE_PED_SF_CALC_MASK) >> 26;
+  FA125SWRITE(id, fe[0].ped_sf,
+	      (ped_sf &
+	       (FA125_FE_PED_SF_NP_MASK | FA125_FE_PED_SF_NP2_MASK)) |
+	      (IBIT<<16) | (ABIT<<19) | (uint_PBIT<<22) | (pbit_sign_bit<<25));
 
-  if(check != (p2 + PBIT))
+  /* Firmware calculation can only be checked once the register is written.
+     While writes are deferred, fa125ShadowFlush checks it. */
+  if(!fa125ShadowDeferred[id])
     {
-      printf("%s: FIRMWARE ERROR:  P2 + PBIT  fw:  = %d    lib: %d\n",
-	     __FUNCTION__,check, p2 + PBIT);
-      printf("   register = 0x%08x\n",vmeRead32(&fa125p[id]->fe[0].ped_sf));
-      rval = ERROR;
+      if(fa125CheckPedCalc(__FUNCTION__, id) != OK)
+	rval = ERROR;
     }
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return rval;
 }
@@ -1363,6 +1771,7 @@ fa125SetScaleFactors(int id, unsigned int IBIT, unsigned int ABIT, int PBIT)
 int
 fa125GetIntegrationScaleFactor(int id)
 {
+  FA125ACCT_ENTRY;
   int rval=0;
   if(id==0) id=fa125ID[0];
 
@@ -1372,9 +1781,9 @@ fa125GetIntegrationScaleFactor(int id)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   rval = (vmeRead32(&fa125p[id]->fe[0].ped_sf) & FA125_FE_PED_SF_IBIT_MASK)>>16;
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return rval;
 }
@@ -1388,6 +1797,7 @@ fa125GetIntegrationScaleFactor(int id)
 int
 fa125GetAmplitudeScaleFactor(int id)
 {
+  FA125ACCT_ENTRY;
   int rval=0;
   if(id==0) id=fa125ID[0];
 
@@ -1397,9 +1807,9 @@ fa125GetAmplitudeScaleFactor(int id)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   rval = (vmeRead32(&fa125p[id]->fe[0].ped_sf) & FA125_FE_PED_SF_ABIT_MASK)>>19;
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return rval;
 }
@@ -1413,6 +1823,7 @@ fa125GetAmplitudeScaleFactor(int id)
 int
 fa125GetPedestalScaleFactor(int id)
 {
+  FA125ACCT_ENTRY;
   int rval=0, sign=1;
   unsigned int ped_sf=0;
   if(id==0) id=fa125ID[0];
@@ -1423,11 +1834,11 @@ fa125GetPedestalScaleFactor(int id)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   ped_sf = vmeRead32(&fa125p[id]->fe[0].ped_sf);
   sign   = (ped_sf & FA125_FE_PED_SF_PBIT_SIGN)?-1:1;
   rval   = sign * ((ped_sf & FA125_FE_PED_SF_PBIT_MASK)>>22);
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return rval;
 }
@@ -1445,6 +1856,7 @@ fa125GetPedestalScaleFactor(int id)
 int
 fa125SetTimingThreshold(int id, unsigned int chan, unsigned int lo, unsigned int hi)
 {
+  FA125ACCT_ENTRY;
   unsigned int wval = 0;
   if(id==0) id=fa125ID[0];
 
@@ -1475,46 +1887,41 @@ fa125SetTimingThreshold(int id, unsigned int chan, unsigned int lo, unsigned int
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   /* Write the lo value */
   if((chan%2)==0)
     {
-      wval = (vmeRead32(&fa125p[id]->fe[chan/6].timing_thres_lo[(chan/2)%3]) & 0xFFFF0000) |
+      wval = (FA125SREAD(id, fe[chan/6].timing_thres_lo[(chan/2)%3]) & 0xFFFF0000) |
 	(lo<<8);
-      vmeWrite32(&fa125p[id]->fe[chan/6].timing_thres_lo[(chan/2)%3],
-		 wval);
+      FA125SWRITE(id, fe[chan/6].timing_thres_lo[(chan/2)%3], wval);
     }
   else
     {
-      wval = (vmeRead32(&fa125p[id]->fe[chan/6].timing_thres_lo[(chan/2)%3]) & 0xFFFF) |
+      wval = (FA125SREAD(id, fe[chan/6].timing_thres_lo[(chan/2)%3]) & 0xFFFF) |
 	(lo<<24);
-      vmeWrite32(&fa125p[id]->fe[chan/6].timing_thres_lo[(chan/2)%3],
-		 wval);
+      FA125SWRITE(id, fe[chan/6].timing_thres_lo[(chan/2)%3], wval);
     }
 
   /* Write the hi value */
   if((chan%3)==0)
     {
-      wval = (vmeRead32(&fa125p[id]->fe[chan/6].timing_thres_hi[(chan/3)%2]) & 0x07fffe00) |
+      wval = (FA125SREAD(id, fe[chan/6].timing_thres_hi[(chan/3)%2]) & 0x07fffe00) |
 	(hi);
-      vmeWrite32(&fa125p[id]->fe[chan/6].timing_thres_hi[(chan/3)%2],
-		 wval);
+      FA125SWRITE(id, fe[chan/6].timing_thres_hi[(chan/3)%2], wval);
     }
   else if((chan%3)==1)
     {
-      wval = (vmeRead32(&fa125p[id]->fe[chan/6].timing_thres_hi[(chan/3)%2]) & 0x07fc01ff) |
+      wval = (FA125SREAD(id, fe[chan/6].timing_thres_hi[(chan/3)%2]) & 0x07fc01ff) |
 	(hi<<9);
-      vmeWrite32(&fa125p[id]->fe[chan/6].timing_thres_hi[(chan/3)%2],
-		 wval);
+      FA125SWRITE(id, fe[chan/6].timing_thres_hi[(chan/3)%2], wval);
     }
   else
     {
-      wval = (vmeRead32(&fa125p[id]->fe[chan/6].timing_thres_hi[(chan/3)%2]) & 0x0003ffff) |
+      wval = (FA125SREAD(id, fe[chan/6].timing_thres_hi[(chan/3)%2]) & 0x0003ffff) |
 	(hi<<18);
-      vmeWrite32(&fa125p[id]->fe[chan/6].timing_thres_hi[(chan/3)%2],
-		 wval);
+      FA125SWRITE(id, fe[chan/6].timing_thres_hi[(chan/3)%2], wval);
     }
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -1530,6 +1937,7 @@ fa125SetTimingThreshold(int id, unsigned int chan, unsigned int lo, unsigned int
 int
 fa125SetCommonTimingThreshold(int id, unsigned int lo, unsigned int hi)
 {
+  FA125ACCT_ENTRY;
   int chan=0;
   if(id==0) id=fa125ID[0];
 
@@ -1570,6 +1978,7 @@ fa125SetCommonTimingThreshold(int id, unsigned int lo, unsigned int hi)
 void
 fa125GSetCommonTimingThreshold(unsigned int lo, unsigned int hi)
 {
+  FA125ACCT_ENTRY;
   int id=0;
 
   for(id=0; id<nfa125; id++)
@@ -1589,6 +1998,7 @@ fa125GSetCommonTimingThreshold(unsigned int lo, unsigned int hi)
 int
 fa125GetTimingThreshold(int id, unsigned int chan, int *lo, int *hi)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
@@ -1604,7 +2014,7 @@ fa125GetTimingThreshold(int id, unsigned int chan, int *lo, int *hi)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   if((chan%2)==0)
     {
       *lo = (vmeRead32(&fa125p[id]->fe[chan/6].timing_thres_lo[(chan/2)%3]) &
@@ -1631,7 +2041,7 @@ fa125GetTimingThreshold(int id, unsigned int chan, int *lo, int *hi)
       *hi = (vmeRead32(&fa125p[id]->fe[chan/6].timing_thres_hi[(chan/3)%2]) &
 	    FA125_FE_TIMING_THRES_HI_MASK(chan))>>18;
     }
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -1639,6 +2049,7 @@ fa125GetTimingThreshold(int id, unsigned int chan, int *lo, int *hi)
 int
 fa125PrintTimingThresholds(int id)
 {
+  FA125ACCT_ENTRY;
   int ichan, rval, i, lo[FA125_MAX_ADC_CHANNELS], hi[FA125_MAX_ADC_CHANNELS];
   if(id==0) id=fa125ID[0];
 
@@ -1677,6 +2088,7 @@ fa125PrintTimingThresholds(int id)
 int
 fa125CheckThresholds(int id, int pflag)
 {
+  FA125ACCT_ENTRY;
   int rval=OK, ichan, tval, TL, TH, H;
   int header_printed=0;
   if(id==0) id=fa125ID[0];
@@ -1733,6 +2145,7 @@ fa125CheckThresholds(int id, int pflag)
 int
 fa125PowerOff (int id)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
@@ -1743,9 +2156,9 @@ fa125PowerOff (int id)
 
   printf("%s: Power Off for slot %d\n",__FUNCTION__,id);
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   vmeWrite32(&fa125p[id]->main.pwrctl, 0);
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -1759,6 +2172,7 @@ fa125PowerOff (int id)
 int
 fa125PowerOn (int id)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
@@ -1770,9 +2184,9 @@ fa125PowerOn (int id)
   printf("%s: Power On (0x%08x) for slot %d\n",__FUNCTION__,
 	 FA125_PWRCTL_KEY_ON,id);
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   vmeWrite32(&fa125p[id]->main.pwrctl, FA125_PWRCTL_KEY_ON);
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
 #ifdef VXWORKS
   taskDelay(18);
@@ -1780,9 +2194,26 @@ fa125PowerOn (int id)
   usleep(300000);         // delay 300 ms for stable power;
 #endif
 
+  /* Front end registers come up with their defaults */
+  FA125SLOTLOCK(id);
+  fa125ShadowReadback(id);
+  FA125SLOTUNLOCK(id);
+
   return OK;
 }
 
+/* DAC channel (LTC2620 chain position) of each ADC channel.
+   DAC channels 0-39 are on the ADACSI chain, 40-79 on the BDACSI chain. */
+static const int DAC_CHAN_OFFSET[72] =
+  {
+    34, 33, 32, 39, 38, 37, 36, 27, 26, 25, 24, 31,
+    74, 73, 72, 79, 78, 77, 76, 67, 66, 65, 64, 71,
+    30, 29, 28, 18, 17, 16, 23, 22, 21, 20, 10, 9,
+    70, 69, 68, 58, 57, 56, 63, 62, 61, 60, 50, 49,
+    8, 15, 14, 13, 12, 2, 1, 0, 7, 6, 5, 4,
+    48, 55, 54, 53, 52, 42, 41, 40, 47, 46, 45, 44
+  };
+
 /**
  *  @ingroup Config
  *  @brief Set DAC value of a specific channel
@@ -1826,7 +2257,7 @@ fa125SetLTC2620 (int id, int dacChan, int dacData)
       dmask=FA125_DACCTL_ADACSI_MASK;                      // this is the data bit mask
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   for(k=4;k>=0;k--)
     for(j=31;j>=0;j--)
       {
@@ -1836,7 +2267,7 @@ fa125SetLTC2620 (int id, int dacChan, int dacData)
       }
 
   vmeWrite32(&fa125p[id]->main.dacctl, 0);  // this deasserts CS, setting the DAC
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -1853,16 +2284,8 @@ fa125SetLTC2620 (int id, int dacChan, int dacData)
 int
 fa125SetOffset (int id, int chan, int dacData)
 {
+  FA125ACCT_ENTRY;
   int rval=0;
-  const int DAC_CHAN_OFFSET[72] =
-    {
-      34, 33, 32, 39, 38, 37, 36, 27, 26, 25, 24, 31,
-      74, 73, 72, 79, 78, 77, 76, 67, 66, 65, 64, 71,
-      30, 29, 28, 18, 17, 16, 23, 22, 21, 20, 10, 9,
-      70, 69, 68, 58, 57, 56, 63, 62, 61, 60, 50, 49,
-      8, 15, 14, 13, 12, 2, 1, 0, 7, 6, 5, 4,
-      48, 55, 54, 53, 52, 42, 41, 40, 47, 46, 45, 44
-    };
 
   if(id==0) id=fa125ID[0];
 
@@ -1886,19 +2309,23 @@ fa125SetOffset (int id, int chan, int dacData)
 
 /**
  *  @ingroup Config
- *  @brief Set the DAC offset for a specific fADC125 Channel from a specified file
+ *  @brief Set the DAC offsets of all channels of an fADC125.
+ *     Every 160 bit shift of the LTC2620 chains carries an update for each
+ *     of the 5 DACs in the chain, and both chains are shifted on the same
+ *     clock edges.  All 72 channels are set in 8 shifts, instead of one
+ *     shift per channel with fa125SetOffset.
  *  @param id Slot number
- *  @param filename Name of file from which to read DAC offsets
- *     Format must be of the type:
- *    dac0   dac1   dac2 ...  dac71
+ *  @param dacData Array of 72 DAC values, indexed by channel number
  *  @return OK if successful, otherwise ERROR.
  */
 int
-fa125SetOffsetFromFile(int id, char *filename)
+fa125SetOffsets(int id, unsigned int *dacData)
 {
-  FILE *fd_1;
-  int ichan;
-  int offset_control=0;
+  FA125ACCT_ENTRY;
+  UINT32 sdat[8][2][5];   /* [shift][chain][DAC in chain] */
+  int nupdate[10];        /* updates queued for each DAC */
+  int ichan, dacChan, idac, ishift, nshift=0, k, j;
+  UINT32 x;
 
   if(id==0) id=fa125ID[0];
 
@@ -1908,23 +2335,94 @@ fa125SetOffsetFromFile(int id, char *filename)
       return ERROR;
     }
 
-  if(filename == NULL)
+  if(dacData == NULL)
     {
-      printf("\n%s: ERROR: No file specified.\n\n",__FUNCTION__);
+      printf("\n%s: ERROR: Invalid DAC data\n\n",__FUNCTION__);
       return ERROR;
     }
 
-  fd_1 = fopen(filename,"r");
-  if(fd_1 > 0)
+  /* No-op everywhere, then one "write n, update all" per DAC per shift */
+  memset(sdat, 0xff, sizeof(sdat));
+  memset(nupdate, 0, sizeof(nupdate));
+  for(ichan=0; ichan<72; ichan++)
     {
-      printf("%s: Reading Data from file: %s\n",__FUNCTION__,filename);
-      for(ichan=0;ichan<72;ichan++)
-	{
-	  fscanf(fd_1,"%d",&offset_control);
-	  fa125SetOffset(id, ichan, offset_control);
-	}
+      dacChan = DAC_CHAN_OFFSET[ichan];
+      idac = dacChan/8;
+      ishift = nupdate[idac]++;
+      sdat[ishift][idac/5][idac%5] =
+	0x00200000 | ((dacChan%8) << 16) | (dacData[ichan] & 0x0000ffff);
+      if(ishift+1 > nshift)
+	nshift = ishift+1;
+    }
+
+  FA125SLOTLOCK(id);
+  for(ishift=0; ishift<nshift; ishift++)
+    {
+      for(k=4;k>=0;k--)
+	for(j=31;j>=0;j--)
+	  {
+	    x = FA125_DACCTL_DACCS_MASK |
+	      (((sdat[ishift][0][k]>>j)&1) ? FA125_DACCTL_ADACSI_MASK : 0) |
+	      (((sdat[ishift][1][k]>>j)&1) ? FA125_DACCTL_BDACSI_MASK : 0);
+	    vmeWrite32(&fa125p[id]->main.dacctl, x);
+	    vmeWrite32(&fa125p[id]->main.dacctl, x | FA125_DACCTL_DACSCLK_MASK);
+	  }
+
+      vmeWrite32(&fa125p[id]->main.dacctl, 0);  // this deasserts CS, setting the DACs
+    }
+  FA125SLOTUNLOCK(id);
+
+  for(ichan=0; ichan<72; ichan++)
+    fa125dacOffset[id][ichan] = dacData[ichan];
+
+  return OK;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Set the DAC offset for a specific fADC125 Channel from a specified file
+ *  @param id Slot number
+ *  @param filename Name of file from which to read DAC offsets
+ *     Format must be of the type:
+ *    dac0   dac1   dac2 ...  dac71
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125SetOffsetFromFile(int id, char *filename)
+{
+  FA125ACCT_ENTRY;
+  FILE *fd_1;
+  int ichan;
+  int offset_control=0;
+  unsigned int dacData[72];
+
+  if(id==0) id=fa125ID[0];
+
+  if((id<0) || (id>21) || (fa125p[id] == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",__FUNCTION__,id);
+      return ERROR;
+    }
+
+  if(filename == NULL)
+    {
+      printf("\n%s: ERROR: No file specified.\n\n",__FUNCTION__);
+      return ERROR;
+    }
+
+  fd_1 = fopen(filename,"r");
+  if(fd_1 > 0)
+    {
+      printf("%s: Reading Data from file: %s\n",__FUNCTION__,filename);
+      for(ichan=0;ichan<72;ichan++)
+	{
+	  fscanf(fd_1,"%d",&offset_control);
+	  dacData[ichan] = offset_control;
+	}
 
 	fclose(fd_1);
+
+	return fa125SetOffsets(id, dacData);
     }
   else
     {
@@ -2024,6 +2522,7 @@ fa125ReadOffsetToFile(int id, char *filename)
 int
 fa125SetThreshold(int id, unsigned short chan, unsigned short tvalue)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<=0) || (id>21) || (fa125p[id] == NULL))
@@ -2047,9 +2546,9 @@ fa125SetThreshold(int id, unsigned short chan, unsigned short tvalue)
     }
 
 
-  FA125LOCK;
-  vmeWrite32(&fa125p[id]->fe[chan/6].threshold[chan%6],tvalue);
-  FA125UNLOCK;
+  FA125SLOTLOCK(id);
+  FA125SWRITE(id, fe[chan/6].threshold[chan%6], tvalue);
+  FA125SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -2065,6 +2564,7 @@ fa125SetThreshold(int id, unsigned short chan, unsigned short tvalue)
 int
 fa125SetSelfTriggerThreshold(int id, unsigned short chan, unsigned short tvalue)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<=0) || (id>21) || (fa125p[id] == NULL))
@@ -2088,9 +2588,9 @@ fa125SetSelfTriggerThreshold(int id, unsigned short chan, unsigned short tvalue)
     }
 
 
-  FA125LOCK;
-  vmeWrite32(&fa125p[id]->fe[chan/6].selftrig_thres[chan%6],tvalue);
-  FA125UNLOCK;
+  FA125SLOTLOCK(id);
+  FA125SWRITE(id, fe[chan/6].selftrig_thres[chan%6], tvalue);
+  FA125SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -2105,6 +2605,7 @@ fa125SetSelfTriggerThreshold(int id, unsigned short chan, unsigned short tvalue)
 int
 fa125SetChannelDisable(int id, int channel)
 {
+  FA125ACCT_ENTRY;
   int feChip=0, feChan=0;
   unsigned int chipMask=0;
   if(id==0) id=fa125ID[0];
@@ -2126,11 +2627,11 @@ fa125SetChannelDisable(int id, int channel)
   feChip = (int)(channel/6);
   feChan = (int)(channel%6);
 
-  FA125LOCK;
-  chipMask = (vmeRead32(&fa125p[id]->fe[feChip].config2) & FA125_FE_CONFIG2_CH_MASK)
+  FA125SLOTLOCK(id);
+  chipMask = (FA125SREAD(id, fe[feChip].config2) & FA125_FE_CONFIG2_CH_MASK)
     | (1<<feChan);
-  vmeWrite32(&fa125p[id]->fe[feChip].config2,chipMask);
-  FA125UNLOCK;
+  FA125SWRITE(id, fe[feChip].config2, chipMask);
+  FA125SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -2148,6 +2649,7 @@ int
 fa125SetChannelDisableMask(int id, unsigned int cmask0,
 			   unsigned int cmask1, unsigned int cmask2)
 {
+  FA125ACCT_ENTRY;
   int ichip=0;
   unsigned int chipMask=0;
   if(id==0) id=fa125ID[0];
@@ -2168,23 +2670,23 @@ fa125SetChannelDisableMask(int id, unsigned int cmask0,
       return(ERROR);
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   for(ichip=0; ichip<4; ichip++)
     {
       chipMask = (cmask0>>(ichip*6)) & FA125_FE_CONFIG2_CH_MASK;
-      vmeWrite32(&fa125p[id]->fe[ichip].config2,chipMask);
+      FA125SWRITE(id, fe[ichip].config2, chipMask);
     }
   for(ichip=4; ichip<8; ichip++)
     {
       chipMask = (cmask1>>((ichip-4)*6)) & FA125_FE_CONFIG2_CH_MASK;
-      vmeWrite32(&fa125p[id]->fe[ichip].config2,chipMask);
+      FA125SWRITE(id, fe[ichip].config2, chipMask);
     }
   for(ichip=8; ichip<12; ichip++)
     {
       chipMask = (cmask2>>((ichip-8)*6)) & FA125_FE_CONFIG2_CH_MASK;
-      vmeWrite32(&fa125p[id]->fe[ichip].config2,chipMask);
+      FA125SWRITE(id, fe[ichip].config2, chipMask);
     }
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2199,6 +2701,7 @@ fa125SetChannelDisableMask(int id, unsigned int cmask0,
 int
 fa125SetChannelEnable(int id, int channel)
 {
+  FA125ACCT_ENTRY;
   int feChip=0, feChan=0;
   unsigned int chipMask=0;
   if(id==0) id=fa125ID[0];
@@ -2220,12 +2723,12 @@ fa125SetChannelEnable(int id, int channel)
   feChip = (int)(channel/6);
   feChan = (int)(channel%6);
 
-  FA125LOCK;
-  chipMask = (vmeRead32(&fa125p[id]->fe[feChip].config2) & FA125_FE_CONFIG2_CH_MASK)
+  FA125SLOTLOCK(id);
+  chipMask = (FA125SREAD(id, fe[feChip].config2) & FA125_FE_CONFIG2_CH_MASK)
     & ~(1<<feChan);
 
-  vmeWrite32(&fa125p[id]->fe[feChip].config2,chipMask);
-  FA125UNLOCK;
+  FA125SWRITE(id, fe[feChip].config2, chipMask);
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2243,6 +2746,7 @@ int
 fa125SetChannelEnableMask(int id, unsigned int cmask0,
 			  unsigned int cmask1, unsigned int cmask2)
 {
+  FA125ACCT_ENTRY;
   int ichip=0;
   unsigned int chipMask=0;
   if(id==0) id=fa125ID[0];
@@ -2267,23 +2771,23 @@ fa125SetChannelEnableMask(int id, unsigned int cmask0,
   cmask1 = (~cmask1) & 0xFFFFFF;
   cmask2 = (~cmask2) & 0xFFFFFF;
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   for(ichip=0; ichip<4; ichip++)
     {
       chipMask = (cmask0>>(ichip*6)) & FA125_FE_CONFIG2_CH_MASK;
-      vmeWrite32(&fa125p[id]->fe[ichip].config2,chipMask);
+      FA125SWRITE(id, fe[ichip].config2, chipMask);
     }
   for(ichip=4; ichip<8; ichip++)
     {
       chipMask = (cmask1>>((ichip-4)*6)) & FA125_FE_CONFIG2_CH_MASK;
-      vmeWrite32(&fa125p[id]->fe[ichip].config2,chipMask);
+      FA125SWRITE(id, fe[ichip].config2, chipMask);
     }
   for(ichip=8; ichip<12; ichip++)
     {
       chipMask = (cmask2>>((ichip-8)*6)) & FA125_FE_CONFIG2_CH_MASK;
-      vmeWrite32(&fa125p[id]->fe[ichip].config2,chipMask);
+      FA125SWRITE(id, fe[ichip].config2, chipMask);
     }
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2298,6 +2802,7 @@ fa125SetChannelEnableMask(int id, unsigned int cmask0,
 int
 fa125SetCommonThreshold(int id, unsigned short tvalue)
 {
+  FA125ACCT_ENTRY;
   int ii,rval=OK;
 
   for(ii=0;ii<FA125_MAX_ADC_CHANNELS;ii++)
@@ -2316,6 +2821,7 @@ fa125SetCommonThreshold(int id, unsigned short tvalue)
 void
 fa125GSetCommonThreshold(unsigned short tvalue)
 {
+  FA125ACCT_ENTRY;
   int ii;
 
   for (ii=0;ii<nfa125;ii++)
@@ -2333,11 +2839,12 @@ fa125GSetCommonThreshold(unsigned short tvalue)
 int
 fa125GetThreshold(int id, int chan)
 {
+  FA125ACCT_ENTRY;
   int rval=0;
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   rval = vmeRead32(&fa125p[id]->fe[chan/6].threshold[chan%6]) & FA125_FE_THRESHOLD_MASK;
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return rval;
 }
@@ -2351,6 +2858,7 @@ fa125GetThreshold(int id, int chan)
 int
 fa125PrintThreshold(int id)
 {
+  FA125ACCT_ENTRY;
   int ii;
   unsigned short tval[FA125_MAX_ADC_CHANNELS];
 
@@ -2362,12 +2870,12 @@ fa125PrintThreshold(int id)
       return(ERROR);
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   for(ii=0;ii<FA125_MAX_ADC_CHANNELS;ii++)
     {
       tval[ii] = vmeRead32(&fa125p[id]->fe[ii/6].threshold[ii%6]);
     }
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
 
   printf(" Threshold Settings for FA125 in slot %d:",id);
@@ -2397,6 +2905,7 @@ fa125PrintThreshold(int id)
 int
 fa125SetPulserAmplitude (int id, int chan, int dacData)
 {
+  FA125ACCT_ENTRY;
   int rval=0;
   const int DAC_CHAN_PULSER[3]={35, 19, 11};
 
@@ -2428,6 +2937,7 @@ fa125SetPulserAmplitude (int id, int chan, int dacData)
 int
 fa125PrintTemps(int id)
 {
+  FA125ACCT_ENTRY;
   double temp1=0, temp2=0;
   if(id==0) id=fa125ID[0];
 
@@ -2437,10 +2947,10 @@ fa125PrintTemps(int id)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   temp1 = 0.0625*((int) vmeRead32(&fa125p[id]->main.temperature[0]));
   temp2 = 0.0625*((int) vmeRead32(&fa125p[id]->main.temperature[1]));
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   printf("%s: Main board temperature: %5.2lf \tMezzanine board temperature: %5.2lf\n",
 	 __FUNCTION__,
@@ -2463,6 +2973,7 @@ fa125PrintTemps(int id)
 int
 fa125SetClockSource(int id, int clksrc)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
@@ -2494,9 +3005,9 @@ fa125SetClockSource(int id, int clksrc)
       break;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   vmeWrite32(&fa125p[id]->main.clock, clksrc);
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2515,6 +3026,7 @@ fa125SetClockSource(int id, int clksrc)
 int
 fa125SetTriggerSource(int id, int trigsrc)
 {
+  FA125ACCT_ENTRY;
   unsigned int regset=0;
   if(id==0) id=fa125ID[0];
 
@@ -2551,9 +3063,9 @@ fa125SetTriggerSource(int id, int trigsrc)
       break;
     }
 
-  FA125LOCK;
-  vmeWrite32(&fa125p[id]->proc.trigsrc, regset);
-  FA125UNLOCK;
+  FA125SLOTLOCK(id);
+  FA125SWRITE(id, proc.trigsrc, regset);
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2572,6 +3084,7 @@ fa125SetTriggerSource(int id, int trigsrc)
 int
 fa125GetTriggerSource(int id)
 {
+  FA125ACCT_ENTRY;
   int rval=0;
   if(id==0) id=fa125ID[0];
 
@@ -2581,9 +3094,9 @@ fa125GetTriggerSource(int id)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   rval = vmeRead32(&fa125p[id]->proc.trigsrc);
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return rval;
 }
@@ -2600,6 +3113,7 @@ fa125GetTriggerSource(int id)
 int
 fa125SetSyncResetSource(int id, int srsrc)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
@@ -2619,12 +3133,12 @@ fa125SetSyncResetSource(int id, int srsrc)
     printf("\n%s: WARN: VME SyncReset Source no longer supported. Setting to VXS.\n\n",
 	   __FUNCTION__);
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   /* Enable */
-  vmeWrite32(&fa125p[id]->fe[0].test,
-	     (vmeRead32(&fa125p[id]->fe[0].test) & ~FA125_FE_TEST_SYNCRESET_ENABLE) |
-	     FA125_FE_TEST_SYNCRESET_ENABLE);
-  FA125UNLOCK;
+  FA125SWRITE(id, fe[0].test,
+	      (FA125SREAD(id, fe[0].test) & ~FA125_FE_TEST_SYNCRESET_ENABLE) |
+	      FA125_FE_TEST_SYNCRESET_ENABLE);
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2643,6 +3157,7 @@ fa125SetSyncResetSource(int id, int srsrc)
 int
 fa125Poll(int id)
 {
+  FA125ACCT_ENTRY;
   int res;
   int rval=0;
   static int nzero=0;
@@ -2651,12 +3166,12 @@ fa125Poll(int id)
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
     {
-      logMsg("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",
-	     __FUNCTION__,id,3,4,5,6);
+      FA125LOGMSG("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",
+		  __FUNCTION__,id,3,4,5,6);
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
 #ifdef VXWORKS
   res = vxMemProbe((char *) &(fa125p[id]->proc.csr),VX_READ,4,(char *)&rval);
 #else
@@ -2665,7 +3180,7 @@ fa125Poll(int id)
   rval = LSWAP(rval);
 #endif //DOBYTESWAP
 #endif
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   /* Sometimes get 0xffffffff.  This is accompanied with a bus error. */
   if(res==ERROR)
@@ -2719,6 +3234,7 @@ fa125GetBerrCount()
 int
 fa125Clear(int id)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
@@ -2727,10 +3243,10 @@ fa125Clear(int id)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   vmeWrite32(&fa125p[id]->proc.csr, FA125_PROC_CSR_CLEAR);
   vmeWrite32(&fa125p[id]->proc.csr, 0);
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2744,6 +3260,7 @@ fa125Clear(int id)
 int
 fa125Enable(int id)
 {
+  FA125ACCT_ENTRY;
   int ife=0;
   if(id==0) id=fa125ID[0];
 
@@ -2753,14 +3270,14 @@ fa125Enable(int id)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   for(ife=0; ife<12; ife++)
     {
-      vmeWrite32(&fa125p[id]->fe[ife].test,
-		 (vmeRead32(&fa125p[id]->fe[ife].test) & ~FA125_FE_TEST_COLLECT_ON) |
+      FA125SWRITE(id, fe[ife].test,
+		  (FA125SREAD(id, fe[ife].test) & ~FA125_FE_TEST_COLLECT_ON) |
 		  FA125_FE_TEST_COLLECT_ON);
     }
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   printf("%s(%2d): ENABLED\n",__FUNCTION__,id);
 
@@ -2776,6 +3293,7 @@ fa125Enable(int id)
 int
 fa125Disable(int id)
 {
+  FA125ACCT_ENTRY;
   int ife=0;
   if(id==0) id=fa125ID[0];
 
@@ -2785,13 +3303,13 @@ fa125Disable(int id)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   for(ife=0; ife<12; ife++)
     {
-      vmeWrite32(&fa125p[id]->fe[ife].test,
-		 (vmeRead32(&fa125p[id]->fe[ife].test) & ~FA125_FE_TEST_COLLECT_ON));
+      FA125SWRITE(id, fe[ife].test,
+		  (FA125SREAD(id, fe[ife].test) & ~FA125_FE_TEST_COLLECT_ON));
     }
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   printf("%s(%2d): DISABLED\n",__FUNCTION__,id);
 
@@ -2810,6 +3328,7 @@ fa125Disable(int id)
 int
 fa125Reset(int id, int reset)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
@@ -2818,7 +3337,15 @@ fa125Reset(int id, int reset)
       return ERROR;
     }
 
+  /* Blocks owed to fa125ReadCrate, and a DMA from the module, are cleared
+     with the module */
   FA125LOCK;
+  fa125ReadoutOwed[id] = 0;
+  if(fa125DmaPending && ((fa125DmaID == id) || (fa125DmaMode == 2)))
+    fa125DmaAbandon();
+  FA125UNLOCK;
+
+  FA125SLOTLOCK(id);
   switch(reset)
     {
     case 0:
@@ -2835,7 +3362,11 @@ fa125Reset(int id, int reset)
       vmeWrite32(&fa125p[id]->main.blockCSR, FA125_BLOCKCSR_PULSE_SOFT_RESET);
     }
   vmeWrite32(&fa125p[id]->main.blockCSR, 0);
-  FA125UNLOCK;
+
+  /* Register values are back to their defaults */
+  if(reset==1)
+    fa125ShadowReadback(id);
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2849,6 +3380,7 @@ fa125Reset(int id, int reset)
 int
 fa125ResetCounters(int id)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
@@ -2857,15 +3389,311 @@ fa125ResetCounters(int id)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   vmeWrite32(&fa125p[id]->proc.trig_count,FA125_PROC_TRIGCOUNT_RESET);
   vmeWrite32(&fa125p[id]->proc.clock125_count,FA125_PROC_CLOCK125COUNT_RESET);
   vmeWrite32(&fa125p[id]->proc.sync_count,FA125_PROC_SYNCCOUNT_RESET);
   vmeWrite32(&fa125p[id]->proc.trig2_count,FA125_PROC_TRIG2COUNT_RESET);
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
+  return OK;
+}
+
+/* Map the shadow to the registers of module id, and fill it from them.
+   Any writes waiting for a flush are dropped.  Call with FA125SLOTLOCK(id) held. */
+static void
+fa125ShadowReadback(int id)
+{
+  UINT32 *sbase = (UINT32 *)&fa125Shadow[id];
+  unsigned int iw;
+  int ife, ii;
+
+#define FA125SMAP(_reg) \
+  fa125ShadowReg[id][&fa125Shadow[id]._reg - sbase] = &fa125p[id]->_reg
+
+  FA125SMAP(main.ctrl1);
+  for(ife=0; ife<12; ife++)
+    {
+      FA125SMAP(fe[ife].nw);
+      FA125SMAP(fe[ife].pl);
+      for(ii=0; ii<6; ii++)
+	{
+	  FA125SMAP(fe[ife].threshold[ii]);
+	  FA125SMAP(fe[ife].selftrig_thres[ii]);
+	}
+      FA125SMAP(fe[ife].config2);
+      FA125SMAP(fe[ife].test);
+      FA125SMAP(fe[ife].ped_sf);
+      for(ii=0; ii<3; ii++)
+	FA125SMAP(fe[ife].timing_thres_lo[ii]);
+      FA125SMAP(fe[ife].ie);
+      for(ii=0; ii<2; ii++)
+	FA125SMAP(fe[ife].timing_thres_hi[ii]);
+      FA125SMAP(fe[ife].config1);
+    }
+  FA125SMAP(proc.trigsrc);
+  FA125SMAP(proc.ctrl2);
+  FA125SMAP(proc.blocklevel);
+  FA125SMAP(proc.pulser_trig_delay);
+  FA125SMAP(proc.ntrig_busy);
+#undef FA125SMAP
+
+  for(iw=0; iw<FA125_SHADOW_NWORDS; iw++)
+    sbase[iw] = vmeRead32(fa125ShadowReg[id][iw]);
+
+  memset(fa125ShadowDirty[id], 0, sizeof(fa125ShadowDirty[id]));
+}
+
+/* Set a shadowed register.  The register is written only if the value
+   changes, and not until a flush if writes are deferred.
+   Call with FA125SLOTLOCK(id) held. */
+static void
+fa125ShadowWrite(int id, UINT32 *sreg, UINT32 val)
+{
+  int iw = sreg - (UINT32 *)&fa125Shadow[id];
+
+  if(*sreg == val)
+    return;
+
+  *sreg = val;
+  if(fa125ShadowDeferred[id])
+    fa125ShadowDirty[id][iw/32] |= (1u<<(iw%32));
+  else
+    vmeWrite32(fa125ShadowReg[id][iw], val);
+}
+
+/* Whether a shadowed register is waiting for a flush */
+static int
+fa125ShadowIsDirty(int id, UINT32 *sreg)
+{
+  int iw = sreg - (UINT32 *)&fa125Shadow[id];
+
+  return (fa125ShadowDirty[id][iw/32] >> (iw%32)) & 1;
+}
+
+/* Compare the firmware's P2 + PBIT calculation in the ped_sf register of
+   module id with the library's.  Call with FA125SLOTLOCK(id) held. */
+static int
+fa125CheckPedCalc(const char *func, int id)
+{
+  UINT32 ped_sf = FA125SREAD(id, fe[0].ped_sf);
+  int p2, pbit, check;
+
+  p2   = (ped_sf & FA125_FE_PED_SF_NP2_MASK) >> 8;
+  pbit = (ped_sf & FA125_FE_PED_SF_PBIT_MASK) >> 22;
+  if(ped_sf & FA125_FE_PED_SF_PBIT_SIGN)
+    pbit = -pbit;
+
+  check = (vmeRead32(&fa125p[id]->fe[0].ped_sf) & FA125_FE_PED_SF_CALC_MASK) >> 26;
+  if(check != (p2 + pbit))
+    {
+      printf("%s: FIRMWARE ERROR:  P2 + PBIT  fw:  = %d    lib: %d\n",
+	     func, check, p2 + pbit);
+      printf("   register = 0x%08x\n",vmeRead32(&fa125p[id]->fe[0].ped_sf));
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/* Write the deferred registers of module id.  Return the number of writes,
+   or ERROR if the firmware P2 + PBIT calculation does not match.
+   Call with FA125SLOTLOCK(id) held. */
+static int
+fa125ShadowFlushLocked(int id)
+{
+  UINT32 *sbase = (UINT32 *)&fa125Shadow[id];
+  unsigned int iw;
+  int ife, nwrite=0, ped_dirty;
+
+  ped_dirty = FA125SDIRTY(id, fe[0].ped_sf);
+
+  /* Hold off processing while the mode or window registers change, as
+     fa125SetProcMode does.  config1 is rewritten last in each front end. */
+  for(ife=0; ife<12; ife++)
+    {
+      if(!FA125SDIRTY(id, fe[ife].config1) && !FA125SDIRTY(id, fe[ife].pl) &&
+	 !FA125SDIRTY(id, fe[ife].nw) && !FA125SDIRTY(id, fe[ife].ie) &&
+	 !FA125SDIRTY(id, fe[ife].ped_sf))
+	continue;
+
+      iw = &fa125Shadow[id].fe[ife].config1 - sbase;
+      vmeWrite32(fa125ShadowReg[id][iw], sbase[iw] & ~FA125_FE_CONFIG1_ENABLE);
+      fa125ShadowDirty[id][iw/32] |= (1u<<(iw%32));
+      nwrite++;
+    }
+
+  for(iw=0; iw<FA125_SHADOW_NWORDS; iw++)
+    {
+      if((fa125ShadowDirty[id][iw/32] & (1u<<(iw%32))) == 0)
+	continue;
+
+      vmeWrite32(fa125ShadowReg[id][iw], sbase[iw]);
+      nwrite++;
+    }
+
+  memset(fa125ShadowDirty[id], 0, sizeof(fa125ShadowDirty[id]));
+
+  if(ped_dirty && (fa125CheckPedCalc(__FUNCTION__, id) != OK))
+    return ERROR;
+
+  return nwrite;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Refill the library's image of the configuration registers from
+ *     the module.  Needed only if the registers were changed outside of
+ *     this library.  Writes waiting for fa125ShadowFlush are dropped.
+ *  @param id Slot number
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125ShadowSync(int id)
+{
+  FA125ACCT_ENTRY;
+  if(id==0) id=fa125ID[0];
+
+  if((id<0) || (id>21) || (fa125p[id] == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",__FUNCTION__,id);
+      return ERROR;
+    }
+
+  FA125SLOTLOCK(id);
+  fa125ShadowReadback(id);
+  FA125SLOTUNLOCK(id);
+
   return OK;
 }
 
+/**
+ *  @ingroup Config
+ *  @brief Enable/Disable deferred writes of configuration registers.
+ *     While deferred, the configuration routines only update the library's
+ *     image of the registers.  The changed registers are written by
+ *     fa125ShadowFlush, or when deferral is disabled.
+ *  @param id Slot number
+ *  @param enable
+ *     - 0: Write registers as they are set
+ *     - 1: Defer writes until fa125ShadowFlush
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125ShadowDefer(int id, int enable)
+{
+  FA125ACCT_ENTRY;
+  int rval=OK;
+  if(id==0) id=fa125ID[0];
+
+  if((id<0) || (id>21) || (fa125p[id] == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",__FUNCTION__,id);
+      return ERROR;
+    }
+
+  FA125SLOTLOCK(id);
+  if(!enable)
+    {
+      if(fa125ShadowFlushLocked(id) == ERROR)
+	rval = ERROR;
+    }
+  fa125ShadowDeferred[id] = enable ? 1 : 0;
+  FA125SLOTUNLOCK(id);
+
+  return rval;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Enable/Disable deferred writes of configuration registers
+ *     for all initialized modules.
+ *  @param enable
+ *     - 0: Write registers as they are set
+ *     - 1: Defer writes until fa125GShadowFlush
+ *  @sa fa125ShadowDefer
+ */
+void
+fa125GShadowDefer(int enable)
+{
+  FA125ACCT_ENTRY;
+  int ii;
+
+  for(ii=0; ii<nfa125; ii++)
+    fa125ShadowDefer(fa125ID[ii], enable);
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Write the configuration registers changed while writes were deferred.
+ *     If the scale factors were changed, the firmware P2 + PBIT calculation
+ *     is checked after they are written.
+ *  @param id Slot number
+ *  @return Number of register writes if successful, otherwise ERROR.
+ */
+int
+fa125ShadowFlush(int id)
+{
+  FA125ACCT_ENTRY;
+  int rval=0;
+  if(id==0) id=fa125ID[0];
+
+  if((id<0) || (id>21) || (fa125p[id] == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",__FUNCTION__,id);
+      return ERROR;
+    }
+
+  FA125SLOTLOCK(id);
+  rval = fa125ShadowFlushLocked(id);
+  FA125SLOTUNLOCK(id);
+
+  return rval;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Write the configuration registers changed while writes were
+ *     deferred, for all initialized modules.
+ *  @return Number of register writes if successful, otherwise ERROR.
+ */
+int
+fa125GShadowFlush()
+{
+  FA125ACCT_ENTRY;
+  int ii, nwrite, rval=0, err=0;
+
+  for(ii=0; ii<nfa125; ii++)
+    {
+      FA125SLOTLOCK(fa125ID[ii]);
+      nwrite = fa125ShadowFlushLocked(fa125ID[ii]);
+      FA125SLOTUNLOCK(fa125ID[ii]);
+
+      if(nwrite == ERROR)
+	err = 1;
+      else
+	rval += nwrite;
+    }
+
+  return err ? ERROR : rval;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Select the locking of module registers.
+ *     By default each module has its own lock, and only the DMA and
+ *     Multiblock token operations take the crate lock.  With the global lock,
+ *     every operation takes the crate lock, as in earlier versions of the
+ *     library.  Call only while no other thread is using the library.
+ *  @param enable
+ *      -  0: Lock of each module
+ *      - !0: Crate lock for all
+ */
+void
+fa125SetGlobalLock(int enable)
+{
+  fa125GlobalLock = (enable) ? 1 : 0;
+}
+
 /**
  *  @ingroup Config
  *  @brief Returns the token to the first module
@@ -2876,18 +3704,21 @@ fa125ResetCounters(int id)
 int
 fa125ResetToken(int id)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
     {
-      logMsg("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",__FUNCTION__,id,3,4,5,6);
+      FA125LOGMSG("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",__FUNCTION__,id,3,4,5,6);
       return ERROR;
     }
 
+  FA125TRACE_BEGIN(FA125_TRACE_RESET_TOKEN, id);
   FA125LOCK;
   vmeWrite32(&fa125p[id]->main.blockCSR, FA125_BLOCKCSR_TAKE_TOKEN);
   vmeWrite32(&fa125p[id]->main.blockCSR, 0);
   FA125UNLOCK;
+  FA125TRACE_END(FA125_TRACE_RESET_TOKEN, id);
 
   return OK;
 }
@@ -2900,6 +3731,7 @@ fa125ResetToken(int id)
 int
 fa125GetTokenMask()
 {
+  FA125ACCT_ENTRY;
   unsigned int rmask=0;
   int ifa=0, id=0, rval=0;
 
@@ -2923,6 +3755,7 @@ fa125GetTokenMask()
 unsigned int
 fa125GetTokenStatus(int pflag)
 {
+  FA125ACCT_ENTRY;
   unsigned int rval = 0;
   int ifa = 0;
 
@@ -2957,6 +3790,7 @@ fa125GetTokenStatus(int pflag)
 int
 fa125SetBlocklevel(int id, int blocklevel)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
@@ -2965,9 +3799,9 @@ fa125SetBlocklevel(int id, int blocklevel)
       return ERROR;
     }
 
-  FA125LOCK;
-  vmeWrite32(&fa125p[id]->proc.blocklevel, blocklevel);
-  FA125UNLOCK;
+  FA125SLOTLOCK(id);
+  FA125SWRITE(id, proc.blocklevel, blocklevel);
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -2983,6 +3817,7 @@ fa125SetBlocklevel(int id, int blocklevel)
 int
 fa125SetNTrigBusy(int id, int ntrig)
 {
+  FA125ACCT_ENTRY;
   unsigned int rval = 0;
   if(id==0) id=fa125ID[0];
 
@@ -3000,10 +3835,10 @@ fa125SetNTrigBusy(int id, int ntrig)
       return ERROR;
     }
 
-  FA125LOCK;
-  rval = vmeRead32(&fa125p[id]->proc.ntrig_busy) & ~FA125_NTRIG_BUSY_MASK;
-  vmeWrite32(&fa125p[id]->proc.ntrig_busy, ntrig | rval);
-  FA125UNLOCK;
+  FA125SLOTLOCK(id);
+  rval = FA125SREAD(id, proc.ntrig_busy) & ~FA125_NTRIG_BUSY_MASK;
+  FA125SWRITE(id, proc.ntrig_busy, ntrig | rval);
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3018,6 +3853,7 @@ fa125SetNTrigBusy(int id, int ntrig)
 int
 fa125GSetNTrigBusy(int ntrig)
 {
+  FA125ACCT_ENTRY;
   int id=0;
   unsigned int rval = 0;
   if((ntrig<0) || (ntrig>0xff))
@@ -3027,13 +3863,13 @@ fa125GSetNTrigBusy(int ntrig)
       return ERROR;
     }
 
-  FA125LOCK;
   for(id=0; id<nfa125; id++)
     {
-      rval = vmeRead32(&fa125p[id]->proc.ntrig_busy) & ~FA125_NTRIG_BUSY_MASK;
-      vmeWrite32(&fa125p[id]->proc.ntrig_busy, ntrig | rval);
+      FA125SLOTLOCK(fa125ID[id]);
+      rval = FA125SREAD(fa125ID[id], proc.ntrig_busy) & ~FA125_NTRIG_BUSY_MASK;
+      FA125SWRITE(fa125ID[id], proc.ntrig_busy, ntrig | rval);
+      FA125SLOTUNLOCK(fa125ID[id]);
     }
-  FA125UNLOCK;
 
   return OK;
 }
@@ -3048,6 +3884,7 @@ fa125GSetNTrigBusy(int ntrig)
 int
 fa125GetNTrigBusy(int id)
 {
+  FA125ACCT_ENTRY;
   int rval=0;
   if(id==0) id=fa125ID[0];
 
@@ -3058,9 +3895,9 @@ fa125GetNTrigBusy(int id)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   rval = vmeRead32(&fa125p[id]->proc.ntrig_busy) & FA125_NTRIG_BUSY_MASK;
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return rval;
 }
@@ -3076,6 +3913,7 @@ fa125GetNTrigBusy(int id)
 int
 fa125SetNTrigStop(int id, int ntrig)
 {
+  FA125ACCT_ENTRY;
   unsigned int rval = 0;
   if(id==0) id=fa125ID[0];
 
@@ -3093,10 +3931,10 @@ fa125SetNTrigStop(int id, int ntrig)
       return ERROR;
     }
 
-  FA125LOCK;
-  rval = vmeRead32(&fa125p[id]->proc.ntrig_busy) & ~FA125_NTRIG_STOP_MASK;
-  vmeWrite32(&fa125p[id]->proc.ntrig_busy, (ntrig << 8) | rval);
-  FA125UNLOCK;
+  FA125SLOTLOCK(id);
+  rval = FA125SREAD(id, proc.ntrig_busy) & ~FA125_NTRIG_STOP_MASK;
+  FA125SWRITE(id, proc.ntrig_busy, (ntrig << 8) | rval);
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3110,6 +3948,7 @@ fa125SetNTrigStop(int id, int ntrig)
 int
 fa125GSetNTrigStop(int ntrig)
 {
+  FA125ACCT_ENTRY;
   int id=0;
   unsigned int rval = 0;
   if((ntrig<0) || (ntrig>0xff))
@@ -3119,13 +3958,13 @@ fa125GSetNTrigStop(int ntrig)
       return ERROR;
     }
 
-  FA125LOCK;
   for(id=0; id<nfa125; id++)
     {
-      rval = vmeRead32(&fa125p[id]->proc.ntrig_busy) & ~FA125_NTRIG_STOP_MASK;
-      vmeWrite32(&fa125p[id]->proc.ntrig_busy, (ntrig << 8) | rval);
+      FA125SLOTLOCK(fa125ID[id]);
+      rval = FA125SREAD(fa125ID[id], proc.ntrig_busy) & ~FA125_NTRIG_STOP_MASK;
+      FA125SWRITE(fa125ID[id], proc.ntrig_busy, (ntrig << 8) | rval);
+      FA125SLOTUNLOCK(fa125ID[id]);
     }
-  FA125UNLOCK;
 
   return OK;
 }
@@ -3139,6 +3978,7 @@ fa125GSetNTrigStop(int ntrig)
 int
 fa125GetNTrigStop(int id)
 {
+  FA125ACCT_ENTRY;
   int rval=0;
   if(id==0) id=fa125ID[0];
 
@@ -3149,9 +3989,9 @@ fa125GetNTrigStop(int id)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   rval = (vmeRead32(&fa125p[id]->proc.ntrig_busy) & FA125_NTRIG_STOP_MASK) >> 8;
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return rval;
 }
@@ -3166,6 +4006,7 @@ fa125GetNTrigStop(int id)
 int
 fa125SoftTrigger(int id)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<0) || (id>21) || (fa125p[id] == NULL))
@@ -3174,10 +4015,10 @@ fa125SoftTrigger(int id)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   vmeWrite32(&fa125p[id]->proc.softtrig, 1);
   vmeWrite32(&fa125p[id]->proc.softtrig, 0);
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3192,6 +4033,7 @@ fa125SoftTrigger(int id)
 int
 fa125SetPulserTriggerDelay(int id, int delay)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<=0) || (id>21) || (fa125p[id] == NULL))
@@ -3207,11 +4049,11 @@ fa125SetPulserTriggerDelay(int id, int delay)
       return ERROR;
     }
 
-  FA125LOCK;
-  vmeWrite32(&fa125p[id]->proc.pulser_trig_delay,
-	     (vmeRead32(&fa125p[id]->proc.pulser_trig_delay) &~ FA125_PROC_PULSER_TRIG_DELAY_MASK)
+  FA125SLOTLOCK(id);
+  FA125SWRITE(id, proc.pulser_trig_delay,
+	      (FA125SREAD(id, proc.pulser_trig_delay) &~ FA125_PROC_PULSER_TRIG_DELAY_MASK)
 	      | delay);
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3226,6 +4068,7 @@ fa125SetPulserTriggerDelay(int id, int delay)
 int
 fa125SetPulserWidth(int id, int width)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<=0) || (id>21) || (fa125p[id] == NULL))
@@ -3241,11 +4084,11 @@ fa125SetPulserWidth(int id, int width)
       return ERROR;
     }
 
-  FA125LOCK;
-  vmeWrite32(&fa125p[id]->proc.pulser_trig_delay,
-	     (vmeRead32(&fa125p[id]->proc.pulser_trig_delay) &~ FA125_PROC_PULSER_WIDTH_MASK)
-	     | (width<<12));
-  FA125UNLOCK;
+  FA125SLOTLOCK(id);
+  FA125SWRITE(id, proc.pulser_trig_delay,
+	      (FA125SREAD(id, proc.pulser_trig_delay) &~ FA125_PROC_PULSER_WIDTH_MASK)
+	      | (width<<12));
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3265,6 +4108,7 @@ fa125SetPulserWidth(int id, int width)
 int
 fa125SoftPulser(int id, int output)
 {
+  FA125ACCT_ENTRY;
   unsigned int selection=0;
   if(id==0) id=fa125ID[0];
 
@@ -3296,9 +4140,9 @@ fa125SoftPulser(int id, int output)
     }
 
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   vmeWrite32(&fa125p[id]->proc.pulser_control, selection);
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3319,6 +4163,7 @@ fa125SoftPulser(int id, int output)
 int
 fa125SetPPG(int id, int fe_chip, unsigned short *sdata, int nsamples)
 {
+  FA125ACCT_ENTRY;
   int ii;
   unsigned short rval;
 
@@ -3343,7 +4188,7 @@ fa125SetPPG(int id, int fe_chip, unsigned short *sdata, int nsamples)
       nsamples = FA125_PPG_MAX_SAMPLES;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   for(ii=0;ii<(nsamples-2);ii++)
     {
       vmeWrite32(&fa125p[id]->fe[fe_chip].test_waveform,
@@ -3370,7 +4215,7 @@ fa125SetPPG(int id, int fe_chip, unsigned short *sdata, int nsamples)
     logMsg("\nfaSetPPG(%d): ERROR: Write error (%d) %x != %x\n\n",fe_chip,nsamples-1,
 	   rval, sdata[nsamples-1],5,6);
 
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   return(OK);
 }
@@ -3385,6 +4230,7 @@ fa125SetPPG(int id, int fe_chip, unsigned short *sdata, int nsamples)
 int
 fa125PPGEnable(int id)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<=0) || (id>21) || (fa125p[id] == NULL))
@@ -3393,10 +4239,10 @@ fa125PPGEnable(int id)
       return ERROR;
     }
 
-  FA125LOCK;
-  vmeWrite32(&fa125p[id]->fe[0].config1,
-	     vmeRead32(&fa125p[id]->fe[0].config1) | FA125_FE_CONFIG1_PLAYBACK_ENABLE);
-  FA125UNLOCK;
+  FA125SLOTLOCK(id);
+  FA125SWRITE(id, fe[0].config1,
+	      FA125SREAD(id, fe[0].config1) | FA125_FE_CONFIG1_PLAYBACK_ENABLE);
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3411,6 +4257,7 @@ fa125PPGEnable(int id)
 int
 fa125PPGDisable(int id)
 {
+  FA125ACCT_ENTRY;
   if(id==0) id=fa125ID[0];
 
   if((id<=0) || (id>21) || (fa125p[id] == NULL))
@@ -3419,10 +4266,10 @@ fa125PPGDisable(int id)
       return ERROR;
     }
 
-  FA125LOCK;
-  vmeWrite32(&fa125p[id]->fe[0].config1,
-	     vmeRead32(&fa125p[id]->fe[0].config1) & ~FA125_FE_CONFIG1_PLAYBACK_ENABLE);
-  FA125UNLOCK;
+  FA125SLOTLOCK(id);
+  FA125SWRITE(id, fe[0].config1,
+	      FA125SREAD(id, fe[0].config1) & ~FA125_FE_CONFIG1_PLAYBACK_ENABLE);
+  FA125SLOTUNLOCK(id);
 
   return OK;
 }
@@ -3436,18 +4283,23 @@ fa125PPGDisable(int id)
 int
 fa125Bready(int id)
 {
+  FA125ACCT_ENTRY;
   int rval=0;
   if(id==0) id=fa125ID[0];
 
   if((id<=0) || (id>21) || (fa125p[id] == NULL))
     {
-      logMsg("\nfa125Bready: ERROR : FA125 in slot %d is not initialized \n\n",id,0,0,0,0,0);
+      FA125LOGMSG("\nfa125Bready: ERROR : FA125 in slot %d is not initialized \n\n",id,0,0,0,0,0);
       return(ERROR);
     }
 
-  FA125LOCK;
+  FA125TRACE_BEGIN(FA125_TRACE_BREADY, id);
+  FA125SLOTLOCK(id);
   rval = (vmeRead32(&fa125p[id]->main.blockCSR) & FA125_BLOCKCSR_BLOCK_READY)>>2;
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
+  FA125STAT(id, bready_polls, 1);
+  FA125STAT(id, bready, rval);
+  FA125TRACE_END(FA125_TRACE_BREADY, rval);
 
   return rval;
 }
@@ -3460,21 +4312,26 @@ fa125Bready(int id)
 unsigned int
 fa125GBready()
 {
+  FA125ACCT_ENTRY;
   int ii, id, stat=0;
   unsigned int dmask=0;
 
-  FA125LOCK;
+  FA125TRACE_BEGIN(FA125_TRACE_BREADY, 0);
   for(ii=0;ii<nfa125;ii++)
     {
       id = fa125ID[ii];
 
+      FA125SLOTLOCK(id);
       stat = (vmeRead32(&fa125p[id]->main.blockCSR) & FA125_BLOCKCSR_BLOCK_READY)>>2;
+      FA125SLOTUNLOCK(id);
+      FA125STAT(id, bready_polls, 1);
+      FA125STAT(id, bready, stat);
 /*       printf("%s(%2d): main.blockCSR = 0x%08x\n", */
 /* 	     __FUNCTION__,id, fa125p[id]->main.blockCSR); */
       if(stat)
 	dmask |= (1<<id);
     }
-  FA125UNLOCK;
+  FA125TRACE_END(FA125_TRACE_BREADY, dmask);
 
   return(dmask);
 }
@@ -3489,12 +4346,13 @@ fa125GBready()
 unsigned int
 fa125GBlockReady(unsigned int slotmask, int nloop)
 {
+  FA125ACCT_ENTRY;
   int iloop, id, stat=0;
   unsigned int scanmask = 0, dmask=0;
 
   scanmask = fa125ScanMask();
 
-  FA125LOCK;
+  FA125TRACE_BEGIN(FA125_TRACE_BREADY, slotmask);
   for(iloop = 0; iloop < nloop; iloop++)
     { /* Loop for user specified number of times */
 
@@ -3504,25 +4362,267 @@ fa125GBlockReady(unsigned int slotmask, int nloop)
 	      && (slotmask & (1<<id))   /* slot used */
 	      && (!(dmask & (1<<id))) ) /* No block ready yet. */
 	    {
+	      FA125SLOTLOCK(id);
 	      stat = (vmeRead32(&fa125p[id]->main.blockCSR)
 		      & FA125_BLOCKCSR_BLOCK_READY)>>2;
+	      FA125SLOTUNLOCK(id);
+	      FA125STAT(id, bready_polls, 1);
+	      FA125STAT(id, bready, stat);
 
 	      if(stat)
 		dmask |= (1<<id);
 
 	      if(dmask == slotmask)
 		{ /* Blockready mask matches user slotmask */
-		  FA125UNLOCK;
+		  FA125TRACE_END(FA125_TRACE_BREADY, dmask);
 		  return(dmask);
 		}
 	    }
 	}
     }
-  FA125UNLOCK;
+  FA125TRACE_END(FA125_TRACE_BREADY, dmask);
 
   return(dmask);
 }
 
+/**
+ *  @ingroup Readout
+ *  @brief Set the time fa125WaitBlockReady polls without pause, before it
+ *     backs off.
+ *  @param ns Spin time in nanoseconds.  0 to calibrate it from the time to
+ *     ready histogram (90% of the blocks), between 1 and 100 usec.
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125SetWaitSpin(int ns)
+{
+  if(ns < 0)
+    {
+      printf("\n%s: ERROR: Invalid spin time (%d)\n\n", __FUNCTION__, ns);
+      return ERROR;
+    }
+
+  FA125LOCK;
+  fa125WaitSpinFixed = ns;
+  if(ns)
+    fa125WaitSpin = ns;
+  FA125UNLOCK;
+
+  return OK;
+}
+
+/* Set the spin time from the 90% point of the time to ready of all
+   modules.  Must be called with FA125LOCK held. */
+static void
+fa125WaitCalibrate()
+{
+  unsigned long long total = 0, sum = 0;
+  int ifa, ibin;
+
+  for(ifa = 0; ifa < nfa125; ifa++)
+    for(ibin = 0; ibin < FA125_READY_NBINS; ibin++)
+      total += fa125ReadyHist[fa125ID[ifa]][ibin];
+
+  for(ibin = 0; ibin < FA125_READY_NBINS; ibin++)
+    {
+      for(ifa = 0; ifa < nfa125; ifa++)
+	sum += fa125ReadyHist[fa125ID[ifa]][ibin];
+      if(10 * sum >= 9 * total)
+	break;
+    }
+
+  /* Upper edge of the bin */
+  fa125WaitSpin = (ibin < 30) ? (2 << ibin) : FA125_WAIT_SPIN_MAX;
+  if(fa125WaitSpin < FA125_WAIT_SPIN_MIN)
+    fa125WaitSpin = FA125_WAIT_SPIN_MIN;
+  if(fa125WaitSpin > FA125_WAIT_SPIN_MAX)
+    fa125WaitSpin = FA125_WAIT_SPIN_MAX;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Wait for a block ready from the modules in slotmask.
+ *
+ *     The modules are polled without pause for the spin time
+ *     (fa125SetWaitSpin), then with pauses that double from 1 usec up to
+ *     1 msec, until all are ready or the timeout passes.  The time each
+ *     module took to be ready, from the call, is added to its histogram
+ *     (fa125PrintReadyHistogram).
+ *
+ *  @param slotmask   Modules to wait for
+ *  @param timeout_ns Timeout in nanoseconds
+ *  @param first      If not NULL, the modules that were ready at the first poll
+ *  @return Block ready mask of the modules in slotmask
+ */
+unsigned int
+fa125WaitBlockReady(unsigned int slotmask, long long timeout_ns, unsigned int *first)
+{
+  FA125ACCT_ENTRY;
+  long long t0, now, spin_end, deadline, when[FA125_MAX_BOARDS+1];
+  unsigned int dmask = 0, pending;
+  int id, stat, npoll = 0, ibin;
+  struct timespec pause;
+  long pause_ns = FA125_WAIT_PAUSE_MIN;
+
+  slotmask &= fa125ScanMask();
+  FA125TRACE_BEGIN(FA125_TRACE_WAIT_READY, slotmask);
+  t0 = fa125ReadoutNsec();
+  spin_end = t0 + fa125WaitSpin;
+  deadline = t0 + timeout_ns;
+
+  while(1)
+    {
+      now = fa125ReadoutNsec();
+      pending = slotmask & ~dmask;
+      for(id = 2; id < 21; id++)
+	{
+	  if(!(pending & (1<<id)))
+	    continue;
+
+	  FA125SLOTLOCK(id);
+	  stat = (vmeRead32(&fa125p[id]->main.blockCSR) & FA125_BLOCKCSR_BLOCK_READY)>>2;
+	  FA125SLOTUNLOCK(id);
+	  FA125STAT(id, bready_polls, 1);
+	  if(stat)
+	    {
+	      FA125STAT(id, bready, 1);
+	      dmask |= (1<<id);
+	      when[id] = now - t0;
+	    }
+	}
+
+      if(npoll++ == 0)
+	{
+	  if(first)
+	    *first = dmask;
+	}
+
+      if((dmask == slotmask) || (now >= deadline))
+	break;
+
+      if(now >= spin_end)
+	{ /* Back off */
+	  pause.tv_sec  = 0;
+	  pause.tv_nsec = pause_ns;
+	  nanosleep(&pause, NULL);
+	  if(pause_ns < FA125_WAIT_PAUSE_MAX)
+	    pause_ns <<= 1;
+	}
+    }
+
+  FA125LOCK;
+  for(id = 2; id < 21; id++)
+    {
+      if(!(slotmask & (1<<id)))
+	continue;
+      if(dmask & (1<<id))
+	{
+	  for(ibin = 0; (ibin < FA125_READY_NBINS - 1) && (when[id] >= (2LL << ibin)); ibin++)
+	    ;
+	  fa125ReadyHist[id][ibin]++;
+	}
+      else
+	{
+	  fa125ReadyTimeout[id]++;
+	  FA125STAT(id, timeouts, 1);
+	}
+    }
+  fa125WaitCount++;
+  fa125WaitPolls += npoll;
+  if(!fa125WaitSpinFixed && ((fa125WaitCount % FA125_WAIT_CALIBRATE) == 0))
+    fa125WaitCalibrate();
+  FA125UNLOCK;
+  FA125TRACE_END(FA125_TRACE_WAIT_READY, dmask);
+
+  return dmask;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Return the time to ready histogram of a module
+ *  @param id Slot number
+ *  @param hist Destination of the FA125_READY_NBINS bins.  Bin 0 counts
+ *     blocks ready within 2 ns, bin N within [2^N, 2^(N+1)) ns.  The last
+ *     bin holds everything longer.
+ *  @param timeouts If not NULL, the number of waits that timed out
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125GetReadyHistogram(int id, unsigned int *hist, unsigned int *timeouts)
+{
+  if(id==0) id=fa125ID[0];
+
+  if((id<=0) || (id>21) || (fa125p[id] == NULL) || (hist == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized\n\n",__FUNCTION__,id);
+      return ERROR;
+    }
+
+  FA125LOCK;
+  memcpy(hist, fa125ReadyHist[id], sizeof(fa125ReadyHist[id]));
+  if(timeouts)
+    *timeouts = fa125ReadyTimeout[id];
+  FA125UNLOCK;
+
+  return OK;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Print the time to ready histogram of all initialized modules, as
+ *     counts in bins of doubling width, and optionally clear them.
+ *  @param rflag If 1, clear the histograms after printing
+ */
+void
+fa125PrintReadyHistogram(int rflag)
+{
+  int ifa, id, ibin, lo = FA125_READY_NBINS, hi = 0;
+
+  FA125LOCK;
+  for(ifa = 0; ifa < nfa125; ifa++)
+    for(ibin = 0; ibin < FA125_READY_NBINS; ibin++)
+      if(fa125ReadyHist[fa125ID[ifa]][ibin])
+	{
+	  if(ibin < lo) lo = ibin;
+	  if(ibin > hi) hi = ibin;
+	}
+
+  printf("\nFA125 time to block ready (%llu waits, %.1f polls/wait, spin %d ns)\n",
+	 fa125WaitCount, fa125WaitCount ? (double)fa125WaitPolls / fa125WaitCount : 0.,
+	 fa125WaitSpin);
+  printf("   < ns  ");
+  for(ifa = 0; ifa < nfa125; ifa++)
+    printf("  Slot %2d", fa125ID[ifa]);
+  printf("\n");
+
+  for(ibin = lo; ibin <= hi; ibin++)
+    {
+      if(ibin == FA125_READY_NBINS - 1)
+	printf("   more  ");
+      else
+	printf("%8lld ", 2LL << ibin);
+      for(ifa = 0; ifa < nfa125; ifa++)
+	printf(" %8u", fa125ReadyHist[fa125ID[ifa]][ibin]);
+      printf("\n");
+    }
+  printf("timeout  ");
+  for(ifa = 0; ifa < nfa125; ifa++)
+    printf(" %8u", fa125ReadyTimeout[fa125ID[ifa]]);
+  printf("\n\n");
+
+  if(rflag)
+    {
+      for(ifa = 0; ifa < nfa125; ifa++)
+	{
+	  id = fa125ID[ifa];
+	  memset(fa125ReadyHist[id], 0, sizeof(fa125ReadyHist[id]));
+	  fa125ReadyTimeout[id] = 0;
+	}
+      fa125WaitCount = fa125WaitPolls = 0;
+    }
+  FA125UNLOCK;
+}
+
 
 
 /**
@@ -3550,7 +4650,8 @@ const char *fa125_blockerror_names[FA125_BLOCKERROR_NTYPES] =
     "Termination on word count",
     "Unknown Bus Error",
     "Zero Word Count",
-    "DmaDone(..) Error"
+    "DmaDone(..) Error",
+    "Timeout waiting for DMA completion"
   };
 
 /**
@@ -3576,6 +4677,169 @@ fa125ReadBlockStatus(int pflag)
 }
 
 
+/* Index the blocks of a DMA readout, for fa125ReadBlockIndex.
+   Must be called with FA125LOCK held. */
+static void
+fa125ReadBlockIndexBuild(volatile UINT32 *data, int nwords)
+{
+#ifdef VXWORKS
+  fa125BlockIndexN = fa125IndexBlocks(data, nwords, 0,
+				      fa125BlockIndex, FA125_MAX_BOARDS+1);
+#else
+  fa125BlockIndexN = fa125IndexBlocks(data, nwords, 1,
+				      fa125BlockIndex, FA125_MAX_BOARDS+1);
+#endif
+  if(fa125BlockIndexN > FA125_MAX_BOARDS+1)
+    fa125BlockIndexN = FA125_MAX_BOARDS+1;
+  else if(fa125BlockIndexN < 0)
+    {
+      FA125LOGMSG("fa125ReadBlock: ERROR: Block headers and trailers do not match\n",
+		  0,0,0,0,0,0);
+      fa125BlockIndexN = 0;
+    }
+}
+
+/* Count the blocks and words of a DMA readout on their modules: from the
+   block index if it was built, otherwise on the module addressed.
+   Must be called with FA125LOCK held, after fa125ReadBlockResult. */
+static void
+fa125ReadBlockCount(int nwords)
+{
+  int iblk;
+
+  if(nwords <= 0)
+    return;
+
+  if(fa125BlockIndexN > 0)
+    {
+      for(iblk = 0; iblk < fa125BlockIndexN; iblk++)
+	{
+	  FA125STAT(fa125BlockIndex[iblk].slot, blocks, 1);
+	  FA125STAT(fa125BlockIndex[iblk].slot, words, fa125BlockIndex[iblk].length);
+	}
+    }
+  else
+    {
+      FA125STAT(fa125DmaID, blocks, 1);
+      FA125STAT(fa125DmaID, words, nwords);
+    }
+}
+
+/* Classify the result of vmeDmaDone for the DMA in progress and set
+   fa125BlockError.  Must be called with FA125LOCK held.
+   Returns the number of words in the destination buffer. */
+static int
+fa125ReadBlockResult(int retVal)
+{
+  int stat, xferCount;
+  int id = fa125DmaID, rmode = fa125DmaMode, nwrds = fa125DmaNwrds, dummy = fa125DmaDummy;
+  unsigned int csr;
+
+  fa125DmaPending = 0;
+  fa125BlockIndexN = 0;
+  FA125STAT(id, ndma, 1);
+  FA125STAT(id, dma_ns, fa125ReadoutNsec() - fa125DmaStart);
+
+  if(retVal > 0)
+    {
+      /* Check to see that Bus error was generated by FA125 */
+      if(rmode == 2)
+	{
+	  csr = vmeRead32(&fa125p[fa125MaxSlot]->main.blockCSR);  /* from Last FA125 */
+	  stat = (csr)&FA125_BLOCKCSR_BERR_ASSERTED;  /* from Last FA125 */
+	}
+      else
+	{
+	  csr = vmeRead32(&fa125p[id]->main.blockCSR);  /* from Last FA125 */
+	  stat = (csr)&FA125_BLOCKCSR_BERR_ASSERTED;  /* from Last FA125 */
+	}
+#ifdef VXWORKS
+      xferCount = (nwrds - (retVal>>2) + dummy);  /* Number of Longwords transfered */
+#else
+      xferCount = ((retVal>>2) + dummy);  /* Number of Longwords transfered */
+#endif
+#ifndef VXWORKS
+      if(!stat && ((retVal>>2) == nwrds))
+	{ /* jvme returns the byte count also when terminated by word count */
+	  FA125LOGMSG("fa125ReadBlock: WARN: DMA transfer terminated by word count 0x%x\n",nwrds,0,0,0,0,0);
+	  fa125BlockError=FA125_BLOCKERROR_TERM_ON_WORDCOUNT;
+	  FA125STAT(id, zero_count, 1);
+	}
+      else
+#endif
+      if(!stat)
+	{
+	  FA125LOGMSG("fa125ReadBlock: DMA transfer terminated by unknown BUS Error (csr=0x%x xferCount=%d id=%d)\n",
+		      csr,xferCount,id,0,0,0);
+	  fa125BlockError=FA125_BLOCKERROR_UNKNOWN_BUS_ERROR;
+	  FA125STAT(id, unknown_berr, 1);
+	}
+      else
+	FA125STAT(id, berr, 1);
+
+      if(fa125DmaIndex)
+	fa125ReadBlockIndexBuild(fa125DmaData, xferCount);
+
+      return(xferCount); /* Return number of data words transfered */
+    }
+#ifndef VXWORKS
+  else if((retVal == 0) &&
+	  (vmeRead32(&fa125p[(rmode == 2) ? fa125MaxSlot : id]->main.blockCSR) &
+	   FA125_BLOCKCSR_BERR_ASSERTED))
+    { /* Bus Error on the first word: nothing was left to read */
+      FA125STAT(id, berr, 1);
+      return(dummy);
+    }
+#endif
+  else if (retVal == 0)
+    { /* Block Error finished without Bus Error */
+      FA125STAT(id, zero_count, 1);
+#ifdef VXWORKS
+      FA125LOGMSG("fa125ReadBlock: WARN: DMA transfer terminated by word count 0x%x\n",nwrds,0,0,0,0,0);
+      fa125BlockError=FA125_BLOCKERROR_TERM_ON_WORDCOUNT;
+#else
+      FA125LOGMSG("fa125ReadBlock: WARN: DMA transfer returned zero word count 0x%x\n",nwrds,0,0,0,0,0);
+      fa125BlockError=FA125_BLOCKERROR_ZERO_WORD_COUNT;
+#endif
+      return(nwrds);
+    }
+  else
+    {  /* Error in DMA */
+#ifdef VXWORKS
+      FA125LOGMSG("\nfa125ReadBlock: ERROR: sysVmeDmaDone returned an Error\n\n",0,0,0,0,0,0);
+#else
+      FA125LOGMSG("\nfa125ReadBlock: ERROR: vmeDmaDone returned an Error\n\n",0,0,0,0,0,0);
+#endif
+      fa125BlockError=FA125_BLOCKERROR_DMADONE_ERROR;
+      FA125STAT(id, dma_errors, 1);
+      return(retVal>>2);
+    }
+}
+
+/* Readout with rflag 0x20: programmed I/O if the recent blocks of the module
+   were shorter than the crossover of fa125DmaCalibrate, otherwise DMA. */
+static int
+fa125ReadBlockAuto(int id, volatile UINT32 *data, int nwrds, int rflag)
+{
+  int nw, expect;
+
+  if(id==0) id=fa125ID[0];
+
+  if((id<=0) || (id>21) || (fa125p[id] == NULL))
+    return fa125ReadBlock(id, data, nwrds, rflag);
+
+  expect = fa125ReadAutoWords[id];
+  if(((rflag & 0x0f) == 1) && !(rflag & 0xc0) &&
+     (expect > 0) && (expect < fa125DmaCal.crossover))
+    rflag &= ~0x0f;
+
+  nw = fa125ReadBlock(id, data, nwrds, rflag);
+  if(nw > 0)
+    fa125ReadAutoWords[id] = expect ? (3 * expect + nw + 2) / 4 : nw;
+
+  return nw;
+}
+
 /**
  *  @ingroup Readout
  *  @brief General Data readout routine
@@ -3590,31 +4854,42 @@ fa125ReadBlockStatus(int pflag)
  *                    (DMA VME transfer Mode must be setup prior)
  *              2 - Multiblock DMA transfer (Multiblock must be enabled
  *                     and daisychain in place or SD being used)
+ *           0x80 - Asynchronous DMA (with 1 or 2).  Return after the DMA is
+ *                     started.  Complete with fa125ReadBlockComplete.
+ *           0x40 - Index the blocks of the DMA (with 1 or 2), for
+ *                     fa125ReadBlockIndex.
+ *           0x20 - Choose programmed I/O or DMA (with 1): blocks of the
+ *                     module shorter than the crossover of fa125DmaCalibrate
+ *                     (fa125SetReadCrossover) are read by programmed I/O.
  * </pre>
  *  @return Number of words inserted into data if successful.  Otherwise ERROR.
  */
 int
 fa125ReadBlock(int id, volatile UINT32 *data, int nwrds, int rflag)
 {
+  FA125ACCT_ENTRY;
   int ii;
-  int stat, retVal, xferCount, rmode, async;
+  int retVal, xferCount, rmode, async;
   int dCnt, berr=0;
   int dummy=0;
   volatile unsigned int *laddr;
   unsigned int bhead, ehead, val;
-  unsigned int vmeAdr, csr;
+  unsigned int vmeAdr;
+
+  if(rflag & 0x20)
+    return fa125ReadBlockAuto(id, data, nwrds, rflag & ~0x20);
 
   if(id==0) id=fa125ID[0];
 
   if((id<=0) || (id>21) || (fa125p[id] == NULL))
     {
-      logMsg("\nfa125ReadBlock: ERROR : FA125 in slot %d is not initialized\n\n",id,0,0,0,0,0);
+      FA125LOGMSG("\nfa125ReadBlock: ERROR : FA125 in slot %d is not initialized\n\n",id,0,0,0,0,0);
       return(ERROR);
     }
 
   if(data==NULL)
     {
-      logMsg("\nfa125ReadBlock: ERROR: Invalid Destination address\n\n",0,0,0,0,0,0);
+      FA125LOGMSG("\nfa125ReadBlock: ERROR: Invalid Destination address\n\n",0,0,0,0,0,0);
       return(ERROR);
     }
 
@@ -3648,11 +4923,18 @@ fa125ReadBlock(int id, volatile UINT32 *data, int nwrds, int rflag)
 	}
 
       FA125LOCK;
+      if(fa125DmaPending)
+	{
+	  FA125LOGMSG("\nfa125ReadBlock: ERROR: DMA already in progress\n\n",0,0,0,0,0,0);
+	  FA125UNLOCK;
+	  return(ERROR);
+	}
+
       if(rmode == 2)
 	{ /* Multiblock Mode */
 	  if((vmeRead32(&fa125p[id]->main.ctrl1)&FA125_CTRL1_FIRST_BOARD)==0)
 	    {
-	      logMsg("\nfa125ReadBlock: ERROR: FA125 in slot %d is not First Board\n\n",id,0,0,0,0,0);
+	      FA125LOGMSG("\nfa125ReadBlock: ERROR: FA125 in slot %d is not First Board\n\n",id,0,0,0,0,0);
 	      FA125UNLOCK;
 	      return(ERROR);
 	    }
@@ -3662,18 +4944,30 @@ fa125ReadBlock(int id, volatile UINT32 *data, int nwrds, int rflag)
 	{
 	  vmeAdr = (unsigned int)((unsigned long)fa125pd[id] - fa125A32Offset);
 	}
+      FA125TRACE_BEGIN(FA125_TRACE_DMA_SEND, id);
 #ifdef VXWORKS
       retVal = sysVmeDmaSend((UINT32)laddr, vmeAdr, (nwrds<<2), 0);
 #else
       retVal = vmeDmaSend((unsigned long)laddr, vmeAdr, (nwrds<<2));
 #endif
+      FA125TRACE_END(FA125_TRACE_DMA_SEND, nwrds);
       if(retVal != 0)
 	{
-	  logMsg("\nfa125ReadBlock: ERROR in DMA transfer Initialization 0x%x\n\n",retVal,0,0,0,0,0);
+	  FA125LOGMSG("\nfa125ReadBlock: ERROR in DMA transfer Initialization 0x%x\n\n",retVal,0,0,0,0,0);
 	  FA125UNLOCK;
 	  return(retVal);
 	}
 
+      fa125DmaPending = 1;
+      fa125DmaStart   = fa125ReadoutNsec();
+      fa125DmaID      = id;
+      fa125DmaMode    = rmode;
+      fa125DmaNwrds   = nwrds;
+      fa125DmaDummy   = dummy;
+      fa125DmaData    = data;
+      fa125DmaIndex   = (rflag & 0x40) ? 1 : 0;
+      fa125BlockIndexN = 0;
+
       if(async)
 	{ /* Asynchonous mode - return immediately - don't wait for done!! */
 	  FA125UNLOCK;
@@ -3682,89 +4976,28 @@ fa125ReadBlock(int id, volatile UINT32 *data, int nwrds, int rflag)
       else
 	{
 	  /* Wait until Done or Error */
+	  FA125TRACE_BEGIN(FA125_TRACE_DMA_DONE, id);
 #ifdef VXWORKS
 	  retVal = sysVmeDmaDone(10000,1);
 #else
 	  retVal = vmeDmaDone();
 #endif
+	  FA125TRACE_END(FA125_TRACE_DMA_DONE, retVal);
 	}
 
-      if(retVal > 0)
-	{
-	  /* Check to see that Bus error was generated by FA125 */
-	  if(rmode == 2)
-	    {
-	      csr = vmeRead32(&fa125p[fa125MaxSlot]->main.blockCSR);  /* from Last FA125 */
-	      stat = (csr)&FA125_BLOCKCSR_BERR_ASSERTED;  /* from Last FA125 */
-	    }
-	  else
-	    {
-	      csr = vmeRead32(&fa125p[id]->main.blockCSR);  /* from Last FA125 */
-	      stat = (csr)&FA125_BLOCKCSR_BERR_ASSERTED;  /* from Last FA125 */
-	    }
-	  if((retVal>0) && (stat))
-	    {
-#ifdef VXWORKS
-	      xferCount = (nwrds - (retVal>>2) + dummy);  /* Number of Longwords transfered */
-#else
-	      xferCount = ((retVal>>2) + dummy);  /* Number of Longwords transfered */
-#endif
-	      FA125UNLOCK;
-	      return(xferCount); /* Return number of data words transfered */
-	    }
-	  else
-	    {
-#ifdef VXWORKS
-	      xferCount = (nwrds - (retVal>>2) + dummy);  /* Number of Longwords transfered */
-#else
-	      xferCount = ((retVal>>2) + dummy);  /* Number of Longwords transfered */
-#endif
-	      logMsg("fa125ReadBlock: DMA transfer terminated by unknown BUS Error (csr=0x%x xferCount=%d id=%d)\n",
-		     csr,xferCount,id,0,0,0);
-	      FA125UNLOCK;
-	      fa125BlockError=FA125_BLOCKERROR_UNKNOWN_BUS_ERROR;
-	      if(rmode == 2)
-		fa125GetTokenStatus(1);
-
-	      return(xferCount);
-	    }
-	}
-      else if (retVal == 0)
-	{ /* Block Error finished without Bus Error */
-#ifdef VXWORKS
-	  logMsg("fa125ReadBlock: WARN: DMA transfer terminated by word count 0x%x\n",nwrds,0,0,0,0,0);
-	  fa125BlockError=FA125_BLOCKERROR_TERM_ON_WORDCOUNT;
-#else
-	  logMsg("fa125ReadBlock: WARN: DMA transfer returned zero word count 0x%x\n",nwrds,0,0,0,0,0);
-	  fa125BlockError=FA125_BLOCKERROR_ZERO_WORD_COUNT;
-#endif
-	  FA125UNLOCK;
-	  if(rmode == 2)
-	    fa125GetTokenStatus(1);
-
-	  return(nwrds);
-	}
-      else
-	{  /* Error in DMA */
-#ifdef VXWORKS
-	  logMsg("\nfa125ReadBlock: ERROR: sysVmeDmaDone returned an Error\n\n",0,0,0,0,0,0);
-#else
-	  logMsg("\nfa125ReadBlock: ERROR: vmeDmaDone returned an Error\n\n",0,0,0,0,0,0);
-#endif
-	  FA125UNLOCK;
-	  fa125BlockError=FA125_BLOCKERROR_DMADONE_ERROR;
-	  if(rmode == 2)
-	    fa125GetTokenStatus(1);
-
-	  return(retVal>>2);
-	}
+      xferCount = fa125ReadBlockResult(retVal);
+      fa125ReadBlockCount(xferCount);
+      FA125UNLOCK;
+      if((rmode == 2) && (fa125BlockError != FA125_BLOCKERROR_NO_ERROR))
+	fa125GetTokenStatus(1);
 
+      return(xferCount);
     }
   else
     {  /*Programmed IO */
 
       /* Check if Bus Errors are enabled. If so then disable for Prog I/O reading */
-      FA125LOCK;
+      FA125SLOTLOCK(id);
       berr = vmeRead32(&fa125p[id]->main.ctrl1)&FA125_CTRL1_ENABLE_BERR;
       if(berr)
 	vmeWrite32(&fa125p[id]->main.ctrl1,
@@ -3772,16 +5005,10 @@ fa125ReadBlock(int id, volatile UINT32 *data, int nwrds, int rflag)
 
       dCnt = 0;
       /* Read Block Header - should be first word */
-      bhead = fa125pd[id]->data;
-#ifndef VXWORKS
-      bhead = LSWAP(bhead);
-#endif
+      bhead = vmeRead32(&fa125pd[id]->data);
       if((bhead&FA125_DATA_TYPE_DEFINE)&&((bhead&FA125_DATA_TYPE_MASK) == FA125_DATA_BLOCK_HEADER))
 	{
-	  ehead = fa125pd[id]->data;
-#ifndef VXWORKS
-	  ehead = LSWAP(ehead);
-#endif
+	  ehead = vmeRead32(&fa125pd[id]->data);
 #ifdef VXWORKS
 	  data[dCnt] = bhead;
 #else
@@ -3800,14 +5027,16 @@ fa125ReadBlock(int id, volatile UINT32 *data, int nwrds, int rflag)
 	  /* We got bad data - Check if there is any data at all */
 	  if( (vmeRead32(&fa125p[id]->proc.ev_count) & FA125_PROC_EVCOUNT_MASK) == 0)
 	    {
-	      logMsg("fa125ReadBlock: FIFO Empty (0x%08x)\n",bhead,0,0,0,0,0);
-	      FA125UNLOCK;
+	      FA125LOGMSG("fa125ReadBlock: FIFO Empty (0x%08x)\n",bhead,0,0,0,0,0);
+	      FA125SLOTUNLOCK(id);
+	      FA125STAT(id, fifo_empty, 1);
 	      return(0);
 	    }
 	  else
 	    {
-	      logMsg("\nfa125ReadBlock: ERROR: Invalid Header Word 0x%08x\n\n",bhead,0,0,0,0,0);
-	      FA125UNLOCK;
+	      FA125LOGMSG("\nfa125ReadBlock: ERROR: Invalid Header Word 0x%08x\n\n",bhead,0,0,0,0,0);
+	      FA125SLOTUNLOCK(id);
+	      FA125STAT(id, bad_header, 1);
 	      return(ERROR);
 	    }
 	}
@@ -3815,10 +5044,11 @@ fa125ReadBlock(int id, volatile UINT32 *data, int nwrds, int rflag)
       ii=0;
       while(ii<nwrds)
 	{
-	  val = fa125pd[id]->data;
+	  val = vmeRead32(&fa125pd[id]->data);
+#ifdef VXWORKS
 	  data[ii+2] = val;
-#ifndef VXWORKS
-	  val = LSWAP(val);
+#else
+	  data[ii+2] = LSWAP(val); /* Swap back to little-endian */
 #endif
 	  if( (val&FA125_DATA_TYPE_DEFINE)
 	      && ((val&FA125_DATA_TYPE_MASK) == FA125_DATA_BLOCK_TRAILER) )
@@ -3833,7 +5063,9 @@ fa125ReadBlock(int id, volatile UINT32 *data, int nwrds, int rflag)
 	vmeWrite32(&fa125p[id]->main.ctrl1,
 		   vmeRead32(&fa125p[id]->main.ctrl1) | FA125_CTRL1_ENABLE_BERR);
 
-      FA125UNLOCK;
+      FA125SLOTUNLOCK(id);
+      FA125STAT(id, blocks, 1);
+      FA125STAT(id, words, dCnt);
       return(dCnt);
     }
 
@@ -3842,418 +5074,3484 @@ fa125ReadBlock(int id, volatile UINT32 *data, int nwrds, int rflag)
 }
 
 /**
- *  @ingroup Config
- *  @brief Enable/Disable suppression of one or both of the trigger time words
- *    in the data stream.
- *  @param id Slot number
- *  @param suppress Suppression Flag
- *      -  0: Trigger time words are enabled in datastream
- *      -  1: Suppress BOTH trigger time words
- *  @return OK if successful, otherwise ERROR.
- */
-int
+ *  @ingroup Readout
+ *  @brief Start a DMA readout and return without waiting for it to finish.
+ *     The DMA must be completed with fa125ReadBlockComplete before another
+ *     readout is started.
+ *
+ *  @param  id     Slot number of module to read
+ *  @param  data   local memory address to place data
+ *  @param  nwrds  Max number of words to transfer
+ *  @param  rflag  Readout Flag
+ * <pre>
+ *              1 - DMA transfer using Universe/Tempe DMA Engine
+ *              2 - Multiblock DMA transfer
+ *           0x40 - Index the blocks of the DMA, for fa125ReadBlockIndex
+ * </pre>
+ *  @return OK if the DMA was started, otherwise ERROR.
+ *  @sa fa125ReadBlock
+ */
+int
+fa125ReadBlockStart(int id, volatile UINT32 *data, int nwrds, int rflag)
+{
+  FA125ACCT_ENTRY;
+  int rmode = rflag&0x0f;
+
+  if((rmode != 1) && (rmode != 2))
+    {
+      FA125LOGMSG("\nfa125ReadBlockStart: ERROR: Invalid rflag (0x%x)\n\n",rflag,0,0,0,0,0);
+      return(ERROR);
+    }
+
+  return fa125ReadBlock(id, data, nwrds, rmode | (rflag & 0x40) | 0x80);
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Wait for the DMA started by fa125ReadBlockStart (or fa125ReadBlock
+ *     with the asynchronous flag) to finish.  The number of words and the
+ *     block error flag are determined as in the synchronous readout.
+ *
+ *  @param timeout Number of polls of the BERR status of the module that ends
+ *     the transfer (last module for Multiblock), before giving up.
+ *      -  0: No polling.  Wait for the DMA in vmeDmaDone.
+ *      - >0: If BERR is not asserted within timeout polls, return ERROR with
+ *            fa125BlockError = FA125_BLOCKERROR_DMA_TIMEOUT.  The DMA remains
+ *            in progress and this routine may be called again, or the DMA
+ *            given up with fa125ReadBlockAbort.
+ *
+ *  @return Number of words inserted into data if successful.  Otherwise ERROR.
+ *  @sa fa125ReadBlockStatus
+ */
+int
+fa125ReadBlockComplete(int timeout)
+{
+  FA125ACCT_ENTRY;
+  int retVal, xferCount, berrid, rmode, ipoll;
+
+  FA125LOCK;
+  if(!fa125DmaPending)
+    {
+      FA125LOGMSG("\nfa125ReadBlockComplete: ERROR: No DMA in progress\n\n",0,0,0,0,0,0);
+      FA125UNLOCK;
+      return(ERROR);
+    }
+
+  rmode = fa125DmaMode;
+  if(timeout > 0)
+    {
+      berrid = (rmode == 2) ? fa125MaxSlot : fa125DmaID;
+      for(ipoll = 0; ipoll < timeout; ipoll++)
+	{
+	  if(vmeRead32(&fa125p[berrid]->main.blockCSR) & FA125_BLOCKCSR_BERR_ASSERTED)
+	    break;
+	}
+
+      if(ipoll == timeout)
+	{
+	  fa125BlockError=FA125_BLOCKERROR_DMA_TIMEOUT;
+	  FA125STAT(berrid, timeouts, 1);
+	  FA125UNLOCK;
+	  return(ERROR);
+	}
+    }
+
+  FA125TRACE_BEGIN(FA125_TRACE_DMA_DONE, fa125DmaID);
+#ifdef VXWORKS
+  retVal = sysVmeDmaDone(10000,1);
+#else
+  retVal = vmeDmaDone();
+#endif
+  FA125TRACE_END(FA125_TRACE_DMA_DONE, retVal);
+
+  fa125BlockError=FA125_BLOCKERROR_NO_ERROR;
+  xferCount = fa125ReadBlockResult(retVal);
+  fa125ReadBlockCount(xferCount);
+  FA125UNLOCK;
+  if((rmode == 2) && (fa125BlockError != FA125_BLOCKERROR_NO_ERROR))
+    fa125GetTokenStatus(1);
+
+  return(xferCount);
+}
+
+/* Give up the DMA in progress.  Called with FA125LOCK held. */
+static int
+fa125DmaAbandon()
+{
+  int retVal;
+
+  if(!fa125DmaPending)
+    return 0;
+
+  /* Wait for the DMA engine, so that it may be used again */
+#ifdef VXWORKS
+  retVal = sysVmeDmaDone(10000,1);
+#else
+  retVal = vmeDmaDone();
+#endif
+  FA125LOGMSG("fa125: WARN: DMA from slot %d given up (0x%x)\n",fa125DmaID,retVal,0,0,0,0);
+  FA125STAT(fa125DmaID, dma_errors, 1);
+
+  fa125DmaPending  = 0;
+  fa125BlockIndexN = 0;
+
+  return 1;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Give up the DMA started by fa125ReadBlockStart (or fa125ReadBlock
+ *     with the asynchronous flag), e.g. after fa125ReadBlockComplete timed
+ *     out.  The DMA engine is waited for and the data of the DMA is
+ *     dropped.  Data left in the modules is not; reset them before the
+ *     next readout.
+ *
+ *  @return 1 if a DMA was given up, 0 if none was in progress.
+ */
+int
+fa125ReadBlockAbort()
+{
+  FA125ACCT_ENTRY;
+  int rval;
+
+  FA125LOCK;
+  rval = fa125DmaAbandon();
+  FA125UNLOCK;
+
+  return rval;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief DMA readout in chunks of a bounded number of words.  Each chunk is
+ *     passed to func while the DMA of the next one is in progress, so the
+ *     data can be decoded (see FA125_DECODER.chunked) as it arrives.  The
+ *     chunks are placed one after the other in data, as by fa125ReadBlock.
+ *
+ *     func is called with the crate lock held, and must not start another
+ *     readout.  If it does not return OK it is not called again, but the
+ *     rest of the block is still read.
+ *
+ *  @param  id     Slot number of module to read
+ *  @param  data   local memory address to place data
+ *  @param  nwrds  Max number of words to transfer
+ *  @param  rflag  Readout Flag
+ * <pre>
+ *              1 - DMA transfer using Universe/Tempe DMA Engine
+ *              2 - Multiblock DMA transfer
+ *           0x40 - Index the blocks of the DMA, for fa125ReadBlockIndex
+ * </pre>
+ *  @param  chunk  Max number of words of each DMA.  Rounded down to an even
+ *                 number, to keep each chunk 64bit aligned.
+ *  @param  func   Called with each chunk.  May be NULL.
+ *  @param  arg    Passed to func
+ *  @return Number of words inserted into data if successful.  Otherwise ERROR.
+ *  @sa fa125ReadBlock, fa125ReadBlockStatus
+ */
+int
+fa125ReadBlockChunked(int id, volatile UINT32 *data, int nwrds, int rflag, int chunk,
+		      FA125_CHUNK_FUNC func, void *arg)
+{
+  FA125ACCT_ENTRY;
+  int rmode = rflag&0x0f;
+  int retVal, xferCount, ncur, total, from = 0, dummy = 0, full;
+  volatile UINT32 *laddr;
+  unsigned int vmeAdr;
+
+  if(id==0) id=fa125ID[0];
+
+  if((id<=0) || (id>21) || (fa125p[id] == NULL))
+    {
+      FA125LOGMSG("\nfa125ReadBlockChunked: ERROR : FA125 in slot %d is not initialized\n\n",id,0,0,0,0,0);
+      return(ERROR);
+    }
+
+  if(data==NULL)
+    {
+      FA125LOGMSG("\nfa125ReadBlockChunked: ERROR: Invalid Destination address\n\n",0,0,0,0,0,0);
+      return(ERROR);
+    }
+
+  if((rmode != 1) && (rmode != 2))
+    {
+      FA125LOGMSG("\nfa125ReadBlockChunked: ERROR: Invalid rflag (0x%x)\n\n",rflag,0,0,0,0,0);
+      return(ERROR);
+    }
+
+  chunk &= ~1;
+  if(chunk < 2)
+    {
+      FA125LOGMSG("\nfa125ReadBlockChunked: ERROR: Invalid chunk size (%d)\n\n",chunk,0,0,0,0,0);
+      return(ERROR);
+    }
+
+  fa125BlockError=FA125_BLOCKERROR_NO_ERROR;
+  if(nwrds <= 0) nwrds= (FA125_MAX_ADC_CHANNELS*FA125_MAX_DATA_PER_CHANNEL) + 8;
+
+  /* Check for 8 byte boundary for address - insert dummy word (Slot 0 FA125 Dummy DATA)*/
+  if((unsigned long) (data)&0x7)
+    {
+#ifdef VXWORKS
+      *data = FA125_DUMMY_DATA;
+#else
+      *data = LSWAP(FA125_DUMMY_DATA);
+#endif
+      dummy = 1;
+    }
+  laddr = data + dummy;
+  total = dummy;
+
+  FA125LOCK;
+  if(fa125DmaPending)
+    {
+      FA125LOGMSG("\nfa125ReadBlockChunked: ERROR: DMA already in progress\n\n",0,0,0,0,0,0);
+      FA125UNLOCK;
+      return(ERROR);
+    }
+
+  if(rmode == 2)
+    { /* Multiblock Mode */
+      if((vmeRead32(&fa125p[id]->main.ctrl1)&FA125_CTRL1_FIRST_BOARD)==0)
+	{
+	  FA125LOGMSG("\nfa125ReadBlockChunked: ERROR: FA125 in slot %d is not First Board\n\n",id,0,0,0,0,0);
+	  FA125UNLOCK;
+	  return(ERROR);
+	}
+      vmeAdr = (unsigned int)((unsigned long)(FA125pmb) - fa125A32Offset);
+    }
+  else
+    {
+      vmeAdr = (unsigned int)((unsigned long)fa125pd[id] - fa125A32Offset);
+    }
+
+  fa125DmaStart    = fa125ReadoutNsec();
+  fa125DmaID       = id;
+  fa125DmaMode     = rmode;
+  fa125DmaDummy    = 0;
+  fa125DmaData     = data;
+  fa125DmaIndex    = 0;
+  fa125BlockIndexN = 0;
+
+  ncur = (nwrds < chunk) ? nwrds : chunk;
+  while(1)
+    {
+      FA125TRACE_BEGIN(FA125_TRACE_DMA_SEND, id);
+#ifdef VXWORKS
+      retVal = sysVmeDmaSend((UINT32)laddr, vmeAdr, (ncur<<2), 0);
+#else
+      retVal = vmeDmaSend((unsigned long)laddr, vmeAdr, (ncur<<2));
+#endif
+      FA125TRACE_END(FA125_TRACE_DMA_SEND, ncur);
+      if(retVal != 0)
+	{
+	  FA125LOGMSG("\nfa125ReadBlockChunked: ERROR in DMA transfer Initialization 0x%x\n\n",retVal,0,0,0,0,0);
+	  FA125UNLOCK;
+	  return(retVal);
+	}
+      fa125DmaPending = 1;
+      fa125DmaNwrds   = ncur;
+
+      /* Hand over the previous chunk while this one is transferred */
+      if(func && (total - from > dummy))
+	{
+	  if((*func)(&data[from], total - from, arg) != OK)
+	    func = NULL;
+	  from = total;
+	}
+
+      FA125TRACE_BEGIN(FA125_TRACE_DMA_DONE, id);
+#ifdef VXWORKS
+      retVal = sysVmeDmaDone(10000,1);
+#else
+      retVal = vmeDmaDone();
+#endif
+      FA125TRACE_END(FA125_TRACE_DMA_DONE, retVal);
+
+      /* A chunk that ends on its word count, without a Bus Error, may be
+	 followed by more data, unless the max number of words has been read.
+	 sysVmeDmaDone returns the bytes not transferred, vmeDmaDone the
+	 bytes transferred. */
+#ifdef VXWORKS
+      full = (retVal == 0);
+#else
+      full = (retVal == (ncur<<2));
+#endif
+      if(full)
+	full = !(vmeRead32(&fa125p[(rmode == 2) ? fa125MaxSlot : id]->main.blockCSR) &
+		 FA125_BLOCKCSR_BERR_ASSERTED);
+      if(full && (total - dummy + ncur < nwrds))
+	{
+	  fa125DmaPending = 0;
+	  total += ncur;
+	  laddr += ncur;
+	  ncur = nwrds - (total - dummy);
+	  if(ncur > chunk)
+	    ncur = chunk;
+	  continue;
+	}
+
+      xferCount = fa125ReadBlockResult(retVal);
+      if(fa125BlockError == FA125_BLOCKERROR_DMADONE_ERROR)
+	{
+	  FA125UNLOCK;
+	  return(ERROR);
+	}
+      total += xferCount;
+      break;
+    }
+
+  if(func && (total > from))
+    (*func)(&data[from], total - from, arg);
+
+  if(rflag & 0x40)
+    fa125ReadBlockIndexBuild(data, total);
+  fa125ReadBlockCount(total);
+  FA125UNLOCK;
+  if((rmode == 2) && (fa125BlockError != FA125_BLOCKERROR_NO_ERROR))
+    fa125GetTokenStatus(1);
+
+  return(total);
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Return the index of the blocks of the last DMA readout made with
+ *     the index flag (0x40 in rflag).  Each entry gives the slot, offset,
+ *     length, block number and number of events of a block in the
+ *     destination buffer, so the block of a module is found without
+ *     decoding the data.  Offsets include the dummy word of an unaligned
+ *     buffer.
+ *  @param index    Destination of the index
+ *  @param maxindex Size of index
+ *  @return Number of blocks in the last readout.  Only the first maxindex are
+ *     stored in index.
+ *  @sa fa125IndexBlocks
+ */
+int
+fa125ReadBlockIndex(FA125_BLOCK_INDEX *index, int maxindex)
+{
+  int rval;
+
+  if((index == NULL) && (maxindex > 0))
+    {
+      printf("\n%s: ERROR: Invalid index pointer\n\n", __FUNCTION__);
+      return ERROR;
+    }
+
+  FA125LOCK;
+  rval = fa125BlockIndexN;
+  if(maxindex > rval)
+    maxindex = rval;
+  if(maxindex > 0)
+    memcpy(index, fa125BlockIndex, maxindex * sizeof(FA125_BLOCK_INDEX));
+  FA125UNLOCK;
+
+  return rval;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Set how long fa125ReadCrate waits for modules without a block
+ *     ready, before reading the others.
+ *  @param usec Deadline in microseconds, from the first block ready check
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125SetReadoutDeadline(int usec)
+{
+  if(usec < 0)
+    {
+      printf("\n%s: ERROR: Invalid deadline (%d)\n\n", __FUNCTION__, usec);
+      return ERROR;
+    }
+
+  FA125LOCK;
+  fa125ReadoutDeadline = usec;
+  FA125UNLOCK;
+
+  return OK;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Read a block from every initialized module, without losing the
+ *     crate when one module is slow.
+ *
+ *     Modules without a block ready are polled up to the deadline of
+ *     fa125SetReadoutDeadline.  If all modules are then ready, the crate is
+ *     read with one multiblock DMA (one board read if there is a single
+ *     module).  Otherwise each ready module is read on its own, in slot
+ *     order, and each missing module is tagged in the data by a
+ *     data-not-valid word (type 14) with its slot number.  Board reads
+ *     are by DMA, or by programmed I/O below the crossover of
+ *     fa125DmaCalibrate (fa125ReadBlock rflag 0x20).
+ *
+ *     The block of a missing module is still owed.  When it arrives, it is
+ *     read and dropped before that module is read again, so the blocks of
+ *     later readouts stay in step.  The token is reset after the readout.
+ *
+ *  @param data    local memory address to place data
+ *  @param nwrds   Max number of words to transfer
+ *  @param missing If not NULL, the slot mask of modules not read
+ *  @return Number of words inserted into data if successful.  Otherwise ERROR.
+ *  @sa fa125GetReadoutLateness, fa125ReadBlockStatus
+ */
+int
+fa125ReadCrate(volatile UINT32 *data, int nwrds, unsigned int *missing)
+{
+  FA125ACCT_ENTRY;
+  unsigned int scanmask, want, ready, first, skip = 0;
+  int ifa, id, nw, dCnt = 0, blockError = FA125_BLOCKERROR_NO_ERROR;
+  long long deadline;
+
+  if(data==NULL)
+    {
+      FA125LOGMSG("\nfa125ReadCrate: ERROR: Invalid Destination address\n\n",0,0,0,0,0,0);
+      return(ERROR);
+    }
+
+  if(nfa125 <= 0)
+    {
+      FA125LOGMSG("\nfa125ReadCrate: ERROR: No FA125 initialized\n\n",0,0,0,0,0,0);
+      return(ERROR);
+    }
+
+  scanmask = fa125ScanMask();
+
+  FA125LOCK;
+
+  /* Drop the late blocks of earlier readouts that have since arrived */
+  for(ifa = 0; ifa < nfa125; ifa++)
+    {
+      id = fa125ID[ifa];
+      while(fa125ReadoutOwed[id] && fa125Bready(id))
+	{
+	  fa125ReadBlock(id, data, nwrds, 1);
+	  fa125ReadoutOwed[id]--;
+	  fa125ReadoutDropped[id]++;
+	}
+      if(fa125ReadoutOwed[id])
+	skip |= (1<<id);
+    }
+
+  /* Modules still owing a block cannot deliver this one in time.
+     The wait polls the modules itself, the crate need not be held. */
+  want     = scanmask & ~skip;
+  deadline = 1000LL * fa125ReadoutDeadline;
+  FA125UNLOCK;
+
+  first = 0;
+  ready = want ? fa125WaitBlockReady(want, deadline, &first) : 0;
+
+  FA125LOCK;
+  for(ifa = 0; ifa < nfa125; ifa++)
+    {
+      id = fa125ID[ifa];
+      if((ready & ~first) & (1<<id))
+	fa125ReadoutLate[id]++;
+      if(!(ready & (1<<id)))
+	{
+	  fa125ReadoutMissed[id]++;
+	  fa125ReadoutOwed[id]++;
+	}
+    }
+
+  if((ready == scanmask) && ((nfa125 == 1) || (FA125pmb != NULL)))
+    {
+      dCnt = fa125ReadBlock(fa125ID[0], data, nwrds, (nfa125 > 1) ? 2 : (1 | 0x20));
+      blockError = fa125BlockError;
+    }
+  else
+    {
+      for(ifa = 0; (ifa < nfa125) && (dCnt < nwrds); ifa++)
+	{
+	  id = fa125ID[ifa];
+	  if(ready & (1<<id))
+	    {
+	      nw = fa125ReadBlock(id, &data[dCnt], nwrds - dCnt, 1 | 0x20);
+	      if(blockError == FA125_BLOCKERROR_NO_ERROR)
+		blockError = fa125BlockError;
+	      if(nw > 0)
+		dCnt += nw;
+	    }
+	  else
+	    {
+#ifdef VXWORKS
+	      data[dCnt++] = FA125_DATA_TYPE_DEFINE | FA125_DATA_DNV | (id<<22);
+#else
+	      data[dCnt++] = LSWAP(FA125_DATA_TYPE_DEFINE | FA125_DATA_DNV | (id<<22));
+#endif
+	    }
+	}
+    }
+  fa125BlockError = blockError;
+
+  fa125ResetToken(fa125ID[0]);
+  FA125UNLOCK;
+
+  if(missing)
+    *missing = scanmask & ~ready;
+
+  return dCnt;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Return the lateness counts of a module in fa125ReadCrate
+ *  @param id Slot number
+ *  @param late Blocks that were ready only after a wait
+ *  @param missed Blocks that were not ready by the deadline
+ *  @param dropped Late blocks that were read and dropped
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125GetReadoutLateness(int id, unsigned int *late, unsigned int *missed,
+			unsigned int *dropped)
+{
+  if(id==0) id=fa125ID[0];
+
+  if((id<=0) || (id>21) || (fa125p[id] == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized\n\n",__FUNCTION__,id);
+      return ERROR;
+    }
+
+  FA125LOCK;
+  if(late)    *late    = fa125ReadoutLate[id];
+  if(missed)  *missed  = fa125ReadoutMissed[id];
+  if(dropped) *dropped = fa125ReadoutDropped[id];
+  FA125UNLOCK;
+
+  return OK;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Return the slot mask of modules that still owe a late block to
+ *     fa125ReadCrate.  Their block ready status is that of the late block.
+ *  @return Slot mask
+ */
+unsigned int
+fa125GetReadoutOwed()
+{
+  unsigned int rmask = 0;
+  int ifa;
+
+  FA125LOCK;
+  for(ifa = 0; ifa < nfa125; ifa++)
+    if(fa125ReadoutOwed[fa125ID[ifa]])
+      rmask |= (1<<fa125ID[ifa]);
+  FA125UNLOCK;
+
+  return rmask;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Print the lateness counts of all initialized modules in
+ *     fa125ReadCrate, and optionally clear them.
+ *  @param rflag If 1, clear the counts after printing
+ */
+void
+fa125PrintReadoutLateness(int rflag)
+{
+  int ifa, id;
+
+  FA125LOCK;
+  printf("\nFA125 readout lateness (deadline %d usec)\n", fa125ReadoutDeadline);
+  printf("----------------------------------------------------\n");
+  printf("Slot        Late      Missed     Dropped        Owed\n");
+  printf("----------------------------------------------------\n");
+  for(ifa = 0; ifa < nfa125; ifa++)
+    {
+      id = fa125ID[ifa];
+      printf("%4d  %10u  %10u  %10u  %10u\n", id, fa125ReadoutLate[id],
+	     fa125ReadoutMissed[id], fa125ReadoutDropped[id], fa125ReadoutOwed[id]);
+      if(rflag)
+	fa125ReadoutLate[id] = fa125ReadoutMissed[id] = fa125ReadoutDropped[id] = 0;
+    }
+  printf("\n");
+  FA125UNLOCK;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Return the readout counters of a module.  The counters are always
+ *     on: they are updated by the readout and block ready routines without
+ *     a lock.
+ *  @param id Slot number
+ *  @param stats Destination of the counters
+ *  @param rflag If 1, clear each counter as it is read, so that no count is
+ *     lost between the snapshot and the reset
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125GetReadoutStats(int id, FA125_READOUT_STATS *stats, int rflag)
+{
+  unsigned long long *src, *dst;
+  int ic, nc = sizeof(FA125_READOUT_STATS) / sizeof(unsigned long long);
+#ifdef VXWORKS
+  int lockKey;
+#endif
+
+  if(id==0) id=fa125ID[0];
+
+  if((id<=0) || (id>21) || (fa125p[id] == NULL) || (stats == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized\n\n",__FUNCTION__,id);
+      return ERROR;
+    }
+
+  src = (unsigned long long *)&fa125Stats[id];
+  dst = (unsigned long long *)stats;
+#ifdef VXWORKS
+  lockKey = intLock();
+  for(ic = 0; ic < nc; ic++)
+    {
+      dst[ic] = src[ic];
+      if(rflag)
+	src[ic] = 0;
+    }
+  intUnlock(lockKey);
+#else
+  for(ic = 0; ic < nc; ic++)
+    {
+      if(rflag)
+	dst[ic] = __atomic_exchange_n(&src[ic], 0, __ATOMIC_RELAXED);
+      else
+	dst[ic] = __atomic_load_n(&src[ic], __ATOMIC_RELAXED);
+    }
+#endif
+
+  return OK;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Print the readout counters of all initialized modules, and
+ *     optionally clear them.
+ *  @param rflag If 1, clear the counters as they are printed
+ */
+void
+fa125PrintReadoutStats(int rflag)
+{
+  FA125_READOUT_STATS st;
+  int ifa, id;
+
+  printf("\nFA125 readout counters\n");
+  printf("-----------------------------------------------------------------------------------------------------\n");
+  printf("Slot     Blocks        Words  DMA(us)   BERR  Unknown  WrdCnt  DMAErr  Empty  BadHdr  Ready%%  Timeout\n");
+  printf("-----------------------------------------------------------------------------------------------------\n");
+  for(ifa = 0; ifa < nfa125; ifa++)
+    {
+      id = fa125ID[ifa];
+      if(fa125GetReadoutStats(id, &st, rflag) != OK)
+	continue;
+      printf("%4d %10llu %12llu %8.1f %6llu %8llu %7llu %7llu %6llu %7llu %7.1f %8llu\n",
+	     id, st.blocks, st.words, st.ndma ? 1e-3 * st.dma_ns / st.ndma : 0.,
+	     st.berr, st.unknown_berr, st.zero_count, st.dma_errors,
+	     st.fifo_empty, st.bad_header,
+	     st.bready_polls ? 100. * st.bready / st.bready_polls : 0., st.timeouts);
+    }
+  printf("\n");
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Enable/Disable suppression of one or both of the trigger time words
+ *    in the data stream.
+ *  @param id Slot number
+ *  @param suppress Suppression Flag
+ *      -  0: Trigger time words are enabled in datastream
+ *      -  1: Suppress BOTH trigger time words
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
 fa125DataSuppressTriggerTime(int id, int suppress)
 {
-  int val = 0;
+  FA125ACCT_ENTRY;
+  int val = 0;
+  if(id==0) id=fa125ID[0];
+
+  if((id<=0) || (id>21) || (fa125p[id] == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized\n\n",
+	     __FUNCTION__, id);
+      return(ERROR);
+    }
+
+  if((suppress < 0) || (suppress > 1))
+    {
+      printf("\n%s: ERROR: Invalid suppress value (%d)\n\n",
+	     __FUNCTION__, suppress);
+      return ERROR;
+    }
+
+  if(suppress)
+    val = 0;
+  else
+    val = FA125_PROC_CTRL2_TRIGTIME_ENABLE;
+
+  FA125SLOTLOCK(id);
+  FA125SWRITE(id, proc.ctrl2, val);
+  FA125SLOTUNLOCK(id);
+
+  return OK;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Enable/Disable suppression of one or both of the trigger time words
+ *    in the data stream for all initialized modules.
+ *  @param suppress Suppression Flag
+ *      -  0: Trigger time words are enabled in datastream
+ *      -  1: Suppress BOTH trigger time words
+ */
+void
+fa125GDataSuppressTriggerTime(int suppress)
+{
+  FA125ACCT_ENTRY;
+  int ifa;
+
+  for(ifa = 0; ifa < nfa125; ifa++)
+    fa125DataSuppressTriggerTime(fa125Slot(ifa), suppress);
+
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Model the number of data words of a module from its configuration:
+ *     processing mode, NPK and NW, the blocklevel, the enabled channels and
+ *     the trigger time words.  The register shadow is used, so no VME access
+ *     is made.
+ *
+ *     model->block_words is an upper bound of the block: every enabled
+ *     channel reports a hit with NPK peaks in every event.  A readout of
+ *     this many words (plus the words needed for the bus error) cannot
+ *     overrun.
+ *  @param id Slot number
+ *  @param model Where to return the model
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125GetWordModel(int id, FA125_WORD_MODEL *model)
+{
+  int supported_modes[FA125_SUPPORTED_NMODES] = FA125_SUPPORTED_MODES;
+  int cdc_modes[FA125_CDC_NMODES] = FA125_CDC_MODES;
+  int imode, supported = 0, cdc_mode = 0, ife, ichan;
+  unsigned int config1, chmask;
+
+  if(id==0) id=fa125ID[0];
+
+  if((id<0) || (id>21) || (fa125p[id] == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",__FUNCTION__,id);
+      return ERROR;
+    }
+
+  if(model == NULL)
+    {
+      printf("\n%s: ERROR: Invalid model pointer\n\n", __FUNCTION__);
+      return ERROR;
+    }
+
+  memset(model, 0, sizeof(FA125_WORD_MODEL));
+
+  FA125SLOTLOCK(id);
+  config1           = FA125SREAD(id, fe[0].config1);
+  model->nw         = FA125SREAD(id, fe[0].nw) & FA125_FE_NW_MASK;
+  model->blocklevel = FA125SREAD(id, proc.blocklevel) & FA125_PROC_BLOCKLEVEL_MASK;
+  model->trigtime   = (FA125SREAD(id, proc.ctrl2) & FA125_PROC_CTRL2_TRIGTIME_ENABLE) ? 1 : 0;
+  for(ife = 0; ife < 12; ife++)
+    {
+      chmask = FA125SREAD(id, fe[ife].config2) & FA125_FE_CONFIG2_CH_MASK;
+      for(ichan = 0; ichan < 6; ichan++)
+	if((chmask & (1 << ichan)) == 0)
+	  model->nchan++;
+    }
+  FA125SLOTUNLOCK(id);
+
+  model->mode = (config1 & FA125_FE_CONFIG1_MODE_MASK) + 1;
+  model->npk  = (config1 & FA125_FE_CONFIG1_NPULSES_MASK) >> 4;
+
+  for(imode = 0; imode < FA125_SUPPORTED_NMODES; imode++)
+    if(model->mode == supported_modes[imode])
+      supported = 1;
+
+  for(imode = 0; imode < FA125_CDC_NMODES; imode++)
+    if(model->mode == cdc_modes[imode])
+      cdc_mode = 1;
+
+  if(!supported)
+    {
+      printf("\n%s: ERROR: Slot %d: Processing mode (%d) not supported\n\n",
+	     __FUNCTION__, id, model->mode);
+      return ERROR;
+    }
+
+  /* The pulse word (one peak for CDC) and the words of its peaks */
+  if(cdc_mode)
+    {
+      model->npk        = 1;
+      model->hit_words  = 2;
+      model->hit1_words = 2;
+    }
+  else
+    {
+      model->hit_words  = 1 + model->npk;
+      model->hit1_words = (model->npk > 0) ? 2 : 1;
+    }
+
+  /* Raw window of the pulse: window word and two samples per word */
+  if(model->mode >= FA125_PROC_MODE_CDC_PULSESAMPLES)
+    {
+      model->hit_words  += 1 + (model->nw + 1) / 2;
+      model->hit1_words += 1 + (model->nw + 1) / 2;
+    }
+
+  /* Event header and the trigger time words */
+  model->event_words = 1 + 2 * model->trigtime;
+
+  /* Block header, trailer and a filler word for 64bit alignment */
+  model->block_words = 3 + model->blocklevel *
+    (model->event_words + model->nchan * model->hit_words);
+
+  return OK;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Upper bound of the number of words of a block from a module.
+ *     See fa125GetWordModel.
+ *  @param id Slot number
+ *  @return Number of words if successful, otherwise ERROR.
+ */
+int
+fa125MaxBlockWords(int id)
+{
+  FA125_WORD_MODEL model;
+
+  if(fa125GetWordModel(id, &model) != OK)
+    return ERROR;
+
+  return model.block_words;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Upper bound of the number of words of a block from all
+ *     initialized modules, as returned by a multiblock readout.
+ *     See fa125GetWordModel.
+ *  @return Number of words if successful, otherwise ERROR.
+ */
+int
+fa125GMaxBlockWords()
+{
+  int ifa, nwords, total = 0;
+
+  for(ifa = 0; ifa < nfa125; ifa++)
+    {
+      nwords = fa125MaxBlockWords(fa125ID[ifa]);
+      if(nwords < 0)
+	return ERROR;
+      total += nwords;
+    }
+
+  return total;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Print the data rate expected from each initialized module at a
+ *     trigger rate, from its configuration (see fa125GetWordModel).
+ *     The expected rate counts one peak for each hit, with the given
+ *     fraction of the enabled channels hit in each event.  The maximum rate
+ *     has every enabled channel hit with NPK peaks.
+ *  @param rate Trigger rate (Hz)
+ *  @param occupancy Fraction of the enabled channels hit in each event (0-1)
+ */
+void
+fa125PrintDataRate(double rate, double occupancy)
+{
+  FA125_WORD_MODEL model;
+  double expected, expected_sum = 0, max_sum = 0;
+  int ifa, id;
+
+  if((occupancy < 0) || (occupancy > 1))
+    {
+      printf("\n%s: ERROR: Invalid occupancy (%f)\n\n", __FUNCTION__, occupancy);
+      return;
+    }
+
+  printf("\nFA125 data rate at %.1f kHz, %.0f%% occupancy\n", rate / 1000., 100. * occupancy);
+  printf("-----------------------------------------------------------------------------------\n");
+  printf("Slot  Mode  NPK    NW  Chan   TT   Words/Event  Max Words/Block      MB/s  Max MB/s\n");
+  printf("-----------------------------------------------------------------------------------\n");
+
+  for(ifa = 0; ifa < nfa125; ifa++)
+    {
+      id = fa125ID[ifa];
+      if(fa125GetWordModel(id, &model) != OK)
+	continue;
+
+      /* Block header, trailer and filler are shared by the events of a block */
+      expected = model.event_words + occupancy * model.nchan * model.hit1_words;
+      if(model.blocklevel > 0)
+	expected += 3. / model.blocklevel;
+
+      printf("%4d  %4d  %3d  %4d  %4d  %3s  %12.1f  %15d  %8.2f  %8.2f\n",
+	     id, model.mode, model.npk, model.nw, model.nchan,
+	     model.trigtime ? "on" : "off", expected, model.block_words,
+	     4e-6 * expected * rate,
+	     4e-6 * model.block_words * rate / (model.blocklevel ? model.blocklevel : 1));
+
+      expected_sum += expected;
+      max_sum += (double)model.block_words / (model.blocklevel ? model.blocklevel : 1);
+    }
+
+  printf("-----------------------------------------------------------------------------------\n");
+  printf("%-32s  %12.1f  %15d  %8.2f  %8.2f\n", "Crate",
+	 expected_sum, fa125GMaxBlockWords(), 4e-6 * expected_sum * rate, 4e-6 * max_sum * rate);
+  printf("\n");
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Configure a module from an FADC125_CONF in one call.
+ *     All parameters are checked before anything is written.  The register
+ *     image of the module (processing mode, window, scale factors, readout
+ *     and timing thresholds, channel disable masks, busy level and data
+ *     format) is then written in one pass, skipping the registers that
+ *     already hold their values.  DAC offsets are set with fa125SetOffsets.
+ *
+ *     Processing mode parameters are checked as by fa125SetProcMode.  Scale
+ *     factors must be in range, with P2 + PBIT <= 7.
+ *     conf->winOffset is the PL (trigger latency) written to the module.
+ *  @param id Slot number
+ *  @param conf Module configuration
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125ConfigApply(int id, FADC125_CONF *conf)
+{
+  FA125ACCT_ENTRY;
+  unsigned int PL, NW, IE, PG, NPK, P1, P2, IBIT, ABIT, PBIT, TL, TH;
+  unsigned int ped_sf, thr[FA125_MAX_ADC_CHANNELS];
+  int ife, ii, chan, deferred, rval=OK;
+
+  if(id==0) id=fa125ID[0];
+
+  if((id<0) || (id>21) || (fa125p[id] == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",__FUNCTION__,id);
+      return ERROR;
+    }
+
+  if(conf == NULL)
+    {
+      printf("\n%s: ERROR: Invalid configuration\n\n",__FUNCTION__);
+      return ERROR;
+    }
+
+  /* Processing mode */
+  PL  = conf->winOffset;
+  NW  = conf->winWidth;
+  IE  = conf->IE;
+  PG  = conf->PG;
+  NPK = conf->npeak;
+  P1  = conf->P1;
+  P2  = conf->P2;
+
+  if(fa125CheckProcMode(__FUNCTION__, conf->mode, &PL, &NW, &IE, &PG, &NPK, P1, P2) != OK)
+    return ERROR;
+
+  /* Scale factors */
+  IBIT = conf->IBIT;
+  ABIT = conf->ABIT;
+  PBIT = conf->PBIT;
+
+  if((IBIT>FA125_MAX_IBIT) || (ABIT>FA125_MAX_ABIT) || (PBIT>FA125_MAX_PBIT))
+    {
+      printf("\n%s: ERROR: Invalid scale factor (IBIT = %d, ABIT = %d, PBIT = %d)\n\n",
+	     __FUNCTION__,IBIT,ABIT,PBIT);
+      return ERROR;
+    }
+
+  if((P2 + PBIT) > 7)
+    {
+      printf("\n%s: ERROR: P2 + PBIT > 7  (%d + %d) = %d\n\n",
+	     __FUNCTION__, P2, PBIT, P2 + PBIT);
+      return ERROR;
+    }
+
+  /* Timing and readout thresholds */
+  TL = conf->TL;
+  TH = conf->TH;
+
+  if((TL>FA125_MAX_LOW_TTH) || (TH>FA125_MAX_HIGH_TTH))
+    {
+      printf("\n%s: ERROR: Invalid Timing Threshold (TL = %d, TH = %d)\n\n",
+	     __FUNCTION__,TL,TH);
+      return ERROR;
+    }
+
+  for(chan=0; chan<FA125_MAX_ADC_CHANNELS; chan++)
+    {
+      thr[chan] = conf->read_thr[chan];
+      if(thr[chan]>FA125_MAX_HIGH_HTH)
+	{
+	  printf("\n%s: ERROR: Invalid threshold (%d) for channel %d. Must be <= %d\n\n",
+		 __FUNCTION__,thr[chan],chan,FA125_MAX_HIGH_HTH);
+	  return ERROR;
+	}
+    }
+
+  for(ii=0; ii<3; ii++)
+    {
+      if(conf->ch_disable[ii] > 0xFFFFFF)
+	{
+	  printf("\n%s: ERROR: Invalid channel disable mask %d (0x%08x).  Must be less than 24 bits.\n\n",
+		 __FUNCTION__,ii,conf->ch_disable[ii]);
+	  return ERROR;
+	}
+    }
+
+  if((conf->busy>0xff) || (conf->stop>0xff))
+    {
+      printf("\n%s: ERROR: Invalid ntrig busy (%d) or stop (%d)\n\n",
+	     __FUNCTION__,conf->busy,conf->stop);
+      return ERROR;
+    }
+
+  if(conf->data_format > 1)
+    {
+      printf("\n%s: ERROR: Invalid data format (%d)\n\n",
+	     __FUNCTION__,conf->data_format);
+      return ERROR;
+    }
+
+  /* Everything checks out.  DAC offsets first, they are not registers. */
+  if(fa125SetOffsets(id, conf->dac) != OK)
+    return ERROR;
+
+  ped_sf = P1 | (P2<<8) | (IBIT<<16) | (ABIT<<19) | (PBIT<<22);
+
+  FA125SLOTLOCK(id);
+  deferred = fa125ShadowDeferred[id];
+  fa125ShadowDeferred[id] = 1;
+
+  FA125SWRITE(id, fe[0].config1,
+	      (conf->mode-1) | (NPK<<4) | FA125_FE_CONFIG1_ENABLE);
+  FA125SWRITE(id, fe[0].pl, PL);
+  FA125SWRITE(id, fe[0].nw, NW);
+  FA125SWRITE(id, fe[0].ie, IE | (PG<<12));
+  FA125SWRITE(id, fe[0].ped_sf, ped_sf);
+
+  for(ife=0; ife<12; ife++)
+    {
+      for(ii=0; ii<6; ii++)
+	FA125SWRITE(id, fe[ife].threshold[ii], thr[ife*6 + ii]);
+
+      /* Two channels per low, three per high timing threshold register */
+      for(ii=0; ii<3; ii++)
+	FA125SWRITE(id, fe[ife].timing_thres_lo[ii], (TL<<8) | (TL<<24));
+      for(ii=0; ii<2; ii++)
+	FA125SWRITE(id, fe[ife].timing_thres_hi[ii], TH | (TH<<9) | (TH<<18));
+
+      FA125SWRITE(id, fe[ife].config2,
+		  (conf->ch_disable[ife/4] >> ((ife%4)*6)) & FA125_FE_CONFIG2_CH_MASK);
+    }
+
+  if(conf->stop)
+    FA125SWRITE(id, proc.ntrig_busy, conf->busy | (conf->stop<<8));
+  else
+    FA125SWRITE(id, proc.ntrig_busy,
+		(FA125SREAD(id, proc.ntrig_busy) & ~FA125_NTRIG_BUSY_MASK) | conf->busy);
+  FA125SWRITE(id, proc.ctrl2,
+	      conf->data_format ? 0 : FA125_PROC_CTRL2_TRIGTIME_ENABLE);
+
+  fa125ShadowDeferred[id] = deferred;
+  if(!deferred)
+    {
+      /* The flush checks the firmware P2 + PBIT calculation */
+      if(fa125ShadowFlushLocked(id) == ERROR)
+	rval = ERROR;
+    }
+  FA125SLOTUNLOCK(id);
+
+  return rval;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Add a step to the configuration of a module.  The steps of each
+ *     module are run in order by fa125ConfigRun.
+ *  @param id Slot number
+ *  @param func Step to run, called as func(id, arg).  OK is success.
+ *     The module mutex is not held: library calls take it themselves.
+ *  @param arg Argument passed to func
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125ConfigQueue(int id, FA125_CONFIG_FUNC func, void *arg)
+{
+  int istep;
+  if(id==0) id=fa125ID[0];
+
+  if((id<0) || (id>21) || (fa125p[id] == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",__FUNCTION__,id);
+      return ERROR;
+    }
+
+  if(func == NULL)
+    {
+      printf("\n%s: ERROR: Invalid configuration step\n\n",__FUNCTION__);
+      return ERROR;
+    }
+
+  pthread_mutex_lock(&fa125ConfigMutex);
+  istep = fa125ConfigSlot[id].nstep;
+  if(istep < FA125_CONFIG_MAX_STEPS)
+    {
+      fa125ConfigSlot[id].func[istep] = func;
+      fa125ConfigSlot[id].arg[istep]  = arg;
+      fa125ConfigSlot[id].nstep++;
+    }
+  pthread_mutex_unlock(&fa125ConfigMutex);
+
+  if(istep >= FA125_CONFIG_MAX_STEPS)
+    {
+      printf("\n%s: ERROR: Slot %d already has %d configuration steps\n\n",
+	     __FUNCTION__,id,FA125_CONFIG_MAX_STEPS);
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Remove all configuration steps, and their results
+ */
+void
+fa125ConfigQueueClear()
+{
+  pthread_mutex_lock(&fa125ConfigMutex);
+  memset(fa125ConfigSlot, 0, sizeof(fa125ConfigSlot));
+  pthread_mutex_unlock(&fa125ConfigMutex);
+}
+
+static double
+fa125ConfigTime()
+{
+  struct timespec ts;
+#ifdef VXWORKS
+  clock_gettime(CLOCK_REALTIME, &ts);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/* Run the steps of one module, stopping at the first failure */
+static void
+fa125ConfigRunSlot(int id)
+{
+  int istep;
+  double t0;
+
+  /* Not under the module mutex: each step takes it as it needs, so that
+     waits of a step (e.g. fa125PowerOn) do not hold up status and readout */
+  t0 = fa125ConfigTime();
+  for(istep=0; istep<fa125ConfigSlot[id].nstep; istep++)
+    {
+      if((*fa125ConfigSlot[id].func[istep])(id, fa125ConfigSlot[id].arg[istep]) != OK)
+	{
+	  fa125ConfigSlot[id].status = ERROR;
+	  fa125ConfigSlot[id].failed = istep;
+	  break;
+	}
+    }
+  fa125ConfigSlot[id].seconds = fa125ConfigTime() - t0;
+}
+
+/* Worker: take modules until there are none left */
+static void *
+fa125ConfigWorker(void *arg)
+{
+  int ifa;
+
+  while(1)
+    {
+      pthread_mutex_lock(&fa125ConfigMutex);
+      ifa = fa125ConfigNext++;
+      pthread_mutex_unlock(&fa125ConfigMutex);
+
+      if(ifa >= nfa125)
+	break;
+
+      if(fa125ConfigSlot[fa125ID[ifa]].nstep > 0)
+	fa125ConfigRunSlot(fa125ID[ifa]);
+    }
+
+  return NULL;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Run the configuration steps of all initialized modules.
+ *     Modules are configured in parallel by worker threads, each running
+ *     the steps of one module at a time, in the order they were queued.
+ *     The steps of a module stop at its first failure.  The queue is kept,
+ *     see fa125ConfigQueueClear.
+ *  @param nthreads Number of worker threads.  0: one per module.
+ *  @return OK if every step succeeded, otherwise ERROR.
+ */
+int
+fa125ConfigRun(int nthreads)
+{
+  pthread_t worker[FA125_MAX_BOARDS];
+  int ithr, ifa, nstarted=0, rval=OK;
+
+  if((nthreads <= 0) || (nthreads > nfa125))
+    nthreads = nfa125;
+
+  fa125ConfigNext = 0;
+  for(ifa=0; ifa<nfa125; ifa++)
+    {
+      fa125ConfigSlot[fa125ID[ifa]].status = OK;
+      fa125ConfigSlot[fa125ID[ifa]].seconds = 0;
+    }
+
+  for(ithr=1; ithr<nthreads; ithr++)
+    {
+      if(pthread_create(&worker[nstarted], NULL, fa125ConfigWorker, NULL) != 0)
+	{
+	  perror("pthread_create");
+	  break;
+	}
+      nstarted++;
+    }
+
+  /* This thread is a worker too */
+  fa125ConfigWorker(NULL);
+
+  for(ithr=0; ithr<nstarted; ithr++)
+    pthread_join(worker[ithr], NULL);
+
+  for(ifa=0; ifa<nfa125; ifa++)
+    if(fa125ConfigSlot[fa125ID[ifa]].status != OK)
+      rval = ERROR;
+
+  return rval;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Return the result of the last fa125ConfigRun for a module
+ *  @param id Slot number
+ *  @param step Where to return the first step that failed, -1 if none.  May be NULL.
+ *  @param seconds Where to return the time taken by the steps.  May be NULL.
+ *  @return OK if all of the module's steps succeeded, otherwise ERROR.
+ */
+int
+fa125ConfigResult(int id, int *step, double *seconds)
+{
+  if(id==0) id=fa125ID[0];
+
+  if((id<0) || (id>21) || (fa125p[id] == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized \n\n",__FUNCTION__,id);
+      return ERROR;
+    }
+
+  if(step)
+    *step = (fa125ConfigSlot[id].status == OK) ? -1 : fa125ConfigSlot[id].failed;
+  if(seconds)
+    *seconds = fa125ConfigSlot[id].seconds;
+
+  return fa125ConfigSlot[id].status;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Print the result of the last fa125ConfigRun for all initialized modules
+ */
+void
+fa125ConfigPrintResults()
+{
+  int ifa, id;
+
+  printf("\nfADC125 Configuration\n");
+  printf("  Slot  Steps  Time (ms)  Result\n");
+  printf("--------------------------------------------------------------------------------\n");
+  for(ifa=0; ifa<nfa125; ifa++)
+    {
+      id = fa125ID[ifa];
+      printf("   %2d    %3d   %8.1f  ", id, fa125ConfigSlot[id].nstep,
+	     1e3 * fa125ConfigSlot[id].seconds);
+      if(fa125ConfigSlot[id].status != OK)
+	printf("FAILED at step %d\n", fa125ConfigSlot[id].failed);
+      else
+	printf("OK\n");
+    }
+  printf("--------------------------------------------------------------------------------\n");
+}
+
+/**
+ * @ingroup Status
+ *  @brief Return the base address of the A32 for specified module
+ *  @param id
+ *   - Slot Number
+ *  @return A32 address base, if successful. Otherwise ERROR.
+ */
+
+unsigned int
+fa125GetA32(int id)
+{
+  unsigned int rval = 0;
+  if(fa125pd[id])
+    {
+      rval = (unsigned int)((unsigned long)fa125pd[id] - fa125A32Offset);
+    }
+  else
+    {
+      logMsg("fa125GetA32(%d): A32 pointer not initialized\n",
+	     id, 2, 3, 4, 5, 6);
+      rval = ERROR;
+    }
+
+  return rval;
+}
+
+/**
+ * @ingroup Status
+ *  @brief Return the base address of the A32 Multiblock
+ *  @return A32 multiblock address base, if successful. Otherwise ERROR.
+ */
+
+unsigned int
+fa125GetA32M()
+{
+  unsigned int rval = 0;
+  if(FA125pmb)
+    {
+      rval = (unsigned int)((unsigned long)FA125pmb - fa125A32Offset);
+    }
+  else
+    {
+      logMsg("fa125GetA32M: A32M pointer not initialized\n",
+	     1, 2, 3, 4, 5, 6);
+      rval = ERROR;
+    }
+
+  return rval;
+}
+
+
+
+
+struct data_struct
+{
+  unsigned int new_type;
+  unsigned int type;
+  unsigned int slot_id_hd;
+  unsigned int mod_id_hd;
+  unsigned int slot_id_tr;
+  unsigned int n_evts;
+  unsigned int blk_num;
+  unsigned int n_words;
+  unsigned int evt_num_1;
+  unsigned int time_now;
+  unsigned int time_1;
+  unsigned int time_2;
+  unsigned int chan;
+  unsigned int width;
+  unsigned int npk;
+  unsigned int le_time;
+  unsigned int time_quality;
+  unsigned int overflow_cnt;
+  unsigned int pedestal;
+  unsigned int fm_amplitude;
+  unsigned int peak_amplitude;
+  unsigned int peak_time;
+  unsigned int valid_1;
+  unsigned int adc_1;
+  unsigned int valid_2;
+  unsigned int adc_2;
+  unsigned int over;
+  unsigned int adc_sum;
+  unsigned int pulse_num;
+  unsigned int thres_bin;
+  unsigned int quality;
+  unsigned int integral;
+  unsigned int time;
+  unsigned int chan_a;
+  unsigned int source_a;
+  unsigned int chan_b;
+  unsigned int source_b;
+  unsigned int group;
+  unsigned int time_coarse;
+  unsigned int time_fine;
+  unsigned int vmin;
+  unsigned int vpeak;
+  unsigned int scaler[18];/* data stream scalers */
+};
+
+volatile struct data_struct fadc_data;
+
+/**
+ *  @ingroup Status
+ *  @brief Decode a data word from an fADC125 and print to standard out.
+ *     State is kept between calls, so only one data stream may be decoded.
+ *  @param data 32bit fADC125 data word
+ *  @sa fa125DecodeBuffer
+*/
+void
+fa125DecodeData(unsigned int data)
+{
+  /* for new data format - 10/23/13 - EJ */
+
+  static unsigned int type_last = 15;/* initialize to type FILLER WORD */
+  static unsigned int time_last = 0;
+  static unsigned int scaler_index = 0;
+  static unsigned int num_scalers = 1;
+
+  static unsigned int slot_id_ev_hd = 0;
+  static unsigned int slot_id_dnv = 0;
+  static unsigned int slot_id_fill = 0;
+
+  static int nsamples=0;
+  static int ipk=0;
+/*   static int goto_raw=0; */
+
+  int i_print =1;
+
+  if( scaler_index )/* scaler data word */
+    {
+      fadc_data.type = 16;/* scaler data words as type 16 */
+      fadc_data.new_type = 0;
+      if( scaler_index < num_scalers )
+	{
+	  fadc_data.scaler[scaler_index - 1] = data;
+	  if( i_print )
+	    printf("%8X - SCALER(%d) = %d\n", data, (scaler_index - 1), data);
+	  scaler_index++;
+	}
+      else/* last scaler word */
+	{
+	  fadc_data.scaler[scaler_index - 1] = data;
+	  if( i_print )
+	    printf("%8X - SCALER(%d) = %d\n", data, (scaler_index - 1), data);
+	  scaler_index = 0;
+	  num_scalers = 1;
+	}
+    }
+  else/* non-scaler word */
+    {
+      if( data & 0x80000000 )/* data type defining word */
+	{
+	  fadc_data.new_type = 1;
+	  fadc_data.type = (data & 0x78000000) >> 27;
+	}
+      else/* data type continuation word */
+	{
+	  fadc_data.new_type = 0;
+	  fadc_data.type = type_last;
+	}
+
+      switch( fadc_data.type )
+	{
+	case 0:/* BLOCK HEADER */
+	  fadc_data.slot_id_hd = (data & 0x7C00000) >> 22;
+	  fadc_data.mod_id_hd =  (data &  0x3C0000) >> 18;
+	  fadc_data.n_evts =  (data & 0x000FF);
+	  fadc_data.blk_num = (data & 0x7F00) >> 8;
+	  if( i_print )
+	    printf("%8X - BLOCK HEADER - slot = %d  id = %d  n_evts = %d  n_blk = %d\n",
+		   data, fadc_data.slot_id_hd, fadc_data.mod_id_hd, fadc_data.n_evts, fadc_data.blk_num);
+	  break;
+
+	case 1:/* BLOCK TRAILER */
+	  fadc_data.slot_id_tr = (data & 0x7C00000) >> 22;
+	  fadc_data.n_words = (data & 0x3FFFFF);
+	  if( i_print )
+	    printf("%8X - BLOCK TRAILER - slot = %d   n_words = %d\n",
+		   data, fadc_data.slot_id_tr, fadc_data.n_words);
+	  break;
+
+	case 2:/* EVENT HEADER */
+	  if( fadc_data.new_type )
+	    {
+	      slot_id_ev_hd        = (data & 0x7C00000) >> 22;
+	      fadc_data.evt_num_1 =  (data & 0x03FFFFF);
+	      if( i_print )
+		printf("%8X - EVENT HEADER - slot = %d  evt_num = %d\n",
+		       data, slot_id_ev_hd, fadc_data.evt_num_1);
+	    }
+	  break;
+
+	case 3:/* TRIGGER TIME */
+	  if( fadc_data.new_type )
+	    {
+	      fadc_data.time_1 = (data & 0xFFFFFF);
+	      if( i_print )
+		printf("%8X - TRIGGER TIME 1 - time = 0x%08x\n", data, fadc_data.time_1);
+	      fadc_data.time_now = 1;
+	      time_last = 1;
+	    }
+	  else
+	    {
+	      if( time_last == 1 )
+		{
+		  fadc_data.time_2 = (data & 0xFFFFFF);
+		  if( i_print )
+		    printf("%8X - TRIGGER TIME 2 - time = 0x%08x\n", data, fadc_data.time_2);
+		  fadc_data.time_now = 2;
+		}
+	      else
+		if( i_print )
+		  printf("%8X - TRIGGER TIME - (ERROR)\n", data);
+
+	      time_last = fadc_data.time_now;
+	    }
+	  break;
+
+	case 4:/* WINDOW RAW DATA */
+          if( fadc_data.new_type )
+            {
+              fadc_data.chan = (data & 0x7F00000) >> 20;
+	      fadc_data.width = (data & 0xFFF);
+              if( i_print )
+		printf("%8X - WINDOW RAW DATA - chan = %2d   width = %d\n",
+		       data, fadc_data.chan, fadc_data.width);
+              nsamples=0;
+            }
+          else
+            {
+	      fadc_data.valid_1 = 1;
+	      fadc_data.valid_2 = 1;
+	      fadc_data.adc_1 = (data & 0x1FFF0000) >> 16;
+	      if( data & 0x20000000 )
+		fadc_data.valid_1 = 0;
+	      fadc_data.adc_2 = (data & 0x1FFF);
+	      if( data & 0x2000 )
+		fadc_data.valid_2 = 0;
+              if( i_print )
+		printf("%8X - RAW SAMPLES (%3d) - valid = %d  adc = %4d (%03X)  valid = %d  adc = %4d (%03X)\n",
+		       data, nsamples,fadc_data.valid_1, fadc_data.adc_1, fadc_data.adc_1,
+		       fadc_data.valid_2, fadc_data.adc_2, fadc_data.adc_2);
+              nsamples += 2;
+            }
+          break;
+
+	case 5:/* PULSE DATA, CDC */
+	  if( fadc_data.new_type )
+	    {
+	      fadc_data.chan = (data & 0x7F00000) >> 20;
+	      fadc_data.npk  = (data & 0xF8000)>>15;
+	      fadc_data.le_time = (data & 0x7FF0)>>4;
+	      fadc_data.time_quality = (data & (1<<3))>>3;
+	      fadc_data.overflow_cnt = (data & 0x7);
+	      if( i_print )
+		printf("%8X - PULSE DATA (CDC IT) - chan = %2d  LE time = %d  Q = %d  OVF = %d\n",
+		       data, fadc_data.chan, fadc_data.le_time,
+		       fadc_data.time_quality, fadc_data.overflow_cnt);
+	    }
+	  else
+	    {
+	      fadc_data.pedestal = (data & 0x7F800000)>>23;
+	      fadc_data.integral = (data & 0x007FFE00)>>9;
+	      fadc_data.fm_amplitude = (data & 0x000001FF);
+	      if( i_print )
+		printf("%8X - PULSE DATA (CDC IT) - ped = %d  integral = %d  firstmax ampl = %d\n",
+		       data, fadc_data.pedestal, fadc_data.integral, fadc_data.fm_amplitude);
+	    }
+	  break;
+
+	case 6:/* PULSE DATA, FDC - Integral and Time */
+	  if( fadc_data.new_type )
+	    {
+	      fadc_data.chan = (data & 0x7F00000) >> 20;
+	      fadc_data.npk  = (data & 0xF8000)>>15;
+	      fadc_data.le_time = (data & 0x7FF0)>>4;
+	      fadc_data.time_quality = (data & (1<<3))>>3;
+	      fadc_data.overflow_cnt = (data & 0x7);
+	      ipk = 0;
+	      if( i_print )
+		printf("%8X - PULSE DATA (FDC IT) - chan = %2d  NPK = %d  LE time = %d  Q = %d  OVF = %d\n",
+		       data, fadc_data.chan, fadc_data.npk, fadc_data.le_time,
+		       fadc_data.time_quality, fadc_data.overflow_cnt);
+	    }
+	  else
+	    {
+	      ipk++;
+	      fadc_data.pedestal = (data & 0x7F800000)>>23;
+	      fadc_data.integral = (data & 0x007FFE00)>>9;
+	      fadc_data.fm_amplitude = (data & 0x000001FF);
+	      if( i_print )
+		printf("%8X - PULSE DATA (FDC IT) %d - ped = %d  integral = %d  firstmax ampl = %d\n",
+		       data, ipk, fadc_data.pedestal, fadc_data.integral, fadc_data.fm_amplitude);
+	    }
+	  break;
+
+	case 9:/* PULSE DATA, FDC - Peak Ampl and Time */
+	  if( fadc_data.new_type )
+	    {
+	      fadc_data.chan = (data & 0x7F00000) >> 20;
+	      fadc_data.le_time = (data & 0x7FF0)>>4;
+	      fadc_data.time_quality = (data & (1<<3))>>3;
+	      fadc_data.overflow_cnt = (data & 0x7);
+	      ipk = 0;
+	      if( i_print )
+		printf("%8X - PULSE DATA (FDC AT) - chan = %2d  NPK = %d  LE time = %d  Q = %d  OVF = %d\n",
+		       data, fadc_data.chan, fadc_data.npk, fadc_data.le_time,
+		       fadc_data.time_quality, fadc_data.overflow_cnt);
+	    }
+	  else
+	    {
+	      ipk++;
+	      fadc_data.peak_amplitude = (data & 0x7ff80000)>>19;
+	      fadc_data.peak_time = (data & 0x0007f800)>>11;
+	      fadc_data.pedestal = (data & 0x000007ff);
+	      if( i_print )
+		printf("%8X - PULSE DATA (FDC AT) %d - Ampl = %d  Time = %d  Pedestal = %d\n",
+		       data, ipk, fadc_data.peak_amplitude, fadc_data.peak_time, fadc_data.pedestal);
+	    }
+	  break;
+
+	case 7:
+	case 8:
+	case 10:
+	case 11:
+	case 12:/* UNDEFINED TYPE */
+	  if( i_print )
+	    printf("%8X - UNDEFINED TYPE = %d\n", data, fadc_data.type);
+	  break;
+
+	case 13:/* END OF EVENT */
+	  if( i_print )
+	    printf("%8X - END OF EVENT = %d\n", data, fadc_data.type);
+	  break;
+
+	case 14:/* DATA NOT VALID (no data available) */
+	  slot_id_dnv = (data & 0x7C00000) >> 22;
+	  if( i_print )
+	    printf("%8X - DATA NOT VALID = %d  slot = %d\n", data, fadc_data.type, slot_id_dnv);
+	  break;
+
+	case 15:/* FILLER WORD */
+	  slot_id_fill = (data & 0x7C00000) >> 22;
+	  if( i_print )
+	    printf("%8X - FILLER WORD = %d  slot = %d\n", data, fadc_data.type, slot_id_fill);
+	  break;
+	}
+
+      type_last = fadc_data.type;    /* save type of current data word */
+
+    }
+
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Initialize a decoder, before the first buffer of its data stream.
+ *     A decoder keeps all of its state in dec, so that separate streams may
+ *     be decoded by separate threads.
+ *  @param dec Decoder state
+ *  @sa fa125DecodeBuffer
+ */
+void
+fa125DecodeInit(FA125_DECODER *dec)
+{
+  memset(dec, 0, sizeof(FA125_DECODER));
+}
+
+/* Return the record being decoded to func, and close it */
+static int
+fa125DecodeEmit(FA125_DECODER *dec, FA125_DECODE_FUNC func, void *arg)
+{
+  FA125_DECODE_RECORD *rec = &dec->rec;
+
+  if(dec->expect > 0)
+    rec->error |= FA125_DECODE_ERROR_TRUNCATED;
+  if((rec->type == FA125_DECODE_WINDOW_RAW) && (rec->nsamples > rec->width))
+    rec->nsamples = rec->width;
+
+  dec->open   = 0;
+  dec->expect = 0;
+  dec->nrecords++;
+  if(rec->error)
+    dec->nerrors++;
+
+  return (*func)(rec, arg);
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Decode a buffer of fADC125 data words into records.
+ *
+ *     func is called with each record, once its last continuation word is
+ *     decoded.  A record may span buffers, except for a raw window.  Its
+ *     sample words are referenced in buf, so a raw window that is not
+ *     complete at the end of buf is returned with
+ *     FA125_DECODE_ERROR_TRUNCATED.  If dec->chunked is set, the raw window
+ *     is kept open instead, to be completed by a buffer that starts at the
+ *     word after buf (the next chunk of the same readout).  Nothing is
+ *     printed or allocated.
+ *
+ *  @param dec    Decoder state, from fa125DecodeInit
+ *  @param buf    Data words
+ *  @param nwords Number of words in buf
+ *  @param swap   If 1, the words are byte swapped (VME byte order, as in a
+ *                DMA buffer on a little endian host)
+ *  @param func   Called with each record.  Decoding stops if it does not
+ *                return OK.
+ *  @param arg    Passed to func
+ *  @return Number of words decoded.  Less than nwords if stopped by func.
+ *  @sa fa125DecodeFlush, fa125DecodeSamples
+ */
+int
+fa125DecodeBuffer(FA125_DECODER *dec, const volatile UINT32 *buf, int nwords,
+		  int swap, FA125_DECODE_FUNC func, void *arg)
+{
+  FA125_DECODE_RECORD *rec = &dec->rec;
+  FA125_DECODE_PEAK *pk;
+  UINT32 data;
+  int iw;
+
+  /* A raw window continues only in the words that follow it */
+  if(dec->open && (rec->type == FA125_DECODE_WINDOW_RAW) && (buf != dec->next) &&
+     (fa125DecodeEmit(dec, func, arg) != OK))
+    return 0;
+
+  for(iw = 0; iw < nwords; iw++)
+    {
+      data = (swap) ? LSWAP(buf[iw]) : buf[iw];
+
+      if(data & FA125_DATA_TYPE_DEFINE)
+	{
+	  if(dec->open && (fa125DecodeEmit(dec, func, arg) != OK))
+	    break;
+
+	  rec->type    = (data & FA125_DATA_TYPE_MASK) >> 27;
+	  rec->error   = 0;
+	  rec->word    = data;
+	  rec->length  = 1;
+	  rec->slot    = dec->slot;
+	  rec->evt_num = dec->evt_num;
+
+	  switch(rec->type)
+	    {
+	    case FA125_DECODE_BLOCK_HEADER:
+	      rec->slot    = (data & 0x7C00000) >> 22;
+	      rec->mod_id  = (data &  0x3C0000) >> 18;
+	      rec->n_evts  = (data & 0x000FF);
+	      rec->blk_num = (data & 0x7F00) >> 8;
+	      dec->slot    = rec->slot;
+	      break;
+
+	    case FA125_DECODE_BLOCK_TRAILER:
+	      rec->slot    = (data & 0x7C00000) >> 22;
+	      rec->n_words = (data & 0x3FFFFF);
+	      break;
+
+	    case FA125_DECODE_EVENT_HEADER:
+	      rec->slot    = (data & 0x7C00000) >> 22;
+	      rec->evt_num = (data & 0x03FFFFF);
+	      dec->evt_num = rec->evt_num;
+	      break;
+
+	    case FA125_DECODE_TRIGGER_TIME:
+	      rec->time_1 = (data & 0xFFFFFF);
+	      rec->time_2 = 0;
+	      dec->expect = 1;
+	      break;
+
+	    case FA125_DECODE_WINDOW_RAW:
+	      rec->chan     = (data & 0x7F00000) >> 20;
+	      rec->width    = (data & 0xFFF);
+	      rec->nsamples = 0;
+	      rec->swap     = swap;
+	      rec->samples  = &buf[iw+1];
+	      dec->expect   = (rec->width + 1) / 2;
+	      break;
+
+	    case FA125_DECODE_PULSE_CDC:
+	    case FA125_DECODE_PULSE_FDC:
+	    case FA125_DECODE_PULSE_FDC_AMP:
+	      rec->chan         = (data & 0x7F00000) >> 20;
+	      rec->npk          = (data & 0xF8000) >> 15;
+	      rec->le_time      = (data & 0x7FF0) >> 4;
+	      rec->time_quality = (data & (1<<3)) >> 3;
+	      rec->overflow_cnt = (data & 0x7);
+	      rec->npeak        = 0;
+	      dec->expect = (rec->type == FA125_DECODE_PULSE_CDC) ? 1 : rec->npk;
+	      break;
+
+	    case FA125_DECODE_END_OF_EVENT:
+	      break;
+
+	    case FA125_DECODE_DNV:
+	    case FA125_DECODE_FILLER:
+	      rec->slot = (data & 0x7C00000) >> 22;
+	      break;
+
+	    default:
+	      rec->error = FA125_DECODE_ERROR_UNDEFINED;
+	    }
+
+	  if(dec->expect > 0)
+	    dec->open = 1;
+	  else if(fa125DecodeEmit(dec, func, arg) != OK)
+	    {
+	      iw++;
+	      break;
+	    }
+	}
+      else if(dec->open)
+	{
+	  rec->length++;
+	  dec->expect--;
+
+	  switch(rec->type)
+	    {
+	    case FA125_DECODE_TRIGGER_TIME:
+	      rec->time_2 = (data & 0xFFFFFF);
+	      break;
+
+	    case FA125_DECODE_WINDOW_RAW:
+	      rec->nsamples += 2;
+	      break;
+
+	    case FA125_DECODE_PULSE_CDC:
+	    case FA125_DECODE_PULSE_FDC:
+	      if(rec->npeak == FA125_MAX_NPK)
+		{
+		  rec->error |= FA125_DECODE_ERROR_NPK;
+		  break;
+		}
+	      pk = &rec->peak[rec->npeak++];
+	      pk->pedestal     = (data & 0x7F800000) >> 23;
+	      pk->integral     = (data & 0x007FFE00) >> 9;
+	      pk->fm_amplitude = (data & 0x000001FF);
+	      break;
+
+	    case FA125_DECODE_PULSE_FDC_AMP:
+	      if(rec->npeak == FA125_MAX_NPK)
+		{
+		  rec->error |= FA125_DECODE_ERROR_NPK;
+		  break;
+		}
+	      pk = &rec->peak[rec->npeak++];
+	      pk->peak_amplitude = (data & 0x7ff80000) >> 19;
+	      pk->peak_time      = (data & 0x0007f800) >> 11;
+	      pk->pedestal       = (data & 0x000007ff);
+	      break;
+	    }
+
+	  if((dec->expect == 0) && (fa125DecodeEmit(dec, func, arg) != OK))
+	    {
+	      iw++;
+	      break;
+	    }
+	}
+      else
+	{ /* Continuation word outside of a record */
+	  dec->nerrors++;
+	}
+    }
+
+  /* The sample words of a raw window must be in buf, or the next chunk */
+  if((iw == nwords) && dec->open && (rec->type == FA125_DECODE_WINDOW_RAW) &&
+     !dec->chunked)
+    fa125DecodeEmit(dec, func, arg);
+
+  dec->next    = &buf[iw];
+  dec->nwords += iw;
+
+  return iw;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Return a record still waiting for continuation words, at the end
+ *     of a data stream.  It is flagged FA125_DECODE_ERROR_TRUNCATED.
+ *  @param dec  Decoder state
+ *  @param func Called with the record
+ *  @param arg  Passed to func
+ *  @return OK if there was no record, otherwise the return value of func.
+ */
+int
+fa125DecodeFlush(FA125_DECODER *dec, FA125_DECODE_FUNC func, void *arg)
+{
+  if(!dec->open)
+    return OK;
+
+  return fa125DecodeEmit(dec, func, arg);
+}
+
+/* Kernel of fa125UnpackSamples and fa125SwapScan, selected by fa125SetUnpackKernel */
+static int fa125UnpackKernel=FA125_UNPACK_AUTO;
+static int fa125UnpackBest=-1;   /* Best kernel of this CPU, once checked */
+
+/* Each sample word holds sample 2n in bits 28:16 (not valid: bit 29) and
+   sample 2n+1 in bits 12:0 (not valid: bit 13).  The kernels unpack whole
+   words from word iw, and return the word reached.  The rest are left to
+   the next kernel. */
+static int
+fa125UnpackScalar(const volatile UINT32 *words, int iw, int nwords, int swap,
+		  short *adc, UINT32 *valid)
+{
+  int is;
+  UINT32 data, nv;
+
+  for(; iw < nwords; iw++)
+    {
+      data = (swap) ? LSWAP(words[iw]) : words[iw];
+      is = 2 * iw;
+
+      adc[is]   = (data & 0x1FFF0000) >> 16;
+      adc[is+1] = (data & 0x1FFF);
+      if(valid)
+	{
+	  nv = ((data >> 29) & 1) | (((data >> 13) & 1) << 1);
+	  valid[is/32] |= (nv ^ 0x3) << (is%32);
+	}
+    }
+
+  return iw;
+}
+
+#ifdef FA125_UNPACK_X86
+/* pshufb: put the two samples of each word in order, as 16 bit words */
+#define FA125_UNPACK_SHUF(_swap)					\
+  ((_swap) ?								\
+   _mm_setr_epi8(1,0,3,2, 5,4,7,6, 9,8,11,10, 13,12,15,14) :		\
+   _mm_setr_epi8(2,3,0,1, 6,7,4,5, 10,11,8,9, 14,15,12,13))
+
+__attribute__((target("ssse3")))
+static int
+fa125UnpackSSSE3(const volatile UINT32 *words, int iw, int nwords, int swap,
+		 short *adc, UINT32 *valid)
+{
+  const __m128i shuf = FA125_UNPACK_SHUF(swap);
+  const __m128i mask = _mm_set1_epi16(0x1FFF);
+  const __m128i nv   = _mm_set1_epi16(0x2000);
+  const __m128i zero = _mm_setzero_si128();
+  __m128i a, b;
+  UINT32 m;
+
+  /* 8 words, 16 samples at a time.  iw must be a multiple of 8. */
+  for(; iw + 8 <= nwords; iw += 8)
+    {
+      a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&words[iw]), shuf);
+      b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&words[iw+4]), shuf);
+      _mm_storeu_si128((__m128i *)&adc[2*iw],   _mm_and_si128(a, mask));
+      _mm_storeu_si128((__m128i *)&adc[2*iw+8], _mm_and_si128(b, mask));
+      if(valid)
+	{
+	  m = _mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(_mm_and_si128(a, nv), zero),
+						_mm_cmpeq_epi16(_mm_and_si128(b, nv), zero)));
+	  valid[iw/16] |= m << ((2*iw)%32);
+	}
+    }
+
+  return iw;
+}
+
+__attribute__((target("avx2")))
+static int
+fa125UnpackAVX2(const volatile UINT32 *words, int iw, int nwords, int swap,
+		short *adc, UINT32 *valid)
+{
+  const __m256i shuf = _mm256_broadcastsi128_si256(FA125_UNPACK_SHUF(swap));
+  const __m256i mask = _mm256_set1_epi16(0x1FFF);
+  const __m256i nv   = _mm256_set1_epi16(0x2000);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i a, b, p;
+
+  /* 16 words, 32 samples at a time.  iw must be a multiple of 16. */
+  for(; iw + 16 <= nwords; iw += 16)
+    {
+      a = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)&words[iw]), shuf);
+      b = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)&words[iw+8]), shuf);
+      _mm256_storeu_si256((__m256i *)&adc[2*iw],    _mm256_and_si256(a, mask));
+      _mm256_storeu_si256((__m256i *)&adc[2*iw+16], _mm256_and_si256(b, mask));
+      if(valid)
+	{
+	  /* packs interleaves the 128 bit lanes of a and b: put them back in order */
+	  p = _mm256_packs_epi16(_mm256_cmpeq_epi16(_mm256_and_si256(a, nv), zero),
+				 _mm256_cmpeq_epi16(_mm256_and_si256(b, nv), zero));
+	  valid[iw/16] |= _mm256_movemask_epi8(_mm256_permute4x64_epi64(p, 0xD8));
+	}
+    }
+
+  return iw;
+}
+#endif /* FA125_UNPACK_X86 */
+
+/* Return the kernel that fa125UnpackSamples uses */
+static int
+fa125UnpackSelect()
+{
+  if(fa125UnpackKernel != FA125_UNPACK_AUTO)
+    return fa125UnpackKernel;
+
+  if(fa125UnpackBest < 0)
+    {
+      fa125UnpackBest = FA125_UNPACK_SCALAR;
+#ifdef FA125_UNPACK_X86
+      __builtin_cpu_init();
+      if(__builtin_cpu_supports("avx2"))
+	fa125UnpackBest = FA125_UNPACK_AVX2;
+      else if(__builtin_cpu_supports("ssse3"))
+	fa125UnpackBest = FA125_UNPACK_SSSE3;
+#endif
+    }
+
+  return fa125UnpackBest;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Select the kernel used to unpack raw window samples, and to
+ *     swap and scan buffers (fa125SwapScan).
+ *  @param kernel
+ *      - FA125_UNPACK_AUTO:   Fastest kernel supported by the CPU (default)
+ *      - FA125_UNPACK_SCALAR: Portable C
+ *      - FA125_UNPACK_SSSE3:  x86 SSSE3
+ *      - FA125_UNPACK_AVX2:   x86 AVX2
+ *  @return OK if successful, ERROR if the kernel is not supported here.
+ */
+int
+fa125SetUnpackKernel(int kernel)
+{
+  int best;
+
+  fa125UnpackKernel = FA125_UNPACK_AUTO;
+  best = fa125UnpackSelect();
+
+  if((kernel < FA125_UNPACK_AUTO) || (kernel > best))
+    {
+      printf("%s: ERROR: Kernel %d not supported (best = %d)\n",
+	     __FUNCTION__,kernel,best);
+      return ERROR;
+    }
+
+  fa125UnpackKernel = kernel;
+  return OK;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Return the kernel used to unpack raw window samples, and to
+ *     swap and scan buffers.
+ *  @sa fa125SetUnpackKernel
+ */
+int
+fa125GetUnpackKernel()
+{
+  return fa125UnpackSelect();
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Unpack a run of raw window sample words (two samples per word).
+ *  @param words    First sample word
+ *  @param nsamples Number of samples
+ *  @param swap     If 1, the words are byte swapped (VME byte order)
+ *  @param adc      Destination of nsamples ADC values
+ *  @param valid    If not NULL, destination of a bitmap of the valid samples
+ *                  (bit N%32 of valid[N/32] for sample N), (nsamples+31)/32 words
+ *  @return Number of samples.
+ */
+int
+fa125UnpackSamples(const volatile UINT32 *words, int nsamples, int swap,
+		   short *adc, UINT32 *valid)
+{
+  int nwords = nsamples / 2, iw = 0;
+  UINT32 data;
+
+  if(nsamples <= 0)
+    return 0;
+
+  if(valid)
+    memset(valid, 0, ((nsamples + 31) / 32) * sizeof(UINT32));
+
+  switch(fa125UnpackSelect())
+    {
+#ifdef FA125_UNPACK_X86
+    case FA125_UNPACK_AVX2:
+      iw = fa125UnpackAVX2(words, iw, nwords, swap, adc, valid);
+      /* fall through, for the rest in 8 word steps */
+    case FA125_UNPACK_SSSE3:
+      iw = fa125UnpackSSSE3(words, iw, nwords, swap, adc, valid);
+      break;
+#endif
+    default:
+      break;
+    }
+  fa125UnpackScalar(words, iw, nwords, swap, adc, valid);
+
+  /* Odd number of samples: the last is the first half of the next word */
+  if(nsamples & 1)
+    {
+      data = (swap) ? LSWAP(words[nwords]) : words[nwords];
+      adc[nsamples-1] = (data & 0x1FFF0000) >> 16;
+      if(valid && !(data & 0x20000000))
+	valid[(nsamples-1)/32] |= 1U << ((nsamples-1)%32);
+    }
+
+  return nsamples;
+}
+
+/**
+ *  @ingroup Readout
+ *  @brief Unpack the samples of a raw window record.
+ *  @param rec   Raw window record, while its buffer is still valid
+ *  @param adc   Destination of rec->nsamples ADC values
+ *  @param valid If not NULL, destination of a bitmap of the valid samples
+ *               (bit N%32 of valid[N/32] for sample N), (rec->nsamples+31)/32 words
+ *  @return Number of samples, otherwise ERROR.
+ *  @sa fa125UnpackSamples
+ */
+int
+fa125DecodeSamples(const FA125_DECODE_RECORD *rec, short *adc, UINT32 *valid)
+{
+  if(rec->type != FA125_DECODE_WINDOW_RAW)
+    return ERROR;
+
+  return fa125UnpackSamples(rec->samples, rec->nsamples, rec->swap, adc, valid);
+}
+
+/* Block header and trailer words: type defining, type 0 or 1 */
+#define FA125_SCAN_MASK   0xF0000000
+#define FA125_SCAN_MATCH  (FA125_DATA_TYPE_DEFINE | FA125_DATA_BLOCK_HEADER)
+
+/* The swap and scan kernels do words from iw, and return the word reached.
+   *nmark counts all header and trailer words, the first maxmarks are stored. */
+static int
+fa125SwapScanScalar(const volatile UINT32 *src, UINT32 *dst, int iw, int nwords,
+		    int swap, int *marks, int maxmarks, int *nmark)
+{
+  UINT32 data;
+
+  for(; iw < nwords; iw++)
+    {
+      data = (swap) ? LSWAP(src[iw]) : src[iw];
+      if(dst)
+	dst[iw] = data;
+      if((data & FA125_SCAN_MASK) == FA125_SCAN_MATCH)
+	{
+	  if(*nmark < maxmarks)
+	    marks[*nmark] = iw;
+	  (*nmark)++;
+	}
+    }
+
+  return iw;
+}
+
+#ifdef FA125_UNPACK_X86
+#define FA125_SCAN_MARKS(_m, _iw)			\
+  while(_m)						\
+    {							\
+      if(*nmark < maxmarks)				\
+	marks[*nmark] = (_iw) + __builtin_ctz(_m);	\
+      (*nmark)++;					\
+      (_m) &= (_m) - 1;					\
+    }
+
+__attribute__((target("ssse3")))
+static int
+fa125SwapScanSSSE3(const volatile UINT32 *src, UINT32 *dst, int iw, int nwords,
+		   int swap, int *marks, int maxmarks, int *nmark)
+{
+  const __m128i bswap = _mm_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+  const __m128i mask  = _mm_set1_epi32(FA125_SCAN_MASK);
+  const __m128i match = _mm_set1_epi32(FA125_SCAN_MATCH);
+  __m128i v;
+  unsigned int m;
+
+  for(; iw + 4 <= nwords; iw += 4)
+    {
+      v = _mm_loadu_si128((const __m128i *)&src[iw]);
+      if(swap)
+	v = _mm_shuffle_epi8(v, bswap);
+      if(dst)
+	_mm_storeu_si128((__m128i *)&dst[iw], v);
+      m = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(v, mask), match)));
+      FA125_SCAN_MARKS(m, iw);
+    }
+
+  return iw;
+}
+
+__attribute__((target("avx2")))
+static int
+fa125SwapScanAVX2(const volatile UINT32 *src, UINT32 *dst, int iw, int nwords,
+		  int swap, int *marks, int maxmarks, int *nmark)
+{
+  const __m256i bswap = _mm256_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+					 3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+  const __m256i mask  = _mm256_set1_epi32(FA125_SCAN_MASK);
+  const __m256i match = _mm256_set1_epi32(FA125_SCAN_MATCH);
+  __m256i v;
+  unsigned int m;
+
+  for(; iw + 8 <= nwords; iw += 8)
+    {
+      v = _mm256_loadu_si256((const __m256i *)&src[iw]);
+      if(swap)
+	v = _mm256_shuffle_epi8(v, bswap);
+      if(dst)
+	_mm256_storeu_si256((__m256i *)&dst[iw], v);
+      m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(v, mask), match)));
+      FA125_SCAN_MARKS(m, iw);
+    }
+
+  return iw;
+}
+#endif /* FA125_UNPACK_X86 */
+
+/**
+ *  @ingroup Readout
+ *  @brief Byte swap a buffer of data words and find its block headers and
+ *     trailers, in one pass.
+ *  @param src      Data words
+ *  @param dst      If not NULL, destination of the (swapped) words.  May be
+ *                  src, to swap in place.
+ *  @param nwords   Number of words
+ *  @param swap     If 1, the words are byte swapped (VME byte order, as in a
+ *                  DMA buffer on a little endian host)
+ *  @param marks    Destination of the offsets of the block header and trailer
+ *                  words, in order
+ *  @param maxmarks Size of marks
+ *  @return Number of block header and trailer words.  Only the first maxmarks
+ *     are stored in marks.
+ *  @sa fa125SetUnpackKernel
+ */
+int
+fa125SwapScan(const volatile UINT32 *src, UINT32 *dst, int nwords, int swap,
+	      int *marks, int maxmarks)
+{
+  int iw = 0, nmark = 0;
+
+  switch(fa125UnpackSelect())
+    {
+#ifdef FA125_UNPACK_X86
+    case FA125_UNPACK_AVX2:
+      iw = fa125SwapScanAVX2(src, dst, iw, nwords, swap, marks, maxmarks, &nmark);
+      /* fall through, for the rest in 4 word steps */
+    case FA125_UNPACK_SSSE3:
+      iw = fa125SwapScanSSSE3(src, dst, iw, nwords, swap, marks, maxmarks, &nmark);
+      break;
+#endif
+    default:
+      break;
+    }
+  fa125SwapScanScalar(src, dst, iw, nwords, swap, marks, maxmarks, &nmark);
+
+  return nmark;
+}
+
+#define FA125_INDEX_NMARKS  64
+/* Words scanned at a time, so that the count of the marks beyond those
+   returned does not make a scan of the whole rest of the buffer */
+#define FA125_INDEX_NSCAN   4096
+
+/**
+ *  @ingroup Readout
+ *  @brief Index the blocks of a readout buffer, from a scan of its block
+ *     header and trailer words (fa125SwapScan).  The buffer is not modified.
+ *  @param buf      Data words
+ *  @param nwords   Number of words
+ *  @param swap     If 1, the words are byte swapped (VME byte order, as in a
+ *                  DMA buffer on a little endian host)
+ *  @param index    Destination of the blocks, in buffer order.  May be NULL
+ *                  if maxindex is 0.
+ *  @param maxindex Size of index
+ *  @return Number of blocks, of which only the first maxindex are stored in
+ *     index.  ERROR if a header has no trailer (or the reverse), or a trailer
+ *     does not match the slot or word count of its block.
+ */
+int
+fa125IndexBlocks(const volatile UINT32 *buf, int nwords, int swap,
+		 FA125_BLOCK_INDEX *index, int maxindex)
+{
+  int marks[FA125_INDEX_NMARKS];
+  int base = 0, nscan, nmark, imark, iw, start = -1, nblk = 0;
+  unsigned int word, head = 0;
+
+  if((buf == NULL) || ((index == NULL) && (maxindex > 0)))
+    {
+      FA125LOGMSG("\n%s: ERROR: Invalid buffer or index pointer\n\n", __FUNCTION__,
+		  0,0,0,0,0);
+      return ERROR;
+    }
+
+  while(base < nwords)
+    {
+      nscan = nwords - base;
+      if(nscan > FA125_INDEX_NSCAN)
+	nscan = FA125_INDEX_NSCAN;
+      nmark = fa125SwapScan(&buf[base], NULL, nscan, swap,
+			    marks, FA125_INDEX_NMARKS);
+
+      for(imark = 0; (imark < nmark) && (imark < FA125_INDEX_NMARKS); imark++)
+	{
+	  iw = base + marks[imark];
+	  word = swap ? LSWAP(buf[iw]) : buf[iw];
+
+	  if((word & FA125_DATA_TYPE_MASK) == FA125_DATA_BLOCK_HEADER)
+	    {
+	      if(start >= 0)
+		return ERROR;
+	      start = iw;
+	      head  = word;
+	      continue;
+	    }
+
+	  if((start < 0) || ((word & 0x3FFFFF) != (iw - start + 1)) ||
+	     ((word & 0x7C00000) != (head & 0x7C00000)))
+	    return ERROR;
+
+	  if(nblk < maxindex)
+	    {
+	      index[nblk].slot    = (head & 0x7C00000) >> 22;
+	      index[nblk].offset  = start;
+	      index[nblk].length  = iw - start + 1;
+	      index[nblk].blknum  = (head & 0x7F00) >> 8;
+	      index[nblk].nevents = head & 0xFF;
+	    }
+	  nblk++;
+	  start = -1;
+	}
+
+      if(nmark <= FA125_INDEX_NMARKS)
+	base += nscan;
+      else
+	base += marks[FA125_INDEX_NMARKS - 1] + 1;
+    }
+
+  if(start >= 0)
+    return ERROR;
+
+  return nblk;
+}
+
+/************************************************************
+ *  fa125 Deferred logging
+ ************************************************************/
+#ifndef VXWORKS
+/* Messages are queued by FA125LOGMSG in a bounded ring (multiple producers,
+   single consumer), and formatted and written by the thread started with
+   fa125LogStart.  Producers never block: a full ring drops the message.
+   Each format is limited to fa125LogRate messages per second; the rest are
+   counted and reported with its next message. */
+#define FA125_LOG_NENTRY  1024    /* ring entries, a power of 2 */
+#define FA125_LOG_NFMT    128     /* formats with a rate limit */
+#define FA125_LOG_NARGS   6
+
+struct fa125_log_entry
+{
+  unsigned long seq;              /* ring position this entry holds (+1 when filled) */
+  const char   *fmt;
+  long          arg[FA125_LOG_NARGS];
+};
+
+struct fa125_log_fmt
+{
+  const char   *fmt;              /* NULL if unused */
+  long          second;           /* rate limit window */
+  unsigned int  count;            /* messages in the window */
+  unsigned int  suppressed;       /* messages over the limit, not yet reported */
+};
+
+static struct fa125_log_entry fa125LogRing[FA125_LOG_NENTRY];
+static struct fa125_log_fmt   fa125LogFmt[FA125_LOG_NFMT];
+static unsigned long fa125LogHead=0;       /* next position to fill */
+static unsigned long fa125LogTail=0;       /* next position to write (consumer only) */
+static int fa125LogRingInit=0;
+static int fa125LogRunning=0;              /* Whether (1) or not (0) the log thread runs */
+static int fa125LogStopping=0;
+static int fa125LogRate=10;                /* messages per second per format, 0 for no limit */
+static unsigned long long fa125LogNdropped=0, fa125LogNsuppressed=0, fa125LogNwritten=0;
+static pthread_t fa125LogThreadId;
+static pthread_mutex_t fa125LogMutex = PTHREAD_MUTEX_INITIALIZER; /* start and stop only */
+
+static void
+fa125LogInitRing()
+{
+  unsigned long ie;
+
+  for(ie = 0; ie < FA125_LOG_NENTRY; ie++)
+    __atomic_store_n(&fa125LogRing[ie].seq, ie, __ATOMIC_RELAXED);
+  fa125LogHead = fa125LogTail = 0;
+  __atomic_store_n(&fa125LogRingInit, 1, __ATOMIC_RELEASE);
+}
+
+/* Rate limit entry of a format.  Entries are claimed once and never freed. */
+static struct fa125_log_fmt *
+fa125LogFindFmt(const char *fmt)
+{
+  unsigned long hash = ((unsigned long)fmt >> 3) * 2654435761UL;
+  const char *expected;
+  int ii, ifmt;
+
+  for(ii = 0; ii < FA125_LOG_NFMT; ii++)
+    {
+      ifmt = (hash + ii) % FA125_LOG_NFMT;
+      expected = __atomic_load_n(&fa125LogFmt[ifmt].fmt, __ATOMIC_ACQUIRE);
+      if(expected == fmt)
+	return &fa125LogFmt[ifmt];
+      if((expected == NULL) &&
+	 (__atomic_compare_exchange_n(&fa125LogFmt[ifmt].fmt, &expected, fmt, 0,
+				      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ||
+	  (expected == fmt)))
+	return &fa125LogFmt[ifmt];
+    }
+
+  return NULL;
+}
+
+/* Whether (1) or not (0) a message of this format may go out now */
+static int
+fa125LogAllow(struct fa125_log_fmt *f)
+{
+  struct timespec ts;
+  long second;
+  int rate = fa125LogRate;
+
+  if((f == NULL) || (rate <= 0))
+    return 1;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  second = ts.tv_sec;
+  if(__atomic_load_n(&f->second, __ATOMIC_RELAXED) != second)
+    {
+      __atomic_store_n(&f->second, second, __ATOMIC_RELAXED);
+      __atomic_store_n(&f->count, 0, __ATOMIC_RELAXED);
+    }
+
+  if(__atomic_fetch_add(&f->count, 1, __ATOMIC_RELAXED) < (unsigned int)rate)
+    return 1;
+
+  __atomic_fetch_add(&f->suppressed, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&fa125LogNsuppressed, 1, __ATOMIC_RELAXED);
+  return 0;
+}
+
+/* Print a message, passing each argument at the width its conversion
+   expects (the arguments are queued as long) */
+static void
+fa125LogPrint(const char *fmt, const long *arg)
+{
+  char spec[32];
+  const char *c = fmt;
+  int iarg = 0, ns, nlong;
+
+  while(*c)
+    {
+      if(*c != '%')
+	{
+	  putchar(*c++);
+	  continue;
+	}
+      if(c[1] == '%')
+	{
+	  putchar('%');
+	  c += 2;
+	  continue;
+	}
+
+      /* Copy the conversion: flags, width, precision, length and type */
+      ns = 0; nlong = 0;
+      spec[ns++] = *c++;
+      while(*c && strchr("-+ #0123456789.hl", *c) && (ns < (int)sizeof(spec) - 2))
+	{
+	  if(*c == 'l')
+	    nlong++;
+	  spec[ns++] = *c++;
+	}
+      if(*c == '\0')
+	break;
+      spec[ns++] = *c;
+      spec[ns]   = '\0';
+
+      if(iarg >= FA125_LOG_NARGS)
+	fputs(spec, stdout);
+      else if((*c == 's') || (*c == 'p'))
+	printf(spec, (void *)arg[iarg++]);
+      else if(nlong > 1)
+	printf(spec, (long long)arg[iarg++]);
+      else if(nlong)
+	printf(spec, arg[iarg++]);
+      else
+	printf(spec, (int)arg[iarg++]);
+      c++;
+    }
+}
+
+/* Write one message, and the number of its format suppressed since the last */
+static void
+fa125LogWrite(const char *fmt, const long *arg)
+{
+  struct fa125_log_fmt *f = fa125LogFindFmt(fmt);
+  unsigned int suppressed = 0;
+
+  if(f)
+    suppressed = __atomic_exchange_n(&f->suppressed, 0, __ATOMIC_RELAXED);
+
+  fa125LogPrint(fmt, arg);
+  if(suppressed)
+    printf("fa125: (%u similar messages suppressed)\n", suppressed);
+}
+
+/* Consumer: write queued messages until stopped and the ring is empty */
+static void *
+fa125LogThread(void *arg)
+{
+  struct fa125_log_entry *e;
+  struct timespec pause = {0, 1000000};
+  long msg[FA125_LOG_NARGS];
+  const char *fmt;
+  int nwritten;
+
+  while(1)
+    {
+      nwritten = 0;
+      while(1)
+	{
+	  e = &fa125LogRing[fa125LogTail & (FA125_LOG_NENTRY - 1)];
+	  if(__atomic_load_n(&e->seq, __ATOMIC_ACQUIRE) != fa125LogTail + 1)
+	    break;
+
+	  fmt = e->fmt;
+	  memcpy(msg, e->arg, sizeof(msg));
+	  __atomic_store_n(&e->seq, fa125LogTail + FA125_LOG_NENTRY, __ATOMIC_RELEASE);
+	  fa125LogTail++;
+
+	  fa125LogWrite(fmt, msg);
+	  fa125LogNwritten++;
+	  nwritten++;
+	}
+
+      if(nwritten)
+	fflush(stdout);
+      else if(__atomic_load_n(&fa125LogStopping, __ATOMIC_ACQUIRE))
+	break;
+      else
+	nanosleep(&pause, NULL);
+    }
+
+  return NULL;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Queue a message for the log thread (fa125LogStart), as logMsg
+ *     with its format and up to six arguments.  Use FA125LOGMSG.  The format
+ *     and string arguments must be static: they are used when the message is
+ *     written.  Without the log thread, the message is written at once.
+ *     Never blocks: a message that does not fit in the queue is dropped.
+ *  @param fmt Format
+ */
+void
+fa125LogMsg(const char *fmt, long a1, long a2, long a3, long a4, long a5, long a6)
+{
+  struct fa125_log_entry *e;
+  unsigned long pos, seq;
+
+  if(!fa125LogAllow(fa125LogFindFmt(fmt)))
+    return;
+
+  if(!__atomic_load_n(&fa125LogRunning, __ATOMIC_ACQUIRE))
+    {
+      long arg[FA125_LOG_NARGS] = {a1, a2, a3, a4, a5, a6};
+
+      fa125LogPrint(fmt, arg);
+      return;
+    }
+
+  pos = __atomic_load_n(&fa125LogHead, __ATOMIC_RELAXED);
+  while(1)
+    {
+      e = &fa125LogRing[pos & (FA125_LOG_NENTRY - 1)];
+      seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+      if(seq == pos)
+	{
+	  if(__atomic_compare_exchange_n(&fa125LogHead, &pos, pos + 1, 1,
+					 __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+	    break;
+	}
+      else if((long)(seq - pos) < 0)
+	{ /* Full */
+	  __atomic_fetch_add(&fa125LogNdropped, 1, __ATOMIC_RELAXED);
+	  return;
+	}
+      else
+	pos = __atomic_load_n(&fa125LogHead, __ATOMIC_RELAXED);
+    }
+
+  e->fmt    = fmt;
+  e->arg[0] = a1; e->arg[1] = a2; e->arg[2] = a3;
+  e->arg[3] = a4; e->arg[4] = a5; e->arg[5] = a6;
+  __atomic_store_n(&e->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Start the thread that writes the messages of FA125LOGMSG.  From
+ *     then on, the readout and error paths of the library queue their
+ *     messages instead of writing them.
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125LogStart()
+{
+  int rval = OK;
+
+  pthread_mutex_lock(&fa125LogMutex);
+  if(!fa125LogRunning)
+    {
+      if(!fa125LogRingInit)
+	fa125LogInitRing();
+      fa125LogStopping = 0;
+      if(pthread_create(&fa125LogThreadId, NULL, fa125LogThread, NULL) != 0)
+	{
+	  printf("\n%s: ERROR: Unable to start the log thread\n\n", __FUNCTION__);
+	  rval = ERROR;
+	}
+      else
+	__atomic_store_n(&fa125LogRunning, 1, __ATOMIC_RELEASE);
+    }
+  pthread_mutex_unlock(&fa125LogMutex);
+
+  return rval;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Write the queued messages and stop the log thread.  Messages are
+ *     written at once from then on.
+ */
+void
+fa125LogStop()
+{
+  pthread_mutex_lock(&fa125LogMutex);
+  if(fa125LogRunning)
+    {
+      __atomic_store_n(&fa125LogRunning, 0, __ATOMIC_RELEASE);
+      __atomic_store_n(&fa125LogStopping, 1, __ATOMIC_RELEASE);
+      pthread_join(fa125LogThreadId, NULL);
+    }
+  pthread_mutex_unlock(&fa125LogMutex);
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Set the number of messages of each format written per second.
+ *     The rest are counted, and reported with the next message written.
+ *  @param per_second Messages per second, 0 for no limit
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125LogSetRateLimit(int per_second)
+{
+  if(per_second < 0)
+    {
+      printf("\n%s: ERROR: Invalid rate (%d)\n\n", __FUNCTION__, per_second);
+      return ERROR;
+    }
+
+  fa125LogRate = per_second;
+
+  return OK;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Return the message counts of the deferred log
+ *  @param written    If not NULL, messages written by the log thread
+ *  @param dropped    If not NULL, messages dropped with the queue full
+ *  @param suppressed If not NULL, messages over the rate limit
+ */
+void
+fa125LogGetStats(unsigned long long *written, unsigned long long *dropped,
+		 unsigned long long *suppressed)
+{
+  if(written)
+    *written = __atomic_load_n(&fa125LogNwritten, __ATOMIC_RELAXED);
+  if(dropped)
+    *dropped = __atomic_load_n(&fa125LogNdropped, __ATOMIC_RELAXED);
+  if(suppressed)
+    *suppressed = __atomic_load_n(&fa125LogNsuppressed, __ATOMIC_RELAXED);
+}
+
+#else /* VXWORKS */
+/* FA125LOGMSG is logMsg, whose own task already writes the messages.  There
+   is no thread to start, and no rate limit. */
+int
+fa125LogStart()
+{
+  return OK;
+}
+
+void
+fa125LogStop()
+{
+}
+
+int
+fa125LogSetRateLimit(int per_second)
+{
+  if(per_second < 0)
+    {
+      printf("\n%s: ERROR: Invalid rate (%d)\n\n", __FUNCTION__, per_second);
+      return ERROR;
+    }
+
+  return OK;
+}
+
+void
+fa125LogGetStats(unsigned long long *written, unsigned long long *dropped,
+		 unsigned long long *suppressed)
+{
+  if(written)
+    *written = 0;
+  if(dropped)
+    *dropped = 0;
+  if(suppressed)
+    *suppressed = 0;
+}
+#endif /* VXWORKS */
+
+/************************************************************
+ *  fa125 DMA calibration
+ ************************************************************/
+/* fa125DmaCalibrate times DMA of each mode, and programmed I/O, from the
+   FIFO of a module.  With its bus errors off, an empty FIFO returns filler
+   words for as long as it is read, so no data is needed.  Each word read
+   is checked to be filler: anything else is data, and the calibration
+   stops. */
+#define FA125_DMA_CAL_SHORT  16   /* words of the short test transfer */
+#define FA125_DMA_CAL_NREP   8    /* repeats, the fastest is kept */
+#define FA125_DMA_CAL_BERR   4    /* cycles of programmed I/O to turn bus errors off and on */
+
+static const char *fa125DmaModeName[FA125_DMA_NMODES] =
+  {"BLK32", "MBLK", "2eVME", "2eSST160", "2eSST267", "2eSST320"};
+
+#ifndef VXWORKS
+static const unsigned int fa125DmaModeType[FA125_DMA_NMODES] = {2, 3, 4, 5, 5, 5};
+static const unsigned int fa125DmaModeSst[FA125_DMA_NMODES]  = {0, 0, 0, 0, 1, 2};
+
+/* Whether (1) or not (0) a word read from an empty FIFO is filler */
+#define FA125_DMA_CAL_ISFILLER(_w)					\
+  (((_w) & (FA125_DATA_TYPE_DEFINE | FA125_DATA_TYPE_MASK)) ==		\
+   (FA125_DATA_TYPE_DEFINE | FA125_DATA_FILLER))
+
+/* ns of a DMA of nwords from the FIFO of module id, -1 if it failed,
+   or -2 if it read data */
+static long long
+fa125DmaCalTime(int id, volatile UINT32 *buf, int nwords)
+{
+  unsigned int vmeAdr = (unsigned int)((unsigned long)fa125pd[id] - fa125A32Offset);
+  long long t;
+  int iw;
+
+  t = fa125ReadoutNsec();
+  if(vmeDmaSend((unsigned long)buf, vmeAdr, (nwords<<2)) != 0)
+    return -1;
+  if(vmeDmaDone() != (nwords<<2))
+    return -1;
+  t = fa125ReadoutNsec() - t;
+
+  for(iw = 0; iw < nwords; iw++)
+    {
+#ifdef VXWORKS
+      if(!FA125_DMA_CAL_ISFILLER(buf[iw]))
+#else
+      if(!FA125_DMA_CAL_ISFILLER(LSWAP(buf[iw])))
+#endif
+	return -2;
+    }
+
+  return t;
+}
+
+/**
+ *  @ingroup Config
+ *  @brief Choose the DMA transfer mode of the crate, and the block length
+ *     below which programmed I/O is faster than DMA.
+ *
+ *     Short and long test transfers are timed in each A32 mode (BLK32, MBLK,
+ *     2eVME, and 2eSST at each rate) from the FIFO of the module, with its
+ *     bus errors turned off.  The fixed and per word cost of each mode are
+ *     fitted from the fastest of several repeats.  The mode fastest on the
+ *     long transfer is set with vmeDmaConfig.  Programmed I/O is timed the
+ *     same way, and blocks shorter than the crossover are read by programmed
+ *     I/O with fa125ReadBlock rflag 0x20.
+ *
+ *     vmeDmaConfig sets the mode of the DMA engine of the crate, which other
+ *     modules (e.g. the TI) also read with.  modemask keeps to the modes
+ *     they support.
+ *
+ *     To be called at Download, with no readout in progress and the FIFO of
+ *     the module empty.  The calibration stops with an error if it reads
+ *     anything but filler words.
+ *
+ *  @param id       Slot number of the module to read
+ *  @param buf      DMA memory of at least 2*FA125_DMA_CAL_SHORT words
+ *                     (physical memory, as for fa125ReadBlock)
+ *  @param nwords   Words of buf.  At most FA125_DMA_CAL_WORDS are used.
+ *  @param modemask Modes that may be chosen (FA125_DMA_MODE_*), 0 for all
+ *  @param pflag    If 1, print the results (fa125PrintDmaCalibration)
+ *  @return OK if successful, ERROR if no mode worked or the FIFO was not empty.
+ *     After an ERROR, the caller sets the DMA mode with vmeDmaConfig.
+ */
+int
+fa125DmaCalibrate(int id, volatile UINT32 *buf, int nwords, unsigned int modemask,
+		  int pflag)
+{
+  FA125ACCT_ENTRY;
+  FA125_DMA_CALIBRATION cal;
+  long long t, t0, tshort, tlong, tpio, tbest = 0;
+  unsigned int ctrl1;
+  int imode, irep, iw, nlong, nshort = FA125_DMA_CAL_SHORT, notempty = 0;
+  double pio, word, n;
+
   if(id==0) id=fa125ID[0];
 
-  if((id<=0) || (id>21) || (fa125p[id] == NULL))
+  if((id<=0) || (id>21) || (fa125p[id] == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized \n\n", __FUNCTION__, id);
+      return ERROR;
+    }
+
+  /* Keep to an 8 byte boundary */
+  if((buf != NULL) && ((unsigned long)buf & 0x7))
+    {
+      buf++;
+      nwords--;
+    }
+
+  nlong = (nwords < FA125_DMA_CAL_WORDS) ? nwords : FA125_DMA_CAL_WORDS;
+  if((buf == NULL) || (nlong < 2 * nshort))
+    {
+      printf("\n%s: ERROR: Invalid buffer (%d words)\n\n", __FUNCTION__, nwords);
+      return ERROR;
+    }
+
+  memset(&cal, 0, sizeof(cal));
+
+  FA125LOCK;
+  if(fa125DmaPending)
+    {
+      FA125UNLOCK;
+      printf("\n%s: ERROR: DMA in progress\n\n", __FUNCTION__);
+      return ERROR;
+    }
+  FA125SLOTLOCK(id);
+
+  ctrl1 = vmeRead32(&fa125p[id]->main.ctrl1);
+  vmeWrite32(&fa125p[id]->main.ctrl1, ctrl1 & ~FA125_CTRL1_ENABLE_BERR);
+
+  for(imode = 0; (imode < FA125_DMA_NMODES) && !notempty; imode++)
+    {
+      cal.dataType[imode] = fa125DmaModeType[imode];
+      cal.sstMode[imode]  = fa125DmaModeSst[imode];
+      if(modemask && !(modemask & (1<<imode)))
+	continue;
+      if(vmeDmaConfig(2, cal.dataType[imode], cal.sstMode[imode]) != OK)
+	continue;
+
+      tshort = tlong = -1;
+      for(irep = 0; irep < FA125_DMA_CAL_NREP; irep++)
+	{
+	  t = fa125DmaCalTime(id, buf, nshort);
+	  if(t < 0)
+	    break;
+	  if((tshort < 0) || (t < tshort))
+	    tshort = t;
+
+	  t = fa125DmaCalTime(id, buf, nlong);
+	  if(t < 0)
+	    break;
+	  if((tlong < 0) || (t < tlong))
+	    tlong = t;
+	}
+      if(t == -2)
+	notempty = 1;
+      if(irep < FA125_DMA_CAL_NREP)
+	continue;
+
+      word = (double)(tlong - tshort) / (nlong - nshort);
+      if(word < 0)
+	word = 0;
+      cal.ok[imode]       = 1;
+      cal.word_ns[imode]  = word;
+      cal.setup_ns[imode] = (tshort > nshort * word) ? tshort - nshort * word : 0;
+
+      if(!cal.valid || (tlong < tbest))
+	{
+	  cal.valid = 1;
+	  cal.best  = imode;
+	  tbest     = tlong;
+	}
+    }
+
+  tpio = -1;
+  for(irep = 0; (irep < FA125_DMA_CAL_NREP) && !notempty; irep++)
     {
-      printf("\n%s: ERROR : FA125 in slot %d is not initialized\n\n",
-	     __FUNCTION__, id);
-      return(ERROR);
+      t0 = fa125ReadoutNsec();
+      for(iw = 0; iw < nshort; iw++)
+	buf[iw] = vmeRead32(&fa125pd[id]->data);
+      t = fa125ReadoutNsec() - t0;
+      if((tpio < 0) || (t < tpio))
+	tpio = t;
+
+      for(iw = 0; iw < nshort; iw++)
+	if(!FA125_DMA_CAL_ISFILLER(buf[iw]))
+	  notempty = 1;
     }
 
-  if((suppress < 0) || (suppress > 1))
+  vmeWrite32(&fa125p[id]->main.ctrl1, ctrl1);
+
+  if(notempty)
+    cal.valid = 0;
+
+  if(cal.valid)
     {
-      printf("\n%s: ERROR: Invalid suppress value (%d)\n\n",
-	     __FUNCTION__, suppress);
-      return ERROR;
-    }
+      /* Programmed I/O of n words, and the bus error toggle, is faster
+	 below n = (setup - berr * pio) / (pio - word) */
+      pio  = (double)tpio / nshort;
+      word = cal.word_ns[cal.best];
+      cal.pio_word_ns = pio;
+      if(pio <= word)
+	cal.crossover = FA125_DMA_CAL_WORDS;
+      else
+	{
+	  n = (cal.setup_ns[cal.best] - FA125_DMA_CAL_BERR * pio) / (pio - word);
+	  cal.crossover = (n <= 0) ? 0 :
+	    (n >= FA125_DMA_CAL_WORDS) ? FA125_DMA_CAL_WORDS : (int)n;
+	}
 
-  if(suppress)
-    val = 0;
+      vmeDmaConfig(2, cal.dataType[cal.best], cal.sstMode[cal.best]);
+      fa125DmaCal = cal;
+    }
   else
-    val = FA125_PROC_CTRL2_TRIGTIME_ENABLE;
+    fa125DmaCal.valid = 0;
 
-  FA125LOCK;
-  vmeWrite32(&fa125p[id]->proc.ctrl2, val);
+  FA125SLOTUNLOCK(id);
   FA125UNLOCK;
 
+  if(notempty)
+    {
+      printf("\n%s: ERROR: FIFO of slot %d is not empty\n\n", __FUNCTION__, id);
+      return ERROR;
+    }
+
+  if(!cal.valid)
+    {
+      printf("\n%s: ERROR: No DMA mode worked from slot %d\n\n", __FUNCTION__, id);
+      return ERROR;
+    }
+
+  if(pflag)
+    fa125PrintDmaCalibration();
+
   return OK;
 }
+#endif /* VXWORKS */
 
 /**
  *  @ingroup Config
- *  @brief Enable/Disable suppression of one or both of the trigger time words
- *    in the data stream for all initialized modules.
- *  @param suppress Suppression Flag
- *      -  0: Trigger time words are enabled in datastream
- *      -  1: Suppress BOTH trigger time words
+ *  @brief Set the block length below which fa125ReadBlock rflag 0x20 reads
+ *     by programmed I/O.  Set by fa125DmaCalibrate.
+ *  @param nwords Words.  0 to always use DMA.
+ *  @return OK if successful, otherwise ERROR.
  */
-void
-fa125GDataSuppressTriggerTime(int suppress)
+int
+fa125SetReadCrossover(int nwords)
 {
-  int ifa;
+  if(nwords < 0)
+    {
+      printf("\n%s: ERROR: Invalid crossover (%d)\n\n", __FUNCTION__, nwords);
+      return ERROR;
+    }
 
-  for(ifa = 0; ifa < nfa125; ifa++)
-    fa125DataSuppressTriggerTime(fa125Slot(ifa), suppress);
+  FA125LOCK;
+  fa125DmaCal.crossover = nwords;
+  FA125UNLOCK;
 
+  return OK;
 }
 
 /**
- * @ingroup Status
- *  @brief Return the base address of the A32 for specified module
- *  @param id
- *   - Slot Number
- *  @return A32 address base, if successful. Otherwise ERROR.
+ *  @ingroup Status
+ *  @brief Return the results of fa125DmaCalibrate
+ *  @param cal Where to put the results
+ *  @return OK if the crate was calibrated, otherwise ERROR.
  */
+int
+fa125GetDmaCalibration(FA125_DMA_CALIBRATION *cal)
+{
+  if(cal == NULL)
+    return ERROR;
 
-unsigned int
-fa125GetA32(int id)
+  FA125LOCK;
+  *cal = fa125DmaCal;
+  FA125UNLOCK;
+
+  return cal->valid ? OK : ERROR;
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Print the results of fa125DmaCalibrate
+ */
+void
+fa125PrintDmaCalibration()
 {
-  unsigned int rval = 0;
-  if(fa125pd[id])
+  FA125_DMA_CALIBRATION cal;
+  int imode;
+
+  fa125GetDmaCalibration(&cal);
+
+  printf("\nfa125 DMA calibration\n");
+  printf("--------------------------------------------------------------------------------\n");
+  if(cal.valid)
     {
-      rval = (unsigned int)((unsigned long)fa125pd[id] - fa125A32Offset);
+      printf("  Mode         Setup (us)   ns/word      MB/s\n");
+      for(imode = 0; imode < FA125_DMA_NMODES; imode++)
+	{
+	  if(cal.ok[imode])
+	    printf("%s %-10s %11.2f %9.2f %9.1f\n", (imode == cal.best) ? " *" : "  ",
+		   fa125DmaModeName[imode], 1e-3 * cal.setup_ns[imode], cal.word_ns[imode],
+		   (cal.word_ns[imode] > 0) ? 4e3 / cal.word_ns[imode] : 0.);
+	  else
+	    printf("   %-10s      failed\n", fa125DmaModeName[imode]);
+	}
+      printf("   %-10s %11s %9.2f %9.1f\n", "PIO", "",
+	     cal.pio_word_ns, (cal.pio_word_ns > 0) ? 4e3 / cal.pio_word_ns : 0.);
+      printf("\n  DMA mode: %s (vmeDmaConfig(2,%d,%d))\n", fa125DmaModeName[cal.best],
+	     cal.dataType[cal.best], cal.sstMode[cal.best]);
     }
   else
-    {
-      logMsg("fa125GetA32(%d): A32 pointer not initialized\n",
-	     id, 2, 3, 4, 5, 6);
-      rval = ERROR;
-    }
+    printf("  Not calibrated\n");
+  printf("  Programmed I/O below %d words (fa125ReadBlock rflag 0x20)\n\n", cal.crossover);
+}
 
-  return rval;
+#ifndef VXWORKS
+/************************************************************
+ *  fa125 VME transaction accounting
+ ************************************************************/
+
+static void
+fa125AcctCopy(FA125_VME_COUNTS *dst, FA125_VME_COUNTS *src)
+{
+  unsigned long long *d = (unsigned long long *)dst, *s = (unsigned long long *)src;
+  int ic, nc = sizeof(FA125_VME_COUNTS) / sizeof(unsigned long long);
+
+  for(ic = 0; ic < nc; ic++)
+    d[ic] = __atomic_load_n(&s[ic], __ATOMIC_RELAXED);
+}
+
+static void
+fa125AcctClear(FA125_VME_COUNTS *c)
+{
+  unsigned long long *d = (unsigned long long *)c;
+  int ic, nc = sizeof(FA125_VME_COUNTS) / sizeof(unsigned long long);
+
+  for(ic = 0; ic < nc; ic++)
+    __atomic_store_n(&d[ic], 0, __ATOMIC_RELAXED);
 }
 
 /**
- * @ingroup Status
- *  @brief Return the base address of the A32 Multiblock
- *  @return A32 multiblock address base, if successful. Otherwise ERROR.
+ *  @ingroup Status
+ *  @brief Return the VME transactions of a library routine, since the last
+ *     fa125ResetVmeCounts.  The transactions of routines it calls are
+ *     counted for it.  Transactions are only counted by a library built
+ *     with -DFA125_ACCT.
+ *  @param api    Name of the routine, e.g. "fa125Status"
+ *  @param counts Destination of the counts.  All zero if the routine made
+ *     no VME transaction.
+ *  @return OK if successful, otherwise ERROR.
  */
-
-unsigned int
-fa125GetA32M()
+int
+fa125GetVmeCountsApi(const char *api, FA125_VME_COUNTS *counts)
 {
-  unsigned int rval = 0;
-  if(FA125pmb)
+  const char *name;
+  int iapi;
+
+  if((api == NULL) || (counts == NULL))
     {
-      rval = (unsigned int)((unsigned long)FA125pmb - fa125A32Offset);
+      printf("\n%s: ERROR: Invalid routine name or counts pointer\n\n", __FUNCTION__);
+      return ERROR;
     }
-  else
+
+  memset(counts, 0, sizeof(FA125_VME_COUNTS));
+  for(iapi = 0; iapi < FA125_ACCT_NAPI; iapi++)
     {
-      logMsg("fa125GetA32M: A32M pointer not initialized\n",
-	     1, 2, 3, 4, 5, 6);
-      rval = ERROR;
+      name = __atomic_load_n(&fa125AcctApi[iapi].name, __ATOMIC_ACQUIRE);
+      if(name && (strcmp(name, api) == 0))
+	{
+	  fa125AcctCopy(counts, &fa125AcctApi[iapi].c);
+	  break;
+	}
     }
 
-  return rval;
+  return OK;
 }
 
+/**
+ *  @ingroup Status
+ *  @brief Return the VME transactions addressed to a module, since the last
+ *     fa125ResetVmeCounts.  Multiblock DMAs are counted for the crate
+ *     (fa125PrintVmeCounts).
+ *  @param id     Slot number
+ *  @param counts Destination of the counts.  calls is not used.
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125GetVmeCountsSlot(int id, FA125_VME_COUNTS *counts)
+{
+  if(id==0) id=fa125ID[0];
 
+  if((id<=0) || (id>21) || (fa125p[id] == NULL) || (counts == NULL))
+    {
+      printf("\n%s: ERROR : FA125 in slot %d is not initialized\n\n",__FUNCTION__,id);
+      return ERROR;
+    }
 
+  fa125AcctCopy(counts, &fa125AcctSlot[id]);
 
-struct data_struct
-{
-  unsigned int new_type;
-  unsigned int type;
-  unsigned int slot_id_hd;
-  unsigned int mod_id_hd;
-  unsigned int slot_id_tr;
-  unsigned int n_evts;
-  unsigned int blk_num;
-  unsigned int n_words;
-  unsigned int evt_num_1;
-  unsigned int time_now;
-  unsigned int time_1;
-  unsigned int time_2;
-  unsigned int chan;
-  unsigned int width;
-  unsigned int npk;
-  unsigned int le_time;
-  unsigned int time_quality;
-  unsigned int overflow_cnt;
-  unsigned int pedestal;
-  unsigned int fm_amplitude;
-  unsigned int peak_amplitude;
-  unsigned int peak_time;
-  unsigned int valid_1;
-  unsigned int adc_1;
-  unsigned int valid_2;
-  unsigned int adc_2;
-  unsigned int over;
-  unsigned int adc_sum;
-  unsigned int pulse_num;
-  unsigned int thres_bin;
-  unsigned int quality;
-  unsigned int integral;
-  unsigned int time;
-  unsigned int chan_a;
-  unsigned int source_a;
-  unsigned int chan_b;
-  unsigned int source_b;
-  unsigned int group;
-  unsigned int time_coarse;
-  unsigned int time_fine;
-  unsigned int vmin;
-  unsigned int vpeak;
-  unsigned int scaler[18];/* data stream scalers */
-};
-
-volatile struct data_struct fadc_data;
+  return OK;
+}
 
 /**
  *  @ingroup Status
- *  @brief Decode a data word from an fADC125 and print to standard out.
- *  @param data 32bit fADC125 data word
-*/
-void
-fa125DecodeData(unsigned int data)
+ *  @brief Return the VME transactions of the library made by the calling
+ *     thread, since the last fa125ResetVmeCounts.
+ *  @param counts Destination of the counts.  calls is not used.
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125GetVmeCountsThread(FA125_VME_COUNTS *counts)
 {
-  /* for new data format - 10/23/13 - EJ */
+  FA125_VME_COUNTS *t = fa125AcctThreadCounts();
 
-  static unsigned int type_last = 15;/* initialize to type FILLER WORD */
-  static unsigned int time_last = 0;
-  static unsigned int scaler_index = 0;
-  static unsigned int num_scalers = 1;
+  if((counts == NULL) || (t == NULL))
+    {
+      printf("\n%s: ERROR: No counts for this thread\n\n", __FUNCTION__);
+      return ERROR;
+    }
 
-  static unsigned int slot_id_ev_hd = 0;
-  static unsigned int slot_id_dnv = 0;
-  static unsigned int slot_id_fill = 0;
+  fa125AcctCopy(counts, t);
 
-  static int nsamples=0;
-  static int ipk=0;
-/*   static int goto_raw=0; */
+  return OK;
+}
 
-  int i_print =1;
+/**
+ *  @ingroup Status
+ *  @brief Clear the VME transaction counts of all routines, modules and
+ *     threads.  Transactions in progress in other threads may be counted
+ *     before or after the reset.
+ */
+void
+fa125ResetVmeCounts()
+{
+  FA125_VME_COUNTS *t;
+  int ii;
 
-  if( scaler_index )/* scaler data word */
+  for(ii = 0; ii < FA125_ACCT_NAPI; ii++)
+    fa125AcctClear(&fa125AcctApi[ii].c);
+  for(ii = 0; ii < FA125_MAX_BOARDS+2; ii++)
+    fa125AcctClear(&fa125AcctSlot[ii]);
+  for(ii = 0; ii < FA125_ACCT_NTHREADS; ii++)
     {
-      fadc_data.type = 16;/* scaler data words as type 16 */
-      fadc_data.new_type = 0;
-      if( scaler_index < num_scalers )
-	{
-	  fadc_data.scaler[scaler_index - 1] = data;
-	  if( i_print )
-	    printf("%8X - SCALER(%d) = %d\n", data, (scaler_index - 1), data);
-	  scaler_index++;
-	}
-      else/* last scaler word */
-	{
-	  fadc_data.scaler[scaler_index - 1] = data;
-	  if( i_print )
-	    printf("%8X - SCALER(%d) = %d\n", data, (scaler_index - 1), data);
-	  scaler_index = 0;
-	  num_scalers = 1;
-	}
+      t = __atomic_load_n(&fa125AcctThreads[ii], __ATOMIC_ACQUIRE);
+      if(t)
+	fa125AcctClear(t);
     }
-  else/* non-scaler word */
-    {
-      if( data & 0x80000000 )/* data type defining word */
-	{
-	  fadc_data.new_type = 1;
-	  fadc_data.type = (data & 0x78000000) >> 27;
-	}
-      else/* data type continuation word */
-	{
-	  fadc_data.new_type = 0;
-	  fadc_data.type = type_last;
-	}
+}
 
-      switch( fadc_data.type )
-	{
-	case 0:/* BLOCK HEADER */
-	  fadc_data.slot_id_hd = (data & 0x7C00000) >> 22;
-	  fadc_data.mod_id_hd =  (data &  0x3C0000) >> 18;
-	  fadc_data.n_evts =  (data & 0x000FF);
-	  fadc_data.blk_num = (data & 0x7F00) >> 8;
-	  if( i_print )
-	    printf("%8X - BLOCK HEADER - slot = %d  id = %d  n_evts = %d  n_blk = %d\n",
-		   data, fadc_data.slot_id_hd, fadc_data.mod_id_hd, fadc_data.n_evts, fadc_data.blk_num);
-	  break;
+static void
+fa125AcctPrintRow(const char *name, FA125_VME_COUNTS *c)
+{
+  printf("%-28s %10llu %10llu %10llu %8llu %8llu %12llu\n", name,
+	 c->calls, c->reads, c->writes, c->probes, c->dmas, c->dma_bytes);
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Print the VME transaction counts of the routines that made any,
+ *     of each module and of each thread.
+ */
+void
+fa125PrintVmeCounts()
+{
+  FA125_VME_COUNTS c, *t;
+  char name[32];
+  const char *api;
+  int ii, id;
+
+  printf("\nFA125 VME transactions\n");
+  printf("--------------------------------------------------------------------------------------------\n");
+  printf("%-28s %10s %10s %10s %8s %8s %12s\n",
+	 "Routine", "Calls", "Reads", "Writes", "Probes", "DMAs", "DMA bytes");
+  printf("--------------------------------------------------------------------------------------------\n");
+  for(ii = 0; ii < FA125_ACCT_NAPI; ii++)
+    {
+      api = __atomic_load_n(&fa125AcctApi[ii].name, __ATOMIC_ACQUIRE);
+      fa125AcctCopy(&c, &fa125AcctApi[ii].c);
+      if(api && (c.calls || c.reads || c.writes || c.probes || c.dmas))
+	fa125AcctPrintRow(api, &c);
+    }
+  printf("--------------------------------------------------------------------------------------------\n");
+  fa125AcctCopy(&c, &fa125AcctSlot[0]);
+  fa125AcctPrintRow("crate", &c);
+  for(ii = 0; ii < nfa125; ii++)
+    {
+      id = fa125ID[ii];
+      sprintf(name, "slot %d", id);
+      fa125AcctCopy(&c, &fa125AcctSlot[id]);
+      fa125AcctPrintRow(name, &c);
+    }
+  printf("--------------------------------------------------------------------------------------------\n");
+  for(ii = 0; ii < FA125_ACCT_NTHREADS; ii++)
+    {
+      t = __atomic_load_n(&fa125AcctThreads[ii], __ATOMIC_ACQUIRE);
+      if(t == NULL)
+	continue;
+      sprintf(name, "thread %d", ii + 1);
+      fa125AcctCopy(&c, t);
+      fa125AcctPrintRow(name, &c);
+    }
+  printf("\n");
+}
+#endif /* VXWORKS */
 
-	case 1:/* BLOCK TRAILER */
-	  fadc_data.slot_id_tr = (data & 0x7C00000) >> 22;
-	  fadc_data.n_words = (data & 0x3FFFFF);
-	  if( i_print )
-	    printf("%8X - BLOCK TRAILER - slot = %d   n_words = %d\n",
-		   data, fadc_data.slot_id_tr, fadc_data.n_words);
-	  break;
+#ifndef VXWORKS
+/************************************************************
+ *  fa125 Readout tracing
+ ************************************************************/
+/* Tracepoints (FA125TRACE_BEGIN/END) write a cycle counter timestamp into
+   a ring of the calling thread, so they take no lock.  Each ring keeps the
+   last FA125_TRACE_NEVENTS events.  fa125TraceExport converts the rings to
+   a Chrome trace (chrome://tracing, Perfetto). */
+#define FA125_TRACE_NEVENTS   16384   /* events kept by each thread, a power of 2 */
+#define FA125_TRACE_NTHREADS  16      /* threads traced */
+
+struct fa125_trace_event
+{
+  unsigned long long tsc;
+  int                arg;
+  unsigned short     point;
+  char               phase;           /* 'B'egin or 'E'nd */
+};
 
-	case 2:/* EVENT HEADER */
-	  if( fadc_data.new_type )
-	    {
-	      slot_id_ev_hd        = (data & 0x7C00000) >> 22;
-	      fadc_data.evt_num_1 =  (data & 0x03FFFFF);
-	      if( i_print )
-		printf("%8X - EVENT HEADER - slot = %d  evt_num = %d\n",
-		       data, slot_id_ev_hd, fadc_data.evt_num_1);
-	    }
-	  break;
+struct fa125_trace_ring
+{
+  unsigned long long head;            /* events written (owner thread only) */
+  struct fa125_trace_event ev[FA125_TRACE_NEVENTS];
+};
 
-	case 3:/* TRIGGER TIME */
-	  if( fadc_data.new_type )
-	    {
-	      fadc_data.time_1 = (data & 0xFFFFFF);
-	      if( i_print )
-		printf("%8X - TRIGGER TIME 1 - time = 0x%08x\n", data, fadc_data.time_1);
-	      fadc_data.time_now = 1;
-	      time_last = 1;
-	    }
-	  else
-	    {
-	      if( time_last == 1 )
-		{
-		  fadc_data.time_2 = (data & 0xFFFFFF);
-		  if( i_print )
-		    printf("%8X - TRIGGER TIME 2 - time = 0x%08x\n", data, fadc_data.time_2);
-		  fadc_data.time_now = 2;
-		}
-	      else
-		if( i_print )
-		  printf("%8X - TRIGGER TIME - (ERROR)\n", data);
+static const char *fa125_trace_names[FA125_TRACE_NPOINTS] =
+  {
+    "Bready",
+    "WaitBlockReady",
+    "vmeDmaSend",
+    "vmeDmaDone",
+    "ResetToken",
+    "Bank"
+  };
 
-	      time_last = fadc_data.time_now;
-	    }
-	  break;
+static struct fa125_trace_ring *fa125TraceRings[FA125_TRACE_NTHREADS];
+static int fa125TraceNrings=0;
+static unsigned long long fa125TraceNlost=0;  /* events of threads without a ring */
+static __thread struct fa125_trace_ring *fa125TraceRing=NULL;
+static __thread int fa125TraceNoRing=0;
+static unsigned long long fa125TraceTsc0=0;   /* cycle counter and time of the first event */
+static long long fa125TraceNs0=0;
+static pthread_once_t fa125TraceOnce = PTHREAD_ONCE_INIT;
+
+static inline unsigned long long
+fa125TraceTsc()
+{
+#ifdef FA125_UNPACK_X86
+  return __rdtsc();
+#else
+  return (unsigned long long)fa125ReadoutNsec();
+#endif
+}
 
-	case 4:/* WINDOW RAW DATA */
-          if( fadc_data.new_type )
-            {
-              fadc_data.chan = (data & 0x7F00000) >> 20;
-	      fadc_data.width = (data & 0xFFF);
-              if( i_print )
-		printf("%8X - WINDOW RAW DATA - chan = %2d   width = %d\n",
-		       data, fadc_data.chan, fadc_data.width);
-              nsamples=0;
-            }
-          else
-            {
-	      fadc_data.valid_1 = 1;
-	      fadc_data.valid_2 = 1;
-	      fadc_data.adc_1 = (data & 0x1FFF0000) >> 16;
-	      if( data & 0x20000000 )
-		fadc_data.valid_1 = 0;
-	      fadc_data.adc_2 = (data & 0x1FFF);
-	      if( data & 0x2000 )
-		fadc_data.valid_2 = 0;
-              if( i_print )
-		printf("%8X - RAW SAMPLES (%3d) - valid = %d  adc = %4d (%03X)  valid = %d  adc = %4d (%03X)\n",
-		       data, nsamples,fadc_data.valid_1, fadc_data.adc_1, fadc_data.adc_1,
-		       fadc_data.valid_2, fadc_data.adc_2, fadc_data.adc_2);
-              nsamples += 2;
-            }
-          break;
+static void
+fa125TraceInitClock()
+{
+  fa125TraceNs0  = fa125ReadoutNsec();
+  fa125TraceTsc0 = fa125TraceTsc();
+}
 
-	case 5:/* PULSE DATA, CDC */
-	  if( fadc_data.new_type )
-	    {
-	      fadc_data.chan = (data & 0x7F00000) >> 20;
-	      fadc_data.npk  = (data & 0xF8000)>>15;
-	      fadc_data.le_time = (data & 0x7FF0)>>4;
-	      fadc_data.time_quality = (data & (1<<3))>>3;
-	      fadc_data.overflow_cnt = (data & 0x7);
-	      if( i_print )
-		printf("%8X - PULSE DATA (CDC IT) - chan = %2d  LE time = %d  Q = %d  OVF = %d\n",
-		       data, fadc_data.chan, fadc_data.le_time,
-		       fadc_data.time_quality, fadc_data.overflow_cnt);
-	    }
-	  else
-	    {
-	      fadc_data.pedestal = (data & 0x7F800000)>>23;
-	      fadc_data.integral = (data & 0x007FFE00)>>9;
-	      fadc_data.fm_amplitude = (data & 0x000001FF);
-	      if( i_print )
-		printf("%8X - PULSE DATA (CDC IT) - ped = %d  integral = %d  firstmax ampl = %d\n",
-		       data, fadc_data.pedestal, fadc_data.integral, fadc_data.fm_amplitude);
-	    }
-	  break;
+/* Ring of the calling thread, created at its first event */
+static struct fa125_trace_ring *
+fa125TraceThreadRing()
+{
+  struct fa125_trace_ring *r;
+  int iring;
 
-	case 6:/* PULSE DATA, FDC - Integral and Time */
-	  if( fadc_data.new_type )
-	    {
-	      fadc_data.chan = (data & 0x7F00000) >> 20;
-	      fadc_data.npk  = (data & 0xF8000)>>15;
-	      fadc_data.le_time = (data & 0x7FF0)>>4;
-	      fadc_data.time_quality = (data & (1<<3))>>3;
-	      fadc_data.overflow_cnt = (data & 0x7);
-	      ipk = 0;
-	      if( i_print )
-		printf("%8X - PULSE DATA (FDC IT) - chan = %2d  NPK = %d  LE time = %d  Q = %d  OVF = %d\n",
-		       data, fadc_data.chan, fadc_data.npk, fadc_data.le_time,
-		       fadc_data.time_quality, fadc_data.overflow_cnt);
-	    }
-	  else
-	    {
-	      ipk++;
-	      fadc_data.pedestal = (data & 0x7F800000)>>23;
-	      fadc_data.integral = (data & 0x007FFE00)>>9;
-	      fadc_data.fm_amplitude = (data & 0x000001FF);
-	      if( i_print )
-		printf("%8X - PULSE DATA (FDC IT) %d - ped = %d  integral = %d  firstmax ampl = %d\n",
-		       data, ipk, fadc_data.pedestal, fadc_data.integral, fadc_data.fm_amplitude);
-	    }
-	  break;
+  pthread_once(&fa125TraceOnce, fa125TraceInitClock);
 
-	case 9:/* PULSE DATA, FDC - Peak Ampl and Time */
-	  if( fadc_data.new_type )
-	    {
-	      fadc_data.chan = (data & 0x7F00000) >> 20;
-	      fadc_data.le_time = (data & 0x7FF0)>>4;
-	      fadc_data.time_quality = (data & (1<<3))>>3;
-	      fadc_data.overflow_cnt = (data & 0x7);
-	      ipk = 0;
-	      if( i_print )
-		printf("%8X - PULSE DATA (FDC AT) - chan = %2d  NPK = %d  LE time = %d  Q = %d  OVF = %d\n",
-		       data, fadc_data.chan, fadc_data.npk, fadc_data.le_time,
-		       fadc_data.time_quality, fadc_data.overflow_cnt);
-	    }
-	  else
-	    {
-	      ipk++;
-	      fadc_data.peak_amplitude = (data & 0x7ff80000)>>19;
-	      fadc_data.peak_time = (data & 0x0007f800)>>11;
-	      fadc_data.pedestal = (data & 0x000007ff);
-	      if( i_print )
-		printf("%8X - PULSE DATA (FDC AT) %d - Ampl = %d  Time = %d  Pedestal = %d\n",
-		       data, ipk, fadc_data.peak_amplitude, fadc_data.peak_time, fadc_data.pedestal);
-	    }
-	  break;
+  iring = __atomic_fetch_add(&fa125TraceNrings, 1, __ATOMIC_ACQ_REL);
+  if(iring >= FA125_TRACE_NTHREADS)
+    {
+      fa125TraceNoRing = 1;
+      return NULL;
+    }
 
-	case 7:
-	case 8:
-	case 10:
-	case 11:
-	case 12:/* UNDEFINED TYPE */
-	  if( i_print )
-	    printf("%8X - UNDEFINED TYPE = %d\n", data, fadc_data.type);
-	  break;
+  r = (struct fa125_trace_ring *)calloc(1, sizeof(struct fa125_trace_ring));
+  if(r == NULL)
+    {
+      fa125TraceNoRing = 1;
+      return NULL;
+    }
+  __atomic_store_n(&fa125TraceRings[iring], r, __ATOMIC_RELEASE);
+  fa125TraceRing = r;
 
-	case 13:/* END OF EVENT */
-	  if( i_print )
-	    printf("%8X - END OF EVENT = %d\n", data, fadc_data.type);
-	  break;
+  return r;
+}
 
-	case 14:/* DATA NOT VALID (no data available) */
-	  slot_id_dnv = (data & 0x7C00000) >> 22;
-	  if( i_print )
-	    printf("%8X - DATA NOT VALID = %d  slot = %d\n", data, fadc_data.type, slot_id_dnv);
-	  break;
+/**
+ *  @ingroup Status
+ *  @brief Record a tracepoint in the ring of the calling thread.  Use
+ *     FA125TRACE_BEGIN and FA125TRACE_END, which are removed unless the
+ *     library is built with -DFA125_TRACE.
+ *  @param point FA125_TRACE_POINTS
+ *  @param phase 'B' at the beginning of the span, 'E' at its end
+ *  @param arg   Shown with the span (e.g. slot number or word count)
+ */
+void
+fa125TracePoint(int point, int phase, int arg)
+{
+  struct fa125_trace_ring *r = fa125TraceRing;
+  struct fa125_trace_event *e;
 
-	case 15:/* FILLER WORD */
-	  slot_id_fill = (data & 0x7C00000) >> 22;
-	  if( i_print )
-	    printf("%8X - FILLER WORD = %d  slot = %d\n", data, fadc_data.type, slot_id_fill);
-	  break;
+  if(r == NULL)
+    {
+      if(fa125TraceNoRing || ((r = fa125TraceThreadRing()) == NULL))
+	{
+	  __atomic_fetch_add(&fa125TraceNlost, 1, __ATOMIC_RELAXED);
+	  return;
 	}
+    }
 
-      type_last = fadc_data.type;    /* save type of current data word */
+  e = &r->ev[r->head & (FA125_TRACE_NEVENTS - 1)];
+  e->tsc   = fa125TraceTsc();
+  e->arg   = arg;
+  e->point = point;
+  e->phase = phase;
+  __atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ *  @ingroup Status
+ *  @brief Write the events in the trace rings to a file in the Chrome trace
+ *     JSON format.  Each traced thread is a row of the timeline.  Call while
+ *     the readout is paused (e.g. at end): events written during the export
+ *     may replace the oldest ones as they are read.
+ *  @param filename Output file
+ *  @return Number of events written if successful, otherwise ERROR.
+ */
+int
+fa125TraceExport(const char *filename)
+{
+  struct fa125_trace_ring *r;
+  struct fa125_trace_event *e;
+  unsigned long long head, iev, tsc1;
+  long long ns1;
+  double ns_per_tick = 1.;
+  int iring, nrings, nev = 0, nthread = 0, pid = getpid();
+  FILE *f;
+
+  f = fopen(filename, "w");
+  if(f == NULL)
+    {
+      printf("\n%s: ERROR: Unable to open %s\n\n", __FUNCTION__, filename);
+      return ERROR;
+    }
+
+  /* Cycle counter rate, from the time since the first event */
+  ns1  = fa125ReadoutNsec();
+  tsc1 = fa125TraceTsc();
+  if(tsc1 > fa125TraceTsc0)
+    ns_per_tick = (double)(ns1 - fa125TraceNs0) / (double)(tsc1 - fa125TraceTsc0);
+
+  nrings = __atomic_load_n(&fa125TraceNrings, __ATOMIC_ACQUIRE);
+  if(nrings > FA125_TRACE_NTHREADS)
+    nrings = FA125_TRACE_NTHREADS;
 
+  fprintf(f, "{\"traceEvents\":[\n");
+  for(iring = 0; iring < nrings; iring++)
+    {
+      r = __atomic_load_n(&fa125TraceRings[iring], __ATOMIC_ACQUIRE);
+      if(r == NULL)
+	continue;
+
+      fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+	      "\"args\":{\"name\":\"fa125 thread %d\"}}",
+	      nthread ? ",\n" : "", pid, iring + 1, iring + 1);
+      nthread++;
+
+      head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+      iev = (head > FA125_TRACE_NEVENTS) ? head - FA125_TRACE_NEVENTS : 0;
+      for(; iev < head; iev++)
+	{
+	  e = &r->ev[iev & (FA125_TRACE_NEVENTS - 1)];
+	  if(e->point >= FA125_TRACE_NPOINTS)
+	    continue;
+	  fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"fa125\",\"ph\":\"%c\",\"ts\":%.3f,"
+		  "\"pid\":%d,\"tid\":%d,\"args\":{\"arg\":%d}}",
+		  fa125_trace_names[e->point], e->phase,
+		  1e-3 * ns_per_tick * (double)(e->tsc - fa125TraceTsc0),
+		  pid, iring + 1, e->arg);
+	  nev++;
+	}
     }
+  fprintf(f, "\n],\"displayTimeUnit\":\"ns\"}\n");
+  fclose(f);
+
+  if(fa125TraceNlost)
+    printf("%s: WARN: %llu events of threads beyond the first %d not traced\n",
+	   __FUNCTION__, fa125TraceNlost, FA125_TRACE_NTHREADS);
 
+  return nev;
 }
 
+/**
+ *  @ingroup Status
+ *  @brief Discard the events in the trace rings.  Call while the readout
+ *     is paused.
+ */
+void
+fa125TraceClear()
+{
+  struct fa125_trace_ring *r;
+  int iring;
+
+  for(iring = 0; iring < FA125_TRACE_NTHREADS; iring++)
+    {
+      r = __atomic_load_n(&fa125TraceRings[iring], __ATOMIC_ACQUIRE);
+      if(r)
+	__atomic_store_n(&r->head, 0, __ATOMIC_RELEASE);
+    }
+  fa125TraceNlost = 0;
+}
+#endif /* VXWORKS */
+
 /************************************************************
  *  fa125 Firmware Updating Routines
  ************************************************************/
@@ -4414,7 +8712,7 @@ fa125FirmwareBlockErase(int id, int iblock, int stayon, int waitForDone)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
 
   /* Configuration csr for block erase */
   vmeWrite32(&fa125p[id]->main.configCSR,
@@ -4430,7 +8728,7 @@ fa125FirmwareBlockErase(int id, int iblock, int stayon, int waitForDone)
 
   if(waitForDone==0)
     {
-      FA125UNLOCK;
+      FA125SLOTUNLOCK(id);
       return OK;
     }
 
@@ -4448,7 +8746,7 @@ fa125FirmwareBlockErase(int id, int iblock, int stayon, int waitForDone)
 	  printf("\n%s: ERROR: Pull down execute timeout (rwait = %d).\n\n",
 		 __FUNCTION__,
 		 rwait);
-	  FA125UNLOCK;
+	  FA125SLOTUNLOCK(id);
 	  return ERROR;
 	}
       if(fa125FirmwareDebug&FA125_FIRMWARE_DEBUG_WAIT_FOR_READY)
@@ -4459,7 +8757,7 @@ fa125FirmwareBlockErase(int id, int iblock, int stayon, int waitForDone)
     }
 #endif
 
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
   return OK;
 }
 
@@ -4490,7 +8788,7 @@ fa125FirmwareWriteToBuffer(int id, int ipage)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   /* Configuration csr for buffer write */
   vmeWrite32(&fa125p[id]->main.configCSR,
 	     FA125_CONFIGCSR_PROG_ENABLE | (FA125_OPCODE_BUFFER_WRITE<<24));
@@ -4514,12 +8812,12 @@ fa125FirmwareWriteToBuffer(int id, int ipage)
 		 ibadr,ipage,
 		 rwait);
 	  vmeWrite32(&fa125p[id]->main.configAdrData, 0);
-	  FA125UNLOCK;
+	  FA125SLOTUNLOCK(id);
 	  return ERROR;
 	}
     }
 
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
   return OK;
 }
 
@@ -4541,7 +8839,7 @@ fa125FirmwarePushBufferToMain(int id, int ipage, int waitForDone)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   /* Configuration csr for buffer to main memory */
   vmeWrite32(&fa125p[id]->main.configCSR,
 	     FA125_CONFIGCSR_PROG_ENABLE | (FA125_OPCODE_BUFFER_PUSH<<24));
@@ -4553,7 +8851,7 @@ fa125FirmwarePushBufferToMain(int id, int ipage, int waitForDone)
 	     FA125_CONFIGADRDATA_EXEC | (ipage<<18));
   vmeWrite32(&fa125p[id]->main.configAdrData,
 	     (ipage<<18));
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   if(waitForDone==0)
     {
@@ -4578,14 +8876,14 @@ fa125FirmwareWaitForPushBufferToMain(int id, int ipage)
       return ERROR;
     }
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   if(fa125FirmwareWaitForReady(id,100000,&rwait)!=OK)
     {
       printf("\n%s: ERROR: Push to main memory timeout (page = %d) (rwait = %d).\n\n",
 	     __FUNCTION__,
 	     ipage,rwait);
       vmeWrite32(&fa125p[id]->main.configAdrData, 0);
-      FA125UNLOCK;
+      FA125SLOTUNLOCK(id);
       return ERROR;
     }
   if(fa125FirmwareDebug&FA125_FIRMWARE_DEBUG_WAIT_FOR_READY)
@@ -4601,11 +8899,11 @@ fa125FirmwareWaitForPushBufferToMain(int id, int ipage)
       printf("\n%s: ERROR: Pull down execute timeout (rwait = %d).\n\n",
 	     __FUNCTION__,
 	     rwait);
-      FA125UNLOCK;
+      FA125SLOTUNLOCK(id);
       return ERROR;
     }
 
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
   return OK;
 }
 
@@ -4634,7 +8932,7 @@ fa125FirmwareReadMainPage(int id, int ipage, int stayon)
   memset((char *)tmp_pageData, 0, sizeof(tmp_pageData));
 /*   taskDelay(1); */
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   /* Configuration csr for main memory read */
   vmeWrite32(&fa125p[id]->main.configCSR,
 	     FA125_CONFIGCSR_PROG_ENABLE | (FA125_OPCODE_MAIN_READ<<24));
@@ -4650,7 +8948,7 @@ fa125FirmwareReadMainPage(int id, int ipage, int stayon)
 	  printf("\n%s: ERROR: Main memory read timeout (byte address = %d, page = %d) (rwait = %d).\n\n",
 		 __FUNCTION__,
 		 ibadr,ipage,rwait);
-	  FA125UNLOCK;
+	  FA125SLOTUNLOCK(id);
 	  return ERROR;
 	}
 
@@ -4669,14 +8967,14 @@ fa125FirmwareReadMainPage(int id, int ipage, int stayon)
 	  printf("\n%s: ERROR: Pull down execute timeout (rwait = %d).\n\n",
 		 __FUNCTION__,
 		 rwait);
-	  FA125UNLOCK;
+	  FA125SLOTUNLOCK(id);
 	  return ERROR;
 	}
       taskDelay(1);
     }
 #endif
 
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
   return OK;
 }
 
@@ -4695,7 +8993,7 @@ fa125FirmwareReadBuffer(int id)
 
   memset((char *)tmp_pageData, 0, sizeof(tmp_pageData));
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   /* Configuration csr for buffer memory read */
   vmeWrite32(&fa125p[id]->main.configCSR,
 	     FA125_CONFIGCSR_PROG_ENABLE | (FA125_OPCODE_BUFFER_READ<<24));
@@ -4716,7 +9014,7 @@ fa125FirmwareReadBuffer(int id)
 	  printf("\n%s: ERROR: Main memory read timeout (byte address = %d) (rwait = %d).\n\n",
 		 __FUNCTION__,
 		 ibadr,rwait);
-	  FA125UNLOCK;
+	  FA125SLOTUNLOCK(id);
 	  return ERROR;
 	}
 
@@ -4726,7 +9024,7 @@ fa125FirmwareReadBuffer(int id)
   /* Pull Execute low before asserting new configuration type */
   vmeWrite32(&fa125p[id]->main.configAdrData, 0);
 
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
   return OK;
 }
 
@@ -4762,9 +9060,9 @@ fa125FirmwareVerifyFull(int id)
     }
 #endif
 
-  FA125LOCK;
+  FA125SLOTLOCK(id);
   vmeWrite32(&fa125p[id]->main.configCSR, 0);
-  FA125UNLOCK;
+  FA125SLOTUNLOCK(id);
 
   printf("%3d: ",id);
   fflush(stdout);
@@ -4828,6 +9126,7 @@ fa125FirmwareVerifyFull(int id)
 int
 fa125FirmwareGVerifyFull()
 {
+  FA125ACCT_ENTRY;
   int ifa=0, id=0;
 
   if(MCS_loaded==0)
@@ -5164,6 +9463,7 @@ fa125FirmwarePrintPage(int page)
 int
 fa125FirmwareEraseFull(int id)
 {
+  FA125ACCT_ENTRY;
   int ipage=0;
   int iblock=0, nblocks=1024;
   int stayon=1;
@@ -5273,6 +9573,7 @@ fa125FirmwareEraseFull(int id)
 int
 fa125FirmwareGEraseFull()
 {
+  FA125ACCT_ENTRY;
   int ipage=0;
   int iblock=0, nblocks=1024;
   int stayon=1;
@@ -5446,6 +9747,7 @@ fa125FirmwareGEraseFull()
 int
 fa125FirmwareWriteFull(int id)
 {
+  FA125ACCT_ENTRY;
   int ipage=0;
   struct timespec time_start, time_end, res;
 
@@ -5562,6 +9864,7 @@ fa125FirmwareWriteFull(int id)
 int
 fa125FirmwareGWriteFull()
 {
+  FA125ACCT_ENTRY;
   int id=0, ifa=0;
   int ipage=0;
   struct timespec time_start, time_end, res;
@@ -316,6 +316,8 @@ struct fa125_a32
 
 #define FA125_DATA_BLOCK_HEADER      0x00000000
 #define FA125_DATA_BLOCK_TRAILER     0x08000000
+#define FA125_DATA_DNV               0x70000000
+#define FA125_DATA_FILLER            0x78000000
 #define FA125_DATA_BLKNUM_MASK       0x0000003f
 
 /* Define Firmware updating OPCODEs */
@@ -438,11 +440,229 @@ typedef enum
     FA125_BLOCKERROR_UNKNOWN_BUS_ERROR,
     FA125_BLOCKERROR_ZERO_WORD_COUNT,
     FA125_BLOCKERROR_DMADONE_ERROR,
+    FA125_BLOCKERROR_DMA_TIMEOUT,
     FA125_BLOCKERROR_NTYPES
   } FA125_BLOCKERROR_FLAGS;
 
 extern const char *fa125_blockerror_names[FA125_BLOCKERROR_NTYPES];
 
+/* Tracepoints of the readout (Linux, built with -DFA125_TRACE).  Each
+   FA125TRACE_BEGIN / FA125TRACE_END pair is a span of the timeline written
+   by fa125TraceExport. */
+typedef enum
+  {
+    FA125_TRACE_BREADY         = 0, /* fa125Bready, fa125GBready, fa125GBlockReady */
+    FA125_TRACE_WAIT_READY,         /* fa125WaitBlockReady */
+    FA125_TRACE_DMA_SEND,           /* vmeDmaSend */
+    FA125_TRACE_DMA_DONE,           /* vmeDmaDone */
+    FA125_TRACE_RESET_TOKEN,        /* fa125ResetToken */
+    FA125_TRACE_BANK,               /* readout list bank of the fa125 data */
+    FA125_TRACE_NPOINTS
+  } FA125_TRACE_POINTS;
+
+#if defined(FA125_TRACE) && !defined(VXWORKS)
+#define FA125TRACE_BEGIN(_point, _arg) fa125TracePoint(_point, 'B', (int)(_arg))
+#define FA125TRACE_END(_point, _arg)   fa125TracePoint(_point, 'E', (int)(_arg))
+#else
+#define FA125TRACE_BEGIN(_point, _arg)
+#define FA125TRACE_END(_point, _arg)
+#endif
+
+/* Configuration step, run by fa125ConfigRun for one module */
+typedef int (*FA125_CONFIG_FUNC)(int id, void *arg);
+#define FA125_CONFIG_MAX_STEPS  16
+
+/* Bins of the time to block ready histogram (fa125GetReadyHistogram) */
+#define FA125_READY_NBINS  32
+
+/* Record types of the decoder: the data type of the type defining word */
+typedef enum
+  {
+    FA125_DECODE_BLOCK_HEADER   = 0,
+    FA125_DECODE_BLOCK_TRAILER  = 1,
+    FA125_DECODE_EVENT_HEADER   = 2,
+    FA125_DECODE_TRIGGER_TIME   = 3,
+    FA125_DECODE_WINDOW_RAW     = 4,
+    FA125_DECODE_PULSE_CDC      = 5,
+    FA125_DECODE_PULSE_FDC      = 6,
+    FA125_DECODE_PULSE_FDC_AMP  = 9,
+    FA125_DECODE_END_OF_EVENT   = 13,
+    FA125_DECODE_DNV            = 14,
+    FA125_DECODE_FILLER         = 15
+  } FA125_DECODE_TYPES;
+
+/* Kernels to unpack raw window samples, see fa125SetUnpackKernel */
+typedef enum
+  {
+    FA125_UNPACK_AUTO   = 0,
+    FA125_UNPACK_SCALAR = 1,
+    FA125_UNPACK_SSSE3  = 2,
+    FA125_UNPACK_AVX2   = 3
+  } FA125_UNPACK_KERNELS;
+
+/* Decoder record error flags */
+typedef enum
+  {
+    FA125_DECODE_ERROR_TRUNCATED = (1<<0), /* fewer continuation words than expected */
+    FA125_DECODE_ERROR_UNDEFINED = (1<<1), /* undefined data type */
+    FA125_DECODE_ERROR_NPK       = (1<<2)  /* more peaks than FA125_MAX_NPK */
+  } FA125_DECODE_ERROR_FLAGS;
+
+/* One peak of a pulse record */
+typedef struct
+{
+  unsigned int pedestal;
+  unsigned int integral;        /* CDC, FDC integral */
+  unsigned int fm_amplitude;    /* CDC, FDC integral: first max amplitude */
+  unsigned int peak_amplitude;  /* FDC peak amplitude */
+  unsigned int peak_time;       /* FDC peak amplitude */
+} FA125_DECODE_PEAK;
+
+/* Record decoded from a type defining word and its continuation words.
+   Only the fields of its type are set. */
+typedef struct
+{
+  int           type;           /* FA125_DECODE_TYPES, or an undefined type */
+  int           error;          /* FA125_DECODE_ERROR_FLAGS */
+  unsigned int  word;           /* type defining word */
+  unsigned int  length;         /* number of words of the record */
+  unsigned int  slot;           /* from the word, otherwise the current block */
+  unsigned int  evt_num;        /* event header, and the records of its event */
+  unsigned int  mod_id;         /* block header */
+  unsigned int  n_evts;         /* block header */
+  unsigned int  blk_num;        /* block header */
+  unsigned int  n_words;        /* block trailer */
+  unsigned int  time_1;         /* trigger time bits 23:0 */
+  unsigned int  time_2;         /* trigger time bits 47:24 */
+  unsigned int  chan;           /* pulse, raw window */
+  unsigned int  npk;            /* pulse: number of peaks in the word */
+  unsigned int  le_time;        /* pulse */
+  unsigned int  time_quality;   /* pulse */
+  unsigned int  overflow_cnt;   /* pulse */
+  unsigned int  npeak;          /* pulse: number of peaks decoded in peak[] */
+  FA125_DECODE_PEAK peak[FA125_MAX_NPK];
+  unsigned int  width;          /* raw window: number of samples in the word */
+  unsigned int  nsamples;       /* raw window: number of samples in the sample words */
+  unsigned int  swap;           /* raw window: sample words are in VME byte order */
+  const volatile UINT32 *samples; /* raw window: first sample word, in the decoded buffer */
+} FA125_DECODE_RECORD;
+
+/* Called for each record.  Return OK to continue decoding. */
+typedef int (*FA125_DECODE_FUNC)(const FA125_DECODE_RECORD *rec, void *arg);
+
+/* Decoder state.  One for each thread or data stream. */
+typedef struct
+{
+  FA125_DECODE_RECORD rec;      /* record being decoded */
+  int                 open;     /* rec waits for continuation words */
+  int                 expect;   /* continuation words still expected */
+  unsigned int        slot;     /* slot of the current block */
+  unsigned int        evt_num;  /* current event */
+  unsigned long long  nwords;   /* words decoded */
+  unsigned long long  nrecords; /* records returned */
+  unsigned long long  nerrors;  /* records with errors, and stray continuation words */
+  int                 chunked;  /* set to 1 if the buffers are successive chunks of one
+				   readout (fa125ReadBlockChunked), so that a raw window
+				   may continue in the next buffer */
+  const volatile UINT32 *next;  /* word after the last buffer decoded */
+} FA125_DECODER;
+
+/* Called with each chunk of a chunked readout.  Return OK to be called again. */
+typedef int (*FA125_CHUNK_FUNC)(const volatile UINT32 *data, int nwords, void *arg);
+
+/* Block of one module in a readout buffer, see fa125IndexBlocks */
+typedef struct
+{
+  int          slot;          /* from the block header */
+  int          offset;        /* word offset of the block header in the buffer */
+  int          length;        /* words from the block header to the trailer */
+  unsigned int blknum;        /* block number */
+  int          nevents;       /* events in the block */
+} FA125_BLOCK_INDEX;
+
+/* Readout counters of a module, see fa125GetReadoutStats.  A multiblock DMA
+   is counted on the first board, unless its blocks are indexed (rflag 0x40). */
+typedef struct
+{
+  unsigned long long blocks;        /* blocks read */
+  unsigned long long words;         /* words read */
+  unsigned long long ndma;          /* DMA transfers */
+  unsigned long long dma_ns;        /* time from the start to the completion of the DMAs */
+  unsigned long long berr;          /* DMAs terminated by the BERR of the module */
+  unsigned long long unknown_berr;  /* DMAs terminated by another bus error */
+  unsigned long long zero_count;    /* DMAs that ended without BERR (word count) */
+  unsigned long long dma_errors;    /* DMAs that failed */
+  unsigned long long fifo_empty;    /* programmed I/O reads without data */
+  unsigned long long bad_header;    /* programmed I/O reads without a block header */
+  unsigned long long bready_polls;  /* block ready polls */
+  unsigned long long bready;        /* block ready polls that found a block */
+  unsigned long long timeouts;      /* block ready waits and DMA completions that timed out */
+} FA125_READOUT_STATS;
+
+/* DMA calibration of the crate, see fa125DmaCalibrate.  Modes are A32
+   BLK32, MBLK, 2eVME, 2eSST160, 2eSST267 and 2eSST320. */
+#define FA125_DMA_NMODES     6
+#define FA125_DMA_CAL_WORDS  1024  /* longest test transfer, and buffer size */
+/* fa125DmaCalibrate modemask: modes that may be chosen */
+#define FA125_DMA_MODE_BLK32     (1<<0)
+#define FA125_DMA_MODE_MBLK      (1<<1)
+#define FA125_DMA_MODE_2EVME     (1<<2)
+#define FA125_DMA_MODE_2ESST160  (1<<3)
+#define FA125_DMA_MODE_2ESST267  (1<<4)
+#define FA125_DMA_MODE_2ESST320  (1<<5)
+typedef struct
+{
+  int          valid;                      /* 1: set by fa125DmaCalibrate */
+  int          best;                       /* mode set with vmeDmaConfig */
+  unsigned int dataType[FA125_DMA_NMODES]; /* vmeDmaConfig dataType of each mode */
+  unsigned int sstMode[FA125_DMA_NMODES];  /* vmeDmaConfig sstMode of each mode */
+  int          ok[FA125_DMA_NMODES];       /* 0: mode failed, not timed */
+  double       setup_ns[FA125_DMA_NMODES]; /* fixed time of a DMA */
+  double       word_ns[FA125_DMA_NMODES];  /* time of each word of a DMA */
+  double       pio_word_ns;                /* time of each word of programmed I/O */
+  int          crossover;                  /* blocks shorter than this many words
+					      are faster by programmed I/O */
+} FA125_DMA_CALIBRATION;
+
+/* VME transactions of a routine, module or thread, see fa125GetVmeCountsApi */
+typedef struct
+{
+  unsigned long long calls;      /* calls of the routine (not nested in another) */
+  unsigned long long reads;      /* single cycle reads */
+  unsigned long long writes;     /* single cycle writes */
+  unsigned long long probes;     /* reads with bus error check (vmeMemProbe) */
+  unsigned long long dmas;       /* DMA transfers started */
+  unsigned long long dma_bytes;  /* bytes transferred by DMA */
+} FA125_VME_COUNTS;
+
+/* Data word count of a module, from its configuration.  See fa125GetWordModel */
+typedef struct
+{
+  int mode;          /* processing mode */
+  int npk;           /* peaks reported per hit (FDC modes) */
+  int nw;            /* window width, samples */
+  int blocklevel;    /* events per block */
+  int nchan;         /* enabled channels */
+  int trigtime;      /* trigger time words enabled */
+  int event_words;   /* words of an event without hits */
+  int hit_words;     /* words of a channel hit with all peaks */
+  int hit1_words;    /* words of a channel hit with one peak */
+  int block_words;   /* upper bound of a block, with header, trailer and filler */
+} FA125_WORD_MODEL;
+
+/* Deferred log of the readout and error paths: logMsg arguments, queued for
+   the thread started by fa125LogStart.  Format and string arguments must be
+   static.  On VxWorks, logMsg itself. */
+#ifdef VXWORKS
+#define FA125LOGMSG(_fmt, _a1, _a2, _a3, _a4, _a5, _a6)			\
+  logMsg((char *)(_fmt), (int)(_a1), (int)(_a2), (int)(_a3),		\
+	 (int)(_a4), (int)(_a5), (int)(_a6))
+#else
+#define FA125LOGMSG(_fmt, _a1, _a2, _a3, _a4, _a5, _a6)			\
+  fa125LogMsg(_fmt, (long)(_a1), (long)(_a2), (long)(_a3),		\
+	      (long)(_a4), (long)(_a5), (long)(_a6))
+#endif
+
 int  fa125Init(UINT32 addr, UINT32 addr_inc, int nadc, int iFlag);
 int  fa125Status(int id, int pflag);
 void fa125GStatus(int pflag);
@@ -463,6 +683,7 @@ int  fa125Slot(unsigned int i);
 int  fa125PowerOff(int id);
 int  fa125PowerOn(int id);
 int  fa125SetOffset(int id, int chan, int dacData);
+int  fa125SetOffsets(int id, unsigned int *dacData);
 int  fa125SetOffsetFromFile(int id, char *filename);
 unsigned short fa125ReadOffset(int id, int chan);
 int  fa125ReadOffsetToFile(int id, char *filename);
@@ -489,6 +710,17 @@ int  fa125Enable(int id);
 int  fa125Disable(int id);
 int  fa125Reset(int id, int reset);
 int  fa125ResetCounters(int id);
+int  fa125ConfigQueue(int id, FA125_CONFIG_FUNC func, void *arg);
+void fa125ConfigQueueClear();
+int  fa125ConfigRun(int nthreads);
+int  fa125ConfigResult(int id, int *step, double *seconds);
+void fa125ConfigPrintResults();
+int  fa125ShadowSync(int id);
+int  fa125ShadowDefer(int id, int enable);
+void fa125GShadowDefer(int enable);
+int  fa125ShadowFlush(int id);
+int  fa125GShadowFlush();
+void fa125SetGlobalLock(int enable);
 int  fa125ResetToken(int id);
 int  fa125GetTokenMask();
 unsigned int fa125GetTokenStatus(int pflag);
@@ -509,15 +741,75 @@ int  fa125PPGDisable(int id);
 int  fa125Bready(int id);
 unsigned int fa125GBready();
 unsigned int fa125GBlockReady(unsigned int slotmask, int nloop);
+unsigned int fa125WaitBlockReady(unsigned int slotmask, long long timeout_ns,
+				 unsigned int *first);
+int  fa125SetWaitSpin(int ns);
+int  fa125GetReadyHistogram(int id, unsigned int *hist, unsigned int *timeouts);
+void fa125PrintReadyHistogram(int rflag);
 unsigned int fa125ScanMask();
 int  fa125ReadBlockStatus(int pflag);
 int  fa125ReadBlock(int id, volatile UINT32 *data, int nwrds, int rflag);
+int  fa125ReadBlockStart(int id, volatile UINT32 *data, int nwrds, int rflag);
+int  fa125ReadBlockComplete(int timeout);
+int  fa125ReadBlockAbort();
+int  fa125ReadBlockChunked(int id, volatile UINT32 *data, int nwrds, int rflag, int chunk,
+			   FA125_CHUNK_FUNC func, void *arg);
+int  fa125ReadBlockIndex(FA125_BLOCK_INDEX *index, int maxindex);
+int  fa125SetReadoutDeadline(int usec);
+int  fa125ReadCrate(volatile UINT32 *data, int nwrds, unsigned int *missing);
+int  fa125GetReadoutLateness(int id, unsigned int *late, unsigned int *missed,
+			     unsigned int *dropped);
+unsigned int fa125GetReadoutOwed();
+void fa125PrintReadoutLateness(int rflag);
+int  fa125GetReadoutStats(int id, FA125_READOUT_STATS *stats, int rflag);
+void fa125PrintReadoutStats(int rflag);
 int  fa125DataSuppressTriggerTime(int id, int suppress);
 void fa125GDataSuppressTriggerTime(int suppress);
+int  fa125GetWordModel(int id, FA125_WORD_MODEL *model);
+int  fa125MaxBlockWords(int id);
+int  fa125GMaxBlockWords();
+void fa125PrintDataRate(double rate, double occupancy);
 unsigned int fa125GetA32(int id);
 unsigned int fa125GetA32M();
 
 void fa125DecodeData(unsigned int data);
+void fa125DecodeInit(FA125_DECODER *dec);
+int  fa125DecodeBuffer(FA125_DECODER *dec, const volatile UINT32 *buf, int nwords,
+		       int swap, FA125_DECODE_FUNC func, void *arg);
+int  fa125DecodeFlush(FA125_DECODER *dec, FA125_DECODE_FUNC func, void *arg);
+int  fa125DecodeSamples(const FA125_DECODE_RECORD *rec, short *adc, UINT32 *valid);
+int  fa125UnpackSamples(const volatile UINT32 *words, int nsamples, int swap,
+			short *adc, UINT32 *valid);
+int  fa125SetUnpackKernel(int kernel);
+int  fa125GetUnpackKernel();
+int  fa125SwapScan(const volatile UINT32 *src, UINT32 *dst, int nwords, int swap,
+		   int *marks, int maxmarks);
+int  fa125IndexBlocks(const volatile UINT32 *buf, int nwords, int swap,
+		      FA125_BLOCK_INDEX *index, int maxindex);
+
+#ifndef VXWORKS
+void fa125LogMsg(const char *fmt, long a1, long a2, long a3, long a4, long a5, long a6);
+#endif
+int  fa125LogStart();
+void fa125LogStop();
+int  fa125LogSetRateLimit(int per_second);
+void fa125LogGetStats(unsigned long long *written, unsigned long long *dropped,
+		      unsigned long long *suppressed);
+int  fa125SetReadCrossover(int nwords);
+int  fa125GetDmaCalibration(FA125_DMA_CALIBRATION *cal);
+void fa125PrintDmaCalibration();
+#ifndef VXWORKS
+int  fa125DmaCalibrate(int id, volatile UINT32 *buf, int nwords, unsigned int modemask,
+		       int pflag);
+int  fa125GetVmeCountsApi(const char *api, FA125_VME_COUNTS *counts);
+int  fa125GetVmeCountsSlot(int id, FA125_VME_COUNTS *counts);
+int  fa125GetVmeCountsThread(FA125_VME_COUNTS *counts);
+void fa125ResetVmeCounts();
+void fa125PrintVmeCounts();
+void fa125TracePoint(int point, int phase, int arg);
+int  fa125TraceExport(const char *filename);
+void fa125TraceClear();
+#endif
 
 /*  Firmware Updating Routine Prototypes */
 void fa125FirmwareSetDebug(unsigned int debug);
@@ -12,8 +12,99 @@ uint32_t trig_delay = 0; /* Extra delay to add to the config value */
 // compile in a default configuration for testing
 #include "fa125_config.c"
 
-// prototype defined way below
+/*
+  Pipelined readout (fa125_set_pipeline(1))
+
+  When the block of the current trigger has been read, the DMA of the next
+  block is started into a staging buffer if the modules already hold it
+  (TI BUFFERLEVEL > 1).  The current block is then banked and checked while
+  the next one is transferred.  The DMA is completed at the start of the
+  next trigger (fa125_dma_complete), before the TI trigger block needs the
+  DMA engine.
+*/
+#define FA125_PIPE_NBUF      2
+#define FA125_PIPE_MAXWORDS  0x3000
+
+/* Room for the fa125 bank in the event buffer, and the words read past the
+   end of the data for the bus error to end the DMA */
+#define FA125_READ_MAXWORDS  0x3000
+#define FA125_READ_BERRWORDS 2
+
+/* Words requested by a readout, sized in fa125_go from the configuration */
+static int32_t fa125ReadWords = FA125_READ_MAXWORDS;
+
+/* Time given to a slow module before the rest of the crate is read without
+   it (fa125ReadCrate), in microseconds */
+#define FA125_READ_DEADLINE  1000
+static uint32_t fa125ReadNpartial = 0;
+
+/* Timeline of the readout written at end, when built with -DFA125_TRACE */
+#ifndef FA125_TRACE_FILE
+#define FA125_TRACE_FILE     "/tmp/fa125_trace.json"
+#endif
+
+int32_t fa125_pipeline = 0;
+static DMA_MEM_ID fa125PipePool = 0;
+static DMANODE *fa125PipeNode[FA125_PIPE_NBUF];
+static int32_t fa125PipeArmed = -1;           /* buffer with a DMA in flight */
+static int32_t fa125PipeReady = -1;           /* buffer holding the next block */
+static int32_t fa125PipeCount[FA125_PIPE_NBUF];
+static uint32_t fa125PipeNprefetch = 0, fa125PipeNdirect = 0, fa125PipeNbad = 0;
+
+// prototypes defined way below
 void fa125_config_init();
+void fa125_dma_complete();
+
+/* Configuration written to each module, and the steps that write it
+   (run in parallel by fa125ConfigRun) */
+static FADC125_CONF fa125_applied[FA125_MAX_BOARDS + 1];
+
+static int
+fa125_step_power_on(int id, void *arg)
+{
+  return fa125PowerOn(id);
+}
+
+static int
+fa125_step_apply(int id, void *arg)
+{
+  return fa125ConfigApply(id, (FADC125_CONF *) arg);
+}
+
+/* Choose the DMA mode of the crate, and the block length below which the
+   readout uses programmed I/O (fa125DmaCalibrate).  The TI is read with the
+   same DMA engine, so only modes it supports are tried.  Falls back to
+   2eSST267 if the calibration fails. */
+#define FA125_ROL_DMA_MODES						\
+  (FA125_DMA_MODE_BLK32 | FA125_DMA_MODE_MBLK | FA125_DMA_MODE_2EVME |	\
+   FA125_DMA_MODE_2ESST160 | FA125_DMA_MODE_2ESST267)
+
+static void
+fa125_dma_calibrate()
+{
+  DMA_MEM_ID pool;
+  DMANODE *node;
+  int stat = ERROR;
+
+  pool = dmaPCreate("fa125Cal", FA125_DMA_CAL_WORDS << 2, 1, 0);
+  if(pool != 0)
+    {
+      node = dmaPGetItem(pool);
+      if(node != NULL)
+	{
+	  stat = fa125DmaCalibrate(0, (volatile UINT32 *) node->data,
+				   FA125_DMA_CAL_WORDS, FA125_ROL_DMA_MODES, 1);
+	  dmaPFreeItem(node);
+	}
+      dmaPFree(pool);
+    }
+
+  if(stat != OK)
+    {
+      daLogMsg("WARN", "fa125 DMA calibration failed, using 2eSST267\n");
+      vmeDmaConfig(2, 5, 1);
+    }
+}
 
 // To be defined in fa125Config.{c,h}
 #define print_fadc125_conf(x)
@@ -74,11 +165,16 @@ fa125_download()
     }
 
   NFADC_125 = nfa125;		/* Redefine our NFADC with what was found from the driver */
+  fa125SetReadoutDeadline(FA125_READ_DEADLINE);
+  fa125LogStart();		/* Messages of the readout written off the trigger path */
+  fa125_dma_calibrate();	/* DMA mode, and programmed I/O of short blocks */
 
   printf(" NUMBER OF FADC125  initialized  %d \n", NFADC_125);
 
   fa125ResetToken(0);		//---  !!!
 
+  fa125ConfigQueueClear();
+
 
   for(slot = 0; slot < NFADC_125; slot++)
     {
@@ -195,43 +291,51 @@ fa125_download()
 
 
 
-      fa125PowerOn(FA_SLOT);
+      /* Board configuration, as written to the module */
+      FADC125_CONF *conf = &fa125_applied[FA_SLOT];
+      *conf = fa125[FA_SLOT];
 
-      for(ichan = 0; ichan < 72; ichan++)
-	{
-
-	  fa125SetOffset(FA_SLOT, ichan, fa125[FA_SLOT].dac[ichan]);
-
-	  unsigned int LOWTHR = 0;
-	  //LOWTHR=fa125[FA_SLOT].read_thr[ichan]*0.5;  printf("SL=%d CH=%d THR=%d LOW=%d  TH=%d  TL=%d \n",FA_SLOT,ichan,fa125[FA_SLOT].read_thr[ichan],LOWTHR,fa125[FA_SLOT].TH,fa125[FA_SLOT].TL);
+      // trig_delay is set in 4 ns bins
+      conf->winOffset = fa125[FA_SLOT].winOffset + trig_delay / 2;
 
-	  if(LOWTHR > 0)
-	    fa125SetThreshold(FA_SLOT, ichan, LOWTHR);	// SF for tests
-	  else
-	    {
-	      if(fa125[FA_SLOT].read_thr[ichan] > 0x1FF)
-		fa125SetThreshold(FA_SLOT, ichan, 0x1FF);	// Maximum Threshold value is 511
-	      else
-		fa125SetThreshold(FA_SLOT, ichan,
-				  fa125[FA_SLOT].read_thr[ichan]);
-	    }
+      printf("Trigger global delay  =  %d,  Window offset =  %d \n", trig_delay, conf->winOffset);
 
-	  // Alex
-	  //      fa125SetThreshold(FA_SLOT, ichan, 1);
+      for(ichan = 0; ichan < 72; ichan++)
+	{
+	  if(conf->read_thr[ichan] > 0x1FF)
+	    conf->read_thr[ichan] = 0x1FF;	// Maximum Threshold value is 511
 	}
 
-      fa125PrintThreshold(FA_SLOT);
-
-
-      //fa125Reset(FA_SLOT, 0);  //--- ???
+      if((conf->busy > 0) && (conf->busy < 5))
+	{
+	  printf(" Enable BUSY for FA125 in slot %d : %d \n",
+		 FA_SLOT, conf->busy);
+	}
+      else
+	{
+	  printf(" BUSY for FA125 in slot %d  is out of range. Set to 3 \n",
+		 FA_SLOT);
+	  conf->busy = 3;
+	}
 
-      // trig_delay is set in 4 ns bins
-      unsigned int window_offset = fa125[FA_SLOT].winOffset + trig_delay / 2;
+      printf("  CHECK  TL = %d   TH = %d \n ", conf->TL, conf->TH);
 
-      printf("Trigger global delay  =  %d,  Window offset =  %d \n", trig_delay, window_offset);
+      printf("\n");
+      printf("Disabled channels:   0x%X   0x%X   0x%X  \n",
+	     (conf->ch_disable[0] & 0xFFFFFF),
+	     (conf->ch_disable[1] & 0xFFFFFF),
+	     (conf->ch_disable[2] & 0xFFFFFF));
+      printf("Enabled channels:   0x%X   0x%X   0x%X  \n",
+	     (~conf->ch_disable[0] & 0xFFFFFF),
+	     (~conf->ch_disable[1] & 0xFFFFFF),
+	     (~conf->ch_disable[2] & 0xFFFFFF));
+      printf("\n");
 
+      if(conf->data_format == 0)
+	printf(" Set data FORMAT for FADC in slot %d to  0  (enable trigger time)   \n", FA_SLOT);
+      else if(conf->data_format == 1)
+	printf(" Set data FORMAT for FADC in slot %d to  1  (suppress trigger time) \n", FA_SLOT);
 
-      // ================================================================================================
       /*
 	"Integral and Time (CDC_short)",             // 3
 	"Integral and Time (FDC_short)",             // 4
@@ -241,60 +345,24 @@ fa125_download()
 	"Peak Amplitude and Samples (FDC_amp_long)", // 8
       */
 
-      int rval =
-	fa125SetProcMode(FA_SLOT,
-			 (char *)fa125_modes[fa125[FA_SLOT].mode],
-			 window_offset,
-			 fa125[FA_SLOT].winWidth,
-			 fa125[FA_SLOT].IE,
-			 fa125[FA_SLOT].PG,	// PG default 4
-			 fa125[FA_SLOT].npeak,	// number of peaks
-			 fa125[FA_SLOT].P1,	// P1 default 4
-			 fa125[FA_SLOT].P2);	// P2 default 4
-
-      if(rval != OK)
-	{
-	  daLogMsg("ERROR", "fa125SetProcMode failed \n");
-	  return -1;
-	}
-
-      // And new now set the Scale Factors
-      // IBIT = 4 scale integral
-      // ABIT = 3 scale amplitude
-      // PBIT = 0 scale pedestal
-
-      rval =
-	fa125SetScaleFactors(FA_SLOT, fa125[FA_SLOT].IBIT,
-			     fa125[FA_SLOT].ABIT, fa125[FA_SLOT].PBIT);
-
-      if(rval != OK)
-	{
-	  daLogMsg("ERROR", "fa125SetScaleFactors failed \n");
-	  return -1;
-	}
-
-
-
-      // And also new the thresholds for the timing alorighm
-      // TH = 100
-      // TL = 25
-
-      printf("  CHECK  TL = %d   TH = %d \n ", fa125[FA_SLOT].TL,
-	     fa125[FA_SLOT].TH);
-
-      rval =
-	fa125SetCommonTimingThreshold(FA_SLOT, fa125[FA_SLOT].TL,
-				      fa125[FA_SLOT].TH);
-
-      if(rval != OK)
-	{
-	  daLogMsg("ERROR", "fa125SetCommonTimingThreshold failed \n");
-	  return -1;
-	}
+      /* Power on, then offsets, thresholds, processing mode, scale factors,
+	 timing thresholds, channel masks, busy level and data format */
+      fa125ConfigQueue(FA_SLOT, fa125_step_power_on, NULL);
+      fa125ConfigQueue(FA_SLOT, fa125_step_apply, conf);
+    }
 
-      //    fa125PrintTimingThresholds(FA_SLOT);
+  /* Configure the modules in parallel */
+  if(fa125ConfigRun(0) != OK)
+    {
+      fa125ConfigPrintResults();
+      daLogMsg("ERROR", "fa125 configuration failed \n");
+      return -1;
+    }
+  fa125ConfigPrintResults();
 
-      //================================================================================================
+  for(slot = 0; slot < NFADC_125; slot++)
+    {
+      FA_SLOT = fa125Slot(slot);
 
       if(debug_init)
 	{
@@ -307,40 +375,6 @@ fa125_download()
 	  printf(" npeak      =  %d  \n", fa125[FA_SLOT].npeak);
 	}
 
-
-      printf("\n");
-      printf("Disabled channels:   0x%X   0x%X   0x%X  \n",
-	     (fa125[FA_SLOT].ch_disable[0] & 0xFFFFFF),
-	     (fa125[FA_SLOT].ch_disable[1] & 0xFFFFFF),
-	     (fa125[FA_SLOT].ch_disable[2] & 0xFFFFFF));
-      printf("Enabled channels:   0x%X   0x%X   0x%X  \n",
-	     (~fa125[FA_SLOT].ch_disable[0] & 0xFFFFFF),
-	     (~fa125[FA_SLOT].ch_disable[1] & 0xFFFFFF),
-	     (~fa125[FA_SLOT].ch_disable[2] & 0xFFFFFF));
-
-      printf("\n");
-      /* printf("Threshold factor = %f \n", */
-      /* 	     fa125[FA_SLOT].thr_fact); */
-      printf("\n");
-
-
-      /* Enable all channels */
-      //    fa125SetChannelEnableMask(FA_SLOT, 0xFFFFFF, 0xFFFFFF, 0xFFFFFF);
-
-      // Alex
-      fa125SetChannelEnableMask(FA_SLOT,
-				(~fa125[FA_SLOT].ch_disable[0] & 0xFFFFFF),
-				(~fa125[FA_SLOT].ch_disable[0] & 0xFFFFFF),
-				(~fa125[FA_SLOT].ch_disable[0] & 0xFFFFFF));
-
-      //    fa125SetChannelDisableMask(FA_SLOT, 0xFFFFFF, 0xFFFFFF, 0xFFFFFF);
-      //    fa125SetChannelEnableMask(FA_SLOT, 0x1, 0 , 0);
-      //    fa125SetChannelEnableMask(FA_SLOT, 0xFFFFFF, 0xFFFFFF, 0xFFFFFF );
-      //    fa125SetChannelEnableMask(FA_SLOT, 0xFFFFFF, 0xFFF000, 0 );
-      //    fa125SetChannelEnableMask(FA_SLOT, 0xF, 0, 0 );
-
-
-
       printf("fa125_prestart():: Reset  board in slot  = %d \n", FA_SLOT);
       fa125Reset(FA_SLOT, 0);	//-- !!!!
 
@@ -360,27 +394,6 @@ fa125_download()
 	}
       printf("\n");
 
-      if((fa125[FA_SLOT].busy > 0) && (fa125[FA_SLOT].busy < 5))
-	{
-	  fa125SetNTrigBusy(FA_SLOT, fa125[FA_SLOT].busy);
-	  printf(" Enable BUSY for FA125 in slot %d : %d \n",
-		 FA_SLOT, fa125[FA_SLOT].busy);
-	}
-      else
-	{
-	  printf(" BUSY for FA125 in slot %d  is out of range. Set to 3 \n",
-		 FA_SLOT);
-	  fa125SetNTrigBusy(FA_SLOT, 3);
-	}
-
-
-      if(fa125[FA_SLOT].data_format == 0)
-	printf(" Set data FORMAT for FADC in slot %d to  0  (enable trigger time)   \n", FA_SLOT);
-      else if(fa125[FA_SLOT].data_format == 1)
-	printf(" Set data FORMAT for FADC in slot %d to  1  (suppress trigger time) \n", FA_SLOT);
-
-      fa125DataSuppressTriggerTime(FA_SLOT, fa125[FA_SLOT].data_format);
-
 
     }
 
@@ -390,6 +403,17 @@ fa125_download()
     }
 
 
+  if(fa125_pipeline && (fa125PipePool == 0))
+    {
+      fa125PipePool = dmaPCreate("fa125Pipe", FA125_PIPE_MAXWORDS << 2,
+				 FA125_PIPE_NBUF, 0);
+      if(fa125PipePool == 0)
+	{
+	  daLogMsg("ERROR", "Unable to allocate fa125 pipeline buffers\n");
+	  fa125_pipeline = 0;
+	}
+    }
+
   /***************************************
    *   SD SETUP
    ***************************************/
@@ -424,6 +448,9 @@ fa125_prestart()
   int stat;
   int islot;
 
+  /* A DMA left by the last run (e.g. a timed out read ahead) */
+  if(fa125ReadBlockAbort())
+    printf("fa125_prestart: WARN: DMA of the last run given up\n");
   fa125ResetToken(0);
 
   /* FADC Perform some resets, status */
@@ -443,6 +470,33 @@ fa125_prestart()
       fa125PrintTimingThresholds(FA_SLOT);
     }
 
+  if(fa125_pipeline)
+    {
+      int ibuf, nbuf = 0;
+      for(ibuf = 0; ibuf < FA125_PIPE_NBUF; ibuf++)
+	{
+	  fa125PipeNode[ibuf] = dmaPGetItem(fa125PipePool);
+	  if(fa125PipeNode[ibuf])
+	    nbuf++;
+	}
+      fa125PipeArmed = fa125PipeReady = -1;
+      fa125PipeNprefetch = fa125PipeNdirect = fa125PipeNbad = 0;
+
+      if(nbuf < FA125_PIPE_NBUF)
+	{
+	  daLogMsg("ERROR", "Unable to get fa125 pipeline buffers.  Pipeline disabled\n");
+	  for(ibuf = 0; ibuf < FA125_PIPE_NBUF; ibuf++)
+	    {
+	      if(fa125PipeNode[ibuf])
+		dmaPFreeItem(fa125PipeNode[ibuf]);
+	      fa125PipeNode[ibuf] = NULL;
+	    }
+	  fa125_pipeline = 0;
+	}
+      else
+	printf("fa125_prestart: Pipelined readout enabled\n");
+    }
+
   return (0);
 
 }
@@ -451,7 +505,7 @@ int
 fa125_go()
 {
 
-  int islot;
+  int islot, maxwords;
 
   blockLevel = tiGetCurrentBlockLevel();
 
@@ -464,6 +518,27 @@ fa125_go()
       // fa125Reset(fa125Slot(islot), 0);   //-- !!!!
     }
 
+  /* Size the readout from the upper bound of the configured data */
+  maxwords = fa125GMaxBlockWords();
+  if(maxwords <= 0)
+    {
+      printf("fa125_go: WARN: Unable to model the block size.  Reading up to %d words\n",
+	     FA125_READ_MAXWORDS);
+      fa125ReadWords = FA125_READ_MAXWORDS;
+    }
+  else
+    {
+      fa125ReadWords = maxwords + FA125_READ_BERRWORDS;
+      if(fa125ReadWords > FA125_READ_MAXWORDS)
+	{
+	  daLogMsg("ERROR",
+		   "fa125 blocks of up to %d words do not fit in %d words.  Reduce blocklevel, NW or NPK",
+		   maxwords, FA125_READ_MAXWORDS);
+	  fa125ReadWords = FA125_READ_MAXWORDS;
+	}
+      printf("fa125_go: Reading up to %d words per block\n", fa125ReadWords);
+    }
+
   sdStatus(0);
 
   return (0);
@@ -474,13 +549,155 @@ int
 fa125_end()
 {
   int32_t islot;
+  unsigned long long ndropped = 0, nsuppressed = 0;
+
+  if(fa125_pipeline)
+    {
+      int ibuf;
+
+      if(fa125PipeArmed >= 0)
+	{
+	  fa125_dma_complete();
+	  FA125LOGMSG("fa125_end: WARN: Block read ahead was not claimed by a trigger (%d words)\n",
+		      fa125PipeCount[fa125PipeReady],0,0,0,0,0);
+	}
+      fa125PipeReady = -1;
+
+      for(ibuf = 0; ibuf < FA125_PIPE_NBUF; ibuf++)
+	{
+	  if(fa125PipeNode[ibuf])
+	    dmaPFreeItem(fa125PipeNode[ibuf]);
+	  fa125PipeNode[ibuf] = NULL;
+	}
+
+      printf("fa125_end: Pipeline: %u blocks read ahead, %u read on trigger, %u bad\n",
+	     fa125PipeNprefetch, fa125PipeNdirect, fa125PipeNbad);
+    }
+  if(fa125ReadBlockAbort())
+    printf("fa125_end: WARN: DMA in progress given up\n");
   for(islot = 0; islot < NFADC_125; islot++)
     {
       FA_SLOT = fa125Slot(islot);
       fa125Disable(FA_SLOT);
 
     }
+  fa125LogStop();		/* Write the messages of the run before the summary */
+  fa125LogGetStats(NULL, &ndropped, &nsuppressed);
+  if(ndropped || nsuppressed)
+    printf("fa125_end: %llu log messages dropped, %llu suppressed by the rate limit\n",
+	   ndropped, nsuppressed);
+  fa125LogStart();
+
   fa125GStatus(1);
+  if(fa125ReadNpartial)
+    printf("fa125_end: %u partial crate readouts\n", fa125ReadNpartial);
+  fa125PrintReadoutLateness(1);
+  fa125PrintReadyHistogram(1);
+  fa125PrintReadoutStats(1);
+#ifdef FA125_ACCT
+  fa125PrintVmeCounts();
+  fa125ResetVmeCounts();
+#endif
+#ifdef FA125_TRACE
+  if(fa125TraceExport(FA125_TRACE_FILE) > 0)
+    printf("fa125_end: Readout trace written to %s\n", FA125_TRACE_FILE);
+  fa125TraceClear();
+#endif
+  fa125ReadNpartial = 0;
+
+  return OK;
+}
+
+void
+fa125_set_pipeline(int enable)
+{
+  fa125_pipeline = enable ? 1 : 0;
+}
+
+/* Complete the DMA started by the previous trigger, if any */
+void
+fa125_dma_complete()
+{
+  if(fa125PipeArmed < 0)
+    return;
+
+  fa125PipeCount[fa125PipeArmed] = fa125ReadBlockComplete(0);
+  fa125PipeReady = fa125PipeArmed;
+  fa125PipeArmed = -1;
+
+  fa125ResetToken(fa125Slot(0));
+}
+
+/* Check the block header / trailer pairs of a readout.  Returns the number
+   of blocks found, or -1 if the structure is broken */
+static int
+fa125_check_blocks(volatile unsigned int *data, int nwords)
+{
+  return fa125IndexBlocks(data, nwords, 1, NULL, 0);
+}
+
+static int
+fa125_trigger_pipeline(int arg)
+{
+  int32_t rflag = (nfa125 > 1) ? 2 : 1;
+  int32_t cur, next, dCnt, nmissing = 0;
+  unsigned int scanmask = fa125ScanMask(), missing = 0;
+
+  cur = fa125PipeReady;
+  fa125PipeReady = -1;
+
+  if(cur < 0)
+    { /* Nothing read ahead: read this block now, from the modules that are ready */
+      cur = 0;
+      fa125PipeCount[cur] =
+	fa125ReadCrate((volatile UINT32 *)fa125PipeNode[cur]->data, fa125ReadWords, &missing);
+      fa125PipeNdirect++;
+      if(missing)
+	{
+	  fa125ReadNpartial++;
+	  FA125LOGMSG("fa125_trigger: WARN: Slots 0x%08x not ready.  Read without them\n",
+		      missing,0,0,0,0,0);
+	}
+      for(; missing; missing &= missing - 1)
+	nmissing++;
+    }
+  else
+    fa125PipeNprefetch++;
+
+  /* Start the transfer of the next block, if it is already in the modules.
+     Not while a module owes a late block: its ready status is for that one. */
+  next = (cur + 1) % FA125_PIPE_NBUF;
+  if((fa125GetReadoutOwed() == 0) && (fa125GBready() == scanmask))
+    {
+      if(fa125ReadBlockStart(fa125Slot(0),
+			     (volatile UINT32 *)fa125PipeNode[next]->data,
+			     fa125ReadWords, rflag) == OK)
+	fa125PipeArmed = next;
+    }
+
+  /* Bank and check this block while the next one is transferred */
+  dCnt = fa125PipeCount[cur];
+  if(dCnt <= 0)
+    {
+      FA125LOGMSG("No fa125 data or error.  dCnt = %d\n", dCnt,0,0,0,0,0);
+    }
+  else
+    {
+      if(fa125_check_blocks((volatile unsigned int *)fa125PipeNode[cur]->data, dCnt) !=
+	 nfa125 - nmissing)
+	{
+	  fa125PipeNbad++;
+	  FA125LOGMSG("fa125_trigger: ERROR: Bad block structure (%d words)\n",
+		      dCnt,0,0,0,0,0);
+	}
+
+      FA125TRACE_BEGIN(FA125_TRACE_BANK, dCnt);
+      BANKOPEN(125, BT_UI4, 1);
+      memcpy((void *)dma_dabufp, (void *)fa125PipeNode[cur]->data, dCnt << 2);
+      dma_dabufp += dCnt;
+      BANKCLOSE;
+      FA125TRACE_END(FA125_TRACE_BANK, dCnt);
+    }
 
   return OK;
 }
@@ -488,46 +705,34 @@ fa125_end()
 int
 fa125_trigger(int arg)
 {
-  int32_t rflag=1;
-  int32_t iread = 0, timeout = 100;
-  int32_t faslot = 0, iadc = 0;
   int32_t dCnt;
+  uint32_t missing = 0;
 
-  if(nfa125>1) rflag=2;
-  printf("Check for BReady\n");
-  for(iread=0; iread<timeout; iread++)
+  if(fa125_pipeline)
+    return fa125_trigger_pipeline(arg);
+
+  /* Read the modules that are ready by the deadline.  Missing modules are
+     tagged in the bank, and their late blocks dropped on a later trigger. */
+  dCnt = fa125ReadCrate((volatile UINT32 *)dma_dabufp, fa125ReadWords, &missing);
+  if(missing)
     {
-      if(fa125GBready(faslot)==fa125ScanMask())
-	break;
+      fa125ReadNpartial++;
+      FA125LOGMSG("fa125_trigger: WARN: Slots 0x%08x not ready.  Read without them\n",
+		  missing,0,0,0,0,0);
     }
-  printf("Check for Timeout\n");
-  if(iread==timeout)
+
+  if(dCnt<=0)
     {
-      printf("fa125 (%d) timeout  (fa125GBready: 0x%08x != 0x%08x)\n",faslot,
-	     fa125GBready(faslot), fa125ScanMask());
-      /* 	  fa125SGtatus(); */
+      FA125LOGMSG("No fa125 data or error.  dCnt = %d\n", dCnt,0,0,0,0,0);
     }
   else
     {
-      printf("Readout\n");
-      /* 	  for(iadc=0; iadc<nfa125; iadc++) */
-      /* 	    { */
-      /* 	      rflag=1; */
-      faslot = fa125Slot(iadc);
-      dCnt = fa125ReadBlock(faslot,(volatile UINT32 *)dma_dabufp,0x3000,rflag);
-      if(dCnt<=0)
-	{
-	  printf("No fa125 (%d) data or error.  dCnt = %d\n",faslot,dCnt);
-	}
-      else
-	{
-	  BANKOPEN(125, BT_UI4, 1);
-	  dma_dabufp += dCnt;
-	  BANKCLOSE;
-	}
-      /* 	    } */
+      FA125TRACE_BEGIN(FA125_TRACE_BANK, dCnt);
+      BANKOPEN(125, BT_UI4, 1);
+      dma_dabufp += dCnt;
+      BANKCLOSE;
+      FA125TRACE_END(FA125_TRACE_BANK, dCnt);
     }
-  fa125ResetToken(fa125Slot(0));
 
   return OK;
 }
@@ -70,6 +70,9 @@ rocDownload()
    *  addrType = 0 (A16)    1 (A24)    2 (A32)
    *  dataType = 0 (D16)    1 (D32)    2 (BLK32) 3 (MBLK) 4 (2eVME) 5 (2eSST)
    *  sstMode  = 0 (SST160) 1 (SST267) 2 (SST320)
+   *
+   *  Replaced at Download by the fastest mode of the crate that the TI
+   *  also supports (fa125DmaCalibrate, in fa125_download).
    */
   vmeDmaConfig(2,5,1);
 
@@ -124,6 +127,8 @@ rocDownload()
   tiStatus(0);
 
 #ifdef USE_FA125
+  /* With more than one block buffered, read ahead the next fa125 block */
+  fa125_set_pipeline(BUFFERLEVEL > 1);
   fa125_download();
 #endif
 
@@ -268,6 +273,12 @@ rocTrigger(int arg)
   /* Set TI output 1 high for diagnostics */
   tiSetOutputPort(1,0,0,0);
 
+#ifdef USE_FA125
+  /* Finish the fa125 transfer started by the previous trigger.
+     The TI needs the DMA engine. */
+  fa125_dma_complete();
+#endif
+
   /* Readout the trigger block from the TI
      Trigger Block MUST be readout first */
   dCnt = tiReadTriggerBlock(dma_dabufp);
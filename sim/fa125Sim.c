@@ -0,0 +1,1475 @@
+/*----------------------------------------------------------------------------*
+ *  Copyright (c) 2010        Southeastern Universities Research Association, *
+ *                            Thomas Jefferson National Accelerator Facility  *
+ *                                                                            *
+ *    This software was developed under a United States Government license    *
+ *    described in the NOTICE file included as part of this distribution.     *
+ *                                                                            *
+ *    Authors: Bryan Moffit                                                   *
+ *             moffit@jlab.org                   Jefferson Lab, MS-12B3       *
+ *             Phone: (757) 269-5660             12000 Jefferson Ave.         *
+ *             Fax:   (757) 269-5800             Newport News, VA 23606       *
+ *                                                                            *
+ * __DATE__:
+ *                                                                            *
+ *----------------------------------------------------------------------------*
+ *
+ * Description:
+ *     Software crate model of fADC125s behind the jvme calls.
+ *
+ *     The A24 and A32 spaces are reserved (PROT_NONE) in the process address
+ *     space, and vmeBusToLocalAdrs() hands out pointers into them.  Every
+ *     register and FIFO access from fa125Lib must therefore go through
+ *     vmeRead32/vmeWrite32/vmeMemProbe/vmeDmaSend, where it is decoded and
+ *     applied to the board model.  A stray dereference faults immediately.
+ *
+ *     Data in the DMA destination buffer is stored in VME (big endian) byte
+ *     order, as it would be with a real Universe/Tempe DMA engine.
+ *
+ *     Every access is charged to a simulated bus clock, from the timing
+ *     model (fa125SimSetTiming): single cycle read and write latency, DMA
+ *     setup, the sustained rate of the configured DMA mode (vmeDmaConfig),
+ *     BERR turnaround and token passes.  The charges are accumulated in
+ *     FA125_SIM_STATS; they cost no wall time unless timing.realtime is set.
+ *
+ *----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "jvme.h"
+#include "fa125Lib.h"
+#include "fa125Sim.h"
+
+#define SIMLOCK     if(pthread_mutex_lock(&simMutex)<0) perror("pthread_mutex_lock");
+#define SIMUNLOCK   if(pthread_mutex_unlock(&simMutex)<0) perror("pthread_mutex_unlock");
+
+#define NREGS        (sizeof(struct fa125_a24)/4)
+#define REG(_m)      (offsetof(struct fa125_a24, _m)/4)
+#define FEREG(_i,_m) ((offsetof(struct fa125_a24, fe[0]._m) + (_i)*sizeof(struct fa125_a24_fe))/4)
+
+#define SIM_MAX_BLOCKS     1024          /* blocks held in a board FIFO */
+#define SIM_MAX_BLOCKWORDS 0x100000      /* largest block a builder may return */
+#define SIM_TEMPERATURE    560           /* 35 degC in units of 0.0625 degC */
+
+#define SIM_FILLER(_slot)  (0xF8000000 | ((_slot)<<22))
+
+struct fa125_sim_board
+{
+  int                present;
+  int                slot;
+  UINT32             reg[NREGS];
+
+  /* FIFO */
+  UINT32            *fifo;
+  int                fifo_alloc;
+  int                fifo_head;
+  int                fifo_tail;
+  int                blk_len[SIM_MAX_BLOCKS];
+  int                blk_nev[SIM_MAX_BLOCKS];
+  int                blk_head;
+  int                nblk;
+  int                nev;            /* events in the FIFO */
+  int                cur_left;       /* words left in the block being read */
+  int                cur_pad;        /* filler word owed after the trailer */
+  int                in_block;
+  int                berr;           /* BERR asserted */
+  int                ready_delay;    /* polls before a head block is ready */
+  int                ready_wait;
+
+  /* Event building */
+  unsigned int       ntrig;
+  unsigned int       evnum;
+  unsigned int       blknum;
+  FA125_SIM_BLOCK    pend;
+
+  /* LTC2620 chains (A: dacChan 0-39, B: dacChan 40-79) */
+  UINT32             dacctl;
+  UINT32             chain[2][5];
+  unsigned short     dac_in[80];
+  unsigned short     dac_out[80];
+};
+
+static pthread_mutex_t         simMutex = PTHREAD_MUTEX_INITIALIZER;
+static char                   *simA24 = NULL;
+static char                   *simA32 = NULL;
+static struct fa125_sim_board  simBoard[FA125_SIM_MAX_SLOT+1];
+static int                     simToken = 0;   /* slot with token, -1 = chain done */
+static unsigned long long      simClock = 0;
+static FA125_SIM_BUILDER       simBuilder = fa125SimDefaultBuilder;
+static void                   *simBuilderArg = NULL;
+static UINT32                 *simBlockBuf = NULL;
+static FA125_SIM_STATS         simStats;
+
+/* Register writes recorded for fa125SimRecordWrites */
+static int                     simRecSlot = 0;
+static FA125_SIM_WRITE        *simRecLog = NULL;
+static int                     simRecMax = 0, simRecN = 0;
+
+/* DMA engine state */
+static unsigned int            simDmaAddrType = 2, simDmaDataType = 2, simDmaSstMode = 0;
+static int                     simDmaPending = 0;
+static int                     simDmaResult = 0;
+
+/* Time charged to the caller for each single cycle access */
+static int                     simCycleTime = 0;   /* ns */
+
+/* Bus timing model (as fa125SimTimingDefaults) */
+static FA125_SIM_TIMING        simTiming =
+  {
+    1000, 500, 8000, 2000, 250,
+    {10., 20., 40., 70., 100.},
+    {150., 200., 220.},
+    8000, 0
+  };
+
+/**
+ *  @brief Reserve the local windows for the A24 and A32 spaces.
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125SimInit()
+{
+  SIMLOCK;
+  if(simA24 == NULL)
+    {
+      simA24 = mmap(NULL, FA125_SIM_A24_SIZE, PROT_NONE,
+		    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      simA32 = mmap(NULL, FA125_SIM_A32_SIZE, PROT_NONE,
+		    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if((simA24 == MAP_FAILED) || (simA32 == MAP_FAILED))
+	{
+	  printf("\n%s: ERROR: Unable to reserve VME windows\n\n", __FUNCTION__);
+	  simA24 = simA32 = NULL;
+	  SIMUNLOCK;
+	  return ERROR;
+	}
+      simBlockBuf = (UINT32 *)malloc(SIM_MAX_BLOCKWORDS * sizeof(UINT32));
+    }
+  SIMUNLOCK;
+
+  return OK;
+}
+
+/**
+ *  @brief Remove all boards and release the FIFO memory.
+ */
+void
+fa125SimCleanup()
+{
+  int islot;
+
+  for(islot = 0; islot <= FA125_SIM_MAX_SLOT; islot++)
+    fa125SimRemoveBoard(islot);
+
+  SIMLOCK;
+  simToken = 0;
+  simDmaPending = 0;
+  memset(&simStats, 0, sizeof(simStats));
+  SIMUNLOCK;
+}
+
+/**
+ *  @brief Set the time taken by each single cycle read or write.  The
+ *     calling thread spins for this long after the access, outside the
+ *     model lock, so that threads on different boards overlap as they would
+ *     on the bus.
+ *  @param ns Access time in ns (0: no delay)
+ */
+void
+fa125SimSetCycleTime(int ns)
+{
+  simCycleTime = (ns > 0) ? ns : 0;
+}
+
+static void
+simSpin(long long ns)
+{
+  struct timespec ts;
+  long long t0, t;
+
+  if(ns <= 0)
+    return;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  t0 = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  do
+    {
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      t = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+  while(t - t0 < ns);
+}
+
+/* Wall time taken by a single cycle access charged ns of bus time */
+static void
+simCycle(long long ns)
+{
+  if(simCycleTime)
+    simSpin(simCycleTime);
+  else if(simTiming.realtime)
+    simSpin(ns);
+}
+
+/* Charge ns of bus time to one component of the stats (call with the
+   model locked) */
+#define SIMCHARGE(_field, _ns) {			\
+    simStats._field += (_ns);				\
+    simStats.bus_ns += (_ns);				\
+  }
+
+/**
+ *  @brief Fill in the default bus timing model.
+ *  @param timing Where to return the defaults
+ */
+void
+fa125SimTimingDefaults(FA125_SIM_TIMING *timing)
+{
+  memset(timing, 0, sizeof(FA125_SIM_TIMING));
+  timing->read_ns      = 1000;
+  timing->write_ns     = 500;
+  timing->dma_setup_ns = 8000;
+  timing->berr_ns      = 2000;
+  timing->token_ns     = 250;
+  timing->mbps[0]      = 10.;    /* D16 */
+  timing->mbps[1]      = 20.;    /* D32 */
+  timing->mbps[2]      = 40.;    /* BLK32 */
+  timing->mbps[3]      = 70.;    /* MBLK */
+  timing->mbps[4]      = 100.;   /* 2eVME */
+  timing->sst_mbps[0]  = 150.;   /* 2eSST160 */
+  timing->sst_mbps[1]  = 200.;   /* 2eSST267 */
+  timing->sst_mbps[2]  = 220.;   /* 2eSST320 */
+  timing->trigger_ns   = 8000;
+  timing->realtime     = 0;
+}
+
+/**
+ *  @brief Set the bus timing model.  Applies to accesses from now on;
+ *     time already charged is kept.
+ *  @param timing Timing model
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125SimSetTiming(const FA125_SIM_TIMING *timing)
+{
+  int i;
+
+  if(timing == NULL)
+    return ERROR;
+
+  for(i = 0; i < 5; i++)
+    if(timing->mbps[i] <= 0)
+      {
+	printf("%s: ERROR: Invalid DMA rate (%g MB/s) for dataType %d\n",
+	       __FUNCTION__, timing->mbps[i], i);
+	return ERROR;
+      }
+  for(i = 0; i < 3; i++)
+    if(timing->sst_mbps[i] <= 0)
+      {
+	printf("%s: ERROR: Invalid 2eSST rate (%g MB/s) for sstMode %d\n",
+	       __FUNCTION__, timing->sst_mbps[i], i);
+	return ERROR;
+      }
+  if(timing->trigger_ns < 4)
+    {
+      printf("%s: ERROR: Invalid trigger interval (%d ns)\n",
+	     __FUNCTION__, timing->trigger_ns);
+      return ERROR;
+    }
+
+  SIMLOCK;
+  simTiming = *timing;
+  SIMUNLOCK;
+
+  return OK;
+}
+
+void
+fa125SimGetTiming(FA125_SIM_TIMING *timing)
+{
+  SIMLOCK;
+  *timing = simTiming;
+  SIMUNLOCK;
+}
+
+/* DMA rate (MB/s) of the configured mode (call with the model locked) */
+static double
+simDmaRate()
+{
+  if(simDmaDataType == 5)
+    return simTiming.sst_mbps[simDmaSstMode];
+
+  return simTiming.mbps[simDmaDataType];
+}
+
+/**
+ *  @brief Sustained DMA rate of the mode set with vmeDmaConfig.
+ *  @return Rate in MB/s
+ */
+double
+fa125SimDmaRate()
+{
+  double rval;
+
+  SIMLOCK;
+  rval = simDmaRate();
+  SIMUNLOCK;
+
+  return rval;
+}
+
+/**
+ *  @brief Highest trigger rate the bus can follow, for the accesses
+ *     counted in stats: triggers per unit of bus time.
+ *  @param stats Counters (NULL: the current counters)
+ *  @return Rate in Hz, or 0 if no triggers or no bus time were counted.
+ */
+double
+fa125SimMaxTriggerRate(const FA125_SIM_STATS *stats)
+{
+  FA125_SIM_STATS st;
+
+  if(stats == NULL)
+    {
+      fa125SimGetStats(&st);
+      stats = &st;
+    }
+
+  if((stats->ntrig == 0) || (stats->bus_ns == 0))
+    return 0;
+
+  return 1e9 * stats->ntrig / stats->bus_ns;
+}
+
+/**
+ *  @brief Print the simulated bus time by component, the bus occupancy at
+ *     the trigger interval of the timing model, and the highest trigger
+ *     rate the bus can follow.
+ *  @param stats Counters (NULL: the current counters)
+ */
+void
+fa125SimPrintBusReport(const FA125_SIM_STATS *stats)
+{
+  static const char *dtname[6] = {"D16", "D32", "BLK32", "MBLK", "2eVME", "2eSST"};
+  static const char *sstname[3] = {"160", "267", "320"};
+  FA125_SIM_STATS st;
+  FA125_SIM_TIMING timing;
+  unsigned int dataType, sstMode;
+  double total, elapsed;
+
+  if(stats == NULL)
+    {
+      fa125SimGetStats(&st);
+      stats = &st;
+    }
+
+  SIMLOCK;
+  timing   = simTiming;
+  dataType = simDmaDataType;
+  sstMode  = simDmaSstMode;
+  SIMUNLOCK;
+
+  total = (stats->bus_ns > 0) ? stats->bus_ns : 1;
+
+  printf("\nSimulated VME bus (DMA %s%s, %.0f MB/s)\n",
+	 dtname[dataType], (dataType == 5) ? sstname[sstMode] : "",
+	 (dataType == 5) ? timing.sst_mbps[sstMode] : timing.mbps[dataType]);
+  printf("--------------------------------------------------------\n");
+  printf("  %-14s %12s %7s %12s %8s\n", "Component", "Count", "Share", "Time(us)", "us/trig");
+  printf("--------------------------------------------------------\n");
+#define BUSLINE(_name, _count, _ns)					\
+  printf("  %-14s %12llu %6.1f%% %12.1f %8.2f\n", _name, (unsigned long long)(_count), \
+	 100. * (_ns) / total, 1e-3 * (_ns),				\
+	 stats->ntrig ? 1e-3 * (_ns) / stats->ntrig : 0.)
+  BUSLINE("Single cycle", stats->nread + stats->nwrite + stats->nprobe, stats->cycle_ns);
+  BUSLINE("DMA setup", stats->ndma, stats->dma_setup_ns);
+  BUSLINE("DMA data (B)", stats->dma_bytes, stats->dma_data_ns);
+  BUSLINE("BERR", stats->nberr, stats->berr_ns);
+  BUSLINE("Token pass", stats->ntoken, stats->token_ns);
+  printf("--------------------------------------------------------\n");
+  BUSLINE("Total (trig)", stats->ntrig, stats->bus_ns);
+#undef BUSLINE
+
+  if(stats->ntrig)
+    {
+      elapsed = (double)stats->ntrig * timing.trigger_ns;
+      printf("  Occupancy at %.1f kHz trigger rate: %.1f%%\n",
+	     1e6 / timing.trigger_ns, 100. * stats->bus_ns / elapsed);
+      printf("  Maximum trigger rate:              %.1f kHz\n",
+	     1e-3 * fa125SimMaxTriggerRate(stats));
+    }
+  printf("\n");
+}
+
+static void
+simClearFifo(struct fa125_sim_board *b)
+{
+  b->fifo_head = b->fifo_tail = 0;
+  b->blk_head = b->nblk = b->nev = 0;
+  b->cur_left = b->cur_pad = b->in_block = 0;
+  b->berr = 0;
+  b->ready_wait = 0;
+  b->pend.nevents = 0;
+}
+
+static void
+simHardReset(struct fa125_sim_board *b)
+{
+  memset(b->reg, 0, sizeof(b->reg));
+  b->reg[REG(proc.blocklevel)] = 1;
+  b->reg[REG(proc.ctrl2)] = FA125_PROC_CTRL2_TRIGTIME_ENABLE;
+  b->ntrig = b->evnum = b->blknum = 0;
+  simClearFifo(b);
+}
+
+/**
+ *  @brief Insert a board into the crate model
+ *  @param slot VME slot (2-20)
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125SimAddBoard(int slot)
+{
+  struct fa125_sim_board *b;
+
+  if((slot < 2) || (slot > 20))
+    {
+      printf("\n%s: ERROR: Invalid slot (%d)\n\n", __FUNCTION__, slot);
+      return ERROR;
+    }
+
+  if(fa125SimInit() != OK)
+    return ERROR;
+
+  SIMLOCK;
+  b = &simBoard[slot];
+  if(b->fifo == NULL)
+    {
+      b->fifo_alloc = 0x10000;
+      b->fifo = (UINT32 *)malloc(b->fifo_alloc * sizeof(UINT32));
+    }
+  b->present = 1;
+  b->slot = slot;
+  b->ready_delay = 0;
+  simHardReset(b);
+  memset(b->chain, 0, sizeof(b->chain));
+  memset(b->dac_in, 0, sizeof(b->dac_in));
+  memset(b->dac_out, 0, sizeof(b->dac_out));
+  SIMUNLOCK;
+
+  return OK;
+}
+
+/**
+ *  @brief Insert boards into the crate model for each slot in slotmask
+ *  @param slotmask Mask of VME slots (bit N = slot N)
+ *  @return Number of boards added, otherwise ERROR.
+ */
+int
+fa125SimAddBoards(unsigned int slotmask)
+{
+  int islot, nadd = 0;
+
+  for(islot = 2; islot <= 20; islot++)
+    {
+      if(slotmask & (1 << islot))
+	{
+	  if(fa125SimAddBoard(islot) != OK)
+	    return ERROR;
+	  nadd++;
+	}
+    }
+
+  return nadd;
+}
+
+/**
+ *  @brief Remove a board from the crate model
+ *  @param slot VME slot
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125SimRemoveBoard(int slot)
+{
+  if((slot < 0) || (slot > FA125_SIM_MAX_SLOT))
+    return ERROR;
+
+  SIMLOCK;
+  if(simBoard[slot].fifo)
+    free(simBoard[slot].fifo);
+  memset(&simBoard[slot], 0, sizeof(struct fa125_sim_board));
+  SIMUNLOCK;
+
+  return OK;
+}
+
+/**
+ *  @brief Install the routine used to build the blocks of every board.
+ *  @param builder Block builder, or NULL for fa125SimDefaultBuilder
+ *  @param arg Argument passed to the builder
+ */
+void
+fa125SimSetBuilder(FA125_SIM_BUILDER builder, void *arg)
+{
+  SIMLOCK;
+  simBuilder = builder ? builder : fa125SimDefaultBuilder;
+  simBuilderArg = arg;
+  SIMUNLOCK;
+}
+
+/**
+ *  @brief Default block builder: block header, event header and trigger
+ *     time for each event, block trailer.  No channel data.
+ */
+int
+fa125SimDefaultBuilder(const FA125_SIM_BLOCK *blk, UINT32 *buf, int maxwords,
+		       void *arg)
+{
+  int iev, nw = 0, trigtime;
+
+  trigtime = blk->regs[REG(proc.ctrl2)] & FA125_PROC_CTRL2_TRIGTIME_ENABLE;
+
+  if(maxwords < (2 + blk->nevents * 3))
+    return ERROR;
+
+  buf[nw++] = FA125_DATA_TYPE_DEFINE | FA125_DATA_BLOCK_HEADER | (blk->slot << 22) |
+    (FA125_SIM_MODULE_ID << 18) | ((blk->blknum & 0x7F) << 8) | (blk->nevents & 0xFF);
+
+  for(iev = 0; iev < blk->nevents; iev++)
+    {
+      buf[nw++] = 0x90000000 | (blk->slot << 22) | (blk->evnum[iev] & 0x3FFFFF);
+      if(trigtime)
+	{
+	  buf[nw++] = 0x98000000 | (blk->trigtime[iev] & 0xFFFFFF);
+	  buf[nw++] = (blk->trigtime[iev] >> 24) & 0xFFFFFF;
+	}
+    }
+
+  buf[nw] = FA125_DATA_TYPE_DEFINE | FA125_DATA_BLOCK_TRAILER | (blk->slot << 22) |
+    ((nw + 1) & 0x3FFFFF);
+  nw++;
+
+  return nw;
+}
+
+static int
+simFifoPush(struct fa125_sim_board *b, UINT32 *buf, int nw, int nev)
+{
+  int ib;
+
+  if(b->nblk >= SIM_MAX_BLOCKS)
+    {
+      printf("%s: WARN: slot %d FIFO full, block dropped\n", __FUNCTION__, b->slot);
+      return ERROR;
+    }
+
+  /* Compact, then grow if needed */
+  if(b->fifo_head > 0)
+    {
+      memmove(b->fifo, &b->fifo[b->fifo_head], (b->fifo_tail - b->fifo_head) * sizeof(UINT32));
+      b->fifo_tail -= b->fifo_head;
+      b->fifo_head = 0;
+    }
+  if(b->fifo_tail + nw > b->fifo_alloc)
+    {
+      while(b->fifo_tail + nw > b->fifo_alloc)
+	b->fifo_alloc *= 2;
+      b->fifo = (UINT32 *)realloc(b->fifo, b->fifo_alloc * sizeof(UINT32));
+    }
+
+  memcpy(&b->fifo[b->fifo_tail], buf, nw * sizeof(UINT32));
+  b->fifo_tail += nw;
+
+  ib = (b->blk_head + b->nblk) % SIM_MAX_BLOCKS;
+  b->blk_len[ib] = nw;
+  b->blk_nev[ib] = nev;
+  if(b->nblk == 0)
+    b->ready_wait = b->ready_delay;
+  b->nblk++;
+  b->nev += nev;
+
+  return OK;
+}
+
+static void
+simBuildBlock(struct fa125_sim_board *b)
+{
+  int nw;
+
+  b->pend.slot   = b->slot;
+  b->pend.blknum = ++b->blknum;
+  b->pend.regs   = b->reg;
+
+  nw = (*simBuilder)(&b->pend, simBlockBuf, SIM_MAX_BLOCKWORDS, simBuilderArg);
+  if(nw > 0)
+    simFifoPush(b, simBlockBuf, nw, b->pend.nevents);
+  else
+    printf("%s: ERROR: block builder failed for slot %d\n", __FUNCTION__, b->slot);
+
+  b->pend.nevents = 0;
+}
+
+static void
+simTriggerBoard(struct fa125_sim_board *b)
+{
+  unsigned int blocklevel;
+
+  /* Triggers are only accepted when data collection is on */
+  if((b->reg[FEREG(0, test)] & FA125_FE_TEST_COLLECT_ON) == 0)
+    return;
+
+  b->ntrig++;
+  b->evnum++;
+  b->pend.evnum[b->pend.nevents]    = b->evnum;
+  b->pend.trigtime[b->pend.nevents] = simClock & 0xFFFFFFFFFFFFULL;
+  b->pend.nevents++;
+
+  blocklevel = b->reg[REG(proc.blocklevel)] & FA125_PROC_BLOCKLEVEL_MASK;
+  if(blocklevel == 0)
+    blocklevel = 1;
+  if(blocklevel > FA125_SIM_MAX_EVENTS)
+    blocklevel = FA125_SIM_MAX_EVENTS;
+
+  if(b->pend.nevents >= blocklevel)
+    simBuildBlock(b);
+}
+
+/**
+ *  @brief Distribute triggers to the boards in the crate.  A board accepts
+ *     triggers when it is enabled (fa125Enable).  Once blocklevel triggers
+ *     have been received, a block is built and queued in the board FIFO.
+ *  @param slotmask Boards to trigger (0 = all)
+ *  @param ntrig Number of triggers
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125SimTrigger(unsigned int slotmask, int ntrig)
+{
+  int itrig, islot;
+
+  SIMLOCK;
+  simStats.ntrig += (ntrig > 0) ? ntrig : 0;
+  for(itrig = 0; itrig < ntrig; itrig++)
+    {
+      simClock += simTiming.trigger_ns / 4;
+      for(islot = 2; islot <= 20; islot++)
+	{
+	  if(!simBoard[islot].present)
+	    continue;
+	  if(slotmask && !(slotmask & (1 << islot)))
+	    continue;
+	  simTriggerBoard(&simBoard[islot]);
+	}
+    }
+  SIMUNLOCK;
+
+  return OK;
+}
+
+/**
+ *  @brief Delay the block ready of a board, to model a slow board.
+ *  @param slot VME slot
+ *  @param npolls Number of blockCSR reads for which a new block is not
+ *     reported ready.  A negative value holds all blocks until changed.
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125SimSetReadyDelay(int slot, int npolls)
+{
+  if((slot < 2) || (slot > 20) || !simBoard[slot].present)
+    return ERROR;
+
+  SIMLOCK;
+  simBoard[slot].ready_delay = npolls;
+  simBoard[slot].ready_wait  = npolls;
+  SIMUNLOCK;
+
+  return OK;
+}
+
+/* Return whether the head block of the FIFO may be read out */
+static int
+simBlockReady(struct fa125_sim_board *b)
+{
+  if(b->nblk == 0)
+    return 0;
+
+  return (b->ready_wait == 0);
+}
+
+/**
+ *  @brief Return the number of complete blocks in the FIFO of a board
+ */
+int
+fa125SimBlocksReady(int slot)
+{
+  int rval;
+
+  if((slot < 2) || (slot > 20) || !simBoard[slot].present)
+    return ERROR;
+
+  SIMLOCK;
+  rval = simBoard[slot].nblk;
+  SIMUNLOCK;
+
+  return rval;
+}
+
+/**
+ *  @brief Return the number of words in the FIFO of a board
+ */
+int
+fa125SimFifoWords(int slot)
+{
+  int rval;
+
+  if((slot < 2) || (slot > 20) || !simBoard[slot].present)
+    return ERROR;
+
+  SIMLOCK;
+  rval = simBoard[slot].fifo_tail - simBoard[slot].fifo_head;
+  SIMUNLOCK;
+
+  return rval;
+}
+
+/**
+ *  @brief Return the output register of an LTC2620 DAC channel
+ *  @param slot VME slot
+ *  @param dacChan DAC channel as numbered by fa125Lib (0-79)
+ *  @return DAC value, otherwise ERROR.
+ */
+int
+fa125SimGetDac(int slot, int dacChan)
+{
+  int rval;
+
+  if((slot < 2) || (slot > 20) || !simBoard[slot].present ||
+     (dacChan < 0) || (dacChan > 79))
+    return ERROR;
+
+  SIMLOCK;
+  rval = simBoard[slot].dac_out[dacChan];
+  SIMUNLOCK;
+
+  return rval;
+}
+
+/**
+ *  @brief Record the register writes to a board, in the order they are made.
+ *     Writes beyond maxlog are counted but not kept.
+ *  @param slot VME slot, or 0 to stop recording
+ *  @param log  Where to record the writes
+ *  @param maxlog Size of log
+ *  @return Number of writes made during the previous recording, otherwise ERROR.
+ */
+int
+fa125SimRecordWrites(int slot, FA125_SIM_WRITE *log, int maxlog)
+{
+  int rval;
+
+  if((slot != 0) &&
+     ((slot < 2) || (slot > 20) || !simBoard[slot].present || (log == NULL)))
+    return ERROR;
+
+  SIMLOCK;
+  rval       = simRecN;
+  simRecSlot = slot;
+  simRecLog  = log;
+  simRecMax  = slot ? maxlog : 0;
+  simRecN    = 0;
+  SIMUNLOCK;
+
+  return rval;
+}
+
+void
+fa125SimGetStats(FA125_SIM_STATS *stats)
+{
+  SIMLOCK;
+  *stats = simStats;
+  SIMUNLOCK;
+}
+
+void
+fa125SimResetStats()
+{
+  SIMLOCK;
+  memset(&simStats, 0, sizeof(simStats));
+  SIMUNLOCK;
+}
+
+/* Pop one word of the head block for a FIFO read.  Returns 1 if a word was
+   returned, 0 if the FIFO has no block ready.  *last is set when the word
+   was the block trailer. */
+static int
+simFifoPop(struct fa125_sim_board *b, UINT32 *word, int *last)
+{
+  *last = 0;
+
+  if(b->cur_left == 0)
+    {
+      if(!simBlockReady(b))
+	return 0;
+      b->cur_left = b->blk_len[b->blk_head];
+    }
+
+  *word = b->fifo[b->fifo_head++];
+  b->cur_left--;
+
+  if(b->cur_left == 0)
+    {
+      b->nev -= b->blk_nev[b->blk_head];
+      b->blk_head = (b->blk_head + 1) % SIM_MAX_BLOCKS;
+      b->nblk--;
+      if(b->nblk > 0)
+	b->ready_wait = b->ready_delay;
+      *last = 1;
+    }
+
+  return 1;
+}
+
+/* DMA words out of one board, up to the end of its current block.
+   Returns 1 when the block (with its filler) is complete, 0 when stopped by
+   the word count, -1 when the board has no block ready. */
+static int
+simBoardXfer(struct fa125_sim_board *b, UINT32 *out, int maxw, int *nw)
+{
+  UINT32 word;
+  int last;
+
+  while(*nw < maxw)
+    {
+      if(b->cur_pad)
+	{
+	  out[(*nw)++] = LSWAP(SIM_FILLER(b->slot));
+	  b->cur_pad = 0;
+	  b->in_block = 0;
+	  return 1;
+	}
+
+      if(!b->in_block)
+	{
+	  if(!simBlockReady(b))
+	    return -1;
+	  b->in_block = 1;
+	}
+
+      if(simFifoPop(b, &word, &last) == 0)
+	return -1;
+
+      out[(*nw)++] = LSWAP(word);
+
+      if(last)
+	{
+	  /* Keep the transfer 64bit aligned */
+	  if(b->blk_len[(b->blk_head + SIM_MAX_BLOCKS - 1) % SIM_MAX_BLOCKS] & 1)
+	    b->cur_pad = 1;
+	  else
+	    {
+	      b->in_block = 0;
+	      return 1;
+	    }
+	}
+    }
+
+  if(b->in_block && (b->cur_left == 0) && (b->cur_pad == 0))
+    {
+      b->in_block = 0;
+      return 1;
+    }
+
+  return 0;
+}
+
+static struct fa125_sim_board *
+simA24Board(volatile unsigned int *addr, unsigned int *idx)
+{
+  unsigned long off;
+  struct fa125_sim_board *b;
+
+  if((simA24 == NULL) || ((char *)addr < simA24) ||
+     ((char *)addr >= simA24 + FA125_SIM_A24_SIZE))
+    return NULL;
+
+  off = (unsigned long)((char *)addr - simA24);
+  if((off >> 19) > 20)
+    return NULL;
+
+  b = &simBoard[off >> 19];
+  if(!b->present || ((off & 0x7FFFF) >= sizeof(struct fa125_a24)))
+    return NULL;
+
+  *idx = (off & 0x7FFFF) / 4;
+  return b;
+}
+
+static struct fa125_sim_board *
+simA32Board(unsigned int vmeAdr)
+{
+  int islot;
+  unsigned int base;
+  struct fa125_sim_board *b;
+
+  for(islot = 2; islot <= 20; islot++)
+    {
+      b = &simBoard[islot];
+      if(!b->present || !(b->reg[REG(main.adr32)] & FA125_ADR32_ENABLE))
+	continue;
+
+      base = (b->reg[REG(main.adr32)] & FA125_ADR32_BASE_MASK) << 16;
+      if((vmeAdr >= base) && (vmeAdr < base + FA125_MAX_A32_MEM))
+	return b;
+    }
+
+  return NULL;
+}
+
+/* Return the first board of the multiblock chain that decodes vmeAdr */
+static struct fa125_sim_board *
+simMblkFirst(unsigned int vmeAdr)
+{
+  int islot;
+  unsigned int amin, amax, adr_mb;
+  struct fa125_sim_board *b;
+
+  for(islot = 2; islot <= 20; islot++)
+    {
+      b = &simBoard[islot];
+      adr_mb = b->reg[REG(main.adr_mb)];
+      if(!b->present || !(adr_mb & FA125_ADRMB_ENABLE) ||
+	 !(b->reg[REG(main.ctrl1)] & FA125_CTRL1_ENABLE_MULTIBLOCK))
+	continue;
+
+      amin = (adr_mb & FA125_ADRMB_MIN_MASK) << 16;
+      amax = (adr_mb & FA125_ADRMB_MAX_MASK);
+      if((vmeAdr >= amin) && (vmeAdr < amax) &&
+	 (b->reg[REG(main.ctrl1)] & FA125_CTRL1_FIRST_BOARD))
+	return b;
+    }
+
+  return NULL;
+}
+
+/* Next board in the multiblock chain after slot, or NULL */
+static struct fa125_sim_board *
+simMblkNext(int slot)
+{
+  int islot;
+  struct fa125_sim_board *b;
+
+  for(islot = slot + 1; islot <= 20; islot++)
+    {
+      b = &simBoard[islot];
+      if(b->present && (b->reg[REG(main.ctrl1)] & FA125_CTRL1_ENABLE_MULTIBLOCK))
+	return b;
+    }
+
+  return NULL;
+}
+
+static UINT32
+simRegRead(struct fa125_sim_board *b, unsigned int idx)
+{
+  UINT32 rval = 0;
+  int ife;
+
+  if(idx == REG(main.id))
+    return FA125_ID;
+  if(idx == REG(main.version))
+    return FA125_MAIN_SUPPORTED_FIRMWARE;
+  if(idx == REG(proc.version))
+    return FA125_PROC_SUPPORTED_FIRMWARE;
+  if(idx == REG(main.slot_ga))
+    return b->slot;
+  if((idx == REG(main.temperature[0])) || (idx == REG(main.temperature[1])))
+    return SIM_TEMPERATURE;
+  if((idx >= REG(main.serial[0])) && (idx <= REG(main.serial[3])))
+    return 0x125000 + (b->slot << 4) + (idx - REG(main.serial[0]));
+
+  for(ife = 0; ife < 12; ife++)
+    if(idx == FEREG(ife, version))
+      return FA125_FE_SUPPORTED_FIRMWARE;
+
+  if(idx == REG(main.blockCSR))
+    {
+      if(b->nblk > 0)
+	{
+	  if(b->ready_wait > 0)
+	    b->ready_wait--;
+	  else if(b->ready_wait == 0)
+	    rval |= FA125_BLOCKCSR_BLOCK_READY;
+	}
+      if(b->berr)
+	rval |= FA125_BLOCKCSR_BERR_ASSERTED;
+      if(simToken == b->slot)
+	rval |= FA125_BLOCKCSR_HAS_TOKEN;
+      return rval;
+    }
+
+  if(idx == REG(main.block_count))
+    return b->nblk & FA125_BLOCKCOUNT_MASK;
+  if(idx == REG(proc.ev_count))
+    return b->nev & FA125_PROC_EVCOUNT_MASK;
+  if(idx == REG(proc.trig_count))
+    return b->ntrig;
+  if(idx == REG(proc.csr))
+    return 0;
+
+  return b->reg[idx];
+}
+
+static void
+simDacWrite(struct fa125_sim_board *b, UINT32 val)
+{
+  UINT32 prev = b->dacctl, w;
+  int ic, k, ich, cmd, adr;
+
+  b->dacctl = val;
+
+  if((val & FA125_DACCTL_DACCS_MASK) && (val & FA125_DACCTL_DACSCLK_MASK) &&
+     !(prev & FA125_DACCTL_DACSCLK_MASK))
+    { /* Rising clock edge: shift both chains */
+      for(ic = 0; ic < 2; ic++)
+	{
+	  for(k = 4; k > 0; k--)
+	    b->chain[ic][k] = (b->chain[ic][k] << 1) | (b->chain[ic][k-1] >> 31);
+	  b->chain[ic][0] = (b->chain[ic][0] << 1) |
+	    ((val & (ic ? FA125_DACCTL_BDACSI_MASK : FA125_DACCTL_ADACSI_MASK)) ? 1 : 0);
+	}
+    }
+
+  if(!(val & FA125_DACCTL_DACCS_MASK) && (prev & FA125_DACCTL_DACCS_MASK))
+    { /* Chip select released: each LTC2620 executes the word it holds */
+      for(ic = 0; ic < 2; ic++)
+	for(k = 0; k < 5; k++)
+	  {
+	    w   = b->chain[ic][k];
+	    cmd = (w >> 20) & 0xF;
+	    adr = (w >> 16) & 0xF;
+	    for(ich = 0; ich < 8; ich++)
+	      {
+		int dch = ic*40 + k*8 + ich;
+		int sel = ((adr == 0xF) || (adr == ich));
+		switch(cmd)
+		  {
+		  case 0x0: /* Write input register n */
+		    if(sel) b->dac_in[dch] = w & 0xFFFF;
+		    break;
+		  case 0x1: /* Update n */
+		    if(sel) b->dac_out[dch] = b->dac_in[dch];
+		    break;
+		  case 0x2: /* Write input register n, update all */
+		    if(sel) b->dac_in[dch] = w & 0xFFFF;
+		    break;
+		  case 0x3: /* Write and update n */
+		    if(sel) b->dac_in[dch] = b->dac_out[dch] = w & 0xFFFF;
+		    break;
+		  default:  /* No operation */
+		    break;
+		  }
+	      }
+	    if(cmd == 0x2)
+	      for(ich = 0; ich < 8; ich++)
+		b->dac_out[ic*40 + k*8 + ich] = b->dac_in[ic*40 + k*8 + ich];
+	  }
+    }
+}
+
+static void
+simRegWrite(struct fa125_sim_board *b, unsigned int idx, UINT32 val)
+{
+  int islot, p2, pbit;
+
+  if(idx == REG(main.blockCSR))
+    {
+      if(val & FA125_BLOCKCSR_PULSE_HARD_RESET)
+	{
+	  simHardReset(b);
+	  if(simToken == b->slot)
+	    simToken = 0;
+	}
+      if(val & FA125_BLOCKCSR_PULSE_SOFT_RESET)
+	{
+	  simClearFifo(b);
+	  if(simToken == b->slot)
+	    simToken = 0;
+	}
+      if(val & FA125_BLOCKCSR_TAKE_TOKEN)
+	{
+	  if(!(b->reg[REG(main.ctrl1)] & FA125_CTRL1_ENABLE_MULTIBLOCK) ||
+	     (b->reg[REG(main.ctrl1)] & FA125_CTRL1_FIRST_BOARD))
+	    {
+	      simToken = b->slot;
+	      for(islot = 2; islot <= 20; islot++)
+		simBoard[islot].berr = 0;
+	    }
+	}
+      if(val & FA125_BLOCKCSR_PULSE_TRIGGER)
+	simTriggerBoard(b);
+      if(val & FA125_BLOCKCSR_PULSE_SYNC_RESET)
+	b->evnum = b->blknum = 0;
+      return;
+    }
+
+  if(idx == REG(main.dacctl))
+    {
+      simDacWrite(b, val);
+      return;
+    }
+
+  if(idx == REG(proc.softtrig))
+    {
+      if(val & 1)
+	simTriggerBoard(b);
+      return;
+    }
+
+  if(idx == REG(proc.csr))
+    {
+      if(val & (FA125_PROC_CSR_CLEAR | FA125_PROC_CSR_RESET))
+	simClearFifo(b);
+      return;
+    }
+
+  if(idx == REG(proc.trig_count))
+    {
+      if(val & FA125_PROC_TRIGCOUNT_RESET)
+	b->ntrig = 0;
+      return;
+    }
+
+  if((idx == REG(proc.clock125_count)) || (idx == REG(proc.sync_count)) ||
+     (idx == REG(proc.trig2_count)) || (idx == REG(proc.ev_count)) ||
+     (idx == REG(main.block_count)))
+    return;
+
+  if((idx % (sizeof(struct fa125_a24_fe)/4)) == (FEREG(0, ped_sf) % (sizeof(struct fa125_a24_fe)/4)) &&
+     (idx >= FEREG(0, ped_sf)) && (idx <= FEREG(11, ped_sf)))
+    { /* Firmware computes P2 + PBIT */
+      p2   = (val & FA125_FE_PED_SF_NP2_MASK) >> 8;
+      pbit = (val & FA125_FE_PED_SF_PBIT_MASK) >> 22;
+      if(val & FA125_FE_PED_SF_PBIT_SIGN)
+	pbit = -pbit;
+      val = (val & ~FA125_FE_PED_SF_CALC_MASK) | (((p2 + pbit) & 0x7) << 26);
+    }
+
+  b->reg[idx] = val;
+}
+
+/*************************************************************************
+ * jvme stand-in
+ *************************************************************************/
+
+int
+vmeOpenDefaultWindows()
+{
+  return fa125SimInit();
+}
+
+int
+vmeCloseDefaultWindows()
+{
+  return OK;
+}
+
+int
+vmeBusToLocalAdrs(int vmeAdrsSpace, char *vmeBusAdrs, char **pPciAdrs)
+{
+  unsigned long addr = (unsigned long)vmeBusAdrs;
+
+  if(fa125SimInit() != OK)
+    return ERROR;
+
+  switch(vmeAdrsSpace)
+    {
+    case 0x39: case 0x3A: case 0x3D: case 0x3E: /* A24 */
+      if(addr >= FA125_SIM_A24_SIZE)
+	return ERROR;
+      *pPciAdrs = simA24 + addr;
+      return OK;
+
+    case 0x09: case 0x0A: case 0x0D: case 0x0E: /* A32 */
+      if((addr < FA125_SIM_A32_VME_BASE) ||
+	 (addr >= FA125_SIM_A32_VME_BASE + FA125_SIM_A32_SIZE))
+	return ERROR;
+      *pPciAdrs = simA32 + (addr - FA125_SIM_A32_VME_BASE);
+      return OK;
+
+    default:
+      return ERROR;
+    }
+}
+
+int
+vmeMemProbe(char *addr, int size, char *rval)
+{
+  struct fa125_sim_board *b;
+  unsigned int idx;
+  UINT32 val;
+
+  SIMLOCK;
+  simStats.nprobe++;
+  b = simA24Board((volatile unsigned int *)addr, &idx);
+  if(b == NULL)
+    {
+      /* Nobody answers: the probe ends with a bus timeout */
+      SIMCHARGE(berr_ns, simTiming.berr_ns);
+      SIMUNLOCK;
+      return ERROR;
+    }
+  SIMCHARGE(cycle_ns, simTiming.read_ns);
+  val = simRegRead(b, idx);
+  SIMUNLOCK;
+
+  memcpy(rval, &val, (size > 4) ? 4 : size);
+
+  return OK;
+}
+
+int
+vmeClearException(int pflag)
+{
+  return OK;
+}
+
+unsigned int
+vmeRead32(volatile unsigned int *addr)
+{
+  struct fa125_sim_board *b;
+  unsigned int idx, vmeAdr;
+  UINT32 rval = 0xffffffff;
+  int last;
+
+  SIMLOCK;
+  simStats.nread++;
+  SIMCHARGE(cycle_ns, simTiming.read_ns);
+  b = simA24Board(addr, &idx);
+  if(b)
+    rval = simRegRead(b, idx);
+  else if(simA32 && ((char *)addr >= simA32) && ((char *)addr < simA32 + FA125_SIM_A32_SIZE))
+    {
+      vmeAdr = (unsigned int)((char *)addr - simA32) + FA125_SIM_A32_VME_BASE;
+      b = simA32Board(vmeAdr);
+      if(b)
+	{
+	  if(simFifoPop(b, &rval, &last) == 0)
+	    {
+	      if(b->reg[REG(main.ctrl1)] & FA125_CTRL1_ENABLE_BERR)
+		rval = 0xffffffff;
+	      else
+		rval = SIM_FILLER(b->slot);
+	    }
+	}
+    }
+  SIMUNLOCK;
+  simCycle(simTiming.read_ns);
+
+  return rval;
+}
+
+void
+vmeWrite32(volatile unsigned int *addr, unsigned int val)
+{
+  struct fa125_sim_board *b;
+  unsigned int idx;
+
+  SIMLOCK;
+  simStats.nwrite++;
+  SIMCHARGE(cycle_ns, simTiming.write_ns);
+  b = simA24Board(addr, &idx);
+  if(b)
+    {
+      if(b->slot == simRecSlot)
+	{
+	  if(simRecN < simRecMax)
+	    {
+	      simRecLog[simRecN].offset = idx << 2;
+	      simRecLog[simRecN].val    = val;
+	    }
+	  simRecN++;
+	}
+      simRegWrite(b, idx, val);
+    }
+  SIMUNLOCK;
+  simCycle(simTiming.write_ns);
+}
+
+int
+vmeDmaConfig(unsigned int addrType, unsigned int dataType, unsigned int sstMode)
+{
+  if((addrType > 2) || (dataType > 5) || (sstMode > 2))
+    {
+      printf("%s: ERROR: Invalid DMA configuration (%d, %d, %d)\n",
+	     __FUNCTION__, addrType, dataType, sstMode);
+      return ERROR;
+    }
+
+  SIMLOCK;
+  simDmaAddrType = addrType;
+  simDmaDataType = dataType;
+  simDmaSstMode  = sstMode;
+  SIMUNLOCK;
+
+  return OK;
+}
+
+int
+vmeDmaSend(unsigned long locAdrs, unsigned int vmeAdrs, int size)
+{
+  struct fa125_sim_board *b;
+  UINT32 *out = (UINT32 *)locAdrs;
+  int maxw = size >> 2, nw = 0, rval, islot, berr = 0, ntoken = 0;
+  long long ns, data_ns, token_ns, berr_ns;
+
+  SIMLOCK;
+  if(simDmaPending)
+    {
+      SIMUNLOCK;
+      printf("%s: ERROR: DMA already in progress\n", __FUNCTION__);
+      return ERROR;
+    }
+
+  simStats.ndma++;
+  for(islot = 2; islot <= 20; islot++)
+    simBoard[islot].berr = 0;
+
+  if((b = simMblkFirst(vmeAdrs)) != NULL)
+    { /* Multiblock: follow the token down the chain */
+      if(simToken == 0)
+	simToken = b->slot;
+
+      while(nw < maxw)
+	{
+	  if(simToken < 0)
+	    { /* Nobody drives the bus: VME bus timeout */
+	      berr = 1;
+	      break;
+	    }
+
+	  b = &simBoard[simToken];
+	  rval = simBoardXfer(b, out, maxw, &nw);
+	  if(rval == 1)
+	    {
+	      if(b->reg[REG(main.ctrl1)] & FA125_CTRL1_LAST_BOARD)
+		{
+		  /* Ended on the word count: the last board keeps the token,
+		     and ends the next transfer with BERR */
+		  if(nw == maxw)
+		    break;
+		  simToken = -1;
+		  if(b->reg[REG(main.ctrl1)] & FA125_CTRL1_ENABLE_BERR)
+		    {
+		      b->berr = 1;
+		      berr = 1;
+		    }
+		  break;
+		}
+	      else
+		{
+		  b = simMblkNext(b->slot);
+		  simToken = b ? b->slot : -1;
+		  ntoken++;
+		}
+	    }
+	  else if(rval == -1)
+	    { /* Token holder has no block: ends the transfer */
+	      if(b->reg[REG(main.ctrl1)] & FA125_CTRL1_ENABLE_BERR)
+		b->berr = 1;
+	      berr = 1;
+	      break;
+	    }
+	}
+    }
+  else if((b = simA32Board(vmeAdrs)) != NULL)
+    {
+      rval = simBoardXfer(b, out, maxw, &nw);
+      if((rval != 0) && (nw < maxw))
+	{
+	  if(b->reg[REG(main.ctrl1)] & FA125_CTRL1_ENABLE_BERR)
+	    {
+	      b->berr = 1;
+	      berr = 1;
+	    }
+	  else
+	    {
+	      while(nw < maxw)
+		out[nw++] = LSWAP(SIM_FILLER(b->slot));
+	    }
+	}
+    }
+  else
+    berr = 1;  /* Address not decoded: VME bus timeout */
+
+  simStats.dma_bytes += nw << 2;
+  if(berr)
+    simStats.nberr++;
+  simStats.ntoken += ntoken;
+
+  /* Bus time of the transfer.  Bytes at MB/s take 1000 * bytes / rate ns */
+  data_ns  = 1000. * (nw << 2) / simDmaRate();
+  token_ns = (long long)ntoken * simTiming.token_ns;
+  berr_ns  = berr ? simTiming.berr_ns : 0;
+  SIMCHARGE(dma_setup_ns, simTiming.dma_setup_ns);
+  SIMCHARGE(dma_data_ns, data_ns);
+  SIMCHARGE(token_ns, token_ns);
+  SIMCHARGE(berr_ns, berr_ns);
+  ns = simTiming.dma_setup_ns + data_ns + token_ns + berr_ns;
+
+  /* jvme returns the bytes transferred, whether terminated by BERR or by
+     the word count */
+  simDmaResult = nw << 2;
+  simDmaPending = 1;
+  SIMUNLOCK;
+
+  /* The transfer is done by the time vmeDmaDone is called */
+  if(simTiming.realtime)
+    simSpin(ns);
+
+  return OK;
+}
+
+int
+vmeDmaDone()
+{
+  int rval;
+
+  SIMLOCK;
+  if(!simDmaPending)
+    {
+      SIMUNLOCK;
+      return ERROR;
+    }
+  simDmaPending = 0;
+  rval = simDmaResult;
+  SIMUNLOCK;
+
+  return rval;
+}
+
+int
+logMsg(const char *format, ...)
+{
+  va_list args;
+  int rval;
+
+  va_start(args, format);
+  rval = vprintf(format, args);
+  va_end(args);
+
+  return rval;
+}
+
+int
+taskDelay(int ticks)
+{
+  return usleep(ticks * (1000000 / 60));
+}
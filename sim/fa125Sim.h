@@ -0,0 +1,134 @@
+/*----------------------------------------------------------------------------*
+ *  Copyright (c) 2010        Southeastern Universities Research Association, *
+ *                            Thomas Jefferson National Accelerator Facility  *
+ *                                                                            *
+ *    This software was developed under a United States Government license    *
+ *    described in the NOTICE file included as part of this distribution.     *
+ *                                                                            *
+ *    Authors: Bryan Moffit                                                   *
+ *             moffit@jlab.org                   Jefferson Lab, MS-12B3       *
+ *             Phone: (757) 269-5660             12000 Jefferson Ave.         *
+ *             Fax:   (757) 269-5800             Newport News, VA 23606       *
+ *                                                                            *
+ * __DATE__:
+ *                                                                            *
+ *----------------------------------------------------------------------------*
+ *
+ * Description:
+ *     Software model of a VXS crate of fADC125s, sitting behind the jvme
+ *     calls used by fa125Lib (vmeRead32, vmeWrite32, vmeMemProbe,
+ *     vmeDmaSend/vmeDmaDone).  Models the fa125_a24 register map, the A32
+ *     FIFO of each board, and the multiblock window with token passing
+ *     and BERR termination.  Each access is charged to a simulated bus
+ *     clock by a configurable timing model (FA125_SIM_TIMING), from which
+ *     the bus occupancy and the trigger rate a crate can sustain follow.
+ *
+ *----------------------------------------------------------------------------*/
+
+#ifndef __FA125SIM__
+#define __FA125SIM__
+
+#include "jvme.h"
+
+/* Local (CPU) windows reserved for the A24 and A32 address spaces */
+#define FA125_SIM_A24_SIZE        0x01000000
+#define FA125_SIM_A32_VME_BASE    0x08000000
+#define FA125_SIM_A32_SIZE        0x10000000
+
+#define FA125_SIM_MAX_SLOT        21
+#define FA125_SIM_MAX_EVENTS      255   /* max events per block (header n_evts) */
+#define FA125_SIM_MODULE_ID       2     /* module type in the block header */
+
+/* Description of a block handed to the block builder */
+typedef struct
+{
+  int          slot;
+  unsigned int blknum;                        /* block number (7 bits used) */
+  int          nevents;                       /* events in this block */
+  unsigned int evnum[FA125_SIM_MAX_EVENTS];   /* event number of each event */
+  unsigned long long
+               trigtime[FA125_SIM_MAX_EVENTS];/* 48bit trigger time of each event */
+  const volatile UINT32 *regs;                /* register image of the board
+                                                 (struct fa125_a24 layout) */
+} FA125_SIM_BLOCK;
+
+/*
+ * Block builder: fill buf (host byte order) with the words of one block,
+ * from block header to block trailer (no filler words).  Return the number
+ * of words, or ERROR.
+ */
+typedef int (*FA125_SIM_BUILDER)(const FA125_SIM_BLOCK *blk, UINT32 *buf,
+				 int maxwords, void *arg);
+
+/* Bus transaction counters */
+typedef struct
+{
+  unsigned long long nread;        /* single cycle reads (incl. FIFO reads) */
+  unsigned long long nwrite;       /* single cycle writes */
+  unsigned long long nprobe;       /* vmeMemProbe calls */
+  unsigned long long ndma;         /* DMA transfers started */
+  unsigned long long dma_bytes;    /* bytes moved by DMA */
+  unsigned long long nberr;        /* DMA transfers terminated by BERR */
+  unsigned long long ntoken;       /* token passes during multiblock DMA */
+  unsigned long long ntrig;        /* triggers distributed (fa125SimTrigger) */
+  /* Simulated bus time (ns), charged by the timing model */
+  unsigned long long cycle_ns;     /* single cycle reads, writes and probes */
+  unsigned long long dma_setup_ns; /* DMA setup */
+  unsigned long long dma_data_ns;  /* DMA data phase */
+  unsigned long long berr_ns;      /* BERR terminations */
+  unsigned long long token_ns;     /* token passes */
+  unsigned long long bus_ns;       /* sum of the above */
+} FA125_SIM_STATS;
+
+/* Register write, as recorded by fa125SimRecordWrites */
+typedef struct
+{
+  unsigned int offset;             /* byte offset in struct fa125_a24 */
+  UINT32       val;                /* value written */
+} FA125_SIM_WRITE;
+
+/* Bus timing model.  The defaults are those of a Tempe (TSI148) based
+   controller with fADC125s in a VXS crate. */
+typedef struct
+{
+  unsigned int read_ns;            /* A24 D32 single cycle read */
+  unsigned int write_ns;           /* A24 D32 single cycle write */
+  unsigned int dma_setup_ns;       /* DMA programming, start and completion */
+  unsigned int berr_ns;            /* BERR (or bus timeout) turnaround */
+  unsigned int token_ns;           /* token pass to the next board */
+  double       mbps[5];            /* sustained DMA rate (MB/s) for the
+				      vmeDmaConfig dataType: D16, D32, BLK32,
+				      MBLK, 2eVME */
+  double       sst_mbps[3];        /* 2eSST rate (MB/s) for the sstMode:
+				      SST160, SST267, SST320 */
+  unsigned int trigger_ns;         /* time between triggers, for the
+				      occupancy in fa125SimPrintBusReport */
+  int          realtime;           /* 1: the caller also spins for the time
+				      charged to each access */
+} FA125_SIM_TIMING;
+
+int  fa125SimInit();
+void fa125SimCleanup();
+int  fa125SimAddBoard(int slot);
+int  fa125SimAddBoards(unsigned int slotmask);
+int  fa125SimRemoveBoard(int slot);
+void fa125SimSetBuilder(FA125_SIM_BUILDER builder, void *arg);
+int  fa125SimDefaultBuilder(const FA125_SIM_BLOCK *blk, UINT32 *buf,
+			    int maxwords, void *arg);
+int  fa125SimTrigger(unsigned int slotmask, int ntrig);
+int  fa125SimSetReadyDelay(int slot, int npolls);
+int  fa125SimBlocksReady(int slot);
+int  fa125SimFifoWords(int slot);
+int  fa125SimGetDac(int slot, int dacChan);
+int  fa125SimRecordWrites(int slot, FA125_SIM_WRITE *log, int maxlog);
+void fa125SimGetStats(FA125_SIM_STATS *stats);
+void fa125SimResetStats();
+void fa125SimSetCycleTime(int ns);
+void fa125SimTimingDefaults(FA125_SIM_TIMING *timing);
+int  fa125SimSetTiming(const FA125_SIM_TIMING *timing);
+void fa125SimGetTiming(FA125_SIM_TIMING *timing);
+double fa125SimDmaRate();
+double fa125SimMaxTriggerRate(const FA125_SIM_STATS *stats);
+void fa125SimPrintBusReport(const FA125_SIM_STATS *stats);
+
+#endif /* __FA125SIM__ */
@@ -0,0 +1,212 @@
+/*
+ * File:
+ *    fa125SimBudget.c
+ *
+ * Description:
+ *    Check the VME transactions of library routines against a budget, so
+ *    that a change that makes configuration or readout slower on the bus
+ *    does not go unnoticed.  Each routine is called once on the crate
+ *    model, and its counts (fa125GetVmeCountsApi) compared to the
+ *    transactions the model saw and to the budget below.  When a change
+ *    saves transactions, lower the budget to the new count.
+ *
+ *    Usage:
+ *      fa125SimBudget [-p]
+ *        -p   print the counts of every routine
+ *
+ *    Returns 0 if all routines are within their budget.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "jvme.h"
+#include "fa125Lib.h"
+#include "fa125Sim.h"
+
+#define SIM_SLOTMASK  ((1<<3) | (1<<4) | (1<<5) | (1<<6))
+#define SLOT          4
+#define BUFSIZE       0x10000
+
+extern int nfa125;
+
+typedef struct
+{
+  const char *api;
+  unsigned long long reads, writes, probes, dmas;  /* budget */
+} BUDGET;
+
+static BUDGET budget[] =
+  {
+    /* routine                      reads writes probes   DMAs */
+    {"fa125Status",                   255,     0,     0,     0},
+    {"fa125SetOffset",                  0,   321,     0,     0},
+    {"fa125SetOffsets",                 0,  2568,     0,     0},
+    {"fa125SetThreshold",               0,     1,     0,     0},
+    {"fa125SetProcMode",                0,     6,     0,     0},
+    {"fa125SetBlocklevel",              0,     1,     0,     0},
+    {"fa125Reset",                      0,     4,     0,     0},
+    {"fa125Disable",                    0,    12,     0,     0},
+    {"fa125Enable",                     0,    12,     0,     0},
+    {"fa125Bready",                     1,     0,     0,     0},
+    {"fa125GBready",                    4,     0,     0,     0},
+    {"fa125ReadBlock",                  1,     0,     0,     1},
+    {"fa125ResetToken",                 0,     2,     0,     0},
+    {"fa125ReadCrate",                  6,     2,     0,     1},
+    {NULL}
+  };
+
+static volatile UINT32 *buf;
+static unsigned int offsets[72];
+
+/* Make one call of the routine */
+static int
+call(const char *api)
+{
+  unsigned int missing;
+
+  if(strcmp(api, "fa125Status") == 0)
+    return fa125Status(SLOT, 0);
+  if(strcmp(api, "fa125SetOffset") == 0)
+    return fa125SetOffset(SLOT, 7, 0x1234);
+  if(strcmp(api, "fa125SetOffsets") == 0)
+    return fa125SetOffsets(SLOT, offsets);
+  if(strcmp(api, "fa125SetThreshold") == 0)
+    return fa125SetThreshold(SLOT, 7, 123);
+  if(strcmp(api, "fa125SetProcMode") == 0)
+    return fa125SetProcMode(SLOT, "CDC_long", 500, 60, 200, 4, 1, 4, 4);
+  if(strcmp(api, "fa125SetBlocklevel") == 0)
+    return fa125SetBlocklevel(SLOT, 3);
+  if(strcmp(api, "fa125Reset") == 0)
+    return fa125Reset(SLOT, 0);
+  if(strcmp(api, "fa125Enable") == 0)
+    return fa125Enable(SLOT);
+  if(strcmp(api, "fa125Disable") == 0)
+    return fa125Disable(SLOT);
+  if(strcmp(api, "fa125Bready") == 0)
+    return fa125Bready(SLOT);
+  if(strcmp(api, "fa125GBready") == 0)
+    return fa125GBready();
+  if(strcmp(api, "fa125ReadBlock") == 0)
+    {
+      fa125SimTrigger(1<<SLOT, 2);
+      return fa125ReadBlock(SLOT, buf, BUFSIZE, 1);
+    }
+  if(strcmp(api, "fa125ResetToken") == 0)
+    return fa125ResetToken(SLOT);
+  if(strcmp(api, "fa125ReadCrate") == 0)
+    {
+      fa125SimTrigger(0, 2);
+      return fa125ReadCrate(buf, BUFSIZE, &missing);
+    }
+
+  return ERROR;
+}
+
+/* Undo the call, if it changed the readout */
+static void
+restore(const char *api)
+{
+  if(strcmp(api, "fa125SetBlocklevel") == 0)
+    fa125SetBlocklevel(SLOT, 2);
+}
+
+int
+main(int argc, char *argv[])
+{
+  FA125_VME_COUNTS c, slot, thread;
+  FA125_SIM_STATS stats;
+  BUDGET *b;
+  int opt, pflag = 0, nerror = 0, ifa, ichan;
+
+  while((opt = getopt(argc, argv, "p")) != -1)
+    {
+      switch(opt)
+	{
+	case 'p': pflag = 1; break;
+	default:
+	  printf("Usage: %s [-p]\n", argv[0]);
+	  return 1;
+	}
+    }
+
+  if(fa125SimAddBoards(SIM_SLOTMASK) < 0)
+    return 1;
+
+  vmeOpenDefaultWindows();
+  vmeDmaConfig(2, 5, 1);
+
+  if(fa125Init(0, 0, 0, (1<<4)) != OK)
+    return 1;
+
+  for(ifa = 0; ifa < nfa125; ifa++)
+    {
+      fa125SetBlocklevel(fa125Slot(ifa), 2);
+      fa125Reset(fa125Slot(ifa), 0);
+      fa125Enable(fa125Slot(ifa));
+    }
+  fa125ResetToken(0);
+
+  buf = (volatile UINT32 *)malloc(BUFSIZE * sizeof(UINT32));
+  for(ichan = 0; ichan < 72; ichan++)
+    offsets[ichan] = 0x1000 + ichan;
+
+  printf("%-24s %8s %8s %8s %8s\n", "Routine", "Reads", "Writes", "Probes", "DMAs");
+  for(b = budget; b->api; b++)
+    {
+      fa125ResetVmeCounts();
+      fa125SimResetStats();
+      call(b->api);
+      fa125GetVmeCountsApi(b->api, &c);
+      fa125GetVmeCountsThread(&thread);
+      fa125SimGetStats(&stats);
+      restore(b->api);
+
+      printf("%-24s %8llu %8llu %8llu %8llu\n", b->api, c.reads, c.writes, c.probes, c.dmas);
+
+      /* Every transaction the crate saw is counted for the routine */
+      if((c.calls != 1) || (c.reads != stats.nread) || (c.writes != stats.nwrite) ||
+	 (c.probes != stats.nprobe) || (c.dmas != stats.ndma) ||
+	 (thread.reads != c.reads) || (thread.writes != c.writes))
+	{
+	  printf("FAIL: %s: counted %llu calls, %llu/%llu/%llu/%llu, crate saw %llu/%llu/%llu/%llu\n",
+		 b->api, c.calls, c.reads, c.writes, c.probes, c.dmas,
+		 stats.nread, stats.nwrite, stats.nprobe, stats.ndma);
+	  nerror++;
+	}
+
+      if(!pflag &&
+	 ((c.reads > b->reads) || (c.writes > b->writes) ||
+	  (c.probes > b->probes) || (c.dmas > b->dmas)))
+	{
+	  printf("FAIL: %s over budget: %llu/%llu/%llu/%llu > %llu/%llu/%llu/%llu\n",
+		 b->api, c.reads, c.writes, c.probes, c.dmas,
+		 b->reads, b->writes, b->probes, b->dmas);
+	  nerror++;
+	}
+    }
+
+  /* Transactions addressed to the module */
+  fa125ResetVmeCounts();
+  fa125SetOffsets(SLOT, offsets);
+  fa125GetVmeCountsApi("fa125SetOffsets", &c);
+  fa125GetVmeCountsSlot(SLOT, &slot);
+  if((slot.writes != c.writes) || (slot.reads != c.reads))
+    {
+      printf("FAIL: slot %d: %llu reads, %llu writes counted for the module\n",
+	     SLOT, slot.reads, slot.writes);
+      nerror++;
+    }
+
+  if(pflag)
+    fa125PrintVmeCounts();
+
+  free((void *)buf);
+  fa125SimCleanup();
+
+  printf("\n%s: %d error(s)\n", nerror ? "FAILED" : "PASSED", nerror);
+
+  return (nerror != 0);
+}
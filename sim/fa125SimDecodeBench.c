@@ -0,0 +1,308 @@
+/*
+ * File:
+ *    fa125SimDecodeBench.c
+ *
+ * Description:
+ *    Decoder throughput benchmark.  For each processing mode, a synthetic
+ *    corpus is generated in memory at low, nominal and saturated occupancy
+ *    (in VME byte order, as a DMA buffer, unless -H is given), and timed
+ *    with:
+ *
+ *      decode    fa125DecodeBuffer: every word type decoded into records,
+ *                as fa125DecodeData does without printing
+ *      unpack    fa125UnpackSamples of every raw window, with each kernel
+ *                (long sample modes only)
+ *      validate  fa125IndexBlocks: block headers matched to their trailers,
+ *                without decoding
+ *
+ *    One CSV line per measurement is written to stdout, with the CPU model
+ *    so that results of different machines and commits can be compared.
+ *
+ *    Usage:
+ *      fa125SimDecodeBench [options] > results.csv
+ *        -m <list>        processing modes (3-8)              [all supported]
+ *        -l <occupancy>   low occupancy                       [0.02]
+ *        -n <occupancy>   nominal occupancy                   [0.10]
+ *        -s <occupancy>   saturated occupancy                 [1.0]
+ *        -b <blocklevel>  events per block                    [10]
+ *        -S <MB>          corpus size in MB                   [4]
+ *        -t <seconds>     minimum time of each measurement    [0.2]
+ *        -H               corpus in host byte order
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "jvme.h"
+#include "fa125Lib.h"
+#include "fa125SimGen.h"
+
+#define MINPASS  3
+
+static const char *kernelName[4] = {"auto", "scalar", "SSSE3", "AVX2"};
+
+/* Corpus of one mode and occupancy */
+struct corpus
+{
+  UINT32             *buf;
+  int                 nwords;
+  int                 swap;
+  unsigned long long  nevents;
+  unsigned long long  nhits;
+  int                 nblocks;
+  /* Raw windows, from a decode pass */
+  const volatile UINT32 **samples;
+  int                *nsamples;
+  int                 nraw, maxraw;
+};
+
+static double
+now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/* CPU model, without commas */
+static void
+cpuModel(char *model, int len)
+{
+  FILE *f;
+  char line[256], *c;
+
+  snprintf(model, len, "unknown");
+  f = fopen("/proc/cpuinfo", "r");
+  if(f == NULL)
+    return;
+
+  while(fgets(line, sizeof(line), f))
+    {
+      if((strncmp(line, "model name", 10) != 0) || ((c = strchr(line, ':')) == NULL))
+	continue;
+      for(c++; *c == ' '; c++)
+	;
+      snprintf(model, len, "%s", c);
+      break;
+    }
+  fclose(f);
+
+  for(c = model; *c; c++)
+    if((*c == ',') || (*c == '\n'))
+      *c = (*c == ',') ? ' ' : '\0';
+}
+
+/* Records are consumed here, so that decoding is not optimized away */
+static int
+sumRecord(const FA125_DECODE_RECORD *rec, void *arg)
+{
+  *(unsigned long long *)arg += rec->type + rec->npeak + rec->nsamples;
+  return OK;
+}
+
+static int
+keepRaw(const FA125_DECODE_RECORD *rec, void *arg)
+{
+  struct corpus *c = (struct corpus *)arg;
+
+  if((rec->type == FA125_DECODE_WINDOW_RAW) && (rec->error == 0) && (c->nraw < c->maxraw))
+    {
+      c->samples[c->nraw]  = rec->samples;
+      c->nsamples[c->nraw] = rec->nsamples;
+      c->nraw++;
+    }
+  if(rec->type == FA125_DECODE_BLOCK_HEADER)
+    c->nblocks++;
+
+  return OK;
+}
+
+static int
+makeCorpus(struct corpus *c, const FA125_SIM_GEN_CONFIG *cfg, double mb, int hostorder)
+{
+  FA125_SIM_GEN gen;
+  FA125_DECODER dec;
+  int maxwords = (int)(mb * 262144), nw, iw;
+
+  if(fa125SimGenInit(&gen, cfg) != OK)
+    return ERROR;
+
+  c->nwords = 0;
+  while(c->nwords < maxwords)
+    {
+      /* Events and hits of the readouts that fit */
+      c->nevents = gen.nevents;
+      c->nhits   = gen.nhits;
+      nw = fa125SimGenCrate(&gen, &c->buf[c->nwords], maxwords - c->nwords);
+      if(nw < 0)
+	break;
+      c->nwords += nw;
+      c->nevents = gen.nevents;
+      c->nhits   = gen.nhits;
+    }
+  if(c->nwords == 0)
+    return ERROR;
+
+  c->swap = !hostorder;
+  if(c->swap)
+    for(iw = 0; iw < c->nwords; iw++)
+      c->buf[iw] = LSWAP(c->buf[iw]);
+
+  c->nraw = c->nblocks = 0;
+  fa125DecodeInit(&dec);
+  fa125DecodeBuffer(&dec, c->buf, c->nwords, c->swap, keepRaw, c);
+  fa125DecodeFlush(&dec, keepRaw, c);
+
+  return OK;
+}
+
+static void
+result(const char *cpu, const char *bench, int kernel, const FA125_SIM_GEN_CONFIG *cfg,
+       const char *level, const struct corpus *c, int npass, double dt)
+{
+  double pass = dt / npass;
+
+  printf("%s,%s,%s,%s,%s,%.3f,%d,%d,%llu,%llu,%d,%.0f,%.0f,%.3f\n",
+	 cpu, bench, kernelName[kernel], fa125_modes[cfg->mode], level, cfg->occupancy,
+	 cfg->blocklevel, c->nwords, c->nevents, c->nhits, npass,
+	 c->nwords / pass, c->nevents / pass, c->nhits ? 1e9 * pass / c->nhits : 0.);
+  fflush(stdout);
+}
+
+int
+main(int argc, char *argv[])
+{
+  static const char *levelName[3] = {"low", "nominal", "saturated"};
+  int supported[FA125_SUPPORTED_NMODES] = FA125_SUPPORTED_MODES;
+  FA125_SIM_GEN_CONFIG cfg;
+  FA125_DECODER dec;
+  FA125_BLOCK_INDEX *index;
+  struct corpus c;
+  double occupancy[3] = {0.02, 0.10, 1.0}, mb = 4., mintime = 0.2, t0, dt;
+  int modes[FA125_SUPPORTED_NMODES], nmodes = 0, opt, hostorder = 0;
+  int imode, ilevel, kernel, best, npass, iraw, rval = OK;
+  unsigned long long sum = 0;
+  static short adc[FA125_MAX_NW+16];
+  static UINT32 valid[(FA125_MAX_NW+31)/32];
+  char cpu[128], *tok, *save = NULL;
+
+  fa125SimGenDefaults(&cfg);
+  cfg.blocklevel = 10;
+
+  while((opt = getopt(argc, argv, "m:l:n:s:b:S:t:H")) != -1)
+    {
+      switch(opt)
+	{
+	case 'm':
+	  for(tok = strtok_r(optarg, ",", &save); tok && (nmodes < FA125_SUPPORTED_NMODES);
+	      tok = strtok_r(NULL, ",", &save))
+	    modes[nmodes++] = strtol(tok, NULL, 0);
+	  break;
+	case 'l': occupancy[0]   = strtod(optarg, NULL); break;
+	case 'n': occupancy[1]   = strtod(optarg, NULL); break;
+	case 's': occupancy[2]   = strtod(optarg, NULL); break;
+	case 'b': cfg.blocklevel = strtol(optarg, NULL, 0); break;
+	case 'S': mb             = strtod(optarg, NULL); break;
+	case 't': mintime        = strtod(optarg, NULL); break;
+	case 'H': hostorder      = 1; break;
+	default:
+	  printf("Usage: %s [-m modes] [-l low] [-n nominal] [-s saturated] [-b blocklevel]\n"
+		 "          [-S MB] [-t seconds] [-H]\n", argv[0]);
+	  return 1;
+	}
+    }
+
+  if(nmodes == 0)
+    {
+      memcpy(modes, supported, sizeof(supported));
+      nmodes = FA125_SUPPORTED_NMODES;
+    }
+
+  memset(&c, 0, sizeof(c));
+  c.buf      = (UINT32 *)malloc((size_t)(mb * 262144) * sizeof(UINT32) + 16);
+  c.maxraw   = (int)(mb * 262144) / 2;
+  c.samples  = (const volatile UINT32 **)malloc(c.maxraw * sizeof(UINT32 *));
+  c.nsamples = (int *)malloc(c.maxraw * sizeof(int));
+  index      = (FA125_BLOCK_INDEX *)malloc(c.maxraw * sizeof(FA125_BLOCK_INDEX));
+
+  cpuModel(cpu, sizeof(cpu));
+  fa125SetUnpackKernel(FA125_UNPACK_AUTO);
+  best = fa125GetUnpackKernel();
+
+  printf("cpu,bench,kernel,proc_mode,occupancy_level,occupancy,blocklevel,words,events,"
+	 "hits,passes,words_per_s,events_per_s,ns_per_hit\n");
+
+  for(imode = 0; imode < nmodes; imode++)
+    for(ilevel = 0; ilevel < 3; ilevel++)
+      {
+	cfg.mode      = modes[imode];
+	cfg.occupancy = occupancy[ilevel];
+	if(makeCorpus(&c, &cfg, mb, hostorder) != OK)
+	  {
+	    fprintf(stderr, "ERROR: corpus of mode %d at occupancy %.3f\n",
+		    cfg.mode, cfg.occupancy);
+	    rval = ERROR;
+	    continue;
+	  }
+
+	/* Full decode */
+	t0 = now();
+	for(npass = 0; (npass < MINPASS) || (now() - t0 < mintime); npass++)
+	  {
+	    fa125DecodeInit(&dec);
+	    fa125DecodeBuffer(&dec, c.buf, c.nwords, c.swap, sumRecord, &sum);
+	    fa125DecodeFlush(&dec, sumRecord, &sum);
+	  }
+	dt = now() - t0;
+	if(dec.nerrors)
+	  {
+	    fprintf(stderr, "ERROR: %llu decode errors in mode %d\n", dec.nerrors, cfg.mode);
+	    rval = ERROR;
+	  }
+	result(cpu, "decode", best, &cfg, levelName[ilevel], &c, npass, dt);
+
+	/* Raw sample unpacking, with each kernel */
+	for(kernel = FA125_UNPACK_SCALAR; (c.nraw > 0) && (kernel <= best); kernel++)
+	  {
+	    fa125SetUnpackKernel(kernel);
+	    t0 = now();
+	    for(npass = 0; (npass < MINPASS) || (now() - t0 < mintime); npass++)
+	      for(iraw = 0; iraw < c.nraw; iraw++)
+		{
+		  fa125UnpackSamples(c.samples[iraw], c.nsamples[iraw], c.swap, adc, valid);
+		  sum += adc[0];
+		}
+	    dt = now() - t0;
+	    result(cpu, "unpack", kernel, &cfg, levelName[ilevel], &c, npass, dt);
+	  }
+	fa125SetUnpackKernel(FA125_UNPACK_AUTO);
+
+	/* Validation only */
+	t0 = now();
+	for(npass = 0; (npass < MINPASS) || (now() - t0 < mintime); npass++)
+	  {
+	    if(fa125IndexBlocks(c.buf, c.nwords, c.swap, index, c.maxraw) != c.nblocks)
+	      {
+		fprintf(stderr, "ERROR: blocks of mode %d do not validate\n", cfg.mode);
+		rval = ERROR;
+		break;
+	      }
+	  }
+	dt = now() - t0;
+	result(cpu, "validate", best, &cfg, levelName[ilevel], &c, npass, dt);
+      }
+
+  /* Keep the sums live */
+  if(sum == 1)
+    fprintf(stderr, "\n");
+
+  free(index);
+  free(c.nsamples);
+  free(c.samples);
+  free(c.buf);
+
+  return (rval != OK);
+}
@@ -0,0 +1,511 @@
+/*----------------------------------------------------------------------------*
+ *  Copyright (c) 2010        Southeastern Universities Research Association, *
+ *                            Thomas Jefferson National Accelerator Facility  *
+ *                                                                            *
+ *    This software was developed under a United States Government license    *
+ *    described in the NOTICE file included as part of this distribution.     *
+ *                                                                            *
+ *    Authors: Bryan Moffit                                                   *
+ *             moffit@jlab.org                   Jefferson Lab, MS-12B3       *
+ *             Phone: (757) 269-5660             12000 Jefferson Ave.         *
+ *             Fax:   (757) 269-5800             Newport News, VA 23606       *
+ *                                                                            *
+ * __DATE__:
+ *                                                                            *
+ *----------------------------------------------------------------------------*
+ *
+ * Description:
+ *     Synthetic fADC125 data stream generator.
+ *
+ *     Word layouts (see fa125DecodeData):
+ *       Block header    1 0000 slot(5) modid(4) ... blknum(7) nevts(8)
+ *       Block trailer   1 0001 slot(5) nwords(22)
+ *       Event header    1 0010 slot(5) evnum(22)
+ *       Trigger time    1 0011 ... time[23:0]
+ *                       0 ...      time[47:24]
+ *       CDC pulse (5)   1 0101 chan(7) npk(5) le_time(11) Q(1) ovf(3)
+ *                       0 ped(8) integral(14) fm_amp(9)
+ *       FDC pulse (6)   as CDC, one continuation word per peak
+ *       FDC amp (9)     1 1001 chan(7) npk(5) le_time(11) Q(1) ovf(3)
+ *                       0 peak_amp(12) peak_time(8) ped(11), one per peak
+ *       Raw window (4)  1 0100 chan(7) ... width(12)
+ *                       0 nv1 adc_1(13) 00 nv2 adc_2(13), two samples per word
+ *       Filler (15)     1 1111 slot(5)
+ *
+ *     The long sample modes (CDC_PULSESAMPLES, FDC_PULSESAMPLES,
+ *     FDC_AMPSAMPLES) report the pulse words followed by the raw window.
+ *
+ *----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "jvme.h"
+#include "fa125Lib.h"
+#include "fa125Sim.h"
+#include "fa125SimGen.h"
+
+#define GEN_TYPE(_t)        (FA125_DATA_TYPE_DEFINE | ((_t)<<27))
+#define GEN_PEDESTAL        100     /* ADC counts */
+#define GEN_TRIGGER_TICKS   2000    /* mean 250MHz ticks between triggers */
+
+/* Parameters of one block */
+struct gen_block
+{
+  int                       slot;
+  unsigned int              blknum;
+  int                       nevents;
+  const unsigned int       *evnum;
+  const unsigned long long *trigtime;
+  int                       mode;
+  int                       npk;
+  int                       nw;
+  int                       trigtime_enable;
+  unsigned int              chdisable[3];
+};
+
+/* xorshift64* */
+static inline unsigned long long
+genRand(FA125_SIM_GEN *gen)
+{
+  gen->rng ^= gen->rng >> 12;
+  gen->rng ^= gen->rng << 25;
+  gen->rng ^= gen->rng >> 27;
+  return gen->rng * 0x2545F4914F6CDD1DULL;
+}
+
+static inline double
+genUniform(FA125_SIM_GEN *gen)
+{
+  return (genRand(gen) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Small integer noise, roughly gaussian with sigma ~1.6 counts */
+static inline int
+genNoise(FA125_SIM_GEN *gen)
+{
+  unsigned long long r = genRand(gen);
+  return (int)((r & 0x7) + ((r >> 3) & 0x7) + ((r >> 6) & 0x7)) - 10;
+}
+
+static int
+genModeSupported(int mode)
+{
+  int imode, supported_modes[FA125_SUPPORTED_NMODES] = FA125_SUPPORTED_MODES;
+
+  for(imode = 0; imode < FA125_SUPPORTED_NMODES; imode++)
+    if(mode == supported_modes[imode])
+      return 1;
+
+  return 0;
+}
+
+static int
+genIsCDC(int mode)
+{
+  return ((mode == FA125_PROC_MODE_CDC_INTEGRAL) ||
+	  (mode == FA125_PROC_MODE_CDC_PULSESAMPLES));
+}
+
+static int
+genHasSamples(int mode)
+{
+  return (mode >= FA125_PROC_MODE_CDC_PULSESAMPLES);
+}
+
+/**
+ *  @brief Fill a generator configuration with defaults: CDC_INTEGRAL,
+ *     10% occupancy, default NPK and NW, blocklevel 1, slots 3-10 and
+ *     13-20, trigger time words on, filler words on.
+ */
+void
+fa125SimGenDefaults(FA125_SIM_GEN_CONFIG *cfg)
+{
+  memset(cfg, 0, sizeof(FA125_SIM_GEN_CONFIG));
+  cfg->mode        = FA125_PROC_MODE_CDC_INTEGRAL;
+  cfg->occupancy   = 0.10;
+  cfg->npk         = FA125_DEFAULT_NPK;
+  cfg->nw          = FA125_DEFAULT_NW;
+  cfg->blocklevel  = 1;
+  cfg->slotmask    = 0x001FE7F8;
+  cfg->suppress_tt = 0;
+  cfg->filler      = 1;
+  cfg->seed        = 0x125;
+}
+
+/**
+ *  @brief Initialize a generator
+ *  @param gen Generator state
+ *  @param cfg Configuration
+ *  @return OK if successful, otherwise ERROR.
+ */
+int
+fa125SimGenInit(FA125_SIM_GEN *gen, const FA125_SIM_GEN_CONFIG *cfg)
+{
+  if(!genModeSupported(cfg->mode))
+    {
+      printf("\n%s: ERROR: Processing Mode (%d) not supported\n\n",
+	     __FUNCTION__, cfg->mode);
+      return ERROR;
+    }
+  if((cfg->occupancy < 0.0) || (cfg->occupancy > 1.0))
+    {
+      printf("\n%s: ERROR: Invalid occupancy (%f)\n\n", __FUNCTION__, cfg->occupancy);
+      return ERROR;
+    }
+  if((cfg->npk < 1) || (cfg->npk > FA125_MAX_NPK))
+    {
+      printf("\n%s: ERROR: Invalid NPK (%d)\n\n", __FUNCTION__, cfg->npk);
+      return ERROR;
+    }
+  if((cfg->nw < 1) || (cfg->nw > FA125_MAX_NW))
+    {
+      printf("\n%s: ERROR: Invalid NW (%d)\n\n", __FUNCTION__, cfg->nw);
+      return ERROR;
+    }
+  if((cfg->blocklevel < 1) || (cfg->blocklevel > FA125_SIM_MAX_EVENTS))
+    {
+      printf("\n%s: ERROR: Invalid blocklevel (%d)\n\n", __FUNCTION__, cfg->blocklevel);
+      return ERROR;
+    }
+  if((cfg->slotmask & ~0x001FFFFC) || (cfg->slotmask == 0))
+    {
+      printf("\n%s: ERROR: Invalid slotmask (0x%x)\n\n", __FUNCTION__, cfg->slotmask);
+      return ERROR;
+    }
+
+  memset(gen, 0, sizeof(FA125_SIM_GEN));
+  gen->cfg = *cfg;
+  gen->rng = cfg->seed ? cfg->seed : 0x125;
+
+  return OK;
+}
+
+/**
+ *  @brief Return the number of words produced for a channel with a hit.
+ *  @param mode Processing mode
+ *  @param npk Number of peaks reported (FDC modes)
+ *  @param nw Window width (long sample modes)
+ */
+int
+fa125SimGenWordsPerHit(int mode, int npk, int nw)
+{
+  int nwords;
+
+  if(genIsCDC(mode))
+    nwords = 2;
+  else
+    nwords = 1 + npk;
+
+  if(genHasSamples(mode))
+    nwords += 1 + (nw + 1) / 2;
+
+  return nwords;
+}
+
+/* Pulse words of one channel.  Returns the number of words written. */
+static int
+genPulse(FA125_SIM_GEN *gen, const struct gen_block *b, int chan, int npeak,
+	 int le_time, UINT32 *buf)
+{
+  int nw = 0, ipk, type, quality, ovf;
+  unsigned int ped, integral, amp, ptime;
+
+  type    = genIsCDC(b->mode) ? 5 :
+    ((b->mode == FA125_PROC_MODE_FDC_PEAKAMP) || (b->mode == FA125_PROC_MODE_FDC_AMPSAMPLES)) ? 9 : 6;
+  quality = ((genRand(gen) & 0x3F) == 0);
+  ovf     = ((genRand(gen) & 0xFF) == 0) ? 1 : 0;
+
+  buf[nw++] = GEN_TYPE(type) | ((chan & 0x7F) << 20) | ((npeak & 0x1F) << 15) |
+    ((le_time & 0x7FF) << 4) | (quality << 3) | ovf;
+
+  for(ipk = 0; ipk < npeak; ipk++)
+    {
+      if(type == 9)
+	{
+	  amp   = 50 + (genRand(gen) % 1500);
+	  ptime = ((le_time / 10) + 4 + ipk * 20) & 0xFF;
+	  ped   = (GEN_PEDESTAL + genNoise(gen)) & 0x7FF;
+	  buf[nw++] = ((amp & 0xFFF) << 19) | (ptime << 11) | ped;
+	}
+      else
+	{
+	  ped      = (GEN_PEDESTAL + genNoise(gen)) & 0xFF;
+	  integral = 200 + (genRand(gen) % 6000);
+	  amp      = 20 + (integral >> 5);
+	  buf[nw++] = (ped << 23) | ((integral & 0x3FFF) << 9) | (amp & 0x1FF);
+	}
+    }
+
+  return nw;
+}
+
+/* Raw window of one channel: a pulse at le_time on top of the pedestal */
+static int
+genSamples(FA125_SIM_GEN *gen, const struct gen_block *b, int chan, int le_time,
+	   UINT32 *buf)
+{
+  int nw = 0, isamp, t0 = le_time / 10, dt, adc[2], ih;
+  int amp = 100 + (int)(genRand(gen) % 2000);
+
+  buf[nw++] = GEN_TYPE(4) | ((chan & 0x7F) << 20) | (b->nw & 0xFFF);
+
+  for(isamp = 0; isamp < b->nw; isamp += 2)
+    {
+      for(ih = 0; ih < 2; ih++)
+	{
+	  dt = isamp + ih - t0;
+	  adc[ih] = GEN_PEDESTAL + genNoise(gen);
+	  if((dt >= 0) && (dt < 4))
+	    adc[ih] += (amp * (dt + 1)) >> 2;
+	  else if((dt >= 4) && (dt < 36))
+	    adc[ih] += (amp * (36 - dt)) >> 5;
+	  if(adc[ih] > 0xFFF)
+	    adc[ih] = 0xFFF;
+	}
+
+      if(isamp + 1 < b->nw)
+	buf[nw++] = (adc[0] << 16) | adc[1];
+      else /* Odd width: second sample not valid */
+	buf[nw++] = (adc[0] << 16) | 0x2000;
+    }
+
+  return nw;
+}
+
+static int
+genBlock(FA125_SIM_GEN *gen, const struct gen_block *b, UINT32 *buf, int maxwords)
+{
+  int nw = 0, iev, chan, npeak, le_time, hitwords;
+  unsigned long long threshold;
+
+  hitwords = fa125SimGenWordsPerHit(b->mode, b->npk, b->nw);
+
+  /* Occupancy as an integer threshold on the 64bit random number */
+  if(gen->cfg.occupancy >= 1.0)
+    threshold = ~0ULL;
+  else
+    threshold = (unsigned long long)(gen->cfg.occupancy * 18446744073709551616.0);
+
+  if(maxwords < 3)
+    return ERROR;
+
+  buf[nw++] = GEN_TYPE(0) | (b->slot << 22) | (FA125_SIM_MODULE_ID << 18) |
+    ((b->blknum & 0x7F) << 8) | (b->nevents & 0xFF);
+
+  for(iev = 0; iev < b->nevents; iev++)
+    {
+      if(nw + 3 >= maxwords)
+	return ERROR;
+
+      buf[nw++] = GEN_TYPE(2) | (b->slot << 22) | (b->evnum[iev] & 0x3FFFFF);
+      if(b->trigtime_enable)
+	{
+	  buf[nw++] = GEN_TYPE(3) | (b->trigtime[iev] & 0xFFFFFF);
+	  buf[nw++] = (b->trigtime[iev] >> 24) & 0xFFFFFF;
+	}
+
+      for(chan = 0; chan < FA125_SIM_GEN_NCHAN; chan++)
+	{
+	  if(b->chdisable[chan / 24] & (1 << (chan % 24)))
+	    continue;
+	  if((threshold != ~0ULL) && (genRand(gen) >= threshold))
+	    continue;
+
+	  if(nw + hitwords + 1 >= maxwords)
+	    return ERROR;
+
+	  /* Mostly single pulses, with a tail of multiple peaks */
+	  npeak = 1;
+	  if(!genIsCDC(b->mode))
+	    while((npeak < b->npk) && ((genRand(gen) & 0x3) == 0))
+	      npeak++;
+
+	  le_time = (int)(genRand(gen) % (10 * (b->nw > 20 ? b->nw - 16 : 4)));
+
+	  nw += genPulse(gen, b, chan, npeak, le_time, &buf[nw]);
+	  if(genHasSamples(b->mode))
+	    nw += genSamples(gen, b, chan, le_time, &buf[nw]);
+	  gen->nhits++;
+	}
+    }
+
+  buf[nw] = GEN_TYPE(1) | (b->slot << 22) | ((nw + 1) & 0x3FFFFF);
+  nw++;
+
+  gen->nevents += b->nevents;
+
+  return nw;
+}
+
+/* Advance the event counter and clock for one block worth of events */
+static void
+genNextEvents(FA125_SIM_GEN *gen, unsigned int *evnum, unsigned long long *trigtime)
+{
+  int iev;
+
+  for(iev = 0; iev < gen->cfg.blocklevel; iev++)
+    {
+      gen->trigtime += GEN_TRIGGER_TICKS / 2 + (genRand(gen) % GEN_TRIGGER_TICKS);
+      evnum[iev]    = ++gen->evnum;
+      trigtime[iev] = gen->trigtime & 0xFFFFFFFFFFFFULL;
+    }
+}
+
+static void
+genFillBlock(FA125_SIM_GEN *gen, struct gen_block *b, int slot,
+	     unsigned int *evnum, unsigned long long *trigtime)
+{
+  b->slot            = slot;
+  b->blknum          = ++gen->blknum[slot];
+  b->nevents         = gen->cfg.blocklevel;
+  b->evnum           = evnum;
+  b->trigtime        = trigtime;
+  b->mode            = gen->cfg.mode;
+  b->npk             = genIsCDC(gen->cfg.mode) ? 1 : gen->cfg.npk;
+  b->nw              = gen->cfg.nw;
+  b->trigtime_enable = !gen->cfg.suppress_tt;
+  memcpy(b->chdisable, gen->cfg.chdisable, sizeof(b->chdisable));
+}
+
+/**
+ *  @brief Generate the next block of one board.
+ *  @param gen Generator
+ *  @param slot Slot number written in the block
+ *  @param buf Destination (host byte order)
+ *  @param maxwords Size of buf
+ *  @return Number of words, including the filler if enabled, otherwise ERROR.
+ */
+int
+fa125SimGenBlock(FA125_SIM_GEN *gen, int slot, UINT32 *buf, int maxwords)
+{
+  struct gen_block b;
+  unsigned int evnum[FA125_SIM_MAX_EVENTS];
+  unsigned long long trigtime[FA125_SIM_MAX_EVENTS];
+  int nw;
+
+  if((slot < 2) || (slot > 20))
+    return ERROR;
+
+  genNextEvents(gen, evnum, trigtime);
+  genFillBlock(gen, &b, slot, evnum, trigtime);
+
+  nw = genBlock(gen, &b, buf, maxwords);
+  if(nw < 0)
+    return ERROR;
+
+  if(gen->cfg.filler && (nw & 1))
+    {
+      if(nw >= maxwords)
+	return ERROR;
+      buf[nw++] = GEN_TYPE(15) | (slot << 22);
+    }
+
+  gen->nwords += nw;
+
+  return nw;
+}
+
+/**
+ *  @brief Generate the next block of every slot in the configured slotmask,
+ *     in slot order, as a multiblock readout of the crate would return them.
+ *  @param gen Generator
+ *  @param buf Destination (host byte order)
+ *  @param maxwords Size of buf
+ *  @return Number of words, otherwise ERROR.
+ */
+int
+fa125SimGenCrate(FA125_SIM_GEN *gen, UINT32 *buf, int maxwords)
+{
+  struct gen_block b;
+  unsigned int evnum[FA125_SIM_MAX_EVENTS];
+  unsigned long long trigtime[FA125_SIM_MAX_EVENTS];
+  int islot, nw = 0, rval;
+
+  genNextEvents(gen, evnum, trigtime);
+
+  for(islot = 2; islot <= 20; islot++)
+    {
+      if(!(gen->cfg.slotmask & (1 << islot)))
+	continue;
+
+      genFillBlock(gen, &b, islot, evnum, trigtime);
+      rval = genBlock(gen, &b, &buf[nw], maxwords - nw);
+      if(rval < 0)
+	return ERROR;
+      nw += rval;
+
+      if(gen->cfg.filler && (rval & 1))
+	{
+	  if(nw >= maxwords)
+	    return ERROR;
+	  buf[nw++] = GEN_TYPE(15) | (islot << 22);
+	}
+    }
+
+  gen->nwords += nw;
+
+  return nw;
+}
+
+/**
+ *  @brief Block builder for the crate model (fa125SimSetBuilder).  Events
+ *     are generated with the occupancy of the generator configuration.
+ *     When processing is enabled on the board (fa125SetProcMode), the mode,
+ *     NPK and NW are taken from its registers, as are the channel disable
+ *     masks and the trigger time suppression.
+ *  @param arg FA125_SIM_GEN generator
+ */
+int
+fa125SimGenBuilder(const FA125_SIM_BLOCK *blk, UINT32 *buf, int maxwords, void *arg)
+{
+  FA125_SIM_GEN *gen = (FA125_SIM_GEN *)arg;
+  const volatile UINT32 *r = blk->regs;
+  const int festride = sizeof(struct fa125_a24_fe) / 4;
+  const int fe0 = offsetof(struct fa125_a24, fe[0]) / 4;
+  struct gen_block b;
+  unsigned int config1, chipmask;
+  int ichip, nw;
+
+  b.slot     = blk->slot;
+  b.blknum   = blk->blknum;
+  b.nevents  = blk->nevents;
+  b.evnum    = blk->evnum;
+  b.trigtime = blk->trigtime;
+
+  config1 = r[fe0 + offsetof(struct fa125_a24_fe, config1) / 4];
+  b.mode  = (config1 & FA125_FE_CONFIG1_MODE_MASK) + 1;
+  if((config1 & FA125_FE_CONFIG1_ENABLE) && genModeSupported(b.mode))
+    {
+      b.npk = (config1 & FA125_FE_CONFIG1_NPULSES_MASK) >> 4;
+      b.nw  = r[fe0 + offsetof(struct fa125_a24_fe, nw) / 4] & 0xFFF;
+      if(genIsCDC(b.mode) || (b.npk < 1))
+	b.npk = 1;
+      if(b.nw < 1)
+	b.nw = FA125_DEFAULT_NW;
+    }
+  else
+    {
+      b.mode = gen->cfg.mode;
+      b.npk  = genIsCDC(gen->cfg.mode) ? 1 : gen->cfg.npk;
+      b.nw   = gen->cfg.nw;
+    }
+
+  b.trigtime_enable = r[offsetof(struct fa125_a24, proc.ctrl2) / 4] &
+    FA125_PROC_CTRL2_TRIGTIME_ENABLE;
+
+  memset(b.chdisable, 0, sizeof(b.chdisable));
+  for(ichip = 0; ichip < 12; ichip++)
+    {
+      chipmask = r[fe0 + ichip * festride + offsetof(struct fa125_a24_fe, config2) / 4] &
+	FA125_FE_CONFIG2_CH_MASK;
+      b.chdisable[ichip / 4] |= chipmask << ((ichip % 4) * 6);
+    }
+
+  nw = genBlock(gen, &b, buf, maxwords);
+  if(nw > 0)
+    gen->nwords += nw;
+
+  return nw;
+}
@@ -0,0 +1,68 @@
+/*----------------------------------------------------------------------------*
+ *  Copyright (c) 2010        Southeastern Universities Research Association, *
+ *                            Thomas Jefferson National Accelerator Facility  *
+ *                                                                            *
+ *    This software was developed under a United States Government license    *
+ *    described in the NOTICE file included as part of this distribution.     *
+ *                                                                            *
+ *    Authors: Bryan Moffit                                                   *
+ *             moffit@jlab.org                   Jefferson Lab, MS-12B3       *
+ *             Phone: (757) 269-5660             12000 Jefferson Ave.         *
+ *             Fax:   (757) 269-5800             Newport News, VA 23606       *
+ *                                                                            *
+ * __DATE__:
+ *                                                                            *
+ *----------------------------------------------------------------------------*
+ *
+ * Description:
+ *     Synthetic fADC125 data stream generator.  Produces the block,
+ *     event, trigger time, pulse and raw window words of each processing
+ *     mode in FA125_SUPPORTED_MODES, as parsed by fa125DecodeData.
+ *
+ *----------------------------------------------------------------------------*/
+
+#ifndef __FA125SIMGEN__
+#define __FA125SIMGEN__
+
+#include "jvme.h"
+#include "fa125Sim.h"
+
+#define FA125_SIM_GEN_NCHAN   72
+
+/* Generator configuration */
+typedef struct
+{
+  int          mode;          /* FA125_PROC_MODE_* from FA125_SUPPORTED_MODES */
+  double       occupancy;     /* probability of a hit, per channel per event */
+  int          npk;           /* max peaks reported per channel (FDC modes) */
+  int          nw;            /* window width, samples (long modes) */
+  int          blocklevel;    /* events per block */
+  unsigned int slotmask;      /* slots in the crate (bit N = slot N) */
+  int          suppress_tt;   /* 1: no trigger time words (fa125DataSuppressTriggerTime) */
+  int          filler;        /* 1: pad blocks to 64 bits as the DMA does */
+  unsigned int chdisable[3];  /* disabled channels, as fa125SetChannelDisableMask */
+  unsigned long long seed;
+} FA125_SIM_GEN_CONFIG;
+
+/* Generator state */
+typedef struct
+{
+  FA125_SIM_GEN_CONFIG cfg;
+  unsigned long long   rng;
+  unsigned int         evnum;
+  unsigned int         blknum[FA125_SIM_MAX_SLOT+1];
+  unsigned long long   trigtime;
+  unsigned long long   nwords;     /* words produced */
+  unsigned long long   nevents;    /* events produced (per slot) */
+  unsigned long long   nhits;      /* channel hits produced */
+} FA125_SIM_GEN;
+
+void fa125SimGenDefaults(FA125_SIM_GEN_CONFIG *cfg);
+int  fa125SimGenInit(FA125_SIM_GEN *gen, const FA125_SIM_GEN_CONFIG *cfg);
+int  fa125SimGenWordsPerHit(int mode, int npk, int nw);
+int  fa125SimGenBlock(FA125_SIM_GEN *gen, int slot, UINT32 *buf, int maxwords);
+int  fa125SimGenCrate(FA125_SIM_GEN *gen, UINT32 *buf, int maxwords);
+int  fa125SimGenBuilder(const FA125_SIM_BLOCK *blk, UINT32 *buf, int maxwords,
+			void *arg);
+
+#endif /* __FA125SIMGEN__ */
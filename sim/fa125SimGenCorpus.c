@@ -0,0 +1,145 @@
+/*
+ * File:
+ *    fa125SimGenCorpus.c
+ *
+ * Description:
+ *    Write a synthetic fADC125 data corpus to a file.  Each readout is the
+ *    next block of every slot in the slot mask, in slot order, as returned
+ *    by a multiblock DMA.  Words are written in VME (big endian) byte order
+ *    unless -H is given.
+ *
+ *    Usage:
+ *      fa125SimGenCorpus [options] <output file>
+ *        -m <mode>        processing mode number (3-8)        [3]
+ *        -o <occupancy>   hit probability per channel/event   [0.10]
+ *        -p <npk>         max peaks per channel (FDC modes)   [1]
+ *        -w <nw>          window width in samples             [120]
+ *        -b <blocklevel>  events per block                    [1]
+ *        -s <slotmask>    slots in the crate                  [0x1FE7F8]
+ *        -t               suppress trigger time words
+ *        -F               no filler words
+ *        -S <MB>          corpus size in MB                   [64]
+ *        -n <nread>       number of readouts (overrides -S)
+ *        -r <seed>        random seed
+ *        -H               write in host byte order
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "jvme.h"
+#include "fa125Lib.h"
+#include "fa125SimGen.h"
+
+#define BUFWORDS  0x400000
+
+static void
+usage(const char *prog)
+{
+  printf("Usage: %s [-m mode] [-o occupancy] [-p npk] [-w nw] [-b blocklevel]\n"
+	 "          [-s slotmask] [-t] [-F] [-S MB | -n nread] [-r seed] [-H] <file>\n",
+	 prog);
+}
+
+int
+main(int argc, char *argv[])
+{
+  FA125_SIM_GEN_CONFIG cfg;
+  FA125_SIM_GEN gen;
+  UINT32 *buf;
+  FILE *fout;
+  int opt, nw, iw, hostorder = 0;
+  long long nread = -1, iread;
+  double maxmb = 64.0, t0, dt, mb;
+  struct timespec ts;
+
+  fa125SimGenDefaults(&cfg);
+
+  while((opt = getopt(argc, argv, "m:o:p:w:b:s:tFS:n:r:H")) != -1)
+    {
+      switch(opt)
+	{
+	case 'm': cfg.mode        = strtol(optarg, NULL, 0); break;
+	case 'o': cfg.occupancy   = strtod(optarg, NULL); break;
+	case 'p': cfg.npk         = strtol(optarg, NULL, 0); break;
+	case 'w': cfg.nw          = strtol(optarg, NULL, 0); break;
+	case 'b': cfg.blocklevel  = strtol(optarg, NULL, 0); break;
+	case 's': cfg.slotmask    = strtoul(optarg, NULL, 0); break;
+	case 't': cfg.suppress_tt = 1; break;
+	case 'F': cfg.filler      = 0; break;
+	case 'S': maxmb           = strtod(optarg, NULL); break;
+	case 'n': nread           = strtoll(optarg, NULL, 0); break;
+	case 'r': cfg.seed        = strtoull(optarg, NULL, 0); break;
+	case 'H': hostorder       = 1; break;
+	default:
+	  usage(argv[0]);
+	  return 1;
+	}
+    }
+
+  if(optind >= argc)
+    {
+      usage(argv[0]);
+      return 1;
+    }
+
+  if(fa125SimGenInit(&gen, &cfg) != OK)
+    return 1;
+
+  fout = fopen(argv[optind], "w");
+  if(fout == NULL)
+    {
+      perror(argv[optind]);
+      return 1;
+    }
+
+  buf = (UINT32 *)malloc(BUFWORDS * sizeof(UINT32));
+
+  printf("Mode %d (%s)  occupancy %.3f  NPK %d  NW %d  blocklevel %d  slots 0x%06x%s\n",
+	 cfg.mode, fa125_mode_names[cfg.mode], cfg.occupancy, cfg.npk, cfg.nw,
+	 cfg.blocklevel, cfg.slotmask, cfg.suppress_tt ? "  (no trigger time)" : "");
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  t0 = ts.tv_sec + 1e-9 * ts.tv_nsec;
+
+  for(iread = 0; (nread < 0) || (iread < nread); iread++)
+    {
+      if((nread < 0) && ((gen.nwords * 4.0) / 1048576.0 >= maxmb))
+	break;
+
+      nw = fa125SimGenCrate(&gen, buf, BUFWORDS);
+      if(nw < 0)
+	{
+	  printf("ERROR: readout %lld does not fit in %d words\n", iread, BUFWORDS);
+	  break;
+	}
+
+      if(!hostorder)
+	for(iw = 0; iw < nw; iw++)
+	  buf[iw] = LSWAP(buf[iw]);
+
+      if(fwrite(buf, sizeof(UINT32), nw, fout) != nw)
+	{
+	  perror("fwrite");
+	  break;
+	}
+    }
+
+  fclose(fout);
+  free(buf);
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  dt = ts.tv_sec + 1e-9 * ts.tv_nsec - t0;
+  mb = (gen.nwords * 4.0) / 1048576.0;
+
+  printf("%lld readouts, %llu events/slot, %.1f MB, %.1f words/event/slot, %.2f hits/event/slot\n",
+	 iread, gen.nevents / __builtin_popcount(cfg.slotmask), mb,
+	 gen.nevents ? (double)gen.nwords / gen.nevents : 0.0,
+	 gen.nevents ? (double)gen.nhits / gen.nevents : 0.0);
+  printf("%.2f s (%.1f MB/s)\n", dt, dt > 0 ? mb / dt : 0.0);
+
+  return 0;
+}
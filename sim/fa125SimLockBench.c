@@ -0,0 +1,180 @@
+/*
+ * File:
+ *    fa125SimLockBench.c
+ *
+ * Description:
+ *    Measure how long the readout of one module waits behind the
+ *    configuration of another.  A second thread reprograms the DAC offsets
+ *    of the last module in a loop, while the readout of the first module
+ *    (block ready poll, DMA, token reset) is timed.  This is done with the
+ *    crate lock for all modules (fa125SetGlobalLock(1)) and with the lock of
+ *    each module.
+ *
+ *    Usage:
+ *      fa125SimLockBench [options]
+ *        -n <nread>   readouts timed in each locking mode   [2000]
+ *        -c <ns>      single cycle VME access time          [1000]
+ *        -p <us>      pause between readouts                [500]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "jvme.h"
+#include "fa125Lib.h"
+#include "fa125Sim.h"
+
+#define SIM_SLOTMASK  ((1<<3) | (1<<4) | (1<<5) | (1<<6))
+#define READ_SLOT     3
+#define CONF_SLOT     6
+#define BUFSIZE       0x10000
+
+extern int nfa125;
+
+static volatile int confRun = 0;
+static unsigned long long nconf = 0;
+
+static double
+now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static int
+cmpDouble(const void *a, const void *b)
+{
+  double da = *(const double *)a, db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+/* Reprogram the DAC offsets of CONF_SLOT until told to stop */
+static void *
+confThread(void *arg)
+{
+  unsigned int offsets[72];
+  int ichan;
+
+  for(ichan = 0; ichan < 72; ichan++)
+    offsets[ichan] = 0x1000 + ichan;
+
+  while(confRun)
+    {
+      offsets[0] ^= 1;
+      fa125SetOffsets(CONF_SLOT, offsets);
+      nconf++;
+    }
+
+  return NULL;
+}
+
+static int
+bench(const char *name, int global, volatile UINT32 *buf, int nread, int pause)
+{
+  pthread_t thread;
+  double *lat, t0, t1, sum = 0;
+  int iread, nw;
+
+  lat = (double *)malloc(nread * sizeof(double));
+
+  fa125SetGlobalLock(global);
+  nconf = 0;
+  confRun = 1;
+  pthread_create(&thread, NULL, confThread, NULL);
+  usleep(10000);
+
+  t1 = now();
+  for(iread = 0; iread < nread; iread++)
+    {
+      fa125SimTrigger(1 << READ_SLOT, 1);
+
+      t0 = now();
+      while(fa125Bready(READ_SLOT) == 0)
+	;
+      nw = fa125ReadBlock(READ_SLOT, buf, BUFSIZE, 1);
+      fa125ResetToken(READ_SLOT);
+      lat[iread] = now() - t0;
+
+      if(nw <= 0)
+	{
+	  printf("ERROR: readout %d returned %d\n", iread, nw);
+	  break;
+	}
+      sum += lat[iread];
+      usleep(pause);
+    }
+  t1 = now() - t1;
+
+  confRun = 0;
+  pthread_join(thread, NULL);
+  fa125SetGlobalLock(0);
+
+  if(iread == nread)
+    {
+      qsort(lat, nread, sizeof(double), cmpDouble);
+      printf("  %-12s %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+	     name, 1e6 * sum / nread, 1e6 * lat[nread / 2],
+	     1e6 * lat[(nread * 99) / 100], 1e6 * lat[nread - 1],
+	     nconf / t1);
+    }
+
+  free(lat);
+  return (iread == nread) ? OK : ERROR;
+}
+
+int
+main(int argc, char *argv[])
+{
+  volatile UINT32 *buf;
+  int opt, nread = 2000, cycle = 1000, pause = 500, ifa, rval = 0;
+
+  while((opt = getopt(argc, argv, "n:c:p:")) != -1)
+    {
+      switch(opt)
+	{
+	case 'n': nread = strtol(optarg, NULL, 0); break;
+	case 'c': cycle = strtol(optarg, NULL, 0); break;
+	case 'p': pause = strtol(optarg, NULL, 0); break;
+	default:
+	  printf("Usage: %s [-n nread] [-c cycle ns] [-p pause us]\n", argv[0]);
+	  return 1;
+	}
+    }
+
+  if(fa125SimAddBoards(SIM_SLOTMASK) < 0)
+    return 1;
+
+  vmeOpenDefaultWindows();
+  vmeDmaConfig(2, 5, 1);
+
+  if(fa125Init(0, 0, 0, (1<<4)) != OK)
+    return 1;
+
+  for(ifa = 0; ifa < nfa125; ifa++)
+    {
+      fa125SetBlocklevel(fa125Slot(ifa), 1);
+      fa125Reset(fa125Slot(ifa), 0);
+      fa125Enable(fa125Slot(ifa));
+    }
+  fa125ResetToken(0);
+
+  buf = (volatile UINT32 *)malloc(BUFSIZE * sizeof(UINT32));
+  fa125SimSetCycleTime(cycle);
+
+  printf("\nReadout of slot %d while slot %d is configured (%d ns VME cycle)\n",
+	 READ_SLOT, CONF_SLOT, cycle);
+  printf("  %-12s %9s %9s %9s %9s %9s\n", "Lock",
+	 "mean(us)", "p50(us)", "p99(us)", "max(us)", "config/s");
+  rval |= bench("crate", 1, buf, nread, pause);
+  rval |= bench("module", 0, buf, nread, pause);
+
+  free((void *)buf);
+  fa125SimCleanup();
+
+  return (rval != OK);
+}
@@ -0,0 +1,241 @@
+/*
+ * File:
+ *    fa125SimRate.c
+ *
+ * Description:
+ *    Predict the highest trigger rate a crate of fADC125s can be read out
+ *    at, from the bus time charged by the timing model of the crate model.
+ *    Synthetic data of the chosen processing mode and occupancy is read out
+ *    as the readout list does (fa125ReadCrate), or board by board.  Each
+ *    readout is a block from every board, so the simulated bus time per
+ *    readout bounds the rate at blocklevel triggers per readout.
+ *
+ *    Usage:
+ *      fa125SimRate [options]
+ *        -m <mode>        processing mode number (3-8)         [3]
+ *        -o <occupancy>   hit probability per channel/event    [0.10]
+ *        -w <nw>          window width in samples              [120]
+ *        -p <npk>         max peaks per channel (FDC modes)    [1]
+ *        -b <blocklevel>  events per block                     [1]
+ *        -n <nboards>     boards in the crate (slots 3-10,13-20) [16]
+ *        -d <dataType>    vmeDmaConfig dataType (0-5)          [5]
+ *        -s <sstMode>     vmeDmaConfig sstMode (0-2)           [1]
+ *        -r <rflag>       0: PIO, 1: DMA of each board,
+ *                         2: multiblock (fa125ReadCrate)       [2]
+ *        -t <kHz>         trigger rate for the bus occupancy   [20]
+ *        -N <nread>       readouts                             [1000]
+ *        -a               every DMA mode, one line each
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "jvme.h"
+#include "fa125Lib.h"
+#include "fa125Sim.h"
+#include "fa125SimGen.h"
+
+#define BUFWORDS  0x400000
+
+extern int nfa125;
+
+static const unsigned int crateSlots[16] =
+  {3, 4, 5, 6, 7, 8, 9, 10, 13, 14, 15, 16, 17, 18, 19, 20};
+
+static const struct
+{
+  const char  *name;
+  unsigned int dataType, sstMode;
+} dmaModes[6] =
+  {
+    {"BLK32",    2, 0},
+    {"MBLK",     3, 0},
+    {"2eVME",    4, 0},
+    {"2eSST160", 5, 0},
+    {"2eSST267", 5, 1},
+    {"2eSST320", 5, 2},
+  };
+
+static void
+usage(const char *prog)
+{
+  printf("Usage: %s [-m mode] [-o occupancy] [-w nw] [-p npk] [-b blocklevel]\n"
+	 "          [-n nboards] [-d dataType] [-s sstMode] [-r rflag] [-t kHz]\n"
+	 "          [-N nread] [-a]\n", prog);
+}
+
+/* Read out nread blocks of every board.  Returns the number of words read,
+   or ERROR. */
+static long long
+readout(volatile UINT32 *buf, int rflag, int blocklevel, int nread)
+{
+  unsigned int scanmask = fa125ScanMask(), missing;
+  long long total = 0;
+  int iread, ifa, nw;
+
+  for(iread = 0; iread < nread; iread++)
+    {
+      fa125SimTrigger(0, blocklevel);
+
+      if(rflag == 2)
+	{
+	  nw = fa125ReadCrate(buf, BUFWORDS, &missing);
+	  if((nw <= 0) || missing)
+	    {
+	      printf("ERROR: readout %d: %d words, slots 0x%x missing\n",
+		     iread, nw, missing);
+	      return ERROR;
+	    }
+	  total += nw;
+	  continue;
+	}
+
+      if(fa125GBlockReady(scanmask, 100) != scanmask)
+	{
+	  printf("ERROR: readout %d: blocks not ready\n", iread);
+	  return ERROR;
+	}
+      for(ifa = 0; ifa < nfa125; ifa++)
+	{
+	  nw = fa125ReadBlock(fa125Slot(ifa), buf, BUFWORDS, rflag);
+	  if(nw <= 0)
+	    {
+	      printf("ERROR: readout %d: slot %d: %d words\n", iread, fa125Slot(ifa), nw);
+	      return ERROR;
+	    }
+	  total += nw;
+	}
+    }
+
+  return total;
+}
+
+int
+main(int argc, char *argv[])
+{
+  FA125_SIM_GEN_CONFIG cfg;
+  FA125_SIM_GEN gen;
+  FA125_SIM_TIMING timing;
+  FA125_SIM_STATS stats;
+  volatile UINT32 *buf;
+  unsigned int slotmask = 0, dataType = 5, sstMode = 1;
+  int opt, nboards = 16, rflag = 2, nread = 1000, all = 0, ifa, imode, first, last;
+  double khz = 20.;
+  long long nwords = 0;
+
+  fa125SimGenDefaults(&cfg);
+  cfg.occupancy = 0.10;
+
+  while((opt = getopt(argc, argv, "m:o:w:p:b:n:d:s:r:t:N:a")) != -1)
+    {
+      switch(opt)
+	{
+	case 'm': cfg.mode       = strtol(optarg, NULL, 0); break;
+	case 'o': cfg.occupancy  = atof(optarg); break;
+	case 'w': cfg.nw         = strtol(optarg, NULL, 0); break;
+	case 'p': cfg.npk        = strtol(optarg, NULL, 0); break;
+	case 'b': cfg.blocklevel = strtol(optarg, NULL, 0); break;
+	case 'n': nboards        = strtol(optarg, NULL, 0); break;
+	case 'd': dataType       = strtol(optarg, NULL, 0); break;
+	case 's': sstMode        = strtol(optarg, NULL, 0); break;
+	case 'r': rflag          = strtol(optarg, NULL, 0); break;
+	case 't': khz            = atof(optarg); break;
+	case 'N': nread          = strtol(optarg, NULL, 0); break;
+	case 'a': all            = 1; break;
+	default:
+	  usage(argv[0]);
+	  return 1;
+	}
+    }
+
+  if((nboards < 1) || (nboards > 16) || (rflag < 0) || (rflag > 2) ||
+     (nread < 1) || (khz <= 0) || (cfg.blocklevel < 1) ||
+     (cfg.blocklevel > FA125_SIM_MAX_EVENTS))
+    {
+      usage(argv[0]);
+      return 1;
+    }
+
+  for(ifa = 0; ifa < nboards; ifa++)
+    slotmask |= 1 << crateSlots[ifa];
+  cfg.slotmask = slotmask;
+  if(fa125SimGenInit(&gen, &cfg) != OK)
+    return 1;
+
+  if(fa125SimAddBoards(slotmask) != nboards)
+    return 1;
+
+  vmeOpenDefaultWindows();
+  if(vmeDmaConfig(2, dataType, sstMode) != OK)
+    return 1;
+
+  if(fa125Init(0, 0, 0, (1<<4)) != OK)
+    return 1;
+
+  for(ifa = 0; ifa < nfa125; ifa++)
+    {
+      fa125SetProcMode(fa125Slot(ifa), (char *)fa125_modes[cfg.mode],
+		       FA125_DEFAULT_PL, cfg.nw, FA125_DEFAULT_IE, FA125_DEFAULT_PG,
+		       cfg.npk, FA125_DEFAULT_P1, FA125_DEFAULT_P2);
+      fa125SetBlocklevel(fa125Slot(ifa), cfg.blocklevel);
+      fa125Reset(fa125Slot(ifa), 0);
+      fa125Enable(fa125Slot(ifa));
+    }
+  fa125ResetToken(0);
+  fa125SimSetBuilder(fa125SimGenBuilder, &gen);
+
+  fa125SimGetTiming(&timing);
+  timing.trigger_ns = 1e6 / khz;
+  fa125SimSetTiming(&timing);
+
+  buf = (volatile UINT32 *)malloc(BUFWORDS * sizeof(UINT32));
+
+  printf("\n%d boards, %s, occupancy %.3f, blocklevel %d, rflag %d\n",
+	 nboards, fa125_modes[cfg.mode], cfg.occupancy, cfg.blocklevel, rflag);
+
+  if(all)
+    {
+      first = 0;
+      last  = 5;
+      printf("  %-10s %12s %12s %10s %12s\n", "DMA", "words/read", "bus us/read",
+	     "occupancy", "max kHz");
+    }
+  else
+    first = last = -1;
+
+  for(imode = first; imode <= last; imode++)
+    {
+      if(imode >= 0)
+	vmeDmaConfig(2, dmaModes[imode].dataType, dmaModes[imode].sstMode);
+
+      /* Same data for each mode */
+      fa125SimGenInit(&gen, &cfg);
+      fa125SimResetStats();
+      nwords = readout(buf, rflag, cfg.blocklevel, nread);
+      if(nwords < 0)
+	break;
+      fa125SimGetStats(&stats);
+
+      if(imode < 0)
+	{
+	  fa125SimPrintBusReport(&stats);
+	  printf("  %.1f words, %.2f us of bus time per readout\n",
+		 (double)nwords / nread, 1e-3 * stats.bus_ns / nread);
+	  printf("  Maximum trigger rate of the crate: %.1f kHz (%.1f MB/s)\n\n",
+		 1e-3 * fa125SimMaxTriggerRate(&stats),
+		 4e-6 * nwords / nread * fa125SimMaxTriggerRate(&stats) / cfg.blocklevel);
+	}
+      else
+	printf("  %-10s %12.1f %12.2f %9.1f%% %12.1f\n", dmaModes[imode].name,
+	       (double)nwords / nread, 1e-3 * stats.bus_ns / nread,
+	       100. * stats.bus_ns / ((double)stats.ntrig * timing.trigger_ns),
+	       1e-3 * fa125SimMaxTriggerRate(&stats));
+    }
+
+  free((void *)buf);
+  fa125SimCleanup();
+
+  return (nwords < 0);
+}
@@ -0,0 +1,1405 @@
+/*
+ * File:
+ *    fa125SimTest.c
+ *
+ * Description:
+ *    Run fa125Lib against the software crate model.  Checks the
+ *    initialization, DAC programming, and the programmed I/O, single board
+ *    DMA, multiblock DMA and asynchronous DMA readout paths, then reports
+ *    the readout throughput of each path.  The synthetic data generator is
+ *    then installed as the block builder, and the stream of each processing
+ *    mode is checked word by word and with the decoder.  The raw sample
+ *    unpacking and buffer swap/scan kernels are compared.  Last, a module
+ *    is configured from an FADC125_CONF with fa125ConfigApply, and the crate
+ *    with fa125ConfigRun, checking that readout is not held up by the
+ *    configuration, and the rate limit and counts of the deferred log are
+ *    checked.  The readout counters and the readout trace are checked after
+ *    the readout paths.
+ *
+ *    Returns 0 if all checks pass.
+ *
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "jvme.h"
+#include "fa125Lib.h"
+#include "fa125Config.h"
+#include "fa125Sim.h"
+#include "fa125SimGen.h"
+
+#define SIM_SLOTMASK  ((1<<3) | (1<<4) | (1<<5) | (1<<6))
+#define NSLOTS        4
+#define BLOCKLEVEL    3
+#define NLOOP         2000
+#define BUFSIZE       0x10000
+
+extern int nfa125;
+
+static int nerror = 0;
+
+#define CHECK(_cond, _fmt, ...)						\
+  if(!(_cond)) { printf("FAIL: " _fmt "\n", ##__VA_ARGS__); nerror++; }
+
+static double
+now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/* Check the blocks in buf (VME byte order).  Returns the number of blocks */
+static int
+checkBlocks(volatile UINT32 *buf, int nwords, unsigned int slotmask)
+{
+  int iw = 0, nblk = 0, bstart = 0, slot = 0, blkslot = -1;
+  UINT32 data;
+
+  while(iw < nwords)
+    {
+      data = LSWAP(buf[iw]);
+
+      if((data & 0xF8000000) == (FA125_DATA_TYPE_DEFINE | FA125_DATA_BLOCK_HEADER))
+	{
+	  blkslot = (data >> 22) & 0x1F;
+	  bstart = iw;
+	  CHECK(slotmask & (1 << blkslot), "block header from unexpected slot %d", blkslot);
+	  CHECK((data & 0xFF) == BLOCKLEVEL, "slot %d: %d events in block",
+		blkslot, data & 0xFF);
+	}
+      else if((data & 0xF8000000) == (FA125_DATA_TYPE_DEFINE | FA125_DATA_BLOCK_TRAILER))
+	{
+	  slot = (data >> 22) & 0x1F;
+	  CHECK(slot == blkslot, "trailer slot %d != header slot %d", slot, blkslot);
+	  CHECK((data & 0x3FFFFF) == (iw - bstart + 1), "slot %d: trailer word count %d != %d",
+		slot, data & 0x3FFFFF, iw - bstart + 1);
+	  nblk++;
+	}
+      iw++;
+    }
+
+  return nblk;
+}
+
+/* Walk a generated stream (VME byte order) and check the word sequence.
+   Returns the number of channel hits, or -1 on error. */
+static int
+checkStream(volatile UINT32 *buf, int nwords, int mode, int trigtime)
+{
+  int iw = 0, type, ncont = 0, expect = 0, nhit = 0, nev = 0, evnts = 0;
+  int lastchan = -1, needraw = 0, ntt = 0;
+  UINT32 data;
+
+  while(iw < nwords)
+    {
+      data = LSWAP(buf[iw]);
+      iw++;
+      if(!(data & FA125_DATA_TYPE_DEFINE))
+	{
+	  ncont++;
+	  continue;
+	}
+
+      if(ncont != expect)
+	{
+	  printf("FAIL: word %d: %d continuation words, expected %d\n", iw - 1, ncont, expect);
+	  return -1;
+	}
+      ncont = expect = 0;
+
+      type = (data & FA125_DATA_TYPE_MASK) >> 27;
+      if(needraw && (type != 4))
+	{
+	  printf("FAIL: word %d: pulse without raw window (mode %d)\n", iw - 1, mode);
+	  return -1;
+	}
+
+      switch(type)
+	{
+	case 0: /* Block header */
+	  evnts = data & 0xFF;
+	  nev = 0;
+	  break;
+	case 1: /* Block trailer */
+	  if((nev != evnts) || (trigtime && (ntt != nev)) || (!trigtime && ntt))
+	    {
+	      printf("FAIL: block with %d/%d events, %d trigger times\n", nev, evnts, ntt);
+	      return -1;
+	    }
+	  ntt = 0;
+	  break;
+	case 2: nev++; break;
+	case 3: ntt++; expect = 1; break;
+	case 4:
+	  if(((data >> 20) & 0x7F) != lastchan)
+	    {
+	      printf("FAIL: raw window for chan %d after pulse on chan %d\n",
+		     (data >> 20) & 0x7F, lastchan);
+	      return -1;
+	    }
+	  expect = ((data & 0xFFF) + 1) / 2;
+	  needraw = 0;
+	  break;
+	case 5: case 6: case 9:
+	  nhit++;
+	  lastchan = (data >> 20) & 0x7F;
+	  expect = (type == 5) ? 1 : (data >> 15) & 0x1F;
+	  needraw = (mode >= FA125_PROC_MODE_CDC_PULSESAMPLES);
+	  break;
+	case 15: break;
+	default:
+	  printf("FAIL: word %d: unexpected type %d\n", iw - 1, type);
+	  return -1;
+	}
+    }
+
+  return nhit;
+}
+
+/* Record counts from fa125DecodeBuffer */
+struct decode_count
+{
+  int nrec[16];
+  int npeak;
+  int nsamples;
+  int nbad;
+  int nw;     /* expected raw window width */
+};
+
+static int
+countRecord(const FA125_DECODE_RECORD *rec, void *arg)
+{
+  struct decode_count *cnt = (struct decode_count *)arg;
+  short adc[FA125_MAX_NW];
+  UINT32 valid[FA125_MAX_NW/32];
+  int is;
+
+  cnt->nrec[rec->type]++;
+  if(rec->error)
+    cnt->nbad++;
+
+  switch(rec->type)
+    {
+    case FA125_DECODE_PULSE_CDC:
+    case FA125_DECODE_PULSE_FDC:
+    case FA125_DECODE_PULSE_FDC_AMP:
+      if(rec->npeak != ((rec->type == FA125_DECODE_PULSE_CDC) ? 1 : rec->npk))
+	cnt->nbad++;
+      cnt->npeak += rec->npeak;
+      break;
+
+    case FA125_DECODE_WINDOW_RAW:
+      if((rec->width != cnt->nw) ||
+	 (fa125DecodeSamples(rec, adc, valid) != cnt->nw))
+	cnt->nbad++;
+      for(is = 0; is < rec->nsamples; is++)
+	if(!(valid[is/32] & (1 << (is%32))) || (adc[is] == 0))
+	  cnt->nbad++;
+      cnt->nsamples += rec->nsamples;
+      break;
+    }
+
+  return OK;
+}
+
+/* Chunks of a chunked readout, decoded as they arrive */
+struct chunk_decode
+{
+  FA125_DECODER      dec;
+  struct decode_count cnt;
+  int                nchunk;
+  int                maxchunk;
+};
+
+static int
+decodeChunk(const volatile UINT32 *data, int nwords, void *arg)
+{
+  struct chunk_decode *cd = (struct chunk_decode *)arg;
+
+  cd->nchunk++;
+  if(nwords > cd->maxchunk)
+    cd->maxchunk = nwords;
+  fa125DecodeBuffer(&cd->dec, data, nwords, 1, countRecord, &cd->cnt);
+
+  return OK;
+}
+
+/* Configuration step: a settling wait, then the whole board configuration */
+static int
+configStep(int id, void *arg)
+{
+  usleep(20000);
+  return fa125ConfigApply(id, (FADC125_CONF *)arg);
+}
+
+static int
+failStep(int id, void *arg)
+{
+  return ERROR;
+}
+
+/* Configuration step that keeps its module busy */
+static int
+holdStep(int id, void *arg)
+{
+  usleep(200000);
+  return OK;
+}
+
+static void *
+configThread(void *arg)
+{
+  fa125ConfigRun(1);
+  return NULL;
+}
+
+static unsigned int crateMissing;
+static void *
+readCrateThread(void *arg)
+{
+  fa125ReadCrate((volatile UINT32 *)arg, BUFSIZE, &crateMissing);
+  return NULL;
+}
+
+static void
+report(const char *name, int nblocks, int nwords, double dt)
+{
+  printf("  %-24s %8d blocks %8.2f us/block %10.3f Mwords/s\n",
+	 name, nblocks, 1e6 * dt / nblocks, 1e-6 * nwords / dt);
+}
+
+int
+main(int argc, char *argv[])
+{
+  volatile UINT32 *buf;
+  int iloop, ifa, slot, nw, total, nblk, dac, ichan, nwrite;
+  unsigned int offsets[72];
+  unsigned int ready;
+  double t0;
+  FA125_SIM_STATS stats;
+
+  printf("\nFA125 Crate Model Tests\n");
+  printf("----------------------------\n");
+
+  if(fa125SimAddBoards(SIM_SLOTMASK) != NSLOTS)
+    return 1;
+
+  vmeOpenDefaultWindows();
+  vmeDmaConfig(2, 5, 1);
+
+  buf = (volatile UINT32 *)malloc(BUFSIZE * sizeof(UINT32));
+
+  /* Scan the default slot list.  Empty slots must not respond. */
+  if(fa125Init(0, 0, 0, (1<<4)) != OK)
+    {
+      printf("FAIL: fa125Init\n");
+      return 1;
+    }
+  CHECK(nfa125 == NSLOTS, "nfa125 = %d", nfa125);
+  CHECK(fa125ScanMask() == SIM_SLOTMASK, "scanmask = 0x%x", fa125ScanMask());
+
+  /* DAC offsets must land in the LTC2620 selected by fa125SetOffset */
+  fa125SetOffset(4, 0, 0x1234);
+  fa125SetOffset(4, 12, 0x4321);
+  dac = fa125SimGetDac(4, 34);
+  CHECK(dac == 0x1234, "chan 0 dac = 0x%x", dac);
+  dac = fa125SimGetDac(4, 74);
+  CHECK(dac == 0x4321, "chan 12 dac = 0x%x", dac);
+
+  /* Bulk offsets must match the per channel path, in fewer VME writes */
+  for(ichan = 0; ichan < 72; ichan++)
+    offsets[ichan] = 0x1000 + 0x101 * ichan;
+
+  fa125SimResetStats();
+  for(ichan = 0; ichan < 72; ichan++)
+    fa125SetOffset(5, ichan, offsets[ichan]);
+  fa125SimGetStats(&stats);
+  nwrite = stats.nwrite;
+
+  fa125SimResetStats();
+  fa125SetOffsets(6, offsets);
+  fa125SimGetStats(&stats);
+  printf("  DAC offsets: %d writes per channel, %d writes bulk\n",
+	 nwrite, (int)stats.nwrite);
+  CHECK(stats.nwrite * 8 < nwrite, "bulk offsets used %d writes",
+	(int)stats.nwrite);
+
+  for(ichan = 0; ichan < 80; ichan++)
+    {
+      dac = fa125SimGetDac(6, ichan);
+      CHECK(dac == fa125SimGetDac(5, ichan), "dac %d = 0x%x, expected 0x%x",
+	    ichan, dac, fa125SimGetDac(5, ichan));
+    }
+  for(ichan = 0; ichan < 72; ichan++)
+    CHECK(fa125ReadOffset(6, ichan) == offsets[ichan], "chan %d offset = 0x%x",
+	  ichan, fa125ReadOffset(6, ichan));
+
+  /* Configuration setters work from the register shadow: no reads */
+  fa125SimResetStats();
+  for(ifa = 0; ifa < nfa125; ifa++)
+    for(ichan = 0; ichan < 72; ichan++)
+      fa125SetTimingThreshold(fa125Slot(ifa), ichan, ichan % 64, ichan % 128);
+  fa125SimGetStats(&stats);
+  printf("  Timing thresholds: %d reads, %d writes\n",
+	 (int)stats.nread, (int)stats.nwrite);
+  CHECK(stats.nread == 0, "timing thresholds read %d registers", (int)stats.nread);
+
+  /* Unchanged values are not written again */
+  fa125SetCommonTimingThreshold(3, 0, 0);
+  fa125SimResetStats();
+  fa125SetCommonTimingThreshold(3, 0, 0);
+  fa125SimGetStats(&stats);
+  CHECK(stats.nwrite == 0, "common timing threshold wrote %d registers",
+	(int)stats.nwrite);
+
+  /* Deferred writes go out in one flush */
+  fa125GShadowDefer(1);
+  fa125SimResetStats();
+  for(ifa = 0; ifa < nfa125; ifa++)
+    for(ichan = 0; ichan < 72; ichan++)
+      fa125SetTimingThreshold(fa125Slot(ifa), ichan, (ichan+1) % 64, (ichan+1) % 128);
+  fa125SimGetStats(&stats);
+  CHECK(stats.nwrite == 0, "deferred timing thresholds wrote %d registers",
+	(int)stats.nwrite);
+  nw = fa125GShadowFlush();
+  fa125SimGetStats(&stats);
+  CHECK((nw == NSLOTS * 12 * 5) && (stats.nwrite == nw),
+	"flush wrote %d (%d) registers", nw, (int)stats.nwrite);
+  fa125GShadowDefer(0);
+
+  for(ifa = 0; ifa < nfa125; ifa++)
+    for(ichan = 0; ichan < 72; ichan++)
+      {
+	int lo, hi;
+	fa125GetTimingThreshold(fa125Slot(ifa), ichan, &lo, &hi);
+	CHECK((lo == (ichan+1) % 64) && (hi == (ichan+1) % 128),
+	      "slot %d chan %d timing threshold %d/%d", fa125Slot(ifa), ichan, lo, hi);
+      }
+
+  for(ifa = 0; ifa < nfa125; ifa++)
+    {
+      slot = fa125Slot(ifa);
+      fa125SetBlocklevel(slot, BLOCKLEVEL);
+      fa125Reset(slot, 0);
+      fa125Enable(slot);
+    }
+  fa125ResetToken(0);
+
+  /* No trigger, no data */
+  CHECK(fa125GBready() == 0, "block ready without triggers");
+
+  /* Programmed I/O */
+  t0 = now();
+  total = nblk = 0;
+  for(iloop = 0; iloop < NLOOP; iloop++)
+    {
+      fa125SimTrigger(0, BLOCKLEVEL);
+      ready = fa125GBlockReady(SIM_SLOTMASK, 100);
+      CHECK(ready == SIM_SLOTMASK, "PIO: ready = 0x%x", ready);
+      for(ifa = 0; ifa < nfa125; ifa++)
+	{
+	  slot = fa125Slot(ifa);
+	  nw = fa125ReadBlock(slot, buf, BUFSIZE, 0);
+	  CHECK(nw == 2 + 3 * BLOCKLEVEL, "PIO: slot %d nwords = %d", slot, nw);
+	  nblk += checkBlocks(buf, nw, 1 << slot);
+	  total += nw;
+	}
+    }
+  report("Programmed I/O", nblk, total, now() - t0);
+  CHECK(nblk == NLOOP * NSLOTS, "PIO: %d blocks", nblk);
+
+  /* Single board DMA */
+  t0 = now();
+  total = nblk = 0;
+  for(iloop = 0; iloop < NLOOP; iloop++)
+    {
+      fa125SimTrigger(0, BLOCKLEVEL);
+      fa125GBlockReady(SIM_SLOTMASK, 100);
+      for(ifa = 0; ifa < nfa125; ifa++)
+	{
+	  slot = fa125Slot(ifa);
+	  nw = fa125ReadBlock(slot, buf, BUFSIZE, 1);
+	  /* Odd block length: a filler word is added */
+	  CHECK(nw == 2 + 3 * BLOCKLEVEL + 1, "DMA: slot %d nwords = %d", slot, nw);
+	  CHECK(fa125ReadBlockStatus(1) == FA125_BLOCKERROR_NO_ERROR, "DMA: block error");
+	  nblk += checkBlocks(buf, nw, 1 << slot);
+	  total += nw;
+	}
+    }
+  report("Single board DMA", nblk, total, now() - t0);
+  CHECK(nblk == NLOOP * NSLOTS, "DMA: %d blocks", nblk);
+
+  /* Multiblock DMA */
+  t0 = now();
+  total = nblk = 0;
+  for(iloop = 0; iloop < NLOOP; iloop++)
+    {
+      fa125SimTrigger(0, BLOCKLEVEL);
+      fa125GBlockReady(SIM_SLOTMASK, 100);
+      nw = fa125ReadBlock(fa125Slot(0), buf, BUFSIZE, 2);
+      CHECK(nw == NSLOTS * (2 + 3 * BLOCKLEVEL + 1), "MBLK: nwords = %d", nw);
+      CHECK(fa125ReadBlockStatus(1) == FA125_BLOCKERROR_NO_ERROR, "MBLK: block error");
+      nblk += checkBlocks(buf, nw, SIM_SLOTMASK);
+      total += nw;
+      fa125ResetToken(fa125Slot(0));
+    }
+  report("Multiblock DMA", nblk, total, now() - t0);
+  CHECK(nblk == NLOOP * NSLOTS, "MBLK: %d blocks", nblk);
+
+  /* Asynchronous multiblock DMA */
+  t0 = now();
+  total = nblk = 0;
+  for(iloop = 0; iloop < NLOOP; iloop++)
+    {
+      fa125SimTrigger(0, BLOCKLEVEL);
+      fa125GBlockReady(SIM_SLOTMASK, 100);
+      CHECK(fa125ReadBlockStart(fa125Slot(0), buf, BUFSIZE, 2) == OK, "ASYNC: start");
+      CHECK(fa125ReadBlock(fa125Slot(0), buf, BUFSIZE, 2) == ERROR, "ASYNC: second DMA started");
+      nw = fa125ReadBlockComplete(100);
+      CHECK(nw == NSLOTS * (2 + 3 * BLOCKLEVEL + 1), "ASYNC: nwords = %d", nw);
+      CHECK(fa125ReadBlockStatus(1) == FA125_BLOCKERROR_NO_ERROR, "ASYNC: block error");
+      nblk += checkBlocks(buf, nw, SIM_SLOTMASK);
+      total += nw;
+      fa125ResetToken(fa125Slot(0));
+    }
+  report("Async multiblock DMA", nblk, total, now() - t0);
+  CHECK(nblk == NLOOP * NSLOTS, "ASYNC: %d blocks", nblk);
+  CHECK(fa125ReadBlockComplete(0) == ERROR, "ASYNC: complete without DMA");
+
+  /* A board that is late must end the multiblock transfer early */
+  fa125SimSetReadyDelay(5, -1);
+  fa125SimTrigger(0, BLOCKLEVEL);
+  CHECK(fa125ReadBlockStart(fa125Slot(0), buf, BUFSIZE, 2) == OK, "MBLK late board: start");
+  CHECK(fa125ReadBlockComplete(10) == ERROR, "MBLK late board: no timeout");
+  CHECK(fa125ReadBlockStatus(0) == FA125_BLOCKERROR_DMA_TIMEOUT,
+	"MBLK late board: block error %d", fa125ReadBlockStatus(0));
+  nw = fa125ReadBlockComplete(0);
+  CHECK(nw == 2 * (2 + 3 * BLOCKLEVEL + 1), "MBLK late board: nwords = %d", nw);
+  CHECK(fa125ReadBlockStatus(0) == FA125_BLOCKERROR_UNKNOWN_BUS_ERROR,
+	"MBLK late board: block error %d", fa125ReadBlockStatus(0));
+  fa125SimSetReadyDelay(5, 0);
+  CHECK(fa125SimFifoWords(5) == 2 + 3 * BLOCKLEVEL, "late board FIFO = %d words",
+	fa125SimFifoWords(5));
+
+  /* A DMA that timed out can be given up, and the next one started */
+  fa125SimSetReadyDelay(5, -1);
+  CHECK(fa125ReadBlockStart(fa125Slot(0), buf, BUFSIZE, 2) == OK, "abort: start");
+  CHECK(fa125ReadBlockComplete(10) == ERROR, "abort: no timeout");
+  CHECK(fa125ReadBlockAbort() == 1, "abort: DMA not given up");
+  CHECK(fa125ReadBlockAbort() == 0, "abort: DMA given up twice");
+  fa125ResetToken(fa125Slot(0));
+  CHECK(fa125ReadBlockStart(fa125Slot(0), buf, BUFSIZE, 2) == OK, "abort: next DMA");
+  fa125ReadBlockComplete(0);
+  fa125ResetToken(fa125Slot(0));
+  fa125SimSetReadyDelay(5, 0);
+
+  /* Bus time: a multiblock readout is charged as the timing model says,
+     at the rate of the DMA mode in use */
+  {
+    static const unsigned int dtype[2] = {5, 3};
+    FA125_SIM_TIMING timing;
+    unsigned long long data_ns;
+    double rate;
+    int imode;
+
+    fa125SimSetReadyDelay(5, 0);
+    fa125ReadBlock(fa125Slot(0), buf, BUFSIZE, 2);
+    fa125ResetToken(fa125Slot(0));
+    fa125SimGetTiming(&timing);
+
+    for(imode = 0; imode < 2; imode++)
+      {
+	vmeDmaConfig(2, dtype[imode], 1);
+	rate = (dtype[imode] == 5) ? timing.sst_mbps[1] : timing.mbps[dtype[imode]];
+	CHECK(fa125SimDmaRate() == rate, "bus: DMA rate %g, not %g", fa125SimDmaRate(), rate);
+
+	fa125SimResetStats();
+	fa125SimTrigger(0, BLOCKLEVEL);
+	fa125GBlockReady(SIM_SLOTMASK, 100);
+	nw = fa125ReadBlock(fa125Slot(0), buf, BUFSIZE, 2);
+	fa125ResetToken(fa125Slot(0));
+	fa125SimGetStats(&stats);
+
+	data_ns = (unsigned long long)(1000. * stats.dma_bytes / rate);
+	CHECK((stats.ntrig == BLOCKLEVEL) && (stats.ndma == 1) &&
+	      (stats.dma_bytes == 4 * nw) && (stats.ntoken == NSLOTS - 1),
+	      "bus: %llu triggers, %llu DMAs, %llu bytes, %llu token passes",
+	      stats.ntrig, stats.ndma, stats.dma_bytes, stats.ntoken);
+	CHECK(stats.cycle_ns == timing.read_ns * (stats.nread + stats.nprobe) +
+	      timing.write_ns * stats.nwrite, "bus: %llu ns of single cycles", stats.cycle_ns);
+	CHECK((stats.dma_setup_ns == timing.dma_setup_ns) && (stats.dma_data_ns == data_ns) &&
+	      (stats.token_ns == (NSLOTS - 1) * timing.token_ns) &&
+	      (stats.berr_ns == stats.nberr * timing.berr_ns),
+	      "bus: DMA %llu + %llu (%llu) ns, token %llu ns, BERR %llu ns",
+	      stats.dma_setup_ns, stats.dma_data_ns, data_ns, stats.token_ns, stats.berr_ns);
+	CHECK(stats.bus_ns == stats.cycle_ns + stats.dma_setup_ns + stats.dma_data_ns +
+	      stats.token_ns + stats.berr_ns, "bus: %llu ns total", stats.bus_ns);
+	CHECK(fa125SimMaxTriggerRate(&stats) == 1e9 * BLOCKLEVEL / stats.bus_ns,
+	      "bus: max trigger rate %g", fa125SimMaxTriggerRate(&stats));
+	fa125SimPrintBusReport(&stats);
+      }
+    vmeDmaConfig(2, 5, 1);
+
+    timing.mbps[3] = 0;
+    CHECK(fa125SimSetTiming(&timing) == ERROR, "bus: zero DMA rate accepted");
+  }
+
+  /* DMA calibration: the fastest mode of the timing model is chosen, and
+     short blocks are then read by programmed I/O */
+  {
+    FA125_DMA_CALIBRATION cal;
+    FA125_SIM_TIMING timing;
+    int crossover[3] = {0, 50, 5}, ipass;
+
+    fa125SimGetTiming(&timing);
+    timing.realtime = 1;
+    fa125SimSetTiming(&timing);
+    CHECK(fa125DmaCalibrate(fa125Slot(0), buf, FA125_DMA_CAL_WORDS, 0, 1) == OK,
+	  "calibration: failed");
+
+    CHECK((fa125GetDmaCalibration(&cal) == OK) && (cal.best == 5),
+	  "calibration: mode %d chosen", cal.best);
+    CHECK(fa125SimDmaRate() == timing.sst_mbps[2], "calibration: DMA rate %g",
+	  fa125SimDmaRate());
+    CHECK((cal.crossover > 0) && (cal.crossover < 16), "calibration: crossover %d",
+	  cal.crossover);
+
+    /* Only the modes of the mask are tried */
+    CHECK(fa125DmaCalibrate(fa125Slot(0), buf, FA125_DMA_CAL_WORDS,
+			    ~FA125_DMA_MODE_2ESST320 & 0x3f, 0) == OK,
+	  "calibration without 2eSST320: failed");
+    CHECK((fa125GetDmaCalibration(&cal) == OK) && (cal.best == 4) && !cal.ok[5],
+	  "calibration without 2eSST320: mode %d chosen", cal.best);
+    CHECK(fa125SimDmaRate() == timing.sst_mbps[1], "calibration: DMA rate %g",
+	  fa125SimDmaRate());
+    timing.realtime = 0;
+    fa125SimSetTiming(&timing);
+
+    /* Data in the FIFO is not taken for filler */
+    fa125SimTrigger(0, BLOCKLEVEL);
+    fa125GBlockReady(SIM_SLOTMASK, 100);
+    CHECK(fa125DmaCalibrate(fa125Slot(0), buf, FA125_DMA_CAL_WORDS, 0, 0) == ERROR,
+	  "calibration: data in the FIFO taken for filler");
+    CHECK(fa125GetDmaCalibration(&cal) == ERROR, "calibration: valid with data");
+    fa125SetReadCrossover(0);
+    for(ifa = 0; ifa < NSLOTS; ifa++)
+      fa125ReadBlock(fa125Slot(ifa), buf, BUFSIZE, 1);
+    fa125ResetToken(0);
+    CHECK(fa125DmaCalibrate(fa125Slot(0), buf, FA125_DMA_CAL_WORDS, 0, 0) == OK,
+	  "calibration: failed after the readout");
+
+    /* DMA, to learn the block length, then PIO below the crossover */
+    for(ipass = 0; ipass < 3; ipass++)
+      {
+	fa125SetReadCrossover(crossover[ipass]);
+	fa125SimTrigger(0, BLOCKLEVEL);
+	fa125GBlockReady(SIM_SLOTMASK, 100);
+	fa125SimResetStats();
+	for(ifa = 0; ifa < NSLOTS; ifa++)
+	  {
+	    nw = fa125ReadBlock(fa125Slot(ifa), buf, BUFSIZE, 1 | 0x20);
+	    CHECK(nw == 2 + 3 * BLOCKLEVEL + (ipass != 1), "auto: slot %d nwords = %d",
+		  fa125Slot(ifa), nw);
+	  }
+	fa125SimGetStats(&stats);
+	CHECK(stats.ndma == ((ipass != 1) ? NSLOTS : 0), "auto: crossover %d: %llu DMAs",
+	      crossover[ipass], stats.ndma);
+      }
+    fa125SetReadCrossover(0);
+    vmeDmaConfig(2, 5, 1);
+  }
+
+  /* Synthetic data of each processing mode */
+  {
+    int supported_modes[FA125_SUPPORTED_NMODES] = FA125_SUPPORTED_MODES;
+    int imode, nhit;
+    FA125_SIM_GEN_CONFIG cfg;
+    FA125_SIM_GEN gen;
+
+    fa125SimGenDefaults(&cfg);
+    cfg.occupancy = 0.25;
+    cfg.slotmask  = SIM_SLOTMASK;
+    fa125SimGenInit(&gen, &cfg);
+    fa125SimSetBuilder(fa125SimGenBuilder, &gen);
+
+    for(imode = 0; imode < FA125_SUPPORTED_NMODES; imode++)
+      {
+	for(ifa = 0; ifa < nfa125; ifa++)
+	  {
+	    slot = fa125Slot(ifa);
+	    fa125SetProcMode(slot, (char *)fa125_modes[supported_modes[imode]],
+			     500, 61, 200, 4, 3, 4, 4);
+	    fa125DataSuppressTriggerTime(slot, imode & 1);
+	    fa125Reset(slot, 0);
+	  }
+	fa125ResetToken(0);
+
+	fa125SimTrigger(0, BLOCKLEVEL);
+	nw = fa125ReadBlock(fa125Slot(0), buf, BUFSIZE, 2 | 0x40);
+	CHECK(fa125ReadBlockStatus(1) == FA125_BLOCKERROR_NO_ERROR,
+	      "mode %d: block error", supported_modes[imode]);
+	nblk = checkBlocks(buf, nw, SIM_SLOTMASK);
+	CHECK(nblk == NSLOTS, "mode %d: %d blocks", supported_modes[imode], nblk);
+
+	/* The block index of the readout must locate each slot */
+	{
+	  FA125_BLOCK_INDEX index[FA125_MAX_BOARDS+1], direct[FA125_MAX_BOARDS+1];
+	  int nidx, iblk, word;
+
+	  nidx = fa125ReadBlockIndex(index, FA125_MAX_BOARDS+1);
+	  CHECK(nidx == NSLOTS, "mode %d: %d blocks indexed", supported_modes[imode], nidx);
+	  for(iblk = 0; (iblk < nidx) && (iblk < NSLOTS); iblk++)
+	    {
+	      word = LSWAP(buf[index[iblk].offset]);
+	      CHECK((index[iblk].slot == fa125Slot(iblk)) && (index[iblk].nevents == BLOCKLEVEL) &&
+		    (index[iblk].blknum == (word & 0x7F00) >> 8) &&
+		    ((word & 0xF8000000) == 0x80000000) &&
+		    ((LSWAP(buf[index[iblk].offset + index[iblk].length - 1]) & 0x3FFFFF) ==
+		     index[iblk].length),
+		    "mode %d: index %d: slot %d offset %d length %d", supported_modes[imode],
+		    iblk, index[iblk].slot, index[iblk].offset, index[iblk].length);
+	    }
+	  CHECK((fa125IndexBlocks(buf, nw, 1, direct, FA125_MAX_BOARDS+1) == nidx) &&
+		(memcmp(index, direct, nidx * sizeof(FA125_BLOCK_INDEX)) == 0),
+		"mode %d: index of the buffer differs", supported_modes[imode]);
+
+	  /* A trailer that does not match its header breaks the index */
+	  word = buf[index[1].offset + index[1].length - 1];
+	  buf[index[1].offset + index[1].length - 1] = LSWAP(LSWAP(word) + 1);
+	  CHECK(fa125IndexBlocks(buf, nw, 1, NULL, 0) == ERROR,
+		"mode %d: bad trailer indexed", supported_modes[imode]);
+	  buf[index[1].offset + index[1].length - 1] = word;
+	}
+	nhit = checkStream(buf, nw, supported_modes[imode], !(imode & 1));
+	CHECK(nhit > 0, "mode %d: %d hits", supported_modes[imode], nhit);
+
+	/* The records of the decoder must match */
+	{
+	  FA125_DECODER dec;
+	  struct decode_count cnt;
+	  int mode = supported_modes[imode], longmode;
+
+	  memset(&cnt, 0, sizeof(cnt));
+	  cnt.nw = 61;
+	  longmode = (mode >= FA125_PROC_MODE_CDC_PULSESAMPLES);
+	  fa125DecodeInit(&dec);
+	  CHECK(fa125DecodeBuffer(&dec, buf, nw, 1, countRecord, &cnt) == nw,
+		"mode %d: decode stopped", mode);
+	  CHECK(fa125DecodeFlush(&dec, countRecord, &cnt) == OK, "mode %d: flush", mode);
+	  CHECK((dec.nerrors == 0) && (cnt.nbad == 0), "mode %d: %llu decode errors, %d bad records",
+		mode, dec.nerrors, cnt.nbad);
+	  CHECK((cnt.nrec[FA125_DECODE_BLOCK_HEADER] == NSLOTS) &&
+		(cnt.nrec[FA125_DECODE_BLOCK_TRAILER] == NSLOTS),
+		"mode %d: %d block headers, %d trailers", mode,
+		cnt.nrec[FA125_DECODE_BLOCK_HEADER], cnt.nrec[FA125_DECODE_BLOCK_TRAILER]);
+	  CHECK(cnt.nrec[FA125_DECODE_EVENT_HEADER] == NSLOTS * BLOCKLEVEL,
+		"mode %d: %d event headers", mode, cnt.nrec[FA125_DECODE_EVENT_HEADER]);
+	  CHECK(cnt.nrec[FA125_DECODE_TRIGGER_TIME] == ((imode & 1) ? 0 : NSLOTS * BLOCKLEVEL),
+		"mode %d: %d trigger times", mode, cnt.nrec[FA125_DECODE_TRIGGER_TIME]);
+	  CHECK(cnt.nrec[FA125_DECODE_PULSE_CDC] + cnt.nrec[FA125_DECODE_PULSE_FDC] +
+		cnt.nrec[FA125_DECODE_PULSE_FDC_AMP] == nhit, "mode %d: pulse records", mode);
+	  CHECK(cnt.nrec[FA125_DECODE_WINDOW_RAW] == (longmode ? nhit : 0),
+		"mode %d: %d raw windows", mode, cnt.nrec[FA125_DECODE_WINDOW_RAW]);
+	}
+
+	/* The word count model must bound the data, and be tight when every
+	   channel is hit (CDC modes report one peak) */
+	{
+	  int mode = supported_modes[imode], maxw, nwfull, cdcmode;
+
+	  cdcmode = (mode == FA125_PROC_MODE_CDC_INTEGRAL) ||
+	    (mode == FA125_PROC_MODE_CDC_PULSESAMPLES);
+	  maxw = fa125GMaxBlockWords();
+	  CHECK(nw <= maxw, "mode %d: %d words > model %d", mode, nw, maxw);
+
+	  fa125ResetToken(0);
+	  gen.cfg.occupancy = 1.0;
+	  fa125SimTrigger(0, BLOCKLEVEL);
+	  nwfull = fa125ReadBlock(fa125Slot(0), buf, BUFSIZE, 2);
+	  gen.cfg.occupancy = 0.25;
+	  CHECK((nwfull > 0) && (nwfull <= maxw), "mode %d: full occupancy %d words > model %d",
+		mode, nwfull, maxw);
+	  CHECK(!cdcmode || (maxw - nwfull <= NSLOTS),
+		"mode %d: full occupancy %d words, model %d", mode, nwfull, maxw);
+	}
+	printf("  %-24s %8d words %8d hits\n", fa125_modes[supported_modes[imode]], nw, nhit);
+      }
+
+    /* Channel disable masks and blocklevel enter the model */
+    {
+      FA125_WORD_MODEL model;
+      int full;
+
+      slot = fa125Slot(0);
+      fa125GetWordModel(slot, &model);
+      full = model.block_words;
+      fa125SetChannelDisableMask(slot, 0x3F, 0, 0);
+      fa125GetWordModel(slot, &model);
+      CHECK(model.nchan == 66, "model: %d channels enabled", model.nchan);
+      CHECK(full - model.block_words == 6 * BLOCKLEVEL * model.hit_words,
+	    "model: %d words with 6 channels disabled, %d enabled", model.block_words, full);
+      fa125SetChannelDisableMask(slot, 0, 0, 0);
+      fa125SetBlocklevel(slot, 1);
+      CHECK(fa125MaxBlockWords(slot) == 3 + model.event_words + 72 * model.hit_words,
+	    "model: %d words at blocklevel 1", fa125MaxBlockWords(slot));
+      fa125SetBlocklevel(slot, BLOCKLEVEL);
+      fa125PrintDataRate(20000., 0.1);
+    }
+
+    /* Chunked readout of long mode data, decoded chunk by chunk.  Raw
+       windows span chunks; the records must match those of the whole
+       buffer.  The last chunk size is the data in the modules (or half of
+       it), so that the data ends on a chunk boundary. */
+    {
+      int chunks[4] = {7, 64, 1000, 0};
+      struct chunk_decode cd;
+      struct decode_count whole;
+      FA125_DECODER dec;
+      int ichunk, nidx;
+
+      for(ifa = 0; ifa < nfa125; ifa++)
+	{
+	  slot = fa125Slot(ifa);
+	  fa125SetProcMode(slot, "CDC_long", 500, 61, 200, 4, 3, 4, 4);
+	  fa125Reset(slot, 0);
+	}
+      fa125ResetToken(0);
+
+      for(ichunk = 0; ichunk < 4; ichunk++)
+	{
+	  memset(&cd, 0, sizeof(cd));
+	  memset(&whole, 0, sizeof(whole));
+	  fa125DecodeInit(&cd.dec);
+	  cd.dec.chunked = 1;
+	  cd.cnt.nw = whole.nw = 61;
+
+	  fa125SimTrigger(0, BLOCKLEVEL);
+	  if(ichunk == 3)
+	    {
+	      /* Each block is padded to an even number of words */
+	      for(ifa = 0; ifa < nfa125; ifa++)
+		chunks[ichunk] += (fa125SimFifoWords(fa125Slot(ifa)) + 1) & ~1;
+	      if(chunks[ichunk] % 4 == 0)
+		chunks[ichunk] /= 2;
+	    }
+	  nw = fa125ReadBlockChunked(fa125Slot(0), buf + 1, BUFSIZE - 1, 2 | 0x40,
+				     chunks[ichunk], decodeChunk, &cd);
+	  fa125DecodeFlush(&cd.dec, countRecord, &cd.cnt);
+	  fa125ResetToken(0);
+
+	  CHECK(fa125ReadBlockStatus(1) == FA125_BLOCKERROR_NO_ERROR,
+		"chunk %d: block error", chunks[ichunk]);
+	  CHECK(checkBlocks(buf + 2, nw - 1, SIM_SLOTMASK) == NSLOTS,
+		"chunk %d: %d words, bad blocks", chunks[ichunk], nw);
+	  nidx = fa125ReadBlockIndex(NULL, 0);
+	  CHECK(nidx == NSLOTS, "chunk %d: %d blocks indexed", chunks[ichunk], nidx);
+	  CHECK((cd.nchunk >= (nw - 1) / (chunks[ichunk] & ~1)) &&
+		(cd.maxchunk <= (chunks[ichunk] & ~1) + 1),
+		"chunk %d: %d chunks, largest %d words", chunks[ichunk], cd.nchunk, cd.maxchunk);
+
+	  fa125DecodeInit(&dec);
+	  fa125DecodeBuffer(&dec, buf + 1, nw, 1, countRecord, &whole);
+	  fa125DecodeFlush(&dec, countRecord, &whole);
+	  CHECK((cd.cnt.nbad == 0) && (cd.dec.nerrors == 0) &&
+		(memcmp(&cd.cnt, &whole, sizeof(whole)) == 0),
+		"chunk %d: %d bad records, %d raw windows (whole buffer: %d)",
+		chunks[ichunk], cd.cnt.nbad, cd.cnt.nrec[FA125_DECODE_WINDOW_RAW],
+		whole.nrec[FA125_DECODE_WINDOW_RAW]);
+	  CHECK(cd.cnt.nrec[FA125_DECODE_WINDOW_RAW] == cd.cnt.nrec[FA125_DECODE_PULSE_CDC],
+		"chunk %d: %d raw windows, %d pulses", chunks[ichunk],
+		cd.cnt.nrec[FA125_DECODE_WINDOW_RAW], cd.cnt.nrec[FA125_DECODE_PULSE_CDC]);
+	  printf("  Chunked readout: %4d word chunks %8d words %6d chunks\n",
+		 chunks[ichunk], nw, cd.nchunk);
+	}
+    }
+
+    /* Index a buffer of more blocks than one scan of its markers holds */
+    {
+      FA125_BLOCK_INDEX index[128];
+      UINT32 *hbuf = (UINT32 *)buf;
+      int icrate, nidx, iblk, nbad = 0;
+
+      nw = 0;
+      gen.cfg.slotmask = 0x1FFFF8;
+      for(icrate = 0; icrate < 6; icrate++)
+	nw += fa125SimGenCrate(&gen, &hbuf[nw], BUFSIZE - nw);
+      gen.cfg.slotmask = SIM_SLOTMASK;
+
+      nidx = fa125IndexBlocks(hbuf, nw, 0, index, 128);
+      CHECK(nidx == 6 * 18, "%d blocks indexed in %d words", nidx, nw);
+      for(iblk = 1; (iblk < nidx) && (iblk < 128); iblk++)
+	if(index[iblk].offset < index[iblk - 1].offset + index[iblk - 1].length)
+	  nbad++;
+      CHECK(nbad == 0, "%d blocks overlap", nbad);
+    }
+
+    fa125SimSetBuilder(NULL, NULL);
+  }
+
+  /* Partial crate readout: a slow module is read without, tagged, and its
+     late block dropped on the next readout */
+  {
+    FA125_BLOCK_INDEX index[FA125_MAX_BOARDS+1];
+    unsigned int missing, late, missed, dropped;
+    int nidx, iblk, ndnv, iw;
+
+    for(ifa = 0; ifa < nfa125; ifa++)
+      fa125Reset(fa125Slot(ifa), 0);
+    fa125ResetToken(0);
+    fa125SetReadoutDeadline(2000);
+
+    fa125SimTrigger(0, BLOCKLEVEL);
+    nw = fa125ReadCrate(buf, BUFSIZE, &missing);
+    CHECK((missing == 0) && (fa125IndexBlocks(buf, nw, 1, NULL, 0) == NSLOTS),
+	  "crate: missing 0x%x, %d words", missing, nw);
+
+    /* Slot 5 does not become ready */
+    fa125SimSetReadyDelay(5, 1000000000);
+    fa125SimTrigger(0, BLOCKLEVEL);
+    t0 = now();
+    nw = fa125ReadCrate(buf, BUFSIZE, &missing);
+    t0 = now() - t0;
+    nidx = fa125IndexBlocks(buf, nw, 1, index, FA125_MAX_BOARDS+1);
+    for(ndnv = 0, iw = 0; iw < nw; iw++)
+      if(LSWAP(buf[iw]) == (FA125_DATA_TYPE_DEFINE | FA125_DATA_DNV | (5<<22)))
+	ndnv++;
+    CHECK((missing == (1<<5)) && (nidx == NSLOTS - 1) && (ndnv == 1),
+	  "partial: missing 0x%x, %d blocks, %d DNV", missing, nidx, ndnv);
+    CHECK(t0 >= 0.002, "partial: read after %.0f us", 1e6 * t0);
+    CHECK(fa125GetReadoutOwed() == (1<<5), "partial: owed 0x%x", fa125GetReadoutOwed());
+
+    /* Its late block arrives: dropped, and the crate is back in step */
+    fa125SimSetReadyDelay(5, 0);
+    fa125SimTrigger(0, BLOCKLEVEL);
+    nw = fa125ReadCrate(buf, BUFSIZE, &missing);
+    nidx = fa125IndexBlocks(buf, nw, 1, index, FA125_MAX_BOARDS+1);
+    CHECK((missing == 0) && (nidx == NSLOTS) && (fa125GetReadoutOwed() == 0),
+	  "recovered: missing 0x%x, %d blocks", missing, nidx);
+    for(iblk = 1; (iblk < nidx) && (iblk <= FA125_MAX_BOARDS); iblk++)
+      CHECK(index[iblk].blknum == index[0].blknum, "recovered: slot %d block %d != %d",
+	    index[iblk].slot, index[iblk].blknum, index[0].blknum);
+    fa125GetReadoutLateness(5, &late, &missed, &dropped);
+    CHECK((missed == 1) && (dropped == 1), "slot 5: %u missed, %u dropped", missed, dropped);
+
+    /* Slot 6 is ready after a few polls, within the deadline */
+    fa125SimSetReadyDelay(6, 20);
+    fa125SimTrigger(0, BLOCKLEVEL);
+    nw = fa125ReadCrate(buf, BUFSIZE, &missing);
+    fa125SimSetReadyDelay(6, 0);
+    fa125GetReadoutLateness(6, &late, &missed, &dropped);
+    CHECK((missing == 0) && (late == 1) && (missed == 0),
+	  "slot 6: missing 0x%x, %u late, %u missed", missing, late, missed);
+    fa125PrintReadoutLateness(1);
+
+    /* Time to ready: the late and missing slots are in the histogram */
+    {
+      unsigned int hist[FA125_READY_NBINS], timeouts, first, nhist;
+      int ibin;
+
+      fa125GetReadyHistogram(5, hist, &timeouts);
+      CHECK(timeouts == 1, "slot 5: %u timeouts", timeouts);
+      fa125GetReadyHistogram(6, hist, &timeouts);
+      for(nhist = 0, ibin = 1; ibin < FA125_READY_NBINS; ibin++)
+	nhist += hist[ibin];
+      CHECK((timeouts == 0) && (nhist >= 1), "slot 6: %u waits, %u timeouts", nhist, timeouts);
+      fa125PrintReadyHistogram(1);
+
+      /* A module that is never ready: back off instead of spinning */
+      fa125SetWaitSpin(2000);
+      fa125SimSetReadyDelay(5, 1000000000);
+      fa125SimTrigger(0, BLOCKLEVEL);
+      fa125SimResetStats();
+      t0 = now();
+      ready = fa125WaitBlockReady(SIM_SLOTMASK, 5000000LL, &first);
+      t0 = now() - t0;
+      fa125SimGetStats(&stats);
+      printf("  Wait for a dead module: %.1f ms, %d reads\n", 1e3 * t0, (int)stats.nread);
+      CHECK((ready == (SIM_SLOTMASK & ~(1<<5))) && (first == ready),
+	    "wait: ready 0x%x, first 0x%x", ready, first);
+      CHECK((t0 >= 0.005) && (t0 < 0.05), "wait: %.1f ms", 1e3 * t0);
+      CHECK(stats.nread < 1000, "wait: %d reads", (int)stats.nread);
+      fa125SimSetReadyDelay(5, 0);
+      fa125SetWaitSpin(0);
+      for(ifa = 0; ifa < nfa125; ifa++)
+	fa125Reset(fa125Slot(ifa), 0);
+      fa125ResetToken(0);
+      fa125PrintReadyHistogram(1);
+    }
+
+    /* The crate is not held while the readout waits for a slow module */
+    {
+      pthread_t thread;
+      volatile UINT32 *tbuf = malloc(BUFSIZE * sizeof(UINT32));
+      double towed;
+
+      fa125SetReadoutDeadline(50000);
+      fa125SimSetReadyDelay(5, 1000000000);
+      fa125SimTrigger(0, BLOCKLEVEL);
+      pthread_create(&thread, NULL, readCrateThread, (void *)tbuf);
+      usleep(10000);
+      t0 = now();
+      fa125GetReadoutOwed();
+      towed = now() - t0;
+      pthread_join(thread, NULL);
+      CHECK(crateMissing == (1<<5), "wait: missing 0x%x", crateMissing);
+      CHECK(towed < 0.005, "status waited %.1f ms for the readout", 1e3 * towed);
+
+      /* Catch up with the late block */
+      fa125SimSetReadyDelay(5, 0);
+      fa125SimTrigger(0, BLOCKLEVEL);
+      nw = fa125ReadCrate(buf, BUFSIZE, &missing);
+      CHECK((missing == 0) && (fa125GetReadoutOwed() == 0),
+	    "caught up: missing 0x%x, owed 0x%x", missing, fa125GetReadoutOwed());
+      fa125SetReadoutDeadline(2000);
+      fa125PrintReadoutLateness(1);
+      free((void *)tbuf);
+    }
+  }
+
+  /* Readout counters: single board DMA of each module, then indexed
+     multiblock DMA, then a programmed I/O read without data */
+  {
+    FA125_READOUT_STATS st;
+    FA125_BLOCK_INDEX index[FA125_MAX_BOARDS+1];
+    int dmawords[FA125_MAX_BOARDS+1], nidx, iblk, id;
+
+    for(ifa = 0; ifa < nfa125; ifa++)
+      fa125GetReadoutStats(fa125Slot(ifa), &st, 1);
+
+    fa125SimTrigger(0, BLOCKLEVEL);
+    while(fa125GBready() != SIM_SLOTMASK)
+      ;
+    for(ifa = 0; ifa < nfa125; ifa++)
+      dmawords[fa125Slot(ifa)] = fa125ReadBlock(fa125Slot(ifa), buf, BUFSIZE, 1);
+    fa125ResetToken(0);
+
+    fa125SimTrigger(0, BLOCKLEVEL);
+    while(fa125GBready() != SIM_SLOTMASK)
+      ;
+    nw = fa125ReadBlock(fa125Slot(0), buf, BUFSIZE, 0x42);
+    fa125ResetToken(0);
+    nidx = fa125ReadBlockIndex(index, FA125_MAX_BOARDS+1);
+    CHECK(nidx == NSLOTS, "stats: %d blocks indexed in %d words", nidx, nw);
+    nw = fa125ReadBlock(4, buf, BUFSIZE, 0);
+    CHECK(nw == 0, "stats: programmed I/O without data returned %d", nw);
+
+    for(iblk = 0; iblk < nidx; iblk++)
+      {
+	id = index[iblk].slot;
+	fa125GetReadoutStats(id, &st, 0);
+	CHECK((st.blocks == 2) && (st.words == dmawords[id] + index[iblk].length),
+	      "stats: slot %d: %llu blocks, %llu words (%d + %d)", id, st.blocks, st.words,
+	      dmawords[id], index[iblk].length);
+	CHECK((st.ndma == ((id == fa125Slot(0)) ? 2 : 1)) && (st.berr == st.ndma) &&
+	      (st.unknown_berr == 0) && (st.zero_count == 0) && (st.dma_ns > 0),
+	      "stats: slot %d: %llu DMAs, %llu BERR, %llu unknown, %llu zero count",
+	      id, st.ndma, st.berr, st.unknown_berr, st.zero_count);
+	CHECK((st.bready_polls >= 2) && (st.bready >= 2) && (st.bready <= st.bready_polls),
+	      "stats: slot %d: %llu of %llu polls ready", id, st.bready, st.bready_polls);
+	CHECK(st.fifo_empty == (id == 4), "stats: slot %d: %llu FIFO empty", id, st.fifo_empty);
+      }
+    fa125PrintReadoutStats(1);
+    fa125GetReadoutStats(fa125Slot(0), &st, 0);
+    CHECK((st.blocks == 0) && (st.bready_polls == 0), "stats: not cleared");
+  }
+
+  /* Readout trace: spans of one readout, exported as a Chrome trace */
+  {
+    static const char *names[] = {"Bready", "vmeDmaSend", "vmeDmaDone", "ResetToken"};
+    char tracefile[] = "/tmp/fa125SimTraceXXXXXX", line[512];
+    int fd, nev, nbegin = 0, nend = 0, nfound[4] = {0, 0, 0, 0}, iname, ipt;
+    FILE *f;
+
+    fa125TraceClear();
+    fa125SimTrigger(0, BLOCKLEVEL);
+    while(fa125GBready() != SIM_SLOTMASK)
+      ;
+    nw = fa125ReadBlock(fa125Slot(0), buf, BUFSIZE, 2);
+    fa125ResetToken(0);
+
+    fd = mkstemp(tracefile);
+    close(fd);
+    nev = fa125TraceExport(tracefile);
+    f = fopen(tracefile, "r");
+    while(f && fgets(line, sizeof(line), f))
+      {
+	nbegin += (strstr(line, "\"ph\":\"B\"") != NULL);
+	nend   += (strstr(line, "\"ph\":\"E\"") != NULL);
+	for(iname = 0; iname < 4; iname++)
+	  {
+	    if(strstr(line, names[iname]))
+	      nfound[iname]++;
+	  }
+      }
+    if(f)
+      fclose(f);
+    unlink(tracefile);
+    CHECK((nev == nbegin + nend) && (nbegin == nend) && (nev >= 8),
+	  "trace: %d events, %d begin, %d end", nev, nbegin, nend);
+    for(iname = 0; iname < 4; iname++)
+      CHECK(nfound[iname] >= 2, "trace: %d %s events", nfound[iname], names[iname]);
+
+    t0 = now();
+    for(ipt = 0; ipt < 100000; ipt++)
+      fa125TracePoint(FA125_TRACE_BANK, (ipt & 1) ? 'E' : 'B', ipt);
+    t0 = now() - t0;
+    printf("  Trace: %d events of one readout, %.1f ns per tracepoint\n", nev, 1e4 * t0);
+    fa125TraceClear();
+  }
+
+  /* Raw window sample kernels must agree with the scalar kernel */
+  {
+    static const char *kname[4] = {"auto", "scalar", "SSSE3", "AVX2"};
+    static short adc[4][FA125_MAX_NW+16], ref[FA125_MAX_NW+16];
+    static UINT32 valid[(FA125_MAX_NW+31)/32], refvalid[(FA125_MAX_NW+31)/32];
+    static UINT32 words[FA125_MAX_NW];
+    int best, kernel, ns, off, swap, is, nrep;
+    unsigned int rng = 12345;
+
+    for(is = 0; is < FA125_MAX_NW; is++)
+      {
+	rng = rng * 1103515245 + 12345;
+	words[is] = rng & 0x3FFF3FFF;
+      }
+
+    best = fa125GetUnpackKernel();
+    for(kernel = FA125_UNPACK_SSSE3; kernel <= best; kernel++)
+      {
+	fa125SetUnpackKernel(kernel);
+	for(ns = 1; ns <= FA125_MAX_NW; ns += (ns < 70) ? 1 : 97)
+	  for(off = 0; off < 4; off++)
+	    for(swap = 0; swap < 2; swap++)
+	      {
+		fa125SetUnpackKernel(FA125_UNPACK_SCALAR);
+		fa125UnpackSamples(&words[off], ns, swap, ref, refvalid);
+		fa125SetUnpackKernel(kernel);
+		fa125UnpackSamples(&words[off], ns, swap, &adc[kernel][off], valid);
+		CHECK((memcmp(ref, &adc[kernel][off], ns * sizeof(short)) == 0) &&
+		      (memcmp(refvalid, valid, ((ns + 31) / 32) * sizeof(UINT32)) == 0),
+		      "%s: %d samples at offset %d (swap %d) differ",
+		      kname[kernel], ns, off, swap);
+	      }
+      }
+
+    /* Throughput of a 1024 sample window */
+    nrep = 20000;
+    for(kernel = FA125_UNPACK_SCALAR; kernel <= best; kernel++)
+      {
+	fa125SetUnpackKernel(kernel);
+	t0 = now();
+	for(iloop = 0; iloop < nrep; iloop++)
+	  fa125UnpackSamples(words, FA125_MAX_NW, 1, adc[kernel], valid);
+	printf("  %-24s %8.2f ns/sample\n", kname[kernel],
+	       1e9 * (now() - t0) / nrep / FA125_MAX_NW);
+      }
+    fa125SetUnpackKernel(FA125_UNPACK_AUTO);
+  }
+
+  /* Swap and scan kernels must agree with the scalar kernel */
+  {
+    static const char *kname[4] = {"auto", "scalar", "SSSE3", "AVX2"};
+    static UINT32 src[0x4000], ref[0x4000], dst[0x4000];
+    static int refmarks[0x1000], marks[0x1000];
+    int best, kernel, n, off, swap, mode, nref, nmark, iw, nrep;
+    unsigned int rng = 54321;
+
+    for(iw = 0; iw < 0x4000; iw++)
+      {
+	rng = rng * 1103515245 + 12345;
+	src[iw] = rng;
+	if((rng & 0xF) == 0)
+	  src[iw] = LSWAP(0x80000000 | (rng & 0x0FFFFFF0) | ((rng >> 4) & 1) << 27);
+      }
+
+    best = fa125GetUnpackKernel();
+    for(kernel = FA125_UNPACK_SSSE3; kernel <= best; kernel++)
+      for(n = 0; n < 200; n += (n < 40) ? 1 : 13)
+	for(off = 0; off < 4; off++)
+	  for(swap = 0; swap < 2; swap++)
+	    for(mode = 0; mode < 3; mode++)
+	      { /* mode 0: scan only, 1: copy, 2: in place */
+		fa125SetUnpackKernel(FA125_UNPACK_SCALAR);
+		nref = fa125SwapScan(&src[off], ref, n, swap, refmarks, 20);
+		fa125SetUnpackKernel(kernel);
+		if(mode == 2)
+		  {
+		    memcpy(dst, &src[off], n * sizeof(UINT32));
+		    nmark = fa125SwapScan(dst, dst, n, swap, marks, 20);
+		  }
+		else
+		  nmark = fa125SwapScan(&src[off], (mode == 1) ? dst : NULL, n, swap, marks, 20);
+		CHECK((nmark == nref) &&
+		      (memcmp(marks, refmarks, ((nref < 20) ? nref : 20) * sizeof(int)) == 0) &&
+		      ((mode == 0) || (memcmp(dst, ref, n * sizeof(UINT32)) == 0)),
+		      "%s: swap scan of %d words at offset %d (swap %d, mode %d) differs",
+		      kname[kernel], n, off, swap, mode);
+	      }
+
+    /* Throughput on a 64 kB buffer: swap then scan, and fused */
+    nrep = 2000;
+    fa125SetUnpackKernel(FA125_UNPACK_AUTO);
+    t0 = now();
+    for(iloop = 0; iloop < nrep; iloop++)
+      {
+	for(iw = 0; iw < 0x4000; iw++)
+	  dst[iw] = LSWAP(src[iw]);
+	nmark = 0;
+	for(iw = 0; iw < 0x4000; iw++)
+	  if((dst[iw] & 0xF0000000) == 0x80000000)
+	    marks[nmark++] = iw;
+      }
+    printf("  %-24s %8.3f ns/word\n", "swap, then scan", 1e9 * (now() - t0) / nrep / 0x4000);
+    for(kernel = FA125_UNPACK_SCALAR; kernel <= best; kernel++)
+      {
+	fa125SetUnpackKernel(kernel);
+	t0 = now();
+	for(iloop = 0; iloop < nrep; iloop++)
+	  fa125SwapScan(src, dst, 0x4000, 1, marks, 0x1000);
+	printf("  fused %-18s %8.3f ns/word\n", kname[kernel], 1e9 * (now() - t0) / nrep / 0x4000);
+      }
+    fa125SetUnpackKernel(FA125_UNPACK_AUTO);
+  }
+
+  /* Whole board configuration */
+  {
+    FADC125_CONF conf;
+    int lo, hi;
+
+    memset(&conf, 0, sizeof(conf));
+    conf.mode = FA125_PROC_MODE_FDC_AMPSAMPLES;
+    conf.winOffset = 100; conf.winWidth = 50; conf.npeak = 1;
+    conf.IE = 80; conf.PG = 4; conf.P1 = 4; conf.P2 = 4;
+    conf.TH = 40; conf.TL = 25;
+    conf.IBIT = 4; conf.ABIT = 3; conf.PBIT = 0;
+    conf.ch_disable[0] = 0x1; conf.ch_disable[2] = 0x800000;
+    conf.busy = 3; conf.data_format = 1;
+    for(ichan = 0; ichan < 72; ichan++)
+      {
+	conf.dac[ichan] = 32000 + ichan;
+	conf.read_thr[ichan] = 50 + ichan;
+      }
+
+    CHECK(fa125ConfigApply(4, &conf) == OK, "fa125ConfigApply");
+    for(ichan = 0; ichan < 72; ichan++)
+      {
+	CHECK(fa125GetThreshold(4, ichan) == 50 + ichan, "conf: chan %d threshold %d",
+	      ichan, fa125GetThreshold(4, ichan));
+	fa125GetTimingThreshold(4, ichan, &lo, &hi);
+	CHECK((lo == 25) && (hi == 40), "conf: chan %d timing threshold %d/%d", ichan, lo, hi);
+	CHECK(fa125ReadOffset(4, ichan) == 32000 + ichan, "conf: chan %d offset %d",
+	      ichan, fa125ReadOffset(4, ichan));
+      }
+    CHECK(fa125SimGetDac(4, 34) == 32000, "conf: dac 34 = %d", fa125SimGetDac(4, 34));
+    CHECK(fa125GetIntegrationScaleFactor(4) == 4, "conf: IBIT");
+    CHECK(fa125GetAmplitudeScaleFactor(4) == 3, "conf: ABIT");
+    CHECK(fa125GetNTrigBusy(4) == 3, "conf: busy %d", fa125GetNTrigBusy(4));
+
+    /* Applying it again only reprograms the DACs */
+    fa125SimResetStats();
+    CHECK(fa125ConfigApply(4, &conf) == OK, "fa125ConfigApply again");
+    fa125SimGetStats(&stats);
+    printf("  Config apply again: %d reads, %d writes\n",
+	   (int)stats.nread, (int)stats.nwrite);
+    CHECK(stats.nwrite == 8 * (5 * 32 * 2 + 1), "conf: %d writes", (int)stats.nwrite);
+
+    /* Nothing is written if anything is out of range */
+    conf.PBIT = 4;
+    fa125SimResetStats();
+    CHECK(fa125ConfigApply(4, &conf) == ERROR, "conf: P2 + PBIT > 7 accepted");
+    fa125SimGetStats(&stats);
+    CHECK(stats.nwrite == 0, "conf: %d writes with invalid PBIT", (int)stats.nwrite);
+    conf.PBIT = 0;
+
+    /* Both check the window the same way: NW > 2^P1 + NE */
+    CHECK(fa125SetProcMode(4, (char *)fa125_modes[conf.mode], 100, 36, 80, 4, 1, 4, 4) == ERROR,
+	  "procmode: NW 36 with P1 4 accepted");
+    CHECK(fa125SetProcMode(4, (char *)fa125_modes[conf.mode], 100, 37, 80, 4, 1, 4, 4) == OK,
+	  "procmode: NW 37 with P1 4 refused");
+    conf.winWidth = 36;
+    CHECK(fa125ConfigApply(4, &conf) == ERROR, "conf: NW 36 with P1 4 accepted");
+    conf.winWidth = 37;
+    CHECK(fa125ConfigApply(4, &conf) == OK, "conf: NW 37 with P1 4 refused");
+    conf.winWidth = 50;
+
+    /* Processing is held off while only the window changes */
+    {
+      static FA125_SIM_WRITE wlog[4096];
+      int nlog, iw, ioff = -1, inw = -1, ion = -1;
+
+      fa125SimRecordWrites(4, wlog, 4096);
+      CHECK(fa125ConfigApply(4, &conf) == OK, "conf: NW 50");
+      nlog = fa125SimRecordWrites(0, NULL, 0);
+      for(iw = 0; (iw < nlog) && (iw < 4096); iw++)
+	{
+	  if(wlog[iw].offset == offsetof(struct fa125_a24, fe[0].nw))
+	    inw = iw;
+	  else if(wlog[iw].offset == offsetof(struct fa125_a24, fe[0].config1))
+	    {
+	      if(wlog[iw].val & FA125_FE_CONFIG1_ENABLE)
+		ion = iw;
+	      else if(ioff < 0)
+		ioff = iw;
+	    }
+	}
+      CHECK((ioff >= 0) && (ioff < inw) && (inw < ion),
+	    "conf: NW written at %d, processing off at %d and on at %d", inw, ioff, ion);
+    }
+
+    /* Deferred scale factors are checked against the firmware by the flush */
+    fa125ShadowDefer(4, 1);
+    CHECK(fa125SetScaleFactors(4, 2, 2, -1) == OK, "deferred scale factors");
+    CHECK(fa125GetIntegrationScaleFactor(4) == 4, "deferred scale factors written");
+    nw = fa125ShadowFlush(4);
+    /* ped_sf, between processing off and on */
+    CHECK(nw == 3, "scale factor flush returned %d", nw);
+    CHECK(fa125GetIntegrationScaleFactor(4) == 2, "flushed IBIT %d",
+	  fa125GetIntegrationScaleFactor(4));
+    fa125ShadowDefer(4, 0);
+
+    /* Crate configuration, one module at a time and in parallel */
+    {
+      double tseq, tpar, tslot;
+      int step;
+
+      fa125ConfigQueueClear();
+      for(ifa = 0; ifa < nfa125; ifa++)
+	fa125ConfigQueue(fa125Slot(ifa), configStep, &conf);
+
+      t0 = now();
+      CHECK(fa125ConfigRun(1) == OK, "sequential configuration");
+      tseq = now() - t0;
+
+      t0 = now();
+      CHECK(fa125ConfigRun(0) == OK, "parallel configuration");
+      tpar = now() - t0;
+
+      printf("  Crate configuration: %.1f ms sequential, %.1f ms parallel\n",
+	     1e3 * tseq, 1e3 * tpar);
+      CHECK(tpar < 0.6 * tseq, "parallel configuration took %.1f ms", 1e3 * tpar);
+
+      for(ifa = 0; ifa < nfa125; ifa++)
+	{
+	  CHECK(fa125ConfigResult(fa125Slot(ifa), &step, &tslot) == OK,
+		"slot %d configuration failed at step %d", fa125Slot(ifa), step);
+	  CHECK(tslot >= 0.02, "slot %d configuration took %.1f ms",
+		fa125Slot(ifa), 1e3 * tslot);
+	}
+
+      /* A failing step stops that module only */
+      fa125ConfigQueue(5, failStep, NULL);
+      fa125ConfigQueue(5, configStep, &conf);
+      CHECK(fa125ConfigRun(0) == ERROR, "failed step not reported");
+      CHECK((fa125ConfigResult(5, &step, NULL) == ERROR) && (step == 1),
+	    "slot 5 failed at step %d", step);
+      CHECK(fa125ConfigResult(6, &step, NULL) == OK, "slot 6 failed at step %d", step);
+      fa125ConfigPrintResults();
+      fa125ConfigQueueClear();
+    }
+
+    /* Readout of one module does not wait for the configuration of another,
+       and status of the module does not wait for its configuration steps */
+    {
+      pthread_t thread;
+      double tread, tstat;
+
+      fa125ConfigQueue(6, holdStep, NULL);
+      pthread_create(&thread, NULL, configThread, NULL);
+      usleep(20000);
+
+      fa125SimTrigger(1<<3, BLOCKLEVEL);
+      t0 = now();
+      while(fa125Bready(3) == 0)
+	;
+      nw = fa125ReadBlock(3, buf, BUFSIZE, 1);
+      fa125ResetToken(0);
+      tread = now() - t0;
+
+      t0 = now();
+      fa125GetNTrigBusy(6);
+      tstat = now() - t0;
+
+      pthread_join(thread, NULL);
+      fa125ConfigQueueClear();
+
+      printf("  Readout during configuration: %.3f ms\n", 1e3 * tread);
+      CHECK(nw > 0, "readout during configuration returned %d", nw);
+      CHECK(tread < 0.1, "readout waited %.1f ms for configuration", 1e3 * tread);
+      CHECK(tstat < 0.1, "status waited %.1f ms for configuration", 1e3 * tstat);
+    }
+  }
+
+  /* Deferred log: rate limit, and no message lost without being counted */
+  {
+    static const char quiet[] = "";
+    unsigned long long written, dropped, suppressed, w0, d0, s0;
+    double tlog;
+    int imsg, nmsg = 100000;
+
+    fa125LogGetStats(&w0, &d0, &s0);
+    fa125LogSetRateLimit(10);
+    fa125LogStart();
+    t0 = now();
+    for(imsg = 0; imsg < nmsg; imsg++)
+      FA125LOGMSG("  Log test message %d of %s\n", imsg, "the rate limit", 0, 0, 0, 0);
+    tlog = now() - t0;
+    fa125LogStop();
+    fa125LogGetStats(&written, &dropped, &suppressed);
+    printf("  Log: %.0f ns per message, %llu written, %llu suppressed\n",
+	   1e9 * tlog / nmsg, written - w0, suppressed - s0);
+    CHECK((written - w0 >= 10) && (written - w0 <= 10 * (1 + (int)tlog + 1)),
+	  "log: %llu messages written", written - w0);
+    CHECK(written - w0 + dropped - d0 + suppressed - s0 == nmsg,
+	  "log: %llu written, %llu dropped, %llu suppressed of %d",
+	  written - w0, dropped - d0, suppressed - s0, nmsg);
+
+    fa125LogSetRateLimit(0);
+    fa125LogStart();
+    for(imsg = 0; imsg < nmsg; imsg++)
+      FA125LOGMSG(quiet, 0, 0, 0, 0, 0, 0);
+    fa125LogStop();
+    fa125LogGetStats(&w0, &d0, &s0);
+    printf("  Log: %llu written, %llu dropped without rate limit\n",
+	   w0 - written, d0 - dropped);
+    CHECK((w0 - written + d0 - dropped == nmsg) && (s0 == suppressed),
+	  "log: %llu written, %llu dropped, %llu suppressed of %d",
+	  w0 - written, d0 - dropped, s0 - suppressed, nmsg);
+    fa125LogSetRateLimit(10);
+
+    /* Each argument is written at the width of its conversion */
+    {
+      static const char fmt[] = "%d %x 0x%08x %s%%\n";
+      char line[128] = "";
+      FILE *tmp = tmpfile();
+      int fd = dup(fileno(stdout));
+
+      fflush(stdout);
+      dup2(fileno(tmp), fileno(stdout));
+      FA125LOGMSG(fmt, -5, 0xbeef, 0x12, "done", 0, 0);
+      fflush(stdout);
+      dup2(fd, fileno(stdout));
+      close(fd);
+      rewind(tmp);
+      if(fgets(line, sizeof(line), tmp) == NULL)
+	line[0] = '\0';
+      fclose(tmp);
+      CHECK(strcmp(line, "-5 beef 0x00000012 done%\n") == 0, "log: wrote \"%s\"", line);
+    }
+  }
+
+  fa125SimGetStats(&stats);
+  printf("\n  VME: %llu reads, %llu writes, %llu probes, %llu DMAs (%llu bytes, %llu BERR)\n",
+	 stats.nread, stats.nwrite, stats.nprobe, stats.ndma, stats.dma_bytes, stats.nberr);
+
+  free((void *)buf);
+  fa125SimCleanup();
+
+  printf("\n%s: %d error(s)\n", nerror ? "FAILED" : "PASSED", nerror);
+
+  return (nerror != 0);
+}
@@ -0,0 +1,73 @@
+/*----------------------------------------------------------------------------*
+ *  Copyright (c) 2010        Southeastern Universities Research Association, *
+ *                            Thomas Jefferson National Accelerator Facility  *
+ *                                                                            *
+ *    This software was developed under a United States Government license    *
+ *    described in the NOTICE file included as part of this distribution.     *
+ *                                                                            *
+ *    Authors: Bryan Moffit                                                   *
+ *             moffit@jlab.org                   Jefferson Lab, MS-12B3       *
+ *             Phone: (757) 269-5660             12000 Jefferson Ave.         *
+ *             Fax:   (757) 269-5800             Newport News, VA 23606       *
+ *                                                                            *
+ * __DATE__:
+ *                                                                            *
+ *----------------------------------------------------------------------------*
+ *
+ * Description:
+ *     Stand-in for the jvme library header, used when building fa125Lib
+ *     against the software crate model (fa125Sim.c) on a plain Linux box.
+ *     Only the subset of jvme used by fa125Lib and the readout lists is
+ *     provided.
+ *
+ *----------------------------------------------------------------------------*/
+
+#ifndef __JVME_SIM__
+#define __JVME_SIM__
+
+#include <stdint.h>
+
+#ifndef OK
+#define OK 0
+#endif
+#ifndef ERROR
+#define ERROR -1
+#endif
+
+typedef unsigned int   UINT32;
+typedef unsigned short UINT16;
+typedef unsigned char  UINT8;
+typedef int            STATUS;
+typedef int            BOOL;
+
+#ifndef TRUE
+#define TRUE  1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef LSWAP
+#define LSWAP(x)        ((((x) & 0x000000ff) << 24) | \
+                         (((x) & 0x0000ff00) <<  8) | \
+                         (((x) & 0x00ff0000) >>  8) | \
+                         (((x) & 0xff000000) >> 24))
+#endif
+
+int  vmeOpenDefaultWindows();
+int  vmeCloseDefaultWindows();
+int  vmeBusToLocalAdrs(int vmeAdrsSpace, char *vmeBusAdrs, char **pPciAdrs);
+int  vmeMemProbe(char *addr, int size, char *rval);
+int  vmeClearException(int pflag);
+
+unsigned int vmeRead32(volatile unsigned int *addr);
+void vmeWrite32(volatile unsigned int *addr, unsigned int val);
+
+int  vmeDmaConfig(unsigned int addrType, unsigned int dataType, unsigned int sstMode);
+int  vmeDmaSend(unsigned long locAdrs, unsigned int vmeAdrs, int size);
+int  vmeDmaDone();
+
+int  logMsg(const char *format, ...);
+int  taskDelay(int ticks);
+
+#endif /* __JVME_SIM__ */
@@ -0,0 +1,352 @@
+/*
+ * File:
+ *    fa125ReadoutBench.c
+ *
+ * Description:
+ *    Readout throughput benchmark.  Drives fa125ReadBlock in each readout
+ *    mode against the software crate model (../sim), so it runs without VME
+ *    hardware and gives the same data on every run:
+ *
+ *      pio    programmed I/O of each board        (rflag 0)
+ *      dma    DMA of each board                    (rflag 1)
+ *      mblk   multiblock DMA of the crate          (rflag 2)
+ *      async  fa125ReadBlockStart/Complete          (rflag 2, 1 for one board)
+ *
+ *    over the processing modes, numbers of boards, blocklevels and
+ *    occupancies (hence block sizes) given.  One CSV line per setting is
+ *    written to stdout; library messages go to stderr.  Latency is from
+ *    the trigger to the end of the readout of the crate (block ready poll,
+ *    transfers and token reset), in wall time.  sim_bus_us_per_block is the
+ *    VME bus time the crate model charges for it (see fa125SimSetTiming).
+ *
+ *    Build with "make bench".
+ *
+ *    Usage:
+ *      fa125ReadoutBench [options] > results.csv
+ *        -r <list>   readout modes (pio,dma,mblk,async)      [all]
+ *        -m <list>   processing modes (3-8)                  [3,6]
+ *        -n <list>   boards in the crate (1-16)              [1,4,16]
+ *        -b <list>   blocklevels                             [1,10]
+ *        -o <list>   occupancies                             [0.05,0.25]
+ *        -N <nread>  readouts per setting                    [1000]
+ *        -W <words>  stop a setting after this many words    [8000000]
+ *        -c <ns>     single cycle VME access time            [0]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "jvme.h"
+#include "fa125Lib.h"
+#include "fa125Sim.h"
+#include "fa125SimGen.h"
+
+#define BUFWORDS   0x800000
+#define MAXLIST    16
+#define NWARM      10
+#define MINREAD    100
+
+enum {READ_PIO, READ_DMA, READ_MBLK, READ_ASYNC, READ_NTYPES};
+
+static const char *readName[READ_NTYPES] = {"pio", "dma", "mblk", "async"};
+
+static const unsigned int crateSlots[16] =
+  {3, 4, 5, 6, 7, 8, 9, 10, 13, 14, 15, 16, 17, 18, 19, 20};
+
+extern int nfa125;
+
+static FILE *csv = NULL;
+
+static long long
+nsec()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int
+cmpLong(const void *a, const void *b)
+{
+  long long la = *(const long long *)a, lb = *(const long long *)b;
+  return (la > lb) - (la < lb);
+}
+
+/* Comma separated list of numbers.  Returns the number of entries. */
+static int
+parseList(const char *arg, double *list)
+{
+  char *copy = strdup(arg), *tok, *save = NULL;
+  int n = 0;
+
+  for(tok = strtok_r(copy, ",", &save); tok && (n < MAXLIST);
+      tok = strtok_r(NULL, ",", &save))
+    list[n++] = atof(tok);
+
+  free(copy);
+  return n;
+}
+
+static int
+parseReadList(const char *arg, int *list)
+{
+  char *copy = strdup(arg), *tok, *save = NULL;
+  int n = 0, itype;
+
+  for(tok = strtok_r(copy, ",", &save); tok && (n < READ_NTYPES);
+      tok = strtok_r(NULL, ",", &save))
+    {
+      for(itype = 0; itype < READ_NTYPES; itype++)
+	if(strcmp(tok, readName[itype]) == 0)
+	  break;
+      if(itype == READ_NTYPES)
+	{
+	  fprintf(stderr, "Unknown readout mode %s\n", tok);
+	  n = -1;
+	  break;
+	}
+      list[n++] = itype;
+    }
+
+  free(copy);
+  return n;
+}
+
+/* Crate of the first nboards slots.  Returns OK or ERROR. */
+static int
+setupCrate(int nboards)
+{
+  unsigned int slotmask = 0;
+  int ifa;
+
+  for(ifa = 0; ifa < nboards; ifa++)
+    slotmask |= 1 << crateSlots[ifa];
+
+  fa125SimCleanup();
+  if(fa125SimAddBoards(slotmask) != nboards)
+    return ERROR;
+
+  if(fa125Init(0, 0, 0, (1<<4)) != OK)
+    return ERROR;
+
+  return (nfa125 == nboards) ? OK : ERROR;
+}
+
+/* Processing mode and blocklevel of every board, data from gen */
+static void
+setupBoards(FA125_SIM_GEN *gen, const FA125_SIM_GEN_CONFIG *cfg)
+{
+  int ifa, slot;
+
+  for(ifa = 0; ifa < nfa125; ifa++)
+    {
+      slot = fa125Slot(ifa);
+      fa125SetProcMode(slot, (char *)fa125_modes[cfg->mode],
+		       FA125_DEFAULT_PL, cfg->nw, FA125_DEFAULT_IE, FA125_DEFAULT_PG,
+		       cfg->npk, FA125_DEFAULT_P1, FA125_DEFAULT_P2);
+      fa125SetBlocklevel(slot, cfg->blocklevel);
+      fa125Reset(slot, 0);
+      fa125Enable(slot);
+    }
+  fa125ResetToken(0);
+
+  fa125SimSetBuilder(fa125SimGenBuilder, gen);
+}
+
+/* One readout of a block from every board.  Returns the number of words,
+   or ERROR. */
+static int
+readCrate(int type, volatile UINT32 *buf)
+{
+  unsigned int scanmask = fa125ScanMask();
+  int ifa, nw, total = 0, first = fa125Slot(0);
+
+  if(fa125GBlockReady(scanmask, 1000) != scanmask)
+    return ERROR;
+
+  switch(type)
+    {
+    case READ_PIO:
+    case READ_DMA:
+      for(ifa = 0; ifa < nfa125; ifa++)
+	{
+	  nw = fa125ReadBlock(fa125Slot(ifa), &buf[total], BUFWORDS - total,
+			      (type == READ_PIO) ? 0 : 1);
+	  if(nw <= 0)
+	    return ERROR;
+	  total += nw;
+	}
+      break;
+
+    case READ_MBLK:
+      total = fa125ReadBlock(first, buf, BUFWORDS, 2);
+      fa125ResetToken(first);
+      break;
+
+    case READ_ASYNC:
+      if(fa125ReadBlockStart(first, buf, BUFWORDS, (nfa125 > 1) ? 2 : 1) != OK)
+	return ERROR;
+      total = fa125ReadBlockComplete(1000);
+      if(nfa125 > 1)
+	fa125ResetToken(first);
+      break;
+    }
+
+  return total;
+}
+
+/* Time the readouts of one setting and write its CSV line */
+static int
+bench(int type, const FA125_SIM_GEN_CONFIG *cfg, volatile UINT32 *buf,
+      long long *lat, int nread, long long maxwords)
+{
+  FA125_SIM_STATS stats;
+  long long t0, t1, total = 0, elapsed = 0;
+  int iread, nw, nblk;
+
+  for(iread = 0; iread < NWARM; iread++)
+    {
+      fa125SimTrigger(0, cfg->blocklevel);
+      if(readCrate(type, buf) <= 0)
+	return ERROR;
+    }
+
+  fa125SimResetStats();
+  for(iread = 0; iread < nread; iread++)
+    {
+      if((iread >= MINREAD) && (total >= maxwords))
+	break;
+
+      fa125SimTrigger(0, cfg->blocklevel);
+      t0 = nsec();
+      nw = readCrate(type, buf);
+      t1 = nsec();
+      if(nw <= 0)
+	return ERROR;
+
+      lat[iread] = t1 - t0;
+      elapsed += t1 - t0;
+      total += nw;
+    }
+  fa125SimGetStats(&stats);
+
+  nread = iread;
+  nblk  = nread * nfa125;
+  qsort(lat, nread, sizeof(long long), cmpLong);
+
+  fprintf(csv, "%s,%s,%d,%d,%.3f,%.1f,%d,%.0f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+	 readName[type], fa125_modes[cfg->mode], nfa125, cfg->blocklevel,
+	 cfg->occupancy, (double)total / nblk, nread,
+	 1e9 * total / elapsed, 1e-3 * elapsed / nblk,
+	 1e-3 * lat[nread / 2], 1e-3 * lat[(nread * 99) / 100],
+	 1e-3 * lat[(nread * 999) / 1000], 1e-3 * stats.bus_ns / nblk);
+  fflush(csv);
+
+  return OK;
+}
+
+int
+main(int argc, char *argv[])
+{
+  FA125_SIM_GEN_CONFIG cfg;
+  FA125_SIM_GEN gen;
+  volatile UINT32 *buf;
+  long long *lat, maxwords = 8000000;
+  double modes[MAXLIST] = {3, 6}, boards[MAXLIST] = {1, 4, 16};
+  double blocklevels[MAXLIST] = {1, 10}, occupancies[MAXLIST] = {0.05, 0.25};
+  int types[READ_NTYPES] = {READ_PIO, READ_DMA, READ_MBLK, READ_ASYNC};
+  int ntypes = READ_NTYPES, nmodes = 2, nboards = 3, nbl = 2, nocc = 2;
+  int opt, nread = 1000, cycle = 0, rval = OK;
+  int ib, im, il, io, it;
+
+  while((opt = getopt(argc, argv, "r:m:n:b:o:N:W:c:")) != -1)
+    {
+      switch(opt)
+	{
+	case 'r': ntypes   = parseReadList(optarg, types); break;
+	case 'm': nmodes   = parseList(optarg, modes); break;
+	case 'n': nboards  = parseList(optarg, boards); break;
+	case 'b': nbl      = parseList(optarg, blocklevels); break;
+	case 'o': nocc     = parseList(optarg, occupancies); break;
+	case 'N': nread    = strtol(optarg, NULL, 0); break;
+	case 'W': maxwords = strtoll(optarg, NULL, 0); break;
+	case 'c': cycle    = strtol(optarg, NULL, 0); break;
+	default:
+	  ntypes = -1;
+	}
+    }
+
+  if((ntypes <= 0) || (nmodes <= 0) || (nboards <= 0) || (nbl <= 0) ||
+     (nocc <= 0) || (nread < 1))
+    {
+      fprintf(stderr,
+	      "Usage: %s [-r pio,dma,mblk,async] [-m modes] [-n boards] [-b blocklevels]\n"
+	      "          [-o occupancies] [-N nread] [-W words] [-c cycle ns]\n", argv[0]);
+      return 1;
+    }
+
+  buf = (volatile UINT32 *)malloc(BUFWORDS * sizeof(UINT32));
+  lat = (long long *)malloc(nread * sizeof(long long));
+
+  /* The CSV keeps stdout.  Library messages go to stderr. */
+  csv = fdopen(dup(1), "w");
+  dup2(2, 1);
+
+  vmeOpenDefaultWindows();
+  vmeDmaConfig(2, 5, 1);
+  fa125SimSetCycleTime(cycle);
+
+  fprintf(csv, "readout,proc_mode,nboards,blocklevel,occupancy,words_per_block,nread,"
+	 "words_per_s,us_per_block,p50_us,p99_us,p999_us,sim_bus_us_per_block\n");
+
+  fa125SimGenDefaults(&cfg);
+  for(ib = 0; ib < nboards; ib++)
+    {
+      if(((int)boards[ib] < 1) || ((int)boards[ib] > 16) ||
+	 (setupCrate((int)boards[ib]) != OK))
+	{
+	  fprintf(stderr, "ERROR: crate of %d boards\n", (int)boards[ib]);
+	  rval = ERROR;
+	  continue;
+	}
+      cfg.slotmask = fa125ScanMask();
+
+      for(im = 0; im < nmodes; im++)
+	for(il = 0; il < nbl; il++)
+	  for(io = 0; io < nocc; io++)
+	    {
+	      cfg.mode       = (int)modes[im];
+	      cfg.blocklevel = (int)blocklevels[il];
+	      cfg.occupancy  = occupancies[io];
+
+	      setupBoards(&gen, &cfg);
+
+	      for(it = 0; it < ntypes; it++)
+		{
+		  if((types[it] == READ_MBLK) && (nfa125 == 1))
+		    continue;  /* no multiblock with one board */
+
+		  /* Same data for each readout mode */
+		  fa125SimGenInit(&gen, &cfg);
+
+		  if(bench(types[it], &cfg, buf, lat, nread, maxwords) != OK)
+		    {
+		      fprintf(stderr, "ERROR: %s readout of %d boards, mode %d, "
+			      "blocklevel %d, occupancy %.3f\n", readName[types[it]],
+			      nfa125, cfg.mode, cfg.blocklevel, cfg.occupancy);
+		      rval = ERROR;
+		    }
+		}
+	    }
+    }
+
+  free(lat);
+  free((void *)buf);
+  fa125SimCleanup();
+  fclose(csv);
+
+  return (rval != OK);
+}